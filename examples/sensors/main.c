@@ -1,113 +1,99 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-#include <libtock-sync/sensors/ambient_light.h>
-#include <libtock-sync/sensors/humidity.h>
-#include <libtock-sync/sensors/moisture.h>
 #include <libtock-sync/sensors/ninedof.h>
-#include <libtock-sync/sensors/proximity.h>
-#include <libtock-sync/sensors/rainfall.h>
-#include <libtock-sync/sensors/sound_pressure.h>
-#include <libtock-sync/sensors/temperature.h>
-#include <libtock-sync/services/alarm.h>
+#include <libtock/sensors/sound_pressure.h>
+#include <libtock/services/sensor_sampler.h>
 #include <libtock/tock.h>
 
-static libtock_alarm_t alarm;
-static bool light          = false;
-static bool temperature    = false;
-static bool humidity       = false;
-static bool ninedof        = false;
-static bool ninedof_accel  = false;
-static bool ninedof_mag    = false;
-static bool ninedof_gyro   = false;
-static bool proximity      = false;
-static bool sound_pressure = false;
-static bool moisture       = false;
-static bool rainfall       = false;
-static void alarm_cb(__attribute__ ((unused)) uint32_t now,
-                     __attribute__ ((unused)) uint32_t scheduled,
-                     __attribute__ ((unused)) void*    opaque) {
-  int lite = 0;
-  int temp = 0;
-  int humi = 0;
-  int mois = 0;
-  uint32_t rain = 0;
-  int ninedof_accel_x = 0, ninedof_accel_y = 0, ninedof_accel_z = 0;
-  int ninedof_magneto_x = 0, ninedof_magneto_y = 0, ninedof_magneto_z = 0;
-  int ninedof_gyro_x = 0, ninedof_gyro_y = 0, ninedof_gyro_z = 0;
-  uint8_t prox_reading = 0;
-  unsigned char sound_pressure_reading = 0;
+// All sensors are read at the same time, so a cycle takes as long as the
+// slowest sensor. Rainfall changes slowly and is only read every tenth cycle.
+#define PERIOD_MS  1000
+#define TIMEOUT_MS 500
 
-  /* *INDENT-OFF* */
-  if (light)          libtocksync_ambient_light_read_intensity(&lite);
-  if (temperature)    libtocksync_temperature_read(&temp);
-  if (humidity)       libtocksync_humidity_read(&humi);
-  if (ninedof_accel)  libtocksync_ninedof_read_accelerometer(&ninedof_accel_x, &ninedof_accel_y, &ninedof_accel_z);
-  if (ninedof_mag)    libtocksync_ninedof_read_magnetometer(&ninedof_magneto_x, &ninedof_magneto_y, &ninedof_magneto_z);
-  if (ninedof_gyro)   libtocksync_ninedof_read_gyroscope(&ninedof_gyro_x, &ninedof_gyro_y, &ninedof_gyro_z);
-  if (proximity)      libtocksync_proximity_read(&prox_reading);
-  if (sound_pressure) libtocksync_sound_pressure_read(&sound_pressure_reading);
-  if (moisture)       libtocksync_moisture_read(&mois);
-  if (rainfall)       libtocksync_rainfall_read(&rain, 1);
-
-  if (light)          printf("Amb. Light: Light Intensity: %d\n", lite);
-  if (temperature)    printf("Temperature:                 %d deg C\n", temp/100);
-  if (humidity)       printf("Humidity:                    %u%%\n", humi/100);
-  if (ninedof_accel)  printf("Acceleration: X: %d Y: %d Z: %d\n", ninedof_accel_x, ninedof_accel_y, ninedof_accel_z);
-  if (ninedof_mag)    printf("Magnetometer: X: %d Y: %d Z: %d\n", ninedof_magneto_x, ninedof_magneto_y, ninedof_magneto_z);
-  if (ninedof_gyro)   printf("Gyro:         X: %d Y: %d Z: %d\n", ninedof_gyro_x, ninedof_gyro_y, ninedof_gyro_z);
-  if (proximity)      printf("Proximity:                   %u\n", prox_reading);
-  if (sound_pressure) printf("Sound Pressure:              %u\n", sound_pressure_reading);
-  if (moisture)       printf("Moisture:                    %d%%\n", mois/100);
-  if (rainfall)       printf("Rainfall:                    %lumm\n", rain / 1000);
+static libtock_sensor_sampler_t sampler;
+
+static const char* names[LIBTOCK_SENSOR_SAMPLER_COUNT] = {
+  [LIBTOCK_SENSOR_SAMPLER_TEMPERATURE]    = "Temperature sensor",
+  [LIBTOCK_SENSOR_SAMPLER_HUMIDITY]       = "Humidity sensor",
+  [LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT]  = "Ambient Light sensor",
+  [LIBTOCK_SENSOR_SAMPLER_PRESSURE]       = "Pressure sensor",
+  [LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER]  = "Accelerometer",
+  [LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER]   = "Magnetometer",
+  [LIBTOCK_SENSOR_SAMPLER_GYROSCOPE]      = "Gyroscope",
+  [LIBTOCK_SENSOR_SAMPLER_PROXIMITY]      = "Proximity sensor",
+  [LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE] = "Sound Pressure sensor",
+  [LIBTOCK_SENSOR_SAMPLER_MOISTURE]       = "Moisture sensor",
+  [LIBTOCK_SENSOR_SAMPLER_RAINFALL]       = "Rainfall sensor",
+};
+
+static bool has(const libtock_sensor_sampler_record_t* record, libtock_sensor_sampler_sensor_t sensor) {
+  return record->valid & LIBTOCK_SENSOR_SAMPLER_BIT(sensor);
+}
 
+static void sampled_cb(const libtock_sensor_sampler_record_t* record, __attribute__ ((unused)) void* opaque) {
+  const int(*v)[3] = record->value;
+
+  /* *INDENT-OFF* */
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT))  printf("Amb. Light: Light Intensity: %d\n", v[LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT][0]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_TEMPERATURE))    printf("Temperature:                 %d deg C\n", v[LIBTOCK_SENSOR_SAMPLER_TEMPERATURE][0]/100);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_HUMIDITY))       printf("Humidity:                    %u%%\n", v[LIBTOCK_SENSOR_SAMPLER_HUMIDITY][0]/100);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_PRESSURE))       printf("Pressure:                    %d hPa\n", v[LIBTOCK_SENSOR_SAMPLER_PRESSURE][0]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER))  printf("Acceleration: X: %d Y: %d Z: %d\n", v[LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER][0], v[LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER][1], v[LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER][2]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER))   printf("Magnetometer: X: %d Y: %d Z: %d\n", v[LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER][0], v[LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER][1], v[LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER][2]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_GYROSCOPE))      printf("Gyro:         X: %d Y: %d Z: %d\n", v[LIBTOCK_SENSOR_SAMPLER_GYROSCOPE][0], v[LIBTOCK_SENSOR_SAMPLER_GYROSCOPE][1], v[LIBTOCK_SENSOR_SAMPLER_GYROSCOPE][2]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_PROXIMITY))      printf("Proximity:                   %u\n", v[LIBTOCK_SENSOR_SAMPLER_PROXIMITY][0]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE)) printf("Sound Pressure:              %u\n", v[LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE][0]);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_MOISTURE))       printf("Moisture:                    %d%%\n", v[LIBTOCK_SENSOR_SAMPLER_MOISTURE][0]/100);
+  if (has(record, LIBTOCK_SENSOR_SAMPLER_RAINFALL))       printf("Rainfall:                    %umm\n", v[LIBTOCK_SENSOR_SAMPLER_RAINFALL][0] / 1000);
   /* *INDENT-ON* */
 
-  printf("\n");
-  libtock_alarm_in_ms(1000, alarm_cb, NULL, &alarm);
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    if (record->timed_out & LIBTOCK_SENSOR_SAMPLER_BIT(i)) {
+      printf("%s did not answer in time\n", names[i]);
+    }
+  }
+
+  printf("Cycle %lu took %lu ms\n\n", record->sequence, libtock_alarm_ticks_to_ms(record->duration));
 }
 
 int main(void) {
   printf("[Sensors] Starting Sensors App.\n");
   printf("[Sensors] All available sensors on the platform will be sampled.\n");
 
-  /* *INDENT-OFF* */
-  light          = libtock_ambient_light_exists();
-  temperature    = libtock_temperature_exists();
-  humidity       = libtock_humidity_exists();
-  ninedof        = libtock_ninedof_exists();
-  proximity      = libtock_proximity_exists();
-  sound_pressure = libtock_sound_pressure_exists();
-  moisture       = libtock_moisture_exists();
-  rainfall       = libtock_rainfall_exists();
-  /* *INDENT-ON* */
+  libtock_sensor_sampler_init(&sampler);
 
-  if (ninedof) {
+  // The 9-DoF driver may only support some of its three sensors, try each.
+  bool ninedof_present[LIBTOCK_SENSOR_SAMPLER_COUNT] = {false};
+  if (libtock_ninedof_exists()) {
     int buffer;
-    ninedof_accel = (libtocksync_ninedof_read_accelerometer(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
-    ninedof_mag   = (libtocksync_ninedof_read_magnetometer(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
-    ninedof_gyro  = (libtocksync_ninedof_read_gyroscope(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
+    ninedof_present[LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER] =
+      (libtocksync_ninedof_read_accelerometer(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
+    ninedof_present[LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER] =
+      (libtocksync_ninedof_read_magnetometer(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
+    ninedof_present[LIBTOCK_SENSOR_SAMPLER_GYROSCOPE] =
+      (libtocksync_ninedof_read_gyroscope(&buffer, &buffer, &buffer) == RETURNCODE_SUCCESS);
   }
 
-  /* *INDENT-OFF* */
-  if (light)          printf("[Sensors]   Sampling Ambient Light sensor.\n");
-  if (temperature)    printf("[Sensors]   Sampling Temperature sensor.\n");
-  if (humidity)       printf("[Sensors]   Sampling Humidity sensor.\n");
-  if (ninedof_accel)  printf("[Sensors]   Sampling Accelerometer.\n");
-  if (ninedof_mag)    printf("[Sensors]   Sampling Magnetometer.\n");
-  if (ninedof_gyro)   printf("[Sensors]   Sampling Gyroscope.\n");
-  if (proximity)      printf("[Sensors]   Sampling Proximity sensor.\n");
-  if (sound_pressure) printf("[Sensors]   Sampling Sound Pressure sensor.\n");
-  if (moisture)       printf("[Sensors]   Sampling Moisture sensor.\n");
-  if (rainfall)       printf("[Sensors]   Sampling Rainfall sensor.\n");
-  /* *INDENT-ON* */
-
-  if (sound_pressure) {
+  if (libtock_sound_pressure_exists()) {
     libtock_sound_pressure_command_enable();
   }
 
-  // Setup periodic alarm to sample the sensors.
-  libtock_alarm_in_ms(1000, alarm_cb, NULL, &alarm);
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    libtock_sensor_sampler_sensor_t sensor = (libtock_sensor_sampler_sensor_t) i;
+    bool ninedof = sensor == LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER ||
+                   sensor == LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER ||
+                   sensor == LIBTOCK_SENSOR_SAMPLER_GYROSCOPE;
+    uint32_t divider = sensor == LIBTOCK_SENSOR_SAMPLER_RAINFALL ? 10 : 1;
+
+    if (ninedof && !ninedof_present[i]) continue;
+    if (libtock_sensor_sampler_configure(&sampler, sensor, divider, TIMEOUT_MS) == RETURNCODE_SUCCESS) {
+      printf("[Sensors]   Sampling %s.\n", names[i]);
+    }
+  }
+
+  // Sample all sensors together once per period.
+  libtock_sensor_sampler_start(&sampler, PERIOD_MS, sampled_cb, NULL);
 
   while (1) {
     yield();
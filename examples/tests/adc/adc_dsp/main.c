@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libtock/peripherals/adc.h>
+#include <libtock/peripherals/syscalls/adc_syscalls.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+#include <libtock/util/dsp.h>
+
+// Sample the first channel. On Hail, this is external pin A0 (AD0)
+#define ADC_CHANNEL 0
+
+// 100 ms of samples per buffer.
+#define ADC_FREQUENCY 8000
+#define BUF_SIZE      800
+
+// Features are computed at the full rate, the waveform is reduced by
+// `FIR_DECIMATION` before peak detection.
+#define FIR_TAPS        15
+#define FIR_DECIMATION  4
+#define RMS_WINDOW_LOG2 5
+#define MAX_PEAKS       16
+
+static uint16_t sample_buffer1[BUF_SIZE];
+static uint16_t sample_buffer2[BUF_SIZE];
+
+// Low-pass at about 1/8 of the sample rate (Hamming window), Q15.
+static const int16_t fir_coefficients[FIR_TAPS] = {
+  -84, -219, -374, 0, 1582, 4321, 7054, 8208, 7054, 4321, 1582, 0, -374, -219, -84,
+};
+static int16_t fir_history[2 * FIR_TAPS];
+static uint32_t rms_squares[1 << RMS_WINDOW_LOG2];
+
+static libtock_dsp_dc_block_t dc;
+static libtock_dsp_fir_t fir;
+static libtock_dsp_rms_t rms;
+static libtock_dsp_scale_t to_millivolts;
+
+static uint32_t resolution_bits = 12;
+
+static uint32_t now_ticks(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+static void buffered_sample_cb(uint8_t   channel,
+                               uint32_t  length,
+                               uint16_t* buf_ptr) {
+  static uint32_t buffers = 0;
+  libtock_dsp_stats_t raw, ac;
+  uint32_t peaks[MAX_PEAKS];
+
+  uint32_t start = now_ticks();
+
+  int16_t* samples = libtock_dsp_adc_to_q15(buf_ptr, length, resolution_bits);
+  libtock_dsp_stats(samples, length, &raw);
+
+  // Vibration features: remove the DC level, then smooth the magnitude.
+  libtock_dsp_dc_block(&dc, samples, length);
+  libtock_dsp_stats(samples, length, &ac);
+  uint32_t count = libtock_dsp_fir_decimate(&fir, samples, length);
+  libtock_dsp_moving_rms(&rms, samples, count);
+  uint32_t peak_count = libtock_dsp_find_peaks(samples, count, ac.rms, 4, peaks, MAX_PEAKS);
+
+  // Only the DC level is reported in physical units.
+  int16_t mean_mv = raw.mean;
+  libtock_dsp_scale(&to_millivolts, &mean_mv, 1);
+
+  uint32_t elapsed = now_ticks() - start;
+
+  printf("Channel: %u\tBuffer: %lu\tMean: %d mV\tAC RMS: %d\tAC Peak: %d @ %lu\tRMS peaks: %lu\tTime: %lu us\n",
+         channel, buffers, mean_mv, ac.rms, ac.peak, ac.peak_index, peak_count,
+         libtock_alarm_ticks_to_ms(elapsed * 1000));
+  buffers++;
+}
+
+static libtock_adc_callbacks callbacks = {
+  .single_sample_callback     = NULL,
+  .continuous_sample_callback = NULL,
+  .buffered_sample_callback   = NULL,
+  .continuous_buffered_sample_callback = buffered_sample_cb,
+};
+
+int main(void) {
+  int err;
+  printf("[Tock] ADC DSP Test\n");
+
+  if (!libtock_adc_exists()) {
+    printf("No ADC driver!\n");
+    return -1;
+  }
+
+  uint32_t reference_mv = 3300;
+  libtock_adc_command_get_resolution_bits(&resolution_bits);
+  libtock_adc_command_get_reference_voltage(&reference_mv);
+  printf("Resolution: %lu bits, reference: %lu mV\n", resolution_bits, reference_mv);
+
+  // Q15 spans [-1, 1) of full scale, millivolts are (x + 1) * reference / 2.
+  to_millivolts.multiplier = reference_mv;
+  to_millivolts.shift      = 16;
+  to_millivolts.offset     = reference_mv / 2;
+
+  // Pole at 0.995, a cut-off of about 6 Hz at 8 kHz.
+  libtock_dsp_dc_block_init(&dc, 32604);
+  libtock_dsp_fir_init(&fir, fir_coefficients, FIR_TAPS, FIR_DECIMATION, fir_history);
+  libtock_dsp_rms_init(&rms, rms_squares, RMS_WINDOW_LOG2);
+
+  err = libtock_adc_set_buffer(sample_buffer1, BUF_SIZE);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("set buffer error: %d\n", err);
+    return -1;
+  }
+  err = libtock_adc_set_double_buffer(sample_buffer2, BUF_SIZE);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("set double buffer error: %d\n", err);
+    return -1;
+  }
+
+  printf("Beginning buffered sampling on channel %d at %d Hz\n", ADC_CHANNEL, ADC_FREQUENCY);
+  err = libtock_adc_continuous_buffered_sample(ADC_CHANNEL, ADC_FREQUENCY, &callbacks);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("continuous buffered sample error: %d\n", err);
+    return -1;
+  }
+
+  return 0;
+}
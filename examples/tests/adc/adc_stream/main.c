@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libtock/peripherals/adc.h>
+#include <libtock/peripherals/adc_stream.h>
+#include <libtock/tock.h>
+
+// Continuous capture of one channel, then an interleaved scan of three.
+#define ADC_CHANNEL     0
+#define ADC_FREQUENCY   20000
+#define SCAN_FREQUENCY  500
+#define BLOCKS_PER_MODE 100
+
+#define BUFFER_LENGTH 500
+#define BUFFER_COUNT  4
+
+static uint16_t stream_memory[BUFFER_COUNT * BUFFER_LENGTH];
+static libtock_adc_stream_t stream;
+
+static const uint8_t scan_channels[] = {0, 1, 2};
+
+static uint32_t blocks;
+static uint32_t overflows;
+static uint32_t lost;
+
+static void start_scan(void);
+
+static void report(libtock_adc_stream_block_t* block) {
+  if (block->overflow) {
+    overflows++;
+    lost += block->lost;
+    printf("Overflow before block %lu: %lu samples lost\n", block->sequence, block->lost);
+  }
+
+  if (block->sequence % 10 != 0) return;
+
+  printf("Block %lu\tt=%lu\tsamples=%lu\tmeans:", block->sequence, block->timestamp, block->sample_count);
+  for (uint32_t ch = 0; ch < block->channel_count; ch++) {
+    uint32_t sum = 0;
+    for (uint32_t i = ch; i < block->sample_count; i += block->channel_count) {
+      sum += block->samples[i];
+    }
+    printf(" %lu", sum / (block->sample_count / block->channel_count));
+  }
+  printf("\n");
+}
+
+static void scan_block_cb(libtock_adc_stream_block_t* block, __attribute__ ((unused)) void* opaque) {
+  report(block);
+  libtock_adc_stream_release(&stream, block);
+
+  if (++blocks == 2 * BLOCKS_PER_MODE) {
+    libtock_adc_stream_stop(&stream);
+    printf("Done: %lu blocks, %lu overflows, %lu samples lost\n", blocks, overflows, lost);
+  }
+}
+
+static void continuous_block_cb(libtock_adc_stream_block_t* block, __attribute__ ((unused)) void* opaque) {
+  report(block);
+  libtock_adc_stream_release(&stream, block);
+
+  if (++blocks == BLOCKS_PER_MODE) {
+    libtock_adc_stream_stop(&stream);
+    printf("Continuous: %lu overflows, %lu samples lost, %lu blocks dropped\n",
+           overflows, lost, stream.blocks_dropped);
+    start_scan();
+  }
+}
+
+static void start_scan(void) {
+  printf("Scanning channels 0, 1, 2 at %d Hz\n", SCAN_FREQUENCY);
+  int err = libtock_adc_stream_start_scan(&stream, scan_channels, sizeof(scan_channels), SCAN_FREQUENCY,
+                                          scan_block_cb, NULL);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("start scan error: %d\n", err);
+  }
+}
+
+int main(void) {
+  int err;
+  printf("[Tock] ADC Stream Test\n");
+
+  if (!libtock_adc_exists()) {
+    printf("No ADC driver!\n");
+    return -1;
+  }
+
+  err = libtock_adc_stream_init(&stream, stream_memory, BUFFER_LENGTH, BUFFER_COUNT);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("stream init error: %d\n", err);
+    return -1;
+  }
+
+  printf("Sampling channel %d at %d Hz\n", ADC_CHANNEL, ADC_FREQUENCY);
+  err = libtock_adc_stream_start(&stream, ADC_CHANNEL, ADC_FREQUENCY, continuous_block_cb, NULL);
+  if (err < RETURNCODE_SUCCESS) {
+    printf("start error: %d\n", err);
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/aes_bulk.h>
+#include <libtock/crypto/aes_bulk.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+
+#define KEY_LEN   16
+#define IV_LEN    16
+#define DATA_LEN  256
+#define CHECK_LEN 240
+#define BENCH_LEN 4096
+
+static const uint8_t key_buf[KEY_LEN] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t iv_buf[IV_LEN] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+  0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+static uint8_t data_buf[DATA_LEN] = \
+  "A language empowering everyone to build reliable and efficient software.";
+static const uint8_t expected_ctr[CHECK_LEN] = \
+{0xad, 0xac, 0xb3, 0x12, 0xf6, 0x07, 0x09, 0xd1, 0x95, 0xb7, 0x36, 0x10,
+  0x87, 0xee, 0xce, 0x93, 0x53, 0x59, 0x15, 0x52, 0x00, 0x53, 0x34, 0x15,
+  0x7d, 0xd2, 0x0e, 0xb8, 0x92, 0x35, 0x53, 0xda, 0x05, 0x0c, 0xa1, 0x0d,
+  0x11, 0xe5, 0x53, 0x6f, 0xcc, 0xd1, 0xa4, 0x72, 0x76, 0xd8, 0x00, 0x21,
+  0xc8, 0xfd, 0x57, 0xfb, 0xd0, 0x94, 0xfe, 0xa0, 0xbd, 0x69, 0x58, 0xbe,
+  0x7b, 0x18, 0x8b, 0x8d, 0xdf, 0x6b, 0x33, 0x8f, 0x75, 0xf8, 0xf4, 0x20,
+  0xf0, 0x68, 0x30, 0x97, 0x90, 0x4b, 0xa5, 0x02, 0x58, 0x99, 0x44, 0x5a,
+  0x4d, 0xe1, 0x01, 0xf5, 0x13, 0xca, 0xd1, 0x98, 0x7d, 0x89, 0xe9, 0x1b,
+  0x3b, 0xd9, 0xac, 0x79, 0x49, 0xde, 0x2b, 0xf9, 0x65, 0x69, 0xac, 0x38,
+  0x43, 0xf8, 0x72, 0x42, 0x7d, 0x9a, 0xce, 0x80, 0x47, 0xc3, 0x53, 0x09,
+  0x15, 0x5a, 0xb8, 0xa8, 0xf0, 0x85, 0x97, 0xb1, 0xb7, 0x9c, 0xb9, 0x26,
+  0x40, 0xee, 0x48, 0x97, 0x95, 0xaf, 0x36, 0x15, 0x2a, 0xb3, 0xf6, 0x3b,
+  0x7a, 0x42, 0x6f, 0x76, 0x8d, 0xb9, 0xe5, 0xe8, 0x1c, 0xb5, 0xc8, 0x4e,
+  0x77, 0x4d, 0xcd, 0x2d, 0xad, 0xa0, 0x4d, 0xe7, 0x28, 0x2d, 0x83, 0xde,
+  0x58, 0x6e, 0xd4, 0x85, 0x0a, 0x93, 0x8f, 0x15, 0x4d, 0x22, 0xb1, 0xe1,
+  0xd2, 0xb1, 0x28, 0x94, 0xfa, 0xa1, 0xff, 0xa6, 0xd4, 0x8c, 0x60, 0x33,
+  0x05, 0xda, 0x9e, 0xff, 0xc9, 0xe2, 0x7e, 0xe7, 0x76, 0xf7, 0x9d, 0xd6,
+  0xb6, 0x0e, 0x98, 0xf1, 0x9e, 0x21, 0xce, 0x9a, 0x6f, 0x65, 0x2b, 0x13,
+  0x02, 0xcb, 0xa1, 0xf6, 0x25, 0x79, 0x17, 0xf6, 0xe4, 0x16, 0x54, 0xe6,
+  0xfb, 0x40, 0x2e, 0xb7, 0x12, 0x71, 0xca, 0xf7, 0xeb, 0x19, 0x1e, 0xd3};
+static uint8_t dest_buf[DATA_LEN];
+static uint8_t bench_buf[BENCH_LEN];
+static uint8_t chunk_buffers[2 * 64];
+
+static bool done = false;
+static returncode_t done_ret;
+
+static void bulk_cb(returncode_t ret, __attribute__ ((unused)) uint32_t length, __attribute__ ((unused)) void* opaque) {
+  done     = true;
+  done_ret = ret;
+}
+
+// Position of the stream test in `dest_buf`.
+static uint32_t stream_read_pos  = 0;
+static uint32_t stream_write_pos = 0;
+
+static int stream_read(uint8_t* buffer, uint32_t length, __attribute__ ((unused)) void* opaque) {
+  if (length > DATA_LEN - stream_read_pos) length = DATA_LEN - stream_read_pos;
+  memcpy(buffer, dest_buf + stream_read_pos, length);
+  stream_read_pos += length;
+  return length;
+}
+
+static int stream_write(const uint8_t* buffer, uint32_t length, __attribute__ ((unused)) void* opaque) {
+  memcpy(dest_buf + stream_write_pos, buffer, length);
+  stream_write_pos += length;
+  return 0;
+}
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+int main(void) {
+  returncode_t ret;
+  libtock_aes_bulk_t op;
+
+  printf("[TEST] Bulk AES\n");
+
+  if (!libtock_aes_exists()) {
+    printf("No AES driver.\n");
+    return -2;
+  }
+
+  // Encrypt in 32 byte chunks, the result must match the known ciphertext.
+  ret = libtock_aes_bulk_crypt(&op, LIBTOCK_AES128Ctr, true, key_buf, iv_buf, data_buf, dest_buf, DATA_LEN, 32,
+                               bulk_cb, NULL);
+  if (ret == RETURNCODE_SUCCESS) {
+    yield_for(&done);
+    ret = done_ret;
+  }
+  if (ret != RETURNCODE_SUCCESS || memcmp(dest_buf, expected_ctr, CHECK_LEN) != 0) {
+    printf("CTR encryption in chunks failed: %d\n", ret);
+    return -1;
+  }
+  printf("CTR encryption in 32 byte chunks matches\n");
+
+  // Decrypt through the double-buffered stream back into `dest_buf`.
+  ret = libtocksync_aes_bulk_stream(LIBTOCK_AES128Ctr, false, key_buf, iv_buf, stream_read, stream_write, NULL,
+                                    chunk_buffers, sizeof(chunk_buffers) / 2);
+  if (ret != RETURNCODE_SUCCESS || memcmp(dest_buf, data_buf, DATA_LEN) != 0) {
+    printf("CTR stream decryption failed: %d\n", ret);
+    return -1;
+  }
+  printf("CTR stream decryption matches\n");
+
+  // Time a 4 kB CBC encryption with different chunk lengths.
+  for (uint32_t chunk = 16; chunk <= 256; chunk *= 2) {
+    done = false;
+    uint32_t start = now_ms();
+    ret = libtock_aes_bulk_crypt(&op, LIBTOCK_AES128CBC, true, key_buf, iv_buf, bench_buf, bench_buf, BENCH_LEN,
+                                 chunk, bulk_cb, NULL);
+    if (ret == RETURNCODE_SUCCESS) {
+      yield_for(&done);
+      ret = done_ret;
+    }
+    uint32_t elapsed = now_ms() - start;
+    if (ret != RETURNCODE_SUCCESS) {
+      printf("CBC encryption with %lu byte chunks failed: %d\n", chunk, ret);
+      return -1;
+    }
+    printf("CBC, %d bytes in %lu byte chunks: %lu ms\n", BENCH_LEN, chunk, elapsed);
+  }
+
+  printf("All tests succeeded\n");
+  return 0;
+}
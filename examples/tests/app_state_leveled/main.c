@@ -0,0 +1,52 @@
+#include <stdio.h>
+
+#include <libtock-sync/storage/app_state.h>
+#include <libtock/tock.h>
+
+#define MAGIC 0xcafe
+
+struct demo_app_state_t {
+  uint32_t magic;
+  uint32_t count;
+};
+
+// Like `LIBTOCK_APP_STATE_DECLARE`, but every save goes to the next of eight
+// record slots in flash instead of overwriting the same location.
+LIBTOCK_APP_STATE_DECLARE_LEVELED(struct demo_app_state_t, app_state, 8);
+
+int main(void) {
+  int ret;
+
+  ret = libtock_app_state_leveled_load();
+  if (ret < 0) {
+    printf("Error loading application state: %s\n", tock_strrcode(ret));
+    return ret;
+  }
+
+  if (app_state.magic != MAGIC) {
+    printf("Application has never saved state before\n");
+    app_state.magic = MAGIC;
+    app_state.count = 1;
+  } else {
+    printf("This application has run %lu time(s) before (record %i, sequence %lu)\n", app_state.count,
+           _app_state_leveled.newest_slot, _app_state_leveled.sequence);
+    app_state.count += 1;
+  }
+
+  ret = libtocksync_app_state_leveled_save();
+  if (ret != 0) {
+    printf("ERROR saving application state: %s\n", tock_strrcode(ret));
+    return ret;
+  }
+
+  // Saving again without changes does not touch flash.
+  ret = libtocksync_app_state_leveled_save();
+  if (ret != 0 || _app_state_leveled.skipped != 1) {
+    printf("ERROR unchanged state was written again\n");
+    return -1;
+  }
+
+  printf("State saved successfully to record %i. Done.\n", _app_state_leveled.newest_slot);
+
+  return 0;
+}
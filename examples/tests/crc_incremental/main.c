@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/peripherals/crc.h>
+#include <libtock/peripherals/crc_software.h>
+
+struct test_case {
+  libtock_crc_alg_t alg;
+  uint32_t output;
+  const char* input;
+};
+
+// Same test vectors as the CRC driver test.
+static const struct test_case test_cases[] = {
+#define CASE(alg, output, input) \
+  { alg, output, input },
+#include "../crc/test_cases.h"
+#undef CASE
+};
+
+static const int n_test_cases = sizeof(test_cases) / sizeof(struct test_case);
+
+static uint8_t large_buf[2048];
+
+// Check the software CRC, the incremental CRC with every split point, and
+// the incremental CRC with the second part computed by the driver.
+static int check_case(const struct test_case* t, bool driver) {
+  const uint8_t* input = (const uint8_t*) t->input;
+  uint32_t length      = strlen(t->input);
+  libtock_crc_t crc;
+
+  if (libtock_crc_software(t->alg, input, length) != t->output) return -1;
+
+  for (uint32_t split = 0; split <= length; split++) {
+    libtock_crc_begin(&crc, t->alg);
+    libtock_crc_update(&crc, input, split);
+    libtock_crc_update(&crc, input + split, length - split);
+    if (libtock_crc_end(&crc) != t->output) return -1;
+  }
+
+  if (driver && length > 1) {
+    uint32_t split = length / 2;
+    uint32_t chunk_crc;
+
+    if (libtocksync_crc_compute(input + split, length - split, t->alg, &chunk_crc) != RETURNCODE_SUCCESS) return -1;
+    libtock_crc_begin(&crc, t->alg);
+    libtock_crc_update(&crc, input, split);
+    libtock_crc_append(&crc, chunk_crc, length - split);
+    if (libtock_crc_end(&crc) != t->output) return -1;
+  }
+  return 0;
+}
+
+// A long buffer in pieces through `libtocksync_crc_update()`, which sends
+// the large piece to the driver, must match the software CRC.
+static int check_large(libtock_crc_alg_t alg) {
+  libtock_crc_t crc;
+
+  libtock_crc_begin(&crc, alg);
+  if (libtocksync_crc_update(&crc, large_buf, 13) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_crc_update(&crc, large_buf + 13, 1500) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_crc_update(&crc, large_buf + 1513, sizeof(large_buf) - 1513) != RETURNCODE_SUCCESS) return -1;
+
+  return libtock_crc_end(&crc) == libtock_crc_software(alg, large_buf, sizeof(large_buf)) ? 0 : -1;
+}
+
+int main(void) {
+  int failures = 0;
+
+  printf("[TEST] Incremental CRC\n");
+
+  bool driver = libtock_crc_exists();
+  if (!driver) {
+    printf("No CRC driver, testing software only.\n");
+  }
+
+  for (int i = 0; i < n_test_cases; i++) {
+    if (check_case(&test_cases[i], driver) != 0) {
+      printf("Case %2d failed (expected %08lx)\n", i, test_cases[i].output);
+      failures++;
+    }
+  }
+
+  for (uint32_t i = 0; i < sizeof(large_buf); i++) {
+    large_buf[i] = i * 13 + 5;
+  }
+  if (check_large(LIBTOCK_CRC_32) != 0 || check_large(LIBTOCK_CRC_32C) != 0 ||
+      check_large(LIBTOCK_CRC_16CCITT) != 0) {
+    printf("Large buffer in pieces failed\n");
+    failures++;
+  }
+
+  if (failures == 0) {
+    printf("All %d cases passed\n", n_test_cases);
+  }
+  return failures;
+}
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/aes_bulk.h>
+#include <libtock-sync/crypto/hmac.h>
+#include <libtock-sync/crypto/sha.h>
+#include <libtock-sync/peripherals/crc.h>
+#include <libtock-sync/peripherals/rng.h>
+#include <libtock/crypto/syscalls/aes_syscalls.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/peripherals/syscalls/crc_syscalls.h>
+#include <libtock/peripherals/syscalls/rng_syscalls.h>
+
+// Throughput and latency of the crypto and checksum drivers.
+//
+// Every benchmark is run for each message size until at least
+// `MIN_RUN_MS` have passed. Results are printed as CSV:
+//
+//     result,<benchmark>,<bytes>,<iterations>,<us per call>,<bytes per s>
+//     overhead,<benchmark>,<fixed us per call>,<ns per byte>
+//     syscall,<name>,<iterations>,<ns per call>
+//
+// The overhead line splits the per-call latency into a fixed part (syscalls,
+// upcall and driver setup) and a per-byte part, from a straight line through
+// the smallest and largest message sizes.
+
+#define MIN_RUN_MS     50
+#define MIN_ITERATIONS 3
+#define MAX_LENGTH     4096
+
+static const uint32_t sizes[] = {16, 64, 256, 1024, MAX_LENGTH};
+#define NUM_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+static uint8_t input_buf[MAX_LENGTH];
+static uint8_t output_buf[MAX_LENGTH + 16];
+static uint8_t digest_buf[64];
+
+static const uint8_t key_buf[32] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t iv_buf[16] = {
+  0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+
+static returncode_t run_sha(libtock_sha_algorithm_t algorithm, uint32_t length) {
+  // The streaming calls always use the driver.
+  returncode_t ret = libtocksync_sha_init(algorithm);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  ret = libtocksync_sha_update(input_buf, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  return libtocksync_sha_finish(digest_buf, sizeof(digest_buf));
+}
+
+static returncode_t run_sha256(uint32_t length) {
+  return run_sha(LIBTOCK_SHA256, length);
+}
+
+static returncode_t run_sha384(uint32_t length) {
+  return run_sha(LIBTOCK_SHA384, length);
+}
+
+static returncode_t run_sha512(uint32_t length) {
+  return run_sha(LIBTOCK_SHA512, length);
+}
+
+static returncode_t run_hmac(libtock_hmac_algorithm_t algorithm, uint32_t length) {
+  return libtocksync_hmac_simple(algorithm, (uint8_t*) key_buf, sizeof(key_buf), input_buf, length,
+                                 digest_buf, sizeof(digest_buf));
+}
+
+static returncode_t run_hmac_sha256(uint32_t length) {
+  return run_hmac(LIBTOCK_HMAC_SHA256, length);
+}
+
+static returncode_t run_hmac_sha384(uint32_t length) {
+  return run_hmac(LIBTOCK_HMAC_SHA384, length);
+}
+
+static returncode_t run_hmac_sha512(uint32_t length) {
+  return run_hmac(LIBTOCK_HMAC_SHA512, length);
+}
+
+static returncode_t run_aes_ctr(uint32_t length) {
+  return libtocksync_aes_bulk_crypt(LIBTOCK_AES128Ctr, true, key_buf, iv_buf, input_buf, output_buf, length);
+}
+
+static returncode_t run_aes_cbc(uint32_t length) {
+  return libtocksync_aes_bulk_crypt(LIBTOCK_AES128CBC, true, key_buf, iv_buf, input_buf, output_buf, length);
+}
+
+static returncode_t run_aes_ecb(uint32_t length) {
+  return libtocksync_aes_bulk_crypt(LIBTOCK_AES128ECB, true, key_buf, iv_buf, input_buf, output_buf, length);
+}
+
+static returncode_t run_aes_ccm(uint32_t length) {
+  return libtocksync_aes_bulk_ccm(true, key_buf, iv_buf, 13, input_buf, output_buf, length, 0, 0, 8);
+}
+
+static returncode_t run_crc(libtock_crc_alg_t algorithm, uint32_t length) {
+  uint32_t crc;
+  return libtocksync_crc_compute(input_buf, length, algorithm, &crc);
+}
+
+static returncode_t run_crc32(uint32_t length) {
+  return run_crc(LIBTOCK_CRC_32, length);
+}
+
+static returncode_t run_crc32c(uint32_t length) {
+  return run_crc(LIBTOCK_CRC_32C, length);
+}
+
+static returncode_t run_crc16ccitt(uint32_t length) {
+  return run_crc(LIBTOCK_CRC_16CCITT, length);
+}
+
+static returncode_t run_rng(uint32_t length) {
+  int received;
+  returncode_t ret = libtocksync_rng_get_random_bytes(output_buf, length, length, &received);
+  if (ret == RETURNCODE_SUCCESS && (uint32_t) received != length) return RETURNCODE_FAIL;
+  return ret;
+}
+
+typedef struct {
+  const char* name;
+  bool (*exists)(void);
+  returncode_t (*run)(uint32_t length);
+} benchmark_t;
+
+static const benchmark_t benchmarks[] = {
+  {"sha256",      libtock_sha_exists,  run_sha256     },
+  {"sha384",      libtock_sha_exists,  run_sha384     },
+  {"sha512",      libtock_sha_exists,  run_sha512     },
+  {"hmac-sha256", libtock_hmac_exists, run_hmac_sha256},
+  {"hmac-sha384", libtock_hmac_exists, run_hmac_sha384},
+  {"hmac-sha512", libtock_hmac_exists, run_hmac_sha512},
+  {"aes128-ctr",  libtock_aes_exists,  run_aes_ctr    },
+  {"aes128-cbc",  libtock_aes_exists,  run_aes_cbc    },
+  {"aes128-ecb",  libtock_aes_exists,  run_aes_ecb    },
+  {"aes128-ccm",  libtock_aes_exists,  run_aes_ccm    },
+  {"crc32",       libtock_crc_exists,  run_crc32      },
+  {"crc32c",      libtock_crc_exists,  run_crc32c     },
+  {"crc16-ccitt", libtock_crc_exists,  run_crc16ccitt },
+  {"rng",         libtock_rng_exists,  run_rng        },
+};
+
+static uint32_t frequency;
+
+static uint32_t now(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks) {
+  return ticks * 1000000000 / frequency;
+}
+
+// Run `benchmark` on messages of `length` bytes and return the average
+// latency in nanoseconds, or 0 on error.
+static uint64_t measure(const benchmark_t* benchmark, uint32_t length) {
+  uint32_t min_ticks  = (uint64_t) frequency * MIN_RUN_MS / 1000;
+  uint32_t iterations = 0;
+  uint32_t start      = now();
+  uint32_t elapsed;
+
+  do {
+    returncode_t ret = benchmark->run(length);
+    if (ret != RETURNCODE_SUCCESS) {
+      printf("error,%s,%lu,%d\n", benchmark->name, length, ret);
+      return 0;
+    }
+    iterations++;
+    elapsed = now() - start;
+  } while (iterations < MIN_ITERATIONS || elapsed < min_ticks);
+
+  uint64_t ns = ticks_to_ns(elapsed) / iterations;
+  if (ns == 0) ns = 1;
+  printf("result,%s,%lu,%lu,%lu,%lu\n", benchmark->name, length, iterations, (uint32_t) (ns / 1000),
+         (uint32_t) ((uint64_t) length * 1000000000 / ns));
+  return ns;
+}
+
+// Cost of a command syscall that does no work.
+static void measure_syscall(void) {
+  const uint32_t iterations = 1000;
+  uint32_t start = now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    driver_exists(DRIVER_NUM_ALARM);
+  }
+  uint32_t elapsed = now() - start;
+  printf("syscall,command,%lu,%lu\n", iterations, (uint32_t) (ticks_to_ns(elapsed) / iterations));
+}
+
+int main(void) {
+  printf("[TEST] Crypto and Checksum Benchmark\n");
+
+  libtock_alarm_command_get_frequency(&frequency);
+  for (uint32_t i = 0; i < sizeof(input_buf); i++) {
+    input_buf[i] = i * 7;
+  }
+
+  measure_syscall();
+
+  for (uint32_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+    const benchmark_t* benchmark = &benchmarks[b];
+    uint64_t latency[NUM_SIZES];
+
+    if (!benchmark->exists()) {
+      printf("missing,%s\n", benchmark->name);
+      continue;
+    }
+
+    for (uint32_t s = 0; s < NUM_SIZES; s++) {
+      latency[s] = measure(benchmark, sizes[s]);
+    }
+
+    uint64_t first = latency[0];
+    uint64_t last  = latency[NUM_SIZES - 1];
+    if (first == 0 || last == 0) continue;
+
+    // Straight line through the smallest and largest size.
+    int64_t per_byte = ((int64_t) last - (int64_t) first) / (int64_t) (sizes[NUM_SIZES - 1] - sizes[0]);
+    int64_t fixed    = (int64_t) first - per_byte * sizes[0];
+    printf("overhead,%s,%ld,%ld\n", benchmark->name, (long) (fixed / 1000), (long) per_byte);
+  }
+
+  printf("done\n");
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/peripherals/rng.h>
+#include <libtock-sync/services/entropy_pool.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+
+#define REQUESTS       1000
+#define REQUEST_LENGTH 8
+
+static uint8_t pool_memory[256];
+static libtock_entropy_pool_t pool;
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+// Time `REQUESTS` requests of `REQUEST_LENGTH` bytes. `source` 0 is the RNG
+// driver, 1 the pool and 2 the DRBG.
+static int measure(const char* name, int source) {
+  uint8_t bytes[REQUEST_LENGTH];
+  uint8_t previous[REQUEST_LENGTH] = {0};
+  returncode_t ret = RETURNCODE_SUCCESS;
+  int repeats      = 0;
+
+  uint32_t start = now_ms();
+  for (int i = 0; i < REQUESTS && ret == RETURNCODE_SUCCESS; i++) {
+    int received;
+    switch (source) {
+      case 0:
+        ret = libtocksync_rng_get_random_bytes(bytes, sizeof(bytes), sizeof(bytes), &received);
+        break;
+      case 1:
+        ret = libtocksync_entropy_pool_get(&pool, bytes, sizeof(bytes));
+        break;
+      default:
+        ret = libtocksync_entropy_pool_drbg_get(&pool, bytes, sizeof(bytes));
+        break;
+    }
+
+    // Consecutive equal requests would mean bytes are being reused.
+    if (memcmp(bytes, previous, sizeof(bytes)) == 0) repeats++;
+    memcpy(previous, bytes, sizeof(bytes));
+  }
+  uint32_t elapsed = now_ms() - start;
+
+  if (ret != RETURNCODE_SUCCESS || repeats > 0) {
+    printf("%s failed: %d, %d repeated requests\n", name, ret, repeats);
+    return -1;
+  }
+  printf("%-6s %d x %d bytes in %lu ms\n", name, REQUESTS, REQUEST_LENGTH, elapsed);
+  return 0;
+}
+
+int main(void) {
+  printf("[TEST] Entropy Pool\n");
+
+  if (!libtock_rng_exists()) {
+    printf("No RNG driver.\n");
+    return -2;
+  }
+
+  // The driver must be measured before the pool takes over its upcall.
+  if (measure("driver", 0) != 0) return -1;
+
+  if (libtock_entropy_pool_init(&pool, pool_memory, sizeof(pool_memory), 128) != RETURNCODE_SUCCESS) {
+    printf("Pool init failed\n");
+    return -1;
+  }
+  if (measure("pool", 1) != 0) return -1;
+  if (measure("drbg", 2) != 0) return -1;
+
+  printf("Pool refills: %lu, bytes served: %lu\n", pool.refills, pool.bytes_served);
+  printf("All tests succeeded\n");
+  return 0;
+}
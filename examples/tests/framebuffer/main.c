@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libtock-sync/display/framebuffer.h>
+#include <libtock-sync/display/screen.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+
+#define TRANSFER_SIZE 1024
+#define BOX_SIZE      16
+#define FRAMES        100
+
+static libtock_framebuffer_t framebuffer;
+static uint8_t transfer[TRANSFER_SIZE];
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+int main(void) {
+  libtock_screen_format_t format;
+  uint32_t width, height;
+  uint8_t* buffer = NULL;
+  returncode_t ret;
+
+  printf("[TEST] Framebuffer\n");
+
+  if (!libtock_screen_setup_enabled()) {
+    printf("No screen.\n");
+    return -1;
+  }
+  libtock_screen_get_resolution(&width, &height);
+  libtocksync_screen_get_pixel_format(&format);
+
+  uint32_t length = libtock_framebuffer_length(width, height, format);
+  if (libtock_screen_buffer_init(length, &buffer) != TOCK_STATUSCODE_SUCCESS) {
+    printf("Cannot allocate a %lu byte framebuffer, increase APP_HEAP_SIZE.\n", length);
+    return -1;
+  }
+  ret = libtocksync_framebuffer_init(&framebuffer, buffer, length, transfer, TRANSFER_SIZE);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("Framebuffer init failed: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+  printf("%lux%lu screen, %d bits per pixel\n", width, height, libtock_screen_get_bits_per_pixel(format));
+
+  int bits       = libtock_screen_get_bits_per_pixel(format);
+  uint32_t white = bits >= 32 ? 0xFFFFFFFF : (1u << bits) - 1;
+
+  // Baseline: redraw the whole screen every frame.
+  uint32_t start = now_ms();
+  for (int i = 0; i < FRAMES / 10; i++) {
+    libtock_framebuffer_invalidate_all(&framebuffer);
+    libtocksync_framebuffer_flush(&framebuffer);
+  }
+  uint32_t full_ms = (now_ms() - start) / (FRAMES / 10);
+  printf("full frame: %lu ms, %lu bytes\n", full_ms, framebuffer.bytes);
+
+  // A box bouncing around the screen, only the area it moved over is sent.
+  int x = 0, y = 0, dx = 3, dy = 2;
+  uint32_t writes = 0, bytes = 0;
+  start = now_ms();
+  for (int i = 0; i < FRAMES; i++) {
+    libtock_framebuffer_fill_rect(&framebuffer, x, y, BOX_SIZE, BOX_SIZE, 0);
+    if (x + dx < 0 || x + dx + BOX_SIZE > (int) width) dx = -dx;
+    if (y + dy < 0 || y + dy + BOX_SIZE > (int) height) dy = -dy;
+    x += dx;
+    y += dy;
+    libtock_framebuffer_fill_rect(&framebuffer, x, y, BOX_SIZE, BOX_SIZE, white);
+
+    ret = libtocksync_framebuffer_flush(&framebuffer);
+    if (ret != RETURNCODE_SUCCESS) {
+      printf("Flush failed: %s\n", tock_strrcode(ret));
+      return -1;
+    }
+    writes += framebuffer.writes;
+    bytes  += framebuffer.bytes;
+  }
+  uint32_t dirty_ms = (now_ms() - start) / FRAMES;
+  printf("dirty regions: %lu ms, %lu bytes in %lu writes per frame\n", dirty_ms, bytes / FRAMES, writes / FRAMES);
+
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/sensor_sampler.h>
+#include <libtock/tock.h>
+#include <libtock/util/fusion.h>
+
+#ifndef CPU_HZ
+#define CPU_HZ 64000000
+#endif
+
+// Gyroscope units of the board's 9-DoF driver.
+#ifndef GYRO_SCALE
+#define GYRO_SCALE LIBTOCK_FUSION_GYRO_SCALE_DPS
+#endif
+
+#define BENCH_SAMPLES 4000
+#define BATCH_LENGTH  25
+
+// Live fusion rates.
+#define SAMPLE_RATE_HZ 50
+#define OUTPUT_RATE_HZ 2
+
+// A tilted board turning slowly, in milli-g, millidegrees per second and
+// magnetometer counts.
+static const libtock_fusion_sample_t bench_data[8] = {
+  {{174, 337, 925}, {-413, 313, 10229}, {220, -40, -410}},
+  {{165, 353, 921}, {-633, -143, 11751}, {225, -37, -408}},
+  {{156, 370, 916}, {336, 70, 10562}, {230, -34, -406}},
+  {{148, 386, 910}, {289, -766, 10480}, {235, -31, -404}},
+  {{139, 403, 905}, {-874, 815, 9921}, {240, -28, -402}},
+  {{131, 419, 899}, {-369, 228, 8959}, {245, -25, -400}},
+  {{122, 435, 892}, {-508, 568, 9926}, {250, -22, -398}},
+  {{113, 451, 885}, {207, 813, 10251}, {255, -19, -396}},
+};
+
+static libtock_fusion_sample_t batch[BATCH_LENGTH];
+static uint32_t batch_length;
+
+static libtock_fusion_t fusion;
+static libtock_sensor_sampler_t sampler;
+static bool calibrated;
+
+static uint64_t ticks_to_cycles(uint32_t ticks) {
+  uint32_t frequency;
+  libtock_alarm_command_get_frequency(&frequency);
+  return (uint64_t) ticks * CPU_HZ / frequency;
+}
+
+static void fill_batch(bool mag) {
+  for (uint32_t i = 0; i < BATCH_LENGTH; i++) {
+    batch[i] = bench_data[i % 8];
+    if (!mag) memset(batch[i].mag, 0, sizeof(batch[i].mag));
+  }
+}
+
+static void measure_filter(const char* name, libtock_fusion_algorithm_t algorithm, bool mag) {
+  libtock_fusion_config_t config = {
+    .algorithm      = algorithm,
+    .sample_rate_hz = 100,
+    .output_rate_hz = 100,
+    .gyro_scale     = LIBTOCK_FUSION_GYRO_SCALE_MDPS,
+    .gain           = algorithm == LIBTOCK_FUSION_MADGWICK ? LIBTOCK_FUSION_MADGWICK_GAIN_DEFAULT :
+                      LIBTOCK_FUSION_MAHONY_GAIN_DEFAULT,
+    .integral_gain  = LIBTOCK_FUSION_MAHONY_INTEGRAL_GAIN_DEFAULT,
+    .euler          = false,
+  };
+  libtock_fusion_orientation_t outputs[BATCH_LENGTH];
+  uint32_t start, end;
+
+  libtock_fusion_init(&fusion, &config, NULL);
+  fill_batch(mag);
+
+  libtock_alarm_command_read(&start);
+  for (uint32_t i = 0; i < BENCH_SAMPLES / BATCH_LENGTH; i++) {
+    libtock_fusion_update(&fusion, batch, BATCH_LENGTH, outputs, BATCH_LENGTH);
+  }
+  libtock_alarm_command_read(&end);
+
+  uint64_t cycles = ticks_to_cycles(end - start);
+  printf("%s,%lu,%lu\n", name, (uint32_t) (cycles / BENCH_SAMPLES),
+         (uint32_t) ((uint64_t) CPU_HZ * BENCH_SAMPLES / (cycles ? cycles : 1)));
+}
+
+static void measure_euler(void) {
+  volatile int32_t sink = 0;
+  int32_t roll, pitch, yaw;
+  uint32_t start, end;
+
+  libtock_alarm_command_read(&start);
+  for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+    fusion.q[1] += 1;
+    libtock_fusion_euler(fusion.q, &roll, &pitch, &yaw);
+    sink += roll + pitch + yaw;
+  }
+  libtock_alarm_command_read(&end);
+
+  uint64_t cycles = ticks_to_cycles(end - start);
+  printf("euler conversion,%lu,%lu\n", (uint32_t) (cycles / BENCH_SAMPLES),
+         (uint32_t) ((uint64_t) CPU_HZ * BENCH_SAMPLES / (cycles ? cycles : 1)));
+}
+
+static void sampled_cb(const libtock_sensor_sampler_record_t* record, __attribute__ ((unused)) void* opaque) {
+  libtock_fusion_sample_t* sample = &batch[batch_length++];
+  libtock_fusion_orientation_t output;
+
+  memcpy(sample->accel, record->value[LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER], sizeof(sample->accel));
+  memcpy(sample->gyro, record->value[LIBTOCK_SENSOR_SAMPLER_GYROSCOPE], sizeof(sample->gyro));
+  memcpy(sample->mag, record->value[LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER], sizeof(sample->mag));
+  if (batch_length < BATCH_LENGTH) return;
+  batch_length = 0;
+
+  // The board is expected to lie still for the first batch.
+  if (!calibrated) {
+    libtock_fusion_calibration_t calibration = fusion.calibration;
+    libtock_fusion_calibrate_gyro(&calibration, batch, BATCH_LENGTH);
+    libtock_fusion_set_calibration(&fusion, &calibration);
+    libtock_fusion_reset(&fusion, &batch[BATCH_LENGTH - 1]);
+    calibrated = true;
+    printf("Gyroscope bias: %ld %ld %ld\n", calibration.gyro_bias[0], calibration.gyro_bias[1],
+           calibration.gyro_bias[2]);
+    return;
+  }
+
+  if (libtock_fusion_update(&fusion, batch, BATCH_LENGTH, &output, 1) == 1) {
+    printf("roll %ld pitch %ld yaw %ld (hundredths of a degree)\n", output.roll, output.pitch, output.yaw);
+  }
+}
+
+static void run_live(void) {
+  libtock_fusion_config_t config = {
+    .algorithm      = LIBTOCK_FUSION_MADGWICK,
+    .sample_rate_hz = SAMPLE_RATE_HZ,
+    .output_rate_hz = OUTPUT_RATE_HZ,
+    .gyro_scale     = GYRO_SCALE,
+    .gain           = LIBTOCK_FUSION_MADGWICK_GAIN_DEFAULT,
+    .euler          = true,
+  };
+
+  libtock_fusion_init(&fusion, &config, NULL);
+  libtock_sensor_sampler_init(&sampler);
+  if (libtock_sensor_sampler_configure(&sampler, LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER, 1, 10) != RETURNCODE_SUCCESS) {
+    printf("No accelerometer, skipping live fusion.\n");
+    return;
+  }
+  libtock_sensor_sampler_configure(&sampler, LIBTOCK_SENSOR_SAMPLER_GYROSCOPE, 1, 10);
+  libtock_sensor_sampler_configure(&sampler, LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER, 1, 10);
+
+  printf("Fusing 9-DoF readings at %d Hz, keep the board still for the first %d samples.\n", SAMPLE_RATE_HZ,
+         BATCH_LENGTH);
+  libtock_sensor_sampler_start(&sampler, 1000 / SAMPLE_RATE_HZ, sampled_cb, NULL);
+  while (1) {
+    yield();
+  }
+}
+
+int main(void) {
+  printf("[TEST] 9-DoF Fusion Benchmark\n");
+  printf("CPU clock assumed to be %lu Hz\n", (uint32_t) CPU_HZ);
+
+  printf("operation,cycles per update,updates per second\n");
+  measure_filter("madgwick 9-dof", LIBTOCK_FUSION_MADGWICK, true);
+  measure_filter("madgwick 6-dof", LIBTOCK_FUSION_MADGWICK, false);
+  measure_filter("mahony 9-dof", LIBTOCK_FUSION_MAHONY, true);
+  measure_filter("mahony 6-dof", LIBTOCK_FUSION_MAHONY, false);
+  measure_euler();
+
+  run_live();
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+
+#include <libtock/peripherals/gpio_events.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+// A pulse input on GPIO 0 and a rotary encoder with its A and B outputs on
+// GPIO 1 and 2.
+#define PULSE_PIN     0
+#define ENCODER_A_PIN 1
+#define ENCODER_B_PIN 2
+
+#define RING_SIZE 64
+
+static libtock_gpio_event_t ring[RING_SIZE];
+static libtock_gpio_events_t events;
+static libtock_alarm_t report_alarm;
+
+static uint32_t pulses;
+static uint32_t last_pulse;
+static uint32_t pulse_period;
+
+// Quadrature decoding: the previous and current AB state index this table.
+static const int8_t encoder_steps[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+static uint8_t encoder_state;
+static int32_t encoder_position;
+static uint32_t encoder_errors;
+
+static void encoder_update(uint32_t pin, bool level) {
+  uint8_t a = (encoder_state >> 1) & 1;
+  uint8_t b = encoder_state & 1;
+
+  if (pin == ENCODER_A_PIN) {
+    a = level;
+  } else {
+    b = level;
+  }
+
+  uint8_t next = (a << 1) | b;
+  int8_t step  = encoder_steps[(encoder_state << 2) | next];
+  // Both outputs changed at once, an edge was lost.
+  if (step == 0 && next != encoder_state) {
+    encoder_errors++;
+  }
+  encoder_position += step;
+  encoder_state     = next;
+}
+
+static void events_ready(__attribute__ ((unused)) void* opaque) {
+  libtock_gpio_event_t event;
+
+  while (libtock_gpio_events_pop(&events, &event)) {
+    if (event.pin == PULSE_PIN) {
+      if (pulses > 0) {
+        pulse_period = event.timestamp - last_pulse;
+      }
+      last_pulse = event.timestamp;
+      pulses++;
+    } else {
+      encoder_update(event.pin, event.level);
+    }
+  }
+}
+
+static void report(__attribute__ ((unused)) uint32_t now,
+                   __attribute__ ((unused)) uint32_t scheduled,
+                   __attribute__ ((unused)) void*    opaque) {
+  const libtock_gpio_events_pin_t* pulse = libtock_gpio_events_pin_stats(&events, PULSE_PIN);
+  if (pulse == NULL) return;
+
+  printf("Pulses: %lu (last period %lu ms, %lu bounces, %lu missed)\tEncoder: %ld (%lu errors)\tDropped: %lu\n",
+         pulses, libtock_alarm_ticks_to_ms(pulse_period), pulse->bounces, pulse->missed,
+         encoder_position, encoder_errors, events.dropped);
+}
+
+int main(void) {
+  int ret;
+
+  printf("[Test] GPIO Events\n");
+
+  ret = libtock_gpio_events_init(&events, ring, RING_SIZE, events_ready, NULL);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: Unable to initialize GPIO events: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+
+  // Count rising edges of a switch-like input, debounced by 5 ms.
+  ret = libtock_gpio_events_add_pin(&events, PULSE_PIN, libtock_pull_down, libtock_rising_edge, 5);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: Unable to monitor pin %d: %s\n", PULSE_PIN, tock_strrcode(ret));
+    return -1;
+  }
+
+  // Encoders need every edge of both outputs, with a short debounce.
+  ret = libtock_gpio_events_add_pin(&events, ENCODER_A_PIN, libtock_pull_up, libtock_change, 1);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: Unable to monitor pin %d: %s\n", ENCODER_A_PIN, tock_strrcode(ret));
+    return -1;
+  }
+  ret = libtock_gpio_events_add_pin(&events, ENCODER_B_PIN, libtock_pull_up, libtock_change, 1);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: Unable to monitor pin %d: %s\n", ENCODER_B_PIN, tock_strrcode(ret));
+    return -1;
+  }
+
+  const libtock_gpio_events_pin_t* encoder_a = libtock_gpio_events_pin_stats(&events, ENCODER_A_PIN);
+  const libtock_gpio_events_pin_t* encoder_b = libtock_gpio_events_pin_stats(&events, ENCODER_B_PIN);
+  if (encoder_a == NULL || encoder_b == NULL) {
+    printf("ERROR: Encoder pins are not monitored\n");
+    return -1;
+  }
+  encoder_state = (encoder_a->level << 1) | encoder_b->level;
+
+  libtock_alarm_repeating_every_ms(1000, report, NULL, &report_alarm);
+
+  while (1) {
+    yield();
+  }
+}
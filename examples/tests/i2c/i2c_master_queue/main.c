@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock/peripherals/i2c_master.h>
+#include <libtock/peripherals/i2c_master_queue.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+// Reads a block of registers from each of several sensors once per cycle,
+// first one transaction at a time with the blocking calls, then all at once
+// through the queue, and compares the time a cycle takes.
+#define SENSOR_COUNT   4
+#define REGISTER_BYTES 6
+#define CYCLES         50
+
+static const uint8_t sensor_addresses[SENSOR_COUNT] = {0x18, 0x1E, 0x40, 0x76};
+static const uint8_t sensor_registers[SENSOR_COUNT] = {0x28, 0x03, 0xE3, 0xF7};
+
+static uint8_t buffers[SENSOR_COUNT][REGISTER_BYTES];
+
+static libtock_i2c_master_queue_t queue;
+static int outstanding;
+static returncode_t first_error;
+
+static uint32_t now_ticks(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+static void transaction_done(returncode_t ret, __attribute__ ((unused)) void* opaque) {
+  if (ret != RETURNCODE_SUCCESS && first_error == RETURNCODE_SUCCESS) {
+    first_error = ret;
+  }
+  outstanding--;
+}
+
+static uint32_t cycle_blocking(void) {
+  uint32_t start = now_ticks();
+
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    buffers[i][0] = sensor_registers[i];
+    i2c_master_write_read_sync(sensor_addresses[i], buffers[i], 1, REGISTER_BYTES);
+  }
+  return now_ticks() - start;
+}
+
+static uint32_t cycle_queued(void) {
+  uint32_t start = now_ticks();
+
+  outstanding = SENSOR_COUNT;
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    buffers[i][0] = sensor_registers[i];
+    returncode_t ret = libtock_i2c_master_queue_write_read(&queue, sensor_addresses[i], buffers[i], 1,
+                                                           REGISTER_BYTES, transaction_done, NULL);
+    if (ret != RETURNCODE_SUCCESS) {
+      transaction_done(ret, NULL);
+    }
+  }
+  while (outstanding > 0) {
+    yield();
+  }
+  return now_ticks() - start;
+}
+
+int main(void) {
+  uint32_t blocking = 0;
+  uint32_t queued   = 0;
+
+  printf("[Test] I2C Master Queue\n");
+  libtock_i2c_master_queue_init(&queue);
+
+  for (int i = 0; i < CYCLES; i++) {
+    blocking += cycle_blocking();
+  }
+  for (int i = 0; i < CYCLES; i++) {
+    queued += cycle_queued();
+  }
+
+  if (first_error != RETURNCODE_SUCCESS) {
+    printf("ERROR: %s\n", tock_strrcode(first_error));
+    return -1;
+  }
+
+  printf("%d sensors, %d cycles\n", SENSOR_COUNT, CYCLES);
+  printf("Blocking: %lu us per cycle\n", libtock_alarm_ticks_to_ms(blocking * 1000 / CYCLES));
+  printf("Queued:   %lu us per cycle\n", libtock_alarm_ticks_to_ms(queued * 1000 / CYCLES));
+  printf("Transactions: %lu completed, %lu failed\n", queue.completed, queue.failed);
+  return 0;
+}
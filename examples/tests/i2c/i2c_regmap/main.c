@@ -0,0 +1,70 @@
+#include <stdio.h>
+
+#include <libtock-sync/peripherals/regmap.h>
+#include <libtock-sync/services/alarm.h>
+#include <libtock/tock.h>
+
+// Configures and polls a LIS3DH-style accelerometer through a cached
+// register map and prints how many bus transfers that took.
+#define ACCEL_ADDRESS 0x18
+
+#define REG_WHO_AM_I  0x0F
+#define REG_CTRL_REG1 0x20
+#define REG_CTRL_REG4 0x23
+#define REG_STATUS    0x27
+#define REG_OUT_X_L   0x28
+
+#define SAMPLES 20
+
+// Control registers 1 to 6 after reset.
+static const uint8_t ctrl_defaults[] = {0x07, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+static uint8_t values[0x40];
+static uint8_t flags[0x40];
+static libtocksync_regmap_t accel;
+
+int main(void) {
+  returncode_t ret;
+  uint8_t who_am_i;
+
+  printf("[Test] I2C Register Map\n");
+
+  libtocksync_regmap_config_t config = {
+    .bus         = LIBTOCKSYNC_REGMAP_I2C,
+    .i2c_address = ACCEL_ADDRESS,
+    .burst_mask  = 0x80,
+  };
+  libtocksync_regmap_init(&accel, &config, values, flags, sizeof(values));
+  libtocksync_regmap_set_volatile(&accel, REG_STATUS, 7);
+  libtocksync_regmap_set_defaults(&accel, REG_CTRL_REG1, ctrl_defaults, sizeof(ctrl_defaults));
+
+  ret = libtocksync_regmap_read(&accel, REG_WHO_AM_I, &who_am_i);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: Unable to read the device: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+  printf("WHO_AM_I: 0x%02x\n", who_am_i);
+
+  // 100 Hz, all axes, +-4 g, high resolution. Only changed registers are
+  // written, in one burst.
+  libtocksync_regmap_update_bits(&accel, REG_CTRL_REG1, 0xF0, 0x50);
+  libtocksync_regmap_update_bits(&accel, REG_CTRL_REG4, 0x30, 0x10);
+  libtocksync_regmap_update_bits(&accel, REG_CTRL_REG4, 0x08, 0x08);
+  libtocksync_regmap_sync(&accel);
+  printf("Configured with %lu reads and %lu writes\n", accel.bus_reads, accel.bus_writes);
+
+  for (int i = 0; i < SAMPLES; i++) {
+    uint8_t data[6];
+    libtocksync_alarm_delay_ms(10);
+    libtocksync_regmap_read_bulk(&accel, REG_OUT_X_L, data, sizeof(data));
+
+    int16_t x = (int16_t) (data[0] | data[1] << 8) >> 4;
+    int16_t y = (int16_t) (data[2] | data[3] << 8) >> 4;
+    int16_t z = (int16_t) (data[4] | data[5] << 8) >> 4;
+    printf("x: %d\ty: %d\tz: %d\n", x, y, z);
+  }
+
+  printf("Bus reads: %lu, bus writes: %lu, cache hits: %lu\n", accel.bus_reads, accel.bus_writes,
+         accel.cache_hits);
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libtock-sync/services/unit_test.h>
+#include <libtock-sync/storage/kv.h>
+#include <libtock-sync/storage/kv_batch.h>
+
+#define DATA_LEN 100
+
+static libtock_kv_batch_t batch;
+
+uint8_t data_buf[DATA_LEN];
+
+static bool test_coalesce(void) {
+  int ret;
+  int written;
+  const char key[] = "kvbatch_ctr";
+  uint32_t value_len;
+
+  libtock_kv_batch_init(&batch, NULL);
+
+  // Many updates of one counter collapse into a single pending write.
+  for (uint32_t i = 0; i < 50; i++) {
+    ret = libtock_kv_batch_set(&batch, (const uint8_t*) key, strlen(key), (const uint8_t*) &i, sizeof(i));
+    CHECK(ret == RETURNCODE_SUCCESS);
+  }
+  CHECK(libtock_kv_batch_pending(&batch) == 1);
+  CHECK(batch.coalesced == 49);
+
+  ret = libtocksync_kv_batch_flush(&batch, &written);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(written == 1);
+  CHECK(libtock_kv_batch_pending(&batch) == 0);
+
+  ret = libtocksync_kv_get((const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(value_len == sizeof(uint32_t));
+  uint32_t stored;
+  memcpy(&stored, data_buf, sizeof(stored));
+  CHECK(stored == 49);
+
+  return true;
+}
+
+static bool test_multiple_keys(void) {
+  int ret;
+  int written;
+  char key[16];
+  uint32_t value_len;
+
+  libtock_kv_batch_init(&batch, NULL);
+
+  for (int i = 0; i < LIBTOCK_KV_BATCH_ENTRIES; i++) {
+    snprintf(key, sizeof(key), "kvbatch_%d", i);
+    uint8_t value = (uint8_t) i;
+    ret = libtock_kv_batch_set(&batch, (const uint8_t*) key, strlen(key), &value, 1);
+    CHECK(ret == RETURNCODE_SUCCESS);
+  }
+
+  // The batch is full.
+  ret = libtock_kv_batch_set(&batch, (const uint8_t*) "kvbatch_x", 9, data_buf, 1);
+  CHECK(ret == RETURNCODE_ENOMEM);
+
+  ret = libtocksync_kv_batch_flush(&batch, &written);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(written == LIBTOCK_KV_BATCH_ENTRIES);
+
+  for (int i = 0; i < LIBTOCK_KV_BATCH_ENTRIES; i++) {
+    snprintf(key, sizeof(key), "kvbatch_%d", i);
+    ret = libtocksync_kv_get((const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+    CHECK(ret == RETURNCODE_SUCCESS);
+    CHECK(value_len == 1);
+    CHECK(data_buf[0] == (uint8_t) i);
+  }
+
+  return true;
+}
+
+static bool test_set_then_delete(void) {
+  int ret;
+  int written;
+  const char key[] = "kvbatch_tmp";
+  uint32_t value_len;
+
+  libtock_kv_batch_init(&batch, NULL);
+
+  ret = libtock_kv_batch_set(&batch, (const uint8_t*) key, strlen(key), (const uint8_t*) "v", 1);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  ret = libtock_kv_batch_delete(&batch, (const uint8_t*) key, strlen(key));
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(libtock_kv_batch_pending(&batch) == 1);
+
+  // Only the delete is issued, and it succeeds even if the key never existed.
+  ret = libtocksync_kv_batch_flush(&batch, &written);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(written == 1);
+
+  ret = libtocksync_kv_get((const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_ENOSUPPORT);
+
+  return true;
+}
+
+static bool test_flush_empty(void) {
+  int ret;
+  int written = -1;
+
+  libtock_kv_batch_init(&batch, NULL);
+
+  ret = libtocksync_kv_batch_flush(&batch, &written);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(written == 0);
+
+  return true;
+}
+
+int main(void) {
+  unit_test_fun tests[] = {
+    TEST(coalesce),
+    TEST(multiple_keys),
+    TEST(set_then_delete),
+    TEST(flush_empty),
+  };
+  unit_test_runner(tests, sizeof(tests) / sizeof(unit_test_fun), 2000, "org.tockos.unit_test");
+  return 0;
+}
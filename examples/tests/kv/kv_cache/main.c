@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libtock-sync/services/unit_test.h>
+#include <libtock-sync/storage/kv.h>
+#include <libtock-sync/storage/kv_cache.h>
+
+#define DATA_LEN 100
+
+static libtock_kv_cache_t cache;
+
+uint8_t value_buf[DATA_LEN];
+uint8_t data_buf[DATA_LEN];
+
+static bool test_miss_then_hit(void) {
+  int ret;
+  const char key[] = "kvcache_hit";
+  uint32_t value_len = 12;
+  for (uint32_t i = 0; i < value_len; i++) {
+    value_buf[i] = (uint8_t) i;
+  }
+
+  ret = libtocksync_kv_set((const uint8_t*) key, strlen(key), value_buf, value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+
+  libtock_kv_cache_init(&cache);
+
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(value_len == 12);
+  CHECK(cache.misses == 1);
+  CHECK(cache.hits == 0);
+
+  memset(data_buf, 0, DATA_LEN);
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(value_len == 12);
+  CHECK(cache.misses == 1);
+  CHECK(cache.hits == 1);
+  for (uint32_t i = 0; i < value_len; i++) {
+    CHECK(data_buf[i] == (uint8_t) i);
+  }
+
+  return true;
+}
+
+static bool test_hit_too_long(void) {
+  int ret;
+  const char key[] = "kvcache_hit";
+  uint32_t value_len = 0;
+
+  // The previous test left this key cached.
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, 2, &value_len);
+  CHECK(ret == RETURNCODE_ESIZE);
+  CHECK(value_len == 12);
+  CHECK(cache.hits == 2);
+
+  return true;
+}
+
+static bool test_write_through(void) {
+  int ret;
+  const char key[] = "kvcache_wt";
+  uint32_t value_len = 8;
+  for (uint32_t i = 0; i < value_len; i++) {
+    value_buf[i] = (uint8_t) (100 + i);
+  }
+
+  libtock_kv_cache_init(&cache);
+
+  ret = libtocksync_kv_cache_set(&cache, (const uint8_t*) key, strlen(key), value_buf, value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(value_len == 8);
+  CHECK(cache.hits == 1);
+  CHECK(cache.misses == 0);
+  for (uint32_t i = 0; i < value_len; i++) {
+    CHECK(data_buf[i] == (uint8_t) (100 + i));
+  }
+
+  return true;
+}
+
+static bool test_delete_invalidates(void) {
+  int ret;
+  const char key[] = "kvcache_wt";
+  uint32_t value_len = 0;
+
+  ret = libtocksync_kv_cache_delete(&cache, (const uint8_t*) key, strlen(key));
+  CHECK(ret == RETURNCODE_SUCCESS);
+
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_ENOSUPPORT);
+
+  return true;
+}
+
+static bool test_lru_eviction(void) {
+  int ret;
+  char key[16];
+  uint32_t value_len = 4;
+
+  libtock_kv_cache_init(&cache);
+
+  // Write one more key than the cache holds, the first one is evicted.
+  for (int i = 0; i <= LIBTOCK_KV_CACHE_ENTRIES; i++) {
+    snprintf(key, sizeof(key), "kvcache_lru%d", i);
+    memset(value_buf, i, value_len);
+    ret = libtocksync_kv_cache_set(&cache, (const uint8_t*) key, strlen(key), value_buf, value_len);
+    CHECK(ret == RETURNCODE_SUCCESS);
+  }
+
+  snprintf(key, sizeof(key), "kvcache_lru%d", 0);
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(cache.misses == 1);
+
+  snprintf(key, sizeof(key), "kvcache_lru%d", LIBTOCK_KV_CACHE_ENTRIES);
+  ret = libtocksync_kv_cache_get(&cache, (const uint8_t*) key, strlen(key), data_buf, DATA_LEN, &value_len);
+  CHECK(ret == RETURNCODE_SUCCESS);
+  CHECK(cache.hits == 1);
+  CHECK(data_buf[0] == LIBTOCK_KV_CACHE_ENTRIES);
+
+  return true;
+}
+
+int main(void) {
+  unit_test_fun tests[] = {
+    TEST(miss_then_hit),
+    TEST(hit_too_long),
+    TEST(write_through),
+    TEST(delete_invalidates),
+    TEST(lru_eviction),
+  };
+  unit_test_runner(tests, sizeof(tests) / sizeof(unit_test_fun), 2000, "org.tockos.unit_test");
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/storage/nonvolatile_storage.h>
+#include <libtock-sync/storage/nonvolatile_storage_cache.h>
+
+// Scans the first 2 kB of nonvolatile storage in 16 byte reads, once directly
+// and once through the read-ahead cache, checking that both return the same
+// data and that writes through the cache are visible to later reads.
+
+#define SCAN_LENGTH 2048
+#define READ_LENGTH 16
+
+static uint8_t cache_memory[4 * 256];
+static libtocksync_nonvolatile_storage_cache_block_t cache_blocks[4];
+static libtocksync_nonvolatile_storage_cache_t cache;
+
+static uint8_t direct[SCAN_LENGTH];
+
+int main(void) {
+  returncode_t ret;
+  int length;
+  uint8_t buf[READ_LENGTH];
+
+  printf("[TEST] Nonvolatile Storage Cache\n");
+
+  ret = libtocksync_nonvolatile_storage_cache_init(&cache, cache_memory, 256, 4, cache_blocks, 4);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR initializing cache: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < SCAN_LENGTH; i++) {
+    direct[i] = i * 7;
+  }
+  ret = libtocksync_nonvolatile_storage_write(0, SCAN_LENGTH, direct, SCAN_LENGTH, &length);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR writing test pattern: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+
+  for (uint32_t offset = 0; offset < SCAN_LENGTH; offset += READ_LENGTH) {
+    ret = libtocksync_nonvolatile_storage_cache_read(&cache, offset, READ_LENGTH, buf, READ_LENGTH, &length);
+    if (ret != RETURNCODE_SUCCESS || memcmp(buf, direct + offset, READ_LENGTH) != 0) {
+      printf("ERROR cached read at %lu does not match\n", offset);
+      return -1;
+    }
+  }
+  printf("Scanned %d bytes in %d reads with %lu storage reads (%lu hits, %lu misses)\n",
+         SCAN_LENGTH, SCAN_LENGTH / READ_LENGTH, cache.storage_reads, cache.hits, cache.misses);
+
+  // Overwrite bytes that are cached and read them back.
+  memset(buf, 0xA5, READ_LENGTH);
+  ret = libtocksync_nonvolatile_storage_cache_write(&cache, SCAN_LENGTH - 8, READ_LENGTH, buf, READ_LENGTH, &length);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR writing through cache: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+
+  memset(buf, 0, READ_LENGTH);
+  ret = libtocksync_nonvolatile_storage_cache_read(&cache, SCAN_LENGTH - 8, READ_LENGTH, buf, READ_LENGTH, &length);
+  for (int i = 0; i < READ_LENGTH; i++) {
+    if (ret != RETURNCODE_SUCCESS || buf[i] != 0xA5) {
+      printf("ERROR write through cache not visible\n");
+      return -1;
+    }
+  }
+
+  printf("All tests succeeded\n");
+  return 0;
+}
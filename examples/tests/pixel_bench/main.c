@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock/display/pixel.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/tock.h>
+
+#ifndef CPU_HZ
+#define CPU_HZ 64000000
+#endif
+
+// A row as wide as a typical small LCD, and a square image for blits.
+#define ROW_PIXELS   240
+#define IMAGE_PIXELS 32
+
+// Each measurement repeats the kernel until about this many pixels were done.
+#define PIXELS_PER_RUN 24000
+
+// Spare bytes around buffers, to run kernels at every alignment and catch
+// writes past the end.
+#define SLACK 8
+
+static const char* format_names[] = {"mono", "rgb233", "rgb565", "rgb888", "argb8888"};
+
+static uint8_t source[IMAGE_PIXELS * IMAGE_PIXELS * 4 + SLACK];
+static uint8_t destination[IMAGE_PIXELS * IMAGE_PIXELS * 4 + SLACK];
+static uint8_t expected[IMAGE_PIXELS * IMAGE_PIXELS * 4 + SLACK];
+static uint32_t colors[ROW_PIXELS];
+
+static uint32_t random_state = 1;
+
+static uint32_t next_random(void) {
+  random_state = random_state * 1664525 + 1013904223;
+  return (random_state >> 16) | (random_state << 16);
+}
+
+static void randomize(uint8_t* buffer, uint32_t length) {
+  for (uint32_t i = 0; i < length; i++) {
+    buffer[i] = next_random();
+  }
+}
+
+static uint64_t ticks_to_cycles(uint32_t ticks) {
+  uint32_t frequency;
+  libtock_alarm_command_get_frequency(&frequency);
+  return (uint64_t) ticks * CPU_HZ / frequency;
+}
+
+// Bytes taken by `count` pixels.
+static uint32_t row_bytes(libtock_screen_format_t format, uint32_t count) {
+  int bits = libtock_screen_get_bits_per_pixel(format);
+  return (count * bits + 7) / 8;
+}
+
+// Reference kernels, one pixel at a time through the ARGB conversions.
+
+static void reference_fill(libtock_screen_format_t format, uint8_t* row, uint32_t count, uint32_t pixel) {
+  for (uint32_t i = 0; i < count; i++) {
+    libtock_pixel_write(format, row, i, pixel);
+  }
+}
+
+static void reference_convert(libtock_screen_format_t destination_format, uint8_t* out,
+                              libtock_screen_format_t source_format, const uint8_t* in, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t argb = libtock_pixel_to_argb(source_format, libtock_pixel_read(source_format, in, i));
+    libtock_pixel_write(destination_format, out, i, libtock_pixel_from_argb(destination_format, argb));
+  }
+}
+
+static uint32_t mix(uint32_t source_channel, uint32_t destination_channel, uint32_t alpha) {
+  return (source_channel * alpha + destination_channel * (255 - alpha) + 127) / 255;
+}
+
+static void reference_blend_one(libtock_screen_format_t format, uint8_t* row, uint32_t index, uint32_t argb) {
+  uint32_t alpha = argb >> 24;
+  uint32_t pixel = libtock_pixel_read(format, row, index);
+  uint32_t result;
+
+  if (alpha == 0) return;
+
+  if (format == RGB_565) {
+    uint32_t alpha5 = (alpha + 4) >> 3;
+    uint32_t color  = libtock_pixel_from_argb(RGB_565, argb);
+    uint32_t r      = ((color >> 11) * alpha5 + (pixel >> 11) * (32 - alpha5)) >> 5;
+    uint32_t g      = (((color >> 5) & 0x3F) * alpha5 + ((pixel >> 5) & 0x3F) * (32 - alpha5)) >> 5;
+    uint32_t b      = ((color & 0x1F) * alpha5 + (pixel & 0x1F) * (32 - alpha5)) >> 5;
+    result = (r << 11) | (g << 5) | b;
+  } else {
+    uint32_t below = libtock_pixel_to_argb(format, pixel);
+    result = 0xFF000000;
+    for (int shift = 0; shift < 24; shift += 8) {
+      result |= mix((argb >> shift) & 0xFF, (below >> shift) & 0xFF, alpha) << shift;
+    }
+    if (format == ARGB_8888) {
+      result = (result & 0xFFFFFF) | ((alpha + ((below >> 24) * (255 - alpha) + 127) / 255) << 24);
+    }
+    result = libtock_pixel_from_argb(format, result);
+  }
+  libtock_pixel_write(format, row, index, result);
+}
+
+static void reference_blit(libtock_screen_format_t format, uint8_t* out, uint32_t out_stride, const uint8_t* in,
+                           uint32_t in_stride, uint32_t width, uint32_t height, libtock_screen_rotation_t rotation) {
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t to_x = x, to_y = y;
+      if (rotation == ROTATION_90) {
+        to_x = height - 1 - y;
+        to_y = x;
+      } else if (rotation == ROTATION_180) {
+        to_x = width - 1 - x;
+        to_y = height - 1 - y;
+      } else if (rotation == ROTATION_270) {
+        to_x = y;
+        to_y = width - 1 - x;
+      }
+      libtock_pixel_write(format, out + to_y * out_stride, to_x, libtock_pixel_read(format, in + y * in_stride, x));
+    }
+  }
+}
+
+// Compare the kernels against the references on random data, at every
+// alignment and a range of lengths. Returns the number of mismatches.
+
+static uint32_t failures;
+
+static void check(const char* kernel, libtock_screen_format_t format, uint32_t offset, uint32_t count) {
+  if (memcmp(destination, expected, sizeof(destination)) != 0) {
+    if (failures++ < 10) {
+      printf("MISMATCH %s %s offset %lu count %lu\n", kernel, format_names[format], offset, count);
+    }
+  }
+}
+
+static void start_check(void) {
+  randomize(destination, sizeof(destination));
+  memcpy(expected, destination, sizeof(destination));
+}
+
+static void verify(void) {
+  static const uint32_t counts[] = {0, 1, 2, 3, 4, 5, 7, 8, 13, 31, 64, 101};
+  static const uint32_t alphas[] = {0, 1, 7, 64, 128, 200, 254, 255};
+
+  for (int format = MONO; format <= ARGB_8888; format++) {
+    for (uint32_t offset = 0; offset < 4; offset++) {
+      for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        uint32_t count = counts[c];
+        uint32_t pixel = libtock_pixel_from_argb(format, next_random());
+
+        start_check();
+        libtock_pixel_fill(format, destination + offset, count, pixel);
+        reference_fill(format, expected + offset, count, pixel);
+        check("fill", format, offset, count);
+
+        for (int from = MONO; from <= ARGB_8888; from++) {
+          for (uint32_t source_offset = 0; source_offset < 4; source_offset++) {
+            randomize(source, sizeof(source));
+            start_check();
+            libtock_pixel_convert(format, destination + offset, from, source + source_offset, count);
+            reference_convert(format, expected + offset, from, source + source_offset, count);
+            check("convert", format, offset, count);
+          }
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+          colors[i] = next_random();
+          if (i % 3 == 0) colors[i] |= 0xFF000000;
+          if (i % 5 == 0) colors[i] &= 0x00FFFFFF;
+        }
+        start_check();
+        libtock_pixel_blend(format, destination + offset, colors, count);
+        for (uint32_t i = 0; i < count; i++) {
+          reference_blend_one(format, expected + offset, i, colors[i]);
+        }
+        check("blend", format, offset, count);
+
+        for (uint32_t a = 0; a < sizeof(alphas) / sizeof(alphas[0]); a++) {
+          uint32_t color = (alphas[a] << 24) | (next_random() & 0xFFFFFF);
+          start_check();
+          libtock_pixel_blend_color(format, destination + offset, count, color);
+          for (uint32_t i = 0; i < count; i++) {
+            reference_blend_one(format, expected + offset, i, color);
+          }
+          check("blend color", format, offset, count);
+        }
+      }
+
+      for (uint32_t width = 1; width <= 9; width += 4) {
+        for (uint32_t height = 1; height <= 10; height += 3) {
+          for (int rotation = ROTATION_NORMAL; rotation <= ROTATION_270; rotation++) {
+            bool turned         = rotation == ROTATION_90 || rotation == ROTATION_270;
+            uint32_t in_stride  = row_bytes(format, width) + offset;
+            uint32_t out_stride = row_bytes(format, turned ? height : width) + (offset & 2);
+
+            randomize(source, sizeof(source));
+            start_check();
+            libtock_pixel_blit(format, destination + offset, out_stride, source + (offset & 1), in_stride, width,
+                               height, rotation);
+            reference_blit(format, expected + offset, out_stride, source + (offset & 1), in_stride, width, height,
+                           rotation);
+            check("blit", format, offset, width * height);
+          }
+        }
+      }
+    }
+  }
+}
+
+typedef enum {
+  FILL,
+  CONVERT,
+  BLEND,
+  BLEND_COLOR,
+  BLIT_90,
+} kernel_t;
+
+static const char* kernel_names[] = {"fill", "convert from argb8888", "blend", "blend color", "blit 90"};
+
+// Run a kernel once, returns the number of pixels processed.
+static uint32_t run_once(kernel_t kernel, libtock_screen_format_t format, bool reference) {
+  uint32_t stride = row_bytes(format, IMAGE_PIXELS);
+
+  switch (kernel) {
+    case FILL:
+      if (reference) {
+        reference_fill(format, destination, ROW_PIXELS, 1);
+      } else {
+        libtock_pixel_fill(format, destination, ROW_PIXELS, 1);
+      }
+      return ROW_PIXELS;
+
+    case CONVERT:
+      if (reference) {
+        reference_convert(format, destination, ARGB_8888, source, ROW_PIXELS);
+      } else {
+        libtock_pixel_convert(format, destination, ARGB_8888, source, ROW_PIXELS);
+      }
+      return ROW_PIXELS;
+
+    case BLEND:
+      if (reference) {
+        for (uint32_t i = 0; i < ROW_PIXELS; i++) {
+          reference_blend_one(format, destination, i, colors[i]);
+        }
+      } else {
+        libtock_pixel_blend(format, destination, colors, ROW_PIXELS);
+      }
+      return ROW_PIXELS;
+
+    case BLEND_COLOR:
+      if (reference) {
+        for (uint32_t i = 0; i < ROW_PIXELS; i++) {
+          reference_blend_one(format, destination, i, 0x80336699);
+        }
+      } else {
+        libtock_pixel_blend_color(format, destination, ROW_PIXELS, 0x80336699);
+      }
+      return ROW_PIXELS;
+
+    case BLIT_90:
+      if (reference) {
+        reference_blit(format, destination, stride, source, stride, IMAGE_PIXELS, IMAGE_PIXELS, ROTATION_90);
+      } else {
+        libtock_pixel_blit(format, destination, stride, source, stride, IMAGE_PIXELS, IMAGE_PIXELS, ROTATION_90);
+      }
+      return IMAGE_PIXELS * IMAGE_PIXELS;
+  }
+  return 0;
+}
+
+// Hundredths of a cycle per pixel.
+static uint32_t measure(kernel_t kernel, libtock_screen_format_t format, bool reference) {
+  uint32_t start, end, pixels = 0;
+
+  libtock_alarm_command_read(&start);
+  while (pixels < PIXELS_PER_RUN) {
+    pixels += run_once(kernel, format, reference);
+  }
+  libtock_alarm_command_read(&end);
+
+  return (uint32_t) (ticks_to_cycles(end - start) * 100 / pixels);
+}
+
+int main(void) {
+  printf("[TEST] Pixel Kernel Benchmark\n");
+  printf("CPU clock assumed to be %lu Hz\n", (uint32_t) CPU_HZ);
+
+  verify();
+  if (failures > 0) {
+    printf("%lu kernel results differ from the reference\n", failures);
+    return -1;
+  }
+  printf("All kernels match the reference\n");
+
+  randomize(source, sizeof(source));
+  for (uint32_t i = 0; i < ROW_PIXELS; i++) {
+    colors[i] = next_random();
+  }
+
+  printf("kernel,format,cycles per pixel,reference cycles per pixel\n");
+  for (int kernel = FILL; kernel <= BLIT_90; kernel++) {
+    for (int format = MONO; format <= ARGB_8888; format++) {
+      uint32_t fast = measure(kernel, format, false);
+      uint32_t slow = measure(kernel, format, true);
+      printf("%s,%s,%lu.%02lu,%lu.%02lu\n", kernel_names[kernel], format_names[format], fast / 100, fast % 100,
+             slow / 100, slow % 100);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/storage/fat.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+
+// Writes a CSV log and a larger binary file to a FAT formatted SD card through
+// the C library, reads both back and reports the throughput.
+
+#define DATA_SIZE (64 * 1024)
+
+static libtocksync_fat_t fs;
+static uint8_t chunk[2048];
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+static int test_log(void) {
+  FILE* log = fopen("/TESTLOG.CSV", "w");
+  if (log == NULL) {
+    printf("ERROR opening TESTLOG.CSV for writing\n");
+    return -1;
+  }
+  for (int i = 0; i < 100; i++) {
+    fprintf(log, "%d,%d\n", i, i * i);
+  }
+  fclose(log);
+
+  log = fopen("/TESTLOG.CSV", "r");
+  if (log == NULL) {
+    printf("ERROR opening TESTLOG.CSV for reading\n");
+    return -1;
+  }
+  int lines = 0;
+  int index, square;
+  while (fscanf(log, "%d,%d\n", &index, &square) == 2) {
+    if (index != lines || square != lines * lines) {
+      printf("ERROR line %d reads back as %d,%d\n", lines, index, square);
+      fclose(log);
+      return -1;
+    }
+    lines++;
+  }
+  fclose(log);
+
+  printf("Wrote and read back %d log lines\n", lines);
+  return lines == 100 ? 0 : -1;
+}
+
+static int test_throughput(void) {
+  FILE* file = fopen("/TESTDATA.BIN", "w");
+  if (file == NULL) {
+    printf("ERROR opening TESTDATA.BIN for writing\n");
+    return -1;
+  }
+
+  uint32_t start = now_ms();
+  for (uint32_t pos = 0; pos < DATA_SIZE; pos += sizeof(chunk)) {
+    memset(chunk, pos / sizeof(chunk), sizeof(chunk));
+    if (fwrite(chunk, 1, sizeof(chunk), file) != sizeof(chunk)) {
+      printf("ERROR writing at %lu\n", pos);
+      fclose(file);
+      return -1;
+    }
+  }
+  fclose(file);
+  uint32_t write_ms = now_ms() - start;
+
+  file = fopen("/TESTDATA.BIN", "r");
+  if (file == NULL) {
+    printf("ERROR opening TESTDATA.BIN for reading\n");
+    return -1;
+  }
+
+  start = now_ms();
+  for (uint32_t pos = 0; pos < DATA_SIZE; pos += sizeof(chunk)) {
+    if (fread(chunk, 1, sizeof(chunk), file) != sizeof(chunk) || chunk[0] != (uint8_t) (pos / sizeof(chunk))) {
+      printf("ERROR reading at %lu\n", pos);
+      fclose(file);
+      return -1;
+    }
+  }
+  fclose(file);
+  uint32_t read_ms = now_ms() - start;
+
+  if (write_ms == 0) write_ms = 1;
+  if (read_ms == 0) read_ms = 1;
+  printf("Wrote %d kB in %lu ms (%lu kB/s)\n", DATA_SIZE / 1024, write_ms, DATA_SIZE / write_ms);
+  printf("Read %d kB in %lu ms (%lu kB/s)\n", DATA_SIZE / 1024, read_ms, DATA_SIZE / read_ms);
+  printf("Sectors read: %lu, sectors written: %lu\n", fs.sectors_read, fs.sectors_written);
+  return 0;
+}
+
+int main(void) {
+  returncode_t ret;
+
+  printf("[TEST] SD Card FAT\n");
+
+  if (!libtock_sdcard_exists()) {
+    printf("No SD card installed\n");
+    return 0;
+  }
+
+  ret = libtocksync_fat_mount(&fs);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("ERROR mounting FAT volume: %s\n", tock_strrcode(ret));
+    return -1;
+  }
+  printf("Mounted FAT%d volume with %lu clusters\n", fs.fat_type, fs.cluster_count);
+
+  if (test_log() != 0) return -1;
+  if (test_throughput() != 0) return -1;
+
+  remove("/TESTDATA.BIN");
+  libtocksync_fat_unmount(&fs);
+
+  printf("All tests succeeded\n");
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/storage/sdcard.h>
+#include <libtock-sync/storage/sdcard_queue.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/storage/sdcard_queue.h>
+#include <libtock/tock.h>
+
+// Sectors used by the test, well past the partition table and boot sector.
+#define FIRST_SECTOR 4096
+#define SECTORS      64
+#define CACHE_SECTORS 8
+
+static uint8_t cache_memory[CACHE_SECTORS * LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE];
+static libtock_sdcard_queue_slot_t cache_slots[CACHE_SECTORS];
+static libtock_sdcard_queue_t queue;
+
+// One buffer per queued write, as the queue holds the pointer until the
+// write completes.
+static uint8_t write_bufs[LIBTOCK_SDCARD_QUEUE_LENGTH][LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE];
+static uint8_t read_buf[LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE];
+
+static uint32_t next_sector = 0;
+static uint32_t completed   = 0;
+static returncode_t write_error = RETURNCODE_SUCCESS;
+
+static uint32_t now_ms(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return libtock_alarm_ticks_to_ms(ticks);
+}
+
+static void fill(uint8_t* buffer, uint32_t sector) {
+  for (int i = 0; i < LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE; i++) {
+    buffer[i] = (uint8_t) (sector * 7 + i);
+  }
+}
+
+static void write_done(returncode_t ret, void* opaque);
+
+// Queue the write of the next sector from `buffer`.
+static void submit_write(uint8_t* buffer) {
+  if (next_sector == SECTORS) return;
+
+  uint32_t sector = next_sector++;
+  fill(buffer, sector);
+  returncode_t ret = libtock_sdcard_queue_write(&queue, FIRST_SECTOR + sector, 1, buffer, write_done, buffer);
+  if (ret != RETURNCODE_SUCCESS) {
+    write_error = ret;
+  }
+}
+
+static void write_done(returncode_t ret, void* opaque) {
+  if (ret != RETURNCODE_SUCCESS) {
+    write_error = ret;
+  }
+  completed++;
+
+  // Keep the queue full by submitting the next write from the callback.
+  submit_write((uint8_t*) opaque);
+}
+
+int main(void) {
+  returncode_t ret;
+  printf("[TEST] SD Card Queue\n");
+
+  if (!libtock_sdcard_exists()) {
+    printf("No SD card installed\n");
+    return 0;
+  }
+
+  uint32_t block_size = 0;
+  uint32_t size_in_kB = 0;
+  ret = libtocksync_sdcard_initialize(&block_size, &size_in_kB);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("Init error: %d\n", ret);
+    return -1;
+  }
+
+  ret = libtock_sdcard_queue_init(&queue, cache_memory, cache_slots, CACHE_SECTORS);
+  if (ret != RETURNCODE_SUCCESS) {
+    printf("Queue init error: %d\n", ret);
+    return -1;
+  }
+
+  // Write the sectors through the queue.
+  uint32_t start = now_ms();
+  for (int i = 0; i < LIBTOCK_SDCARD_QUEUE_LENGTH; i++) {
+    submit_write(write_bufs[i]);
+  }
+  while (completed < SECTORS && write_error == RETURNCODE_SUCCESS) {
+    yield();
+  }
+  if (write_error == RETURNCODE_SUCCESS) {
+    write_error = libtocksync_sdcard_queue_flush(&queue);
+  }
+  if (write_error != RETURNCODE_SUCCESS) {
+    printf("Write error: %d\n", write_error);
+    return -1;
+  }
+  uint32_t write_ms = now_ms() - start;
+  printf("Wrote %d sectors in %lu ms, %lu blocks written\n", SECTORS, write_ms, queue.blocks_written);
+
+  // Read every sector back, the most recent ones come from the cache.
+  start = now_ms();
+  for (uint32_t sector = 0; sector < SECTORS; sector++) {
+    uint8_t expected[LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE];
+
+    ret = libtocksync_sdcard_queue_read(&queue, FIRST_SECTOR + sector, 1, read_buf);
+    if (ret != RETURNCODE_SUCCESS) {
+      printf("Read error: %d\n", ret);
+      return -1;
+    }
+    fill(expected, sector);
+    if (memcmp(read_buf, expected, sizeof(expected)) != 0) {
+      printf("Sector %lu does not match\n", FIRST_SECTOR + sector);
+      return -1;
+    }
+  }
+  uint32_t read_ms = now_ms() - start;
+  printf("Read %d sectors in %lu ms, %lu blocks read, %lu cache hits\n", SECTORS, read_ms, queue.blocks_read,
+         queue.cache_hits);
+
+  printf("All tests succeeded\n");
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/sha.h>
+#include <libtock/crypto/sha256_software.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/tock.h>
+
+#ifndef CPU_HZ
+#define CPU_HZ 64000000
+#endif
+
+// Each measurement repeats the hash until about this many bytes were hashed.
+#define BYTES_PER_RUN 32768
+
+static const uint32_t sizes[] = {16, 64, 128, 512, 4096};
+
+static uint8_t data_buf[4096];
+static uint8_t digest[LIBTOCK_SHA256_DIGEST_LENGTH];
+
+typedef enum {
+  HARDWARE,
+  SOFTWARE_SMALL,
+  SOFTWARE_FAST,
+} engine_t;
+
+static const char* engine_names[] = {"hardware", "software (small)", "software (fast)"};
+
+static uint64_t ticks_to_cycles(uint32_t ticks) {
+  uint32_t frequency;
+  libtock_alarm_command_get_frequency(&frequency);
+  return (uint64_t) ticks * CPU_HZ / frequency;
+}
+
+static returncode_t hash_once(engine_t engine, uint32_t length) {
+  libtock_sha256_software_t ctx;
+
+  switch (engine) {
+    case HARDWARE:
+      // The streaming calls always use the driver, `libtocksync_sha_simple_hash()`
+      // would hash short messages in software.
+      if (libtocksync_sha_init(LIBTOCK_SHA256) != RETURNCODE_SUCCESS) return RETURNCODE_FAIL;
+      if (libtocksync_sha_update(data_buf, length) != RETURNCODE_SUCCESS) return RETURNCODE_FAIL;
+      return libtocksync_sha_finish(digest, sizeof(digest));
+
+    case SOFTWARE_SMALL:
+      libtock_sha256_software_init(&ctx);
+      break;
+
+    case SOFTWARE_FAST:
+      libtock_sha256_software_init_fast(&ctx);
+      break;
+  }
+  libtock_sha256_software_update(&ctx, data_buf, length);
+  libtock_sha256_software_finish(&ctx, digest);
+  return RETURNCODE_SUCCESS;
+}
+
+static void measure(engine_t engine, uint32_t length) {
+  uint32_t iterations = BYTES_PER_RUN / length;
+  uint32_t start, end;
+
+  libtock_alarm_command_read(&start);
+  for (uint32_t i = 0; i < iterations; i++) {
+    if (hash_once(engine, length) != RETURNCODE_SUCCESS) {
+      printf("%s,%lu,error\n", engine_names[engine], length);
+      return;
+    }
+  }
+  libtock_alarm_command_read(&end);
+
+  uint64_t cycles = ticks_to_cycles(end - start);
+  uint64_t bytes  = (uint64_t) iterations * length;
+  if (cycles == 0) cycles = 1;
+
+  // Bytes per 1000 cycles, and cycles per byte.
+  printf("%s,%lu,%lu,%lu\n", engine_names[engine], length, (uint32_t) (bytes * 1000 / cycles),
+         (uint32_t) (cycles / bytes));
+}
+
+int main(void) {
+  printf("[TEST] SHA-256 Benchmark\n");
+  printf("CPU clock assumed to be %lu Hz\n", (uint32_t) CPU_HZ);
+
+  for (uint32_t i = 0; i < sizeof(data_buf); i++) {
+    data_buf[i] = i;
+  }
+
+  bool hardware = libtock_sha_exists();
+  if (!hardware) {
+    printf("No SHA driver, measuring software only.\n");
+  }
+
+  printf("engine,message bytes,bytes per kcycle,cycles per byte\n");
+  for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    if (hardware) measure(HARDWARE, sizes[i]);
+    measure(SOFTWARE_SMALL, sizes[i]);
+    measure(SOFTWARE_FAST, sizes[i]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/crypto/hmac.h>
+#include <libtock-sync/crypto/sha.h>
+#include <libtock/tock.h>
+
+#define DEST_LEN  32
+#define CHUNK_LEN 128
+
+static uint8_t data_buf[] = "A language empowering everyone to build reliable and efficient software.";
+static uint8_t key_buf[]  = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xA0, 0xA1};
+
+static uint8_t oneshot_buf[DEST_LEN];
+static uint8_t stream_buf[DEST_LEN];
+static uint8_t chunk_buffers[2 * CHUNK_LEN];
+
+// Reads the app's flash image a chunk at a time, as a file would be read.
+struct flash_reader {
+  const uint8_t* position;
+  const uint8_t* end;
+};
+
+static int read_flash(uint8_t* buffer, uint32_t length, void* opaque) {
+  struct flash_reader* reader = (struct flash_reader*) opaque;
+  uint32_t left = reader->end - reader->position;
+  if (length > left) length = left;
+
+  memcpy(buffer, reader->position, length);
+  reader->position += length;
+  return length;
+}
+
+static void print_digest(const char* name, uint8_t* digest) {
+  printf("%s: ", name);
+  for (int i = 0; i < DEST_LEN; i++) {
+    printf("%02x", digest[i]);
+  }
+  printf("\n");
+}
+
+// Feed `data_buf` in uneven chunks, the result must match the one-shot hash.
+static int test_sha_chunks(void) {
+  uint32_t length = strlen((char*) data_buf);
+
+  if (libtocksync_sha_simple_hash(LIBTOCK_SHA256, data_buf, length, oneshot_buf, DEST_LEN) != RETURNCODE_SUCCESS) {
+    return -1;
+  }
+
+  if (libtocksync_sha_init(LIBTOCK_SHA256) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_sha_update(data_buf, 1) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_sha_update(data_buf + 1, 30) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_sha_update(data_buf + 31, length - 31) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_sha_finish(stream_buf, DEST_LEN) != RETURNCODE_SUCCESS) return -1;
+
+  print_digest("SHA-256 (one-shot)", oneshot_buf);
+  print_digest("SHA-256 (chunked) ", stream_buf);
+  return memcmp(oneshot_buf, stream_buf, DEST_LEN) == 0 ? 0 : -1;
+}
+
+// Hash the app image straight from flash, and again through the
+// double-buffered reader.
+static int test_sha_flash(void) {
+  const uint8_t* begin = tock_app_flash_begins_at();
+  const uint8_t* end   = tock_app_flash_ends_at();
+
+  if (libtocksync_sha_init(LIBTOCK_SHA256) != RETURNCODE_SUCCESS) return -1;
+  for (const uint8_t* p = begin; p < end; p += 4096) {
+    uint32_t length = end - p < 4096 ? end - p : 4096;
+    if (libtocksync_sha_update(p, length) != RETURNCODE_SUCCESS) return -1;
+  }
+  if (libtocksync_sha_finish(oneshot_buf, DEST_LEN) != RETURNCODE_SUCCESS) return -1;
+
+  struct flash_reader reader = {.position = begin, .end = end};
+  if (libtocksync_sha_hash_stream(LIBTOCK_SHA256, read_flash, &reader, chunk_buffers, CHUNK_LEN,
+                                  stream_buf, DEST_LEN) != RETURNCODE_SUCCESS) {
+    return -1;
+  }
+
+  printf("App image: %d bytes\n", end - begin);
+  print_digest("SHA-256 (flash)   ", oneshot_buf);
+  print_digest("SHA-256 (buffered)", stream_buf);
+  return memcmp(oneshot_buf, stream_buf, DEST_LEN) == 0 ? 0 : -1;
+}
+
+static int test_hmac_chunks(void) {
+  uint32_t length = strlen((char*) data_buf);
+
+  if (libtocksync_hmac_simple(LIBTOCK_HMAC_SHA256, key_buf, sizeof(key_buf), data_buf, length,
+                              oneshot_buf, DEST_LEN) != RETURNCODE_SUCCESS) {
+    return -1;
+  }
+
+  if (libtocksync_hmac_init(LIBTOCK_HMAC_SHA256, key_buf, sizeof(key_buf)) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_hmac_update(data_buf, 17) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_hmac_update(data_buf + 17, length - 17) != RETURNCODE_SUCCESS) return -1;
+  if (libtocksync_hmac_finish(stream_buf, DEST_LEN) != RETURNCODE_SUCCESS) return -1;
+
+  print_digest("HMAC-SHA256 (one-shot)", oneshot_buf);
+  print_digest("HMAC-SHA256 (chunked) ", stream_buf);
+  return memcmp(oneshot_buf, stream_buf, DEST_LEN) == 0 ? 0 : -1;
+}
+
+int main(void) {
+  printf("[TEST] Streaming SHA and HMAC\n");
+
+  if (!libtock_sha_exists()) {
+    printf("No SHA driver.\n");
+    return -2;
+  }
+
+  if (test_sha_chunks() != 0) {
+    printf("Chunked SHA-256 failed\n");
+    return -1;
+  }
+  if (test_sha_flash() != 0) {
+    printf("Hashing the app image failed\n");
+    return -1;
+  }
+
+  if (libtock_hmac_exists()) {
+    if (test_hmac_chunks() != 0) {
+      printf("Chunked HMAC-SHA256 failed\n");
+      return -1;
+    }
+  } else {
+    printf("No HMAC driver, skipping HMAC.\n");
+  }
+
+  printf("All tests succeeded\n");
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock-sync/peripherals/spi_controller.h>
+#include <libtock/peripherals/spi_controller.h>
+#include <libtock/peripherals/spi_controller_queue.h>
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/services/alarm.h>
+#include <libtock/tock.h>
+
+// Sends the same generated payload twice: as blocking chunks, generating each
+// chunk before sending it, and as a double-buffered stream. Then sends a
+// flash-style page program command as a scatter list with chip select held.
+#define SPI_RATE      8000000
+#define PAYLOAD_BYTES 32768
+#define CHUNK_BYTES   512
+
+static uint8_t chunk[CHUNK_BYTES];
+static uint8_t stream_buffers[2 * CHUNK_BYTES];
+
+static libtock_spi_controller_queue_t queue;
+static bool done;
+static returncode_t done_ret;
+
+static uint32_t now_ticks(void) {
+  uint32_t ticks;
+  libtock_alarm_command_read(&ticks);
+  return ticks;
+}
+
+// Something that costs CPU time per byte, like rendering pixels.
+static void generate(uint8_t* buffer, size_t length, uint32_t offset) {
+  for (size_t i = 0; i < length; i++) {
+    uint32_t x = offset + i;
+    buffer[i] = (uint8_t) ((x * 2654435761u) >> 24);
+  }
+}
+
+static size_t stream_fill(uint8_t* buffer, size_t length, void* opaque) {
+  uint32_t* offset = (uint32_t*) opaque;
+
+  if (*offset + length > PAYLOAD_BYTES) {
+    length = PAYLOAD_BYTES - *offset;
+  }
+  generate(buffer, length, *offset);
+  *offset += length;
+  return length;
+}
+
+static void job_done(returncode_t ret, __attribute__ ((unused)) void* opaque) {
+  done_ret = ret;
+  done     = true;
+}
+
+static void report(const char* name, uint32_t ticks) {
+  uint32_t us = libtock_alarm_ticks_to_ms(ticks * 10) * 100;
+  if (us == 0) us = 1;
+  printf("%-10s %lu bytes in %lu us, %lu kbit/s\n", name, (uint32_t) PAYLOAD_BYTES, us,
+         (uint32_t) ((uint64_t) PAYLOAD_BYTES * 8000 / us));
+}
+
+int main(void) {
+  uint32_t start, offset;
+
+  printf("[Test] SPI Controller Queue\n");
+  libtock_spi_controller_set_rate(SPI_RATE);
+  libtock_spi_controller_queue_init(&queue);
+  printf("Clock: %d kbit/s\n", SPI_RATE / 1000);
+
+  start = now_ticks();
+  for (offset = 0; offset < PAYLOAD_BYTES; offset += CHUNK_BYTES) {
+    generate(chunk, CHUNK_BYTES, offset);
+    libtocksync_spi_controller_write(chunk, CHUNK_BYTES);
+  }
+  report("Blocking:", now_ticks() - start);
+
+  offset = 0;
+  done   = false;
+  start  = now_ticks();
+  libtock_spi_controller_queue_stream(&queue, stream_fill, stream_buffers, CHUNK_BYTES, true, job_done, &offset);
+  yield_for(&done);
+  report("Stream:", now_ticks() - start);
+  if (done_ret != RETURNCODE_SUCCESS) {
+    printf("ERROR: stream failed: %s\n", tock_strrcode(done_ret));
+    return -1;
+  }
+
+  // Write enable, then page program: command and address, then the data.
+  static uint8_t write_enable[] = {0x06};
+  static uint8_t program[]      = {0x02, 0x00, 0x10, 0x00};
+  generate(chunk, 256, 0);
+
+  libtock_spi_controller_segment_t enable_segments[] = {
+    {write_enable, NULL, sizeof(write_enable)},
+  };
+  libtock_spi_controller_segment_t program_segments[] = {
+    {program, NULL, sizeof(program)},
+    {chunk, NULL, 256},
+  };
+
+  done = false;
+  libtock_spi_controller_queue_transfer(&queue, enable_segments, 1, true, NULL, NULL);
+  libtock_spi_controller_queue_transfer(&queue, program_segments, 2, true, job_done, NULL);
+  yield_for(&done);
+  printf("Page program: %s, %lu transfers, %lu bytes in total\n", tock_strrcode(done_ret), queue.transfers,
+         queue.bytes);
+  return 0;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <libtock/peripherals/syscalls/alarm_syscalls.h>
+#include <libtock/tock.h>
+#include <libtock/util/timeseries.h>
+
+#ifndef CPU_HZ
+#define CPU_HZ 64000000
+#endif
+
+#define SERIES_LENGTH 256
+#define ROUNDS        8
+#define BLOCK_SIZE    256
+
+static uint32_t timestamps[SERIES_LENGTH];
+static int32_t values[SERIES_LENGTH][3];
+
+static uint8_t block[BLOCK_SIZE];
+static uint8_t stream[4096];
+static uint32_t stream_length;
+
+static libtock_timeseries_encoder_t encoder;
+static libtock_timeseries_decoder_t decoder;
+
+static uint32_t random_state = 1;
+
+// Small noise in -range to +range.
+static int32_t noise(int32_t range) {
+  random_state = random_state * 1664525 + 1013904223;
+  return (int32_t) ((random_state >> 16) % (2 * range + 1)) - range;
+}
+
+static uint64_t ticks_to_cycles(uint32_t ticks) {
+  uint32_t frequency;
+  libtock_alarm_command_get_frequency(&frequency);
+  return (uint64_t) ticks * CPU_HZ / frequency;
+}
+
+// Temperature and humidity in hundredths, every 10 s.
+static void generate_environment(void) {
+  int32_t temperature = 2150, humidity = 4800;
+  for (uint32_t i = 0; i < SERIES_LENGTH; i++) {
+    temperature  += noise(1) * noise(1);
+    humidity     += noise(2) / 2;
+    timestamps[i] = 1700000000 + i * 10;
+    values[i][0]  = temperature;
+    values[i][1]  = humidity;
+  }
+}
+
+// Accelerometer at rest in milli-g, sampled every 10 ms of a 32 kHz alarm
+// with a tick of jitter.
+static void generate_accelerometer(void) {
+  for (uint32_t i = 0; i < SERIES_LENGTH; i++) {
+    timestamps[i] = 0xFFFF0000u + i * 328 + noise(1);
+    values[i][0]  = 12 + noise(4);
+    values[i][1]  = -7 + noise(4);
+    values[i][2]  = 1003 + noise(4);
+  }
+}
+
+// A `float` reading in steps of a quarter degree, XOR encoded.
+static void generate_float(void) {
+  for (uint32_t i = 0; i < SERIES_LENGTH; i++) {
+    float reading = 21.5f + 0.25f * (noise(8) > 6 ? 1 : 0) + 0.25f * (int32_t) (i / 64);
+    timestamps[i] = i * 1000;
+    memcpy(&values[i][0], &reading, sizeof(reading));
+  }
+}
+
+// Encode the series into blocks appended to `stream`.
+static returncode_t encode(uint32_t channels, uint8_t xor_mask) {
+  returncode_t ret;
+
+  stream_length = 0;
+  libtock_timeseries_encoder_init(&encoder, channels, xor_mask);
+  libtock_timeseries_encoder_start(&encoder, block, BLOCK_SIZE);
+
+  for (uint32_t i = 0; i < SERIES_LENGTH; ) {
+    ret = libtock_timeseries_encoder_add(&encoder, timestamps[i], values[i]);
+    if (ret == RETURNCODE_ESIZE) {
+      uint32_t length = libtock_timeseries_encoder_finish(&encoder);
+      if (stream_length + length > sizeof(stream)) return RETURNCODE_ESIZE;
+      memcpy(stream + stream_length, block, length);
+      stream_length += length;
+      libtock_timeseries_encoder_start(&encoder, block, BLOCK_SIZE);
+      continue;
+    }
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    i++;
+  }
+
+  uint32_t length = libtock_timeseries_encoder_finish(&encoder);
+  if (stream_length + length > sizeof(stream)) return RETURNCODE_ESIZE;
+  memcpy(stream + stream_length, block, length);
+  stream_length += length;
+  return RETURNCODE_SUCCESS;
+}
+
+// Decode `stream` and return the number of samples that match the series.
+static uint32_t decode(uint32_t channels) {
+  uint32_t position = 0, matched = 0;
+  uint32_t timestamp;
+  int32_t decoded[LIBTOCK_TIMESERIES_MAX_CHANNELS];
+
+  while (position < stream_length) {
+    uint32_t length = libtock_timeseries_block_length(stream + position, stream_length - position);
+    if (length == 0) break;
+    if (libtock_timeseries_decoder_init(&decoder, stream + position, length) != RETURNCODE_SUCCESS) break;
+
+    while (libtock_timeseries_decoder_next(&decoder, &timestamp, decoded)) {
+      if (matched < SERIES_LENGTH && timestamp == timestamps[matched] &&
+          memcmp(decoded, values[matched], channels * sizeof(int32_t)) == 0) {
+        matched++;
+      }
+    }
+    position += length;
+  }
+  return matched;
+}
+
+static void measure(const char* name, uint32_t channels, uint8_t xor_mask) {
+  uint32_t start, end, matched = 0;
+  uint64_t encode_cycles, decode_cycles;
+
+  libtock_alarm_command_read(&start);
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    if (encode(channels, xor_mask) != RETURNCODE_SUCCESS) {
+      printf("%s,encoding failed\n", name);
+      return;
+    }
+  }
+  libtock_alarm_command_read(&end);
+  encode_cycles = ticks_to_cycles(end - start);
+
+  libtock_alarm_command_read(&start);
+  for (uint32_t i = 0; i < ROUNDS; i++) {
+    matched = decode(channels);
+  }
+  libtock_alarm_command_read(&end);
+  decode_cycles = ticks_to_cycles(end - start);
+
+  if (matched != SERIES_LENGTH) {
+    printf("%s,decoding failed after %lu samples\n", name, matched);
+    return;
+  }
+
+  uint32_t raw     = SERIES_LENGTH * (1 + channels) * sizeof(int32_t);
+  uint32_t ratio   = raw * 100 / stream_length;
+  uint32_t samples = SERIES_LENGTH * ROUNDS;
+  printf("%s,%lu,%lu,%lu.%02lu,%lu,%lu,%lu,%lu\n", name, raw, stream_length, ratio / 100, ratio % 100,
+         (uint32_t) (encode_cycles / samples), (uint32_t) (decode_cycles / samples),
+         (uint32_t) ((uint64_t) CPU_HZ * samples / (encode_cycles ? encode_cycles : 1)),
+         (uint32_t) ((uint64_t) CPU_HZ * samples / (decode_cycles ? decode_cycles : 1)));
+}
+
+int main(void) {
+  printf("[TEST] Time-Series Compression Benchmark\n");
+  printf("CPU clock assumed to be %lu Hz\n", (uint32_t) CPU_HZ);
+
+  printf("series,raw bytes,encoded bytes,ratio,encode cycles per sample,decode cycles per sample,"
+         "encoded samples per second,decoded samples per second\n");
+
+  generate_environment();
+  measure("temperature+humidity", 2, 0);
+  generate_accelerometer();
+  measure("accelerometer", 3, 0);
+  generate_float();
+  measure("float xor", 1, 1);
+
+  return 0;
+}
@@ -1,17 +1,34 @@
 #include <openthread/platform/entropy.h>
 
-#include <libtock-sync/peripherals/rng.h>
+#include <libtock-sync/services/entropy_pool.h>
 
 #include <stdio.h>
 
+// OpenThread asks for entropy a few bytes at a time, mostly to seed and
+// reseed its own CTR-DRBG. Serve those requests from a pool that the RNG
+// driver refills in the background instead of waiting on the driver for each
+// one. OpenThread runs its own DRBG, so it gets raw pool bytes.
+#define ENTROPY_POOL_SIZE      128
+#define ENTROPY_POOL_LOW_WATER 64
+
+static uint8_t entropy_pool_memory[ENTROPY_POOL_SIZE];
+static libtock_entropy_pool_t entropy_pool;
+static bool entropy_pool_initialized = false;
+
 otError otPlatEntropyGet(uint8_t *aOutput, uint16_t aOutputLength) {
   if (aOutput == NULL) {
     return OT_ERROR_INVALID_ARGS;
   }
 
-  // Synchronously fill buffer
-  int count;
-  int returnCode = libtocksync_rng_get_random_bytes(aOutput, (uint32_t)aOutputLength, (uint32_t)aOutputLength, &count);
+  if (!entropy_pool_initialized) {
+    if (libtock_entropy_pool_init(&entropy_pool, entropy_pool_memory, ENTROPY_POOL_SIZE,
+                                  ENTROPY_POOL_LOW_WATER) != RETURNCODE_SUCCESS) {
+      return OT_ERROR_FAILED;
+    }
+    entropy_pool_initialized = true;
+  }
+
+  int returnCode = libtocksync_entropy_pool_get(&entropy_pool, aOutput, (uint32_t)aOutputLength);
 
   if (returnCode == RETURNCODE_SUCCESS) {
     return OT_ERROR_NONE;
@@ -1,13 +1,92 @@
 #include <storage/nonvolatile_storage.h>
 #include <libtock-sync/storage/nonvolatile_storage.h>
+#include <libtock-sync/storage/nonvolatile_storage_cache.h>
 
 #include <openthread/platform/flash.h>
 
+#include <assert.h>
 #include <stdio.h>
+#include <string.h>
+
+#include "plat.h"
+
+// OpenThread keeps its settings in two swap areas at the start of the
+// nonvolatile storage region. Settings are appended as small records and a
+// swap area is erased when the settings are compacted into the other one.
+//
+// Nonvolatile storage has no erase operation, so an erase writes 0xFF over
+// the part of the swap area that was written since its last erase. That
+// extent is tracked per swap area (and found by scanning after a reset), so
+// erasing an unused swap area costs nothing.
+//
+// Small writes are collected in a write-back buffer and go out to storage as
+// one write when a write does not continue the buffered range, when the
+// buffer is full, or from `otSysProcessDrivers` at the end of each main loop
+// iteration. Reads see buffered data.
 
 const uint32_t SWAP_SIZE = 1024;
 const uint8_t SWAP_NUM = 2;
 
+// Settings lookups read the swap areas a few bytes at a time, serve them from
+// a small read-ahead cache instead of one storage read each.
+#define FLASH_CACHE_BLOCK_SIZE 128
+#define FLASH_CACHE_BLOCKS     4
+#define FLASH_CACHE_READAHEAD  4
+
+static uint8_t flash_cache_memory[FLASH_CACHE_BLOCKS * FLASH_CACHE_BLOCK_SIZE];
+static libtocksync_nonvolatile_storage_cache_block_t flash_cache_blocks[FLASH_CACHE_BLOCKS];
+static libtocksync_nonvolatile_storage_cache_t flash_cache;
+
+#define FLASH_WRITE_BUFFER_SIZE 64
+
+// Pending writes, covering `length` bytes of storage starting at `offset`.
+static struct {
+    uint32_t offset;
+    uint32_t length;
+    uint8_t data[FLASH_WRITE_BUFFER_SIZE];
+} flash_pending;
+
+#define FLASH_USED_UNKNOWN UINT32_MAX
+
+// Number of bytes at the start of each swap area that may differ from 0xFF.
+static uint32_t flash_swap_used[2] = {FLASH_USED_UNKNOWN, FLASH_USED_UNKNOWN};
+
+static uint32_t flash_swap_offset(uint8_t aSwapIndex) {
+    assert(aSwapIndex < SWAP_NUM);
+    return aSwapIndex ? SWAP_SIZE : 0;
+}
+
+static void flash_write_through(uint32_t offset, const uint8_t *data, uint32_t length) {
+    int _written;
+    libtocksync_nonvolatile_storage_cache_write(&flash_cache, offset, length, (uint8_t*)data, length, &_written);
+}
+
+void flush_pending_flash_writes(void) {
+    if (flash_pending.length == 0) {
+        return;
+    }
+
+    flash_write_through(flash_pending.offset, flash_pending.data, flash_pending.length);
+    flash_pending.length = 0;
+}
+
+// Find how much of a swap area has been written by looking for the last
+// byte that is not 0xFF.
+static uint32_t flash_scan_used(uint8_t aSwapIndex) {
+    uint8_t chunk[FLASH_CACHE_BLOCK_SIZE];
+    uint32_t used = 0;
+
+    for (uint32_t pos = 0; pos < SWAP_SIZE; pos += sizeof(chunk)) {
+        otPlatFlashRead(NULL, aSwapIndex, pos, chunk, sizeof(chunk));
+        for (uint32_t i = 0; i < sizeof(chunk); i++) {
+            if (chunk[i] != 0xFF) {
+                used = pos + i + 1;
+            }
+        }
+    }
+    return used;
+}
+
 uint32_t otPlatFlashGetSwapSize(otInstance *aInstance){
 	OT_UNUSED_VARIABLE(aInstance);
 	return SWAP_SIZE;
@@ -15,51 +94,96 @@ uint32_t otPlatFlashGetSwapSize(otInstance *aInstance){
 
 void otPlatFlashInit(otInstance *aInstance) {
     OT_UNUSED_VARIABLE(aInstance);
+
+    int ret = libtocksync_nonvolatile_storage_cache_init(&flash_cache, flash_cache_memory, FLASH_CACHE_BLOCK_SIZE,
+                                                         FLASH_CACHE_BLOCKS, flash_cache_blocks,
+                                                         FLASH_CACHE_READAHEAD);
+    if (ret != RETURNCODE_SUCCESS) {
+        printf("Initializing Flash Cache Failed!\n");
+        assert(false);
+    }
 }
 
 void otPlatFlashErase(otInstance *aInstance, uint8_t aSwapIndex) {
     OT_UNUSED_VARIABLE(aInstance);
 
-    uint32_t num_bytes;
-    libtock_nonvolatile_storage_get_number_bytes(&num_bytes);
+    uint32_t swap_offset = flash_swap_offset(aSwapIndex);
+
+    // Buffered writes to this swap area would be erased anyway.
+    if (flash_pending.length > 0 && flash_pending.offset >= swap_offset &&
+        flash_pending.offset < swap_offset + SWAP_SIZE) {
+        flash_pending.length = 0;
+    }
+
+    if (flash_swap_used[aSwapIndex] == FLASH_USED_UNKNOWN) {
+        flash_swap_used[aSwapIndex] = flash_scan_used(aSwapIndex);
+    }
 
-    // Write all zeroes to flash
-    uint8_t zeroes[SWAP_SIZE];
+    // Only the written part has to be set back to the erased value.
+    uint8_t erased[FLASH_CACHE_BLOCK_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
 
-    otPlatFlashWrite(aInstance, aSwapIndex, 0, zeroes, num_bytes);
+    uint32_t used = flash_swap_used[aSwapIndex];
+    for (uint32_t pos = 0; pos < used; pos += sizeof(erased)) {
+        uint32_t length = used - pos < sizeof(erased) ? used - pos : sizeof(erased);
+        flash_write_through(swap_offset + pos, erased, length);
+    }
 
+    flash_swap_used[aSwapIndex] = 0;
 }
 
 void otPlatFlashWrite(otInstance *aInstance, uint8_t aSwapIndex, uint32_t aOffset,
                       const void *aData, uint32_t aSize) {
     OT_UNUSED_VARIABLE(aInstance);
-    OT_UNUSED_VARIABLE(aSwapIndex);
-    int ret;
 
-    assert(aSwapIndex < SWAP_NUM);
-    uint32_t offset = aSwapIndex ? SWAP_SIZE : 0;
-    offset += aOffset;
+    uint32_t offset = flash_swap_offset(aSwapIndex) + aOffset;
 
-    int _written;
-    ret = libtocksync_nonvolatile_storage_write(offset, aSize, (uint8_t*)aData, aSize, &_written);
-    if (ret != RETURNCODE_SUCCESS) {
+    if (flash_swap_used[aSwapIndex] != FLASH_USED_UNKNOWN && aOffset + aSize > flash_swap_used[aSwapIndex]) {
+        flash_swap_used[aSwapIndex] = aOffset + aSize;
+    }
+
+    // Extend the buffered range if this write continues or overlaps it and
+    // everything still fits.
+    uint32_t pending_end = flash_pending.offset + flash_pending.length;
+    if (flash_pending.length > 0 && offset >= flash_pending.offset && offset <= pending_end) {
+        uint32_t end = offset + aSize > pending_end ? offset + aSize : pending_end;
+        if (end - flash_pending.offset <= FLASH_WRITE_BUFFER_SIZE) {
+            memcpy(flash_pending.data + (offset - flash_pending.offset), aData, aSize);
+            flash_pending.length = end - flash_pending.offset;
+            return;
+        }
+    }
+
+    flush_pending_flash_writes();
+
+    if (aSize > FLASH_WRITE_BUFFER_SIZE) {
+        flash_write_through(offset, aData, aSize);
         return;
     }
+
+    flash_pending.offset = offset;
+    flash_pending.length = aSize;
+    memcpy(flash_pending.data, aData, aSize);
 }
 
 void otPlatFlashRead(otInstance *aInstance, uint8_t aSwapIndex, uint32_t aOffset, void *aData,
                      uint32_t aSize) {
     OT_UNUSED_VARIABLE(aInstance);
-    OT_UNUSED_VARIABLE(aSwapIndex);
     int ret;
 
-    assert(aSwapIndex < SWAP_NUM);
-    uint32_t offset = aSwapIndex ? SWAP_SIZE : 0;
-    offset += aOffset;
+    uint32_t offset = flash_swap_offset(aSwapIndex) + aOffset;
 
     int _read;
-    ret = libtocksync_nonvolatile_storage_read(offset, aSize, (uint8_t*)aData, aSize, &_read);
+    ret = libtocksync_nonvolatile_storage_cache_read(&flash_cache, offset, aSize, (uint8_t*)aData, aSize, &_read);
     if (ret != RETURNCODE_SUCCESS) {
         return;
     }
+
+    // Overlay any buffered bytes that have not reached storage yet.
+    uint32_t pending_end = flash_pending.offset + flash_pending.length;
+    if (flash_pending.length > 0 && offset < pending_end && offset + aSize > flash_pending.offset) {
+        uint32_t start = offset > flash_pending.offset ? offset : flash_pending.offset;
+        uint32_t end = offset + aSize < pending_end ? offset + aSize : pending_end;
+        memcpy((uint8_t*)aData + (start - offset), flash_pending.data + (start - flash_pending.offset), end - start);
+    }
 }
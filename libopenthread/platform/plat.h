@@ -33,5 +33,8 @@ void reset_pending_rx_done_callback(void);
 // to call yield() somewhere besides the main OpenThread loop.
 bool openthread_platform_pending_work(void);
 
+// Write settings buffered by the flash PAL methods out to storage.
+void flush_pending_flash_writes(void);
+
 // Initializer needed for alarm PAL methods.
 void init_otPlatAlarm(void);
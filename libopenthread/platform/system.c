@@ -181,6 +181,9 @@ void otSysProcessDrivers(otInstance *aInstance){
     else otPlatRadioTxDone(aInstance, &txFrame, &ackFrame, OT_ERROR_ABORT);
   }
 
+  // Settings written while processing tasklets reach storage once per loop.
+  flush_pending_flash_writes();
+
 }
 
 
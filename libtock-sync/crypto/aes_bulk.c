@@ -0,0 +1,134 @@
+#include "aes_bulk.h"
+
+struct aes_bulk_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static struct aes_bulk_data result = {.fired = false};
+
+static void aes_bulk_cb(returncode_t ret, __attribute__ ((unused)) uint32_t length,
+                        __attribute__ ((unused)) void* opaque) {
+  result.fired = true;
+  result.ret   = ret;
+}
+
+returncode_t libtocksync_aes_bulk_crypt(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                        const uint8_t* key, const uint8_t* iv,
+                                        const uint8_t* input, uint8_t* output, uint32_t length) {
+  returncode_t ret;
+  libtock_aes_bulk_t op;
+
+  result.fired = false;
+
+  ret = libtock_aes_bulk_crypt(&op, algorithm, encrypting, key, iv, input, output, length,
+                               LIBTOCK_AES_BULK_CHUNK_LENGTH, aes_bulk_cb, NULL);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_aes_bulk_ccm(bool encrypting, const uint8_t* key, const uint8_t* nonce,
+                                      uint32_t nonce_length, const uint8_t* input, uint8_t* output,
+                                      uint32_t length, uint32_t a_offset, uint32_t m_offset, uint32_t mic_length) {
+  returncode_t ret;
+  libtock_aes_bulk_t op;
+
+  result.fired = false;
+
+  ret = libtock_aes_bulk_ccm(&op, encrypting, key, nonce, nonce_length, input, output, length, a_offset, m_offset,
+                             mic_length, aes_bulk_cb, NULL);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+static void aes_stream_upcall(int                            ret,
+                              __attribute__ ((unused)) int   length,
+                              __attribute__ ((unused)) int   verified,
+                              __attribute__ ((unused)) void* opaque) {
+  result.fired = true;
+  result.ret   = (returncode_t) ret;
+}
+
+// Process `length` bytes of `chunk` in place, starting the operation if
+// `first` is set.
+static returncode_t aes_stream_start(uint8_t* chunk, uint32_t length, bool first) {
+  returncode_t ret;
+
+  result.fired = false;
+
+  ret = libtock_aes_set_readonly_allow_source_buffer(chunk, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readwrite_allow_dest_buffer(chunk, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return first ? libtock_aes_setup() : libtock_aes_crypt();
+}
+
+returncode_t libtocksync_aes_bulk_stream(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                         const uint8_t* key, const uint8_t* iv,
+                                         libtocksync_aes_read_fn read, libtocksync_aes_write_fn write, void* opaque,
+                                         uint8_t* chunk_buffers, uint32_t chunk_length) {
+  returncode_t ret;
+  uint8_t* chunk = chunk_buffers;
+  uint8_t* spare = chunk_buffers + chunk_length;
+  bool first     = true;
+
+  if (algorithm == LIBTOCK_AES128CCM) return RETURNCODE_EINVAL;
+  if (chunk_length == 0 || chunk_length % LIBTOCK_AES_BLOCK_LENGTH != 0) return RETURNCODE_EINVAL;
+
+  ret = libtock_aes_set_algorithm(algorithm, encrypting);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readonly_allow_key_buffer(key, LIBTOCK_AES_BLOCK_LENGTH);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  if (algorithm != LIBTOCK_AES128ECB) {
+    ret = libtock_aes_set_readonly_allow_iv_buffer(iv, LIBTOCK_AES_BLOCK_LENGTH);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+
+  ret = libtock_aes_set_upcall(aes_stream_upcall, NULL);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  int length = read(chunk, chunk_length, opaque);
+  while (length > 0) {
+    if (algorithm != LIBTOCK_AES128Ctr && length % LIBTOCK_AES_BLOCK_LENGTH != 0) {
+      ret = RETURNCODE_EINVAL;
+      break;
+    }
+
+    ret = aes_stream_start(chunk, length, first);
+    if (ret != RETURNCODE_SUCCESS) break;
+    first = false;
+
+    // Read the next chunk while the kernel processes this one.
+    int next = read(spare, chunk_length, opaque);
+
+    yield_for(&result.fired);
+    ret = result.ret;
+    if (ret != RETURNCODE_SUCCESS) break;
+
+    if (write(chunk, length, opaque) < 0 || next < 0) {
+      ret = RETURNCODE_FAIL;
+      break;
+    }
+
+    length = next;
+    uint8_t* done = chunk;
+    chunk = spare;
+    spare = done;
+  }
+  if (length < 0) ret = RETURNCODE_FAIL;
+
+  libtock_aes_finish();
+  libtock_aes_set_readonly_allow_source_buffer(NULL, 0);
+  libtock_aes_set_readwrite_allow_dest_buffer(NULL, 0);
+  return ret;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <libtock/crypto/aes_bulk.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encrypt or decrypt `length` bytes from `input` into `output` with AES-128
+// CTR, CBC or ECB. See `libtock_aes_bulk_crypt()`.
+returncode_t libtocksync_aes_bulk_crypt(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                        const uint8_t* key, const uint8_t* iv,
+                                        const uint8_t* input, uint8_t* output, uint32_t length);
+
+// Run a confidential AES-128 CCM operation. See `libtock_aes_bulk_ccm()`.
+returncode_t libtocksync_aes_bulk_ccm(bool encrypting, const uint8_t* key, const uint8_t* nonce,
+                                      uint32_t nonce_length, const uint8_t* input, uint8_t* output,
+                                      uint32_t length, uint32_t a_offset, uint32_t m_offset, uint32_t mic_length);
+
+// Function that supplies the input of `libtocksync_aes_bulk_stream()`.
+//
+// Fills `buffer` with at most `length` bytes and returns how many it wrote,
+// 0 at the end of the input or a negative value on error.
+typedef int (*libtocksync_aes_read_fn)(uint8_t* buffer, uint32_t length, void* opaque);
+
+// Function that consumes the output of `libtocksync_aes_bulk_stream()`.
+//
+// Returns a negative value to stop with an error.
+typedef int (*libtocksync_aes_write_fn)(const uint8_t* buffer, uint32_t length, void* opaque);
+
+// Encrypt or decrypt all input returned by `read` and pass the result to
+// `write`, with AES-128 CTR, CBC or ECB.
+//
+// `chunk_buffers` must hold `2 * chunk_length` bytes and `chunk_length` must
+// be a multiple of 16. Each chunk is processed in place. While the kernel
+// processes one half, the other is drained to `write` and refilled by
+// `read`. Only the final chunk may be shorter than `chunk_length`, and only
+// in CTR mode may it be a partial block.
+returncode_t libtocksync_aes_bulk_stream(libtock_aes_algorithm_t algorithm, bool encrypting,
+                                         const uint8_t* key, const uint8_t* iv,
+                                         libtocksync_aes_read_fn read, libtocksync_aes_write_fn write, void* opaque,
+                                         uint8_t* chunk_buffers, uint32_t chunk_length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -39,3 +39,81 @@ returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
 
   return RETURNCODE_SUCCESS;
 }
+
+returncode_t libtocksync_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer,
+                                   uint32_t key_length) {
+  return libtock_hmac_init(hmac_type, key_buffer, key_length);
+}
+
+returncode_t libtocksync_hmac_update(const uint8_t* input_buffer, uint32_t input_length) {
+  returncode_t ret;
+
+  if (input_length == 0) return RETURNCODE_SUCCESS;
+
+  result.fired = false;
+
+  ret = libtock_hmac_update(input_buffer, input_length, hmac_cb_hmac);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length) {
+  returncode_t ret;
+
+  result.fired = false;
+
+  ret = libtock_hmac_finish(hmac_buffer, hmac_length, hmac_cb_hmac);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+
+  ret = libtock_hmac_set_readonly_allow_key_buffer(NULL, 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_readonly_allow_data_buffer(NULL, 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_readwrite_allow_destination_buffer(NULL, 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_hmac_stream(libtock_hmac_algorithm_t hmac_type,
+                                     const uint8_t* key_buffer, uint32_t key_length,
+                                     libtocksync_hmac_read_fn read, void* opaque,
+                                     uint8_t* chunk_buffers, uint32_t chunk_length,
+                                     uint8_t* hmac_buffer, uint32_t hmac_length) {
+  returncode_t ret;
+  uint8_t* chunk = chunk_buffers;
+  uint8_t* spare = chunk_buffers + chunk_length;
+
+  ret = libtock_hmac_init(hmac_type, key_buffer, key_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  int length = read(chunk, chunk_length, opaque);
+  while (length > 0) {
+    result.fired = false;
+
+    ret = libtock_hmac_update(chunk, length, hmac_cb_hmac);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    // Read the next chunk while the kernel processes this one.
+    length = read(spare, chunk_length, opaque);
+
+    yield_for(&result.fired);
+    if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+
+    uint8_t* done = chunk;
+    chunk = spare;
+    spare = done;
+  }
+  if (length < 0) return RETURNCODE_FAIL;
+
+  return libtocksync_hmac_finish(hmac_buffer, hmac_length);
+}
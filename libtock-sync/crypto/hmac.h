@@ -13,6 +13,32 @@ returncode_t libtocksync_hmac_simple(libtock_hmac_algorithm_t hmac_type,
                                      uint8_t* input_buffer, uint32_t input_length,
                                      uint8_t* hmac_buffer, uint32_t hmac_length);
 
+// Start a streaming HMAC. See `libtock_hmac_init()`.
+returncode_t libtocksync_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer,
+                                   uint32_t key_length);
+
+// Add `input_length` bytes to a streaming HMAC. The input may be in flash.
+returncode_t libtocksync_hmac_update(const uint8_t* input_buffer, uint32_t input_length);
+
+// Finish a streaming HMAC and store it in `hmac_buffer`.
+returncode_t libtocksync_hmac_finish(uint8_t* hmac_buffer, uint32_t hmac_length);
+
+// Function that supplies the input of `libtocksync_hmac_stream()`.
+//
+// Fills `buffer` with at most `length` bytes and returns how many it wrote,
+// 0 at the end of the input or a negative value on error.
+typedef int (*libtocksync_hmac_read_fn)(uint8_t* buffer, uint32_t length, void* opaque);
+
+// Compute an HMAC over all input returned by `read`.
+//
+// `chunk_buffers` must hold `2 * chunk_length` bytes. While the kernel
+// processes one half, `read` fills the other.
+returncode_t libtocksync_hmac_stream(libtock_hmac_algorithm_t hmac_type,
+                                     const uint8_t* key_buffer, uint32_t key_length,
+                                     libtocksync_hmac_read_fn read, void* opaque,
+                                     uint8_t* chunk_buffers, uint32_t chunk_length,
+                                     uint8_t* hmac_buffer, uint32_t hmac_length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,9 @@ returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
   yield_for(&result.fired);
   if (result.ret != RETURNCODE_SUCCESS) return result.ret;
 
+  // Nothing was shared with the driver.
+  if (libtock_sha_uses_software(hash_type, input_length)) return RETURNCODE_SUCCESS;
+
   ret = libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
@@ -34,3 +37,76 @@ returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
 
   return RETURNCODE_SUCCESS;
 }
+
+returncode_t libtocksync_sha_init(libtock_sha_algorithm_t hash_type) {
+  return libtock_sha_init(hash_type);
+}
+
+returncode_t libtocksync_sha_update(const uint8_t* input_buffer, uint32_t input_length) {
+  returncode_t ret;
+
+  if (input_length == 0) return RETURNCODE_SUCCESS;
+
+  result.fired = false;
+
+  ret = libtock_sha_update(input_buffer, input_length, sha_cb_hash);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_sha_finish(uint8_t* hash_buffer, uint32_t hash_length) {
+  returncode_t ret;
+
+  result.fired = false;
+
+  ret = libtock_sha_finish(hash_buffer, hash_length, sha_cb_hash);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+
+  ret = libtock_sha_set_readonly_allow_data_buffer(NULL, 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sha_set_readwrite_allow_destination_buffer(NULL, 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_sha_hash_stream(libtock_sha_algorithm_t hash_type,
+                                         libtocksync_sha_read_fn read, void* opaque,
+                                         uint8_t* chunk_buffers, uint32_t chunk_length,
+                                         uint8_t* hash_buffer, uint32_t hash_length) {
+  returncode_t ret;
+  uint8_t* chunk = chunk_buffers;
+  uint8_t* spare = chunk_buffers + chunk_length;
+
+  ret = libtock_sha_init(hash_type);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  int length = read(chunk, chunk_length, opaque);
+  while (length > 0) {
+    result.fired = false;
+
+    ret = libtock_sha_update(chunk, length, sha_cb_hash);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    // Read the next chunk while the kernel hashes this one.
+    length = read(spare, chunk_length, opaque);
+
+    yield_for(&result.fired);
+    if (result.ret != RETURNCODE_SUCCESS) return result.ret;
+
+    uint8_t* done = chunk;
+    chunk = spare;
+    spare = done;
+  }
+  if (length < 0) return RETURNCODE_FAIL;
+
+  return libtocksync_sha_finish(hash_buffer, hash_length);
+}
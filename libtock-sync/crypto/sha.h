@@ -12,6 +12,30 @@ returncode_t libtocksync_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                          uint8_t* input_buffer, uint32_t input_length,
                                          uint8_t* hash_buffer, uint32_t hash_length);
 
+// Start a streaming hash. See `libtock_sha_init()`.
+returncode_t libtocksync_sha_init(libtock_sha_algorithm_t hash_type);
+
+// Add `input_length` bytes to a streaming hash. The input may be in flash.
+returncode_t libtocksync_sha_update(const uint8_t* input_buffer, uint32_t input_length);
+
+// Finish a streaming hash and store it in `hash_buffer`.
+returncode_t libtocksync_sha_finish(uint8_t* hash_buffer, uint32_t hash_length);
+
+// Function that supplies the input of `libtocksync_sha_hash_stream()`.
+//
+// Fills `buffer` with at most `length` bytes and returns how many it wrote,
+// 0 at the end of the input or a negative value on error.
+typedef int (*libtocksync_sha_read_fn)(uint8_t* buffer, uint32_t length, void* opaque);
+
+// Hash all input returned by `read`.
+//
+// `chunk_buffers` must hold `2 * chunk_length` bytes. While the kernel hashes
+// one half, `read` fills the other.
+returncode_t libtocksync_sha_hash_stream(libtock_sha_algorithm_t hash_type,
+                                         libtocksync_sha_read_fn read, void* opaque,
+                                         uint8_t* chunk_buffers, uint32_t chunk_length,
+                                         uint8_t* hash_buffer, uint32_t hash_length);
+
 #ifdef __cplusplus
 }
 #endif
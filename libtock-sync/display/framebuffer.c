@@ -0,0 +1,40 @@
+#include "framebuffer.h"
+#include "screen.h"
+
+struct framebuffer_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static void framebuffer_cb(returncode_t ret, void* opaque) {
+  struct framebuffer_data* data = (struct framebuffer_data*) opaque;
+  data->ret   = ret;
+  data->fired = true;
+}
+
+returncode_t libtocksync_framebuffer_init(libtock_framebuffer_t* framebuffer, uint8_t* buffer,
+                                          uint32_t buffer_length, uint8_t* transfer, uint32_t transfer_length) {
+  libtock_screen_format_t format;
+  uint32_t width, height;
+  returncode_t ret;
+
+  ret = libtock_screen_get_resolution(&width, &height);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtocksync_screen_get_pixel_format(&format);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return libtock_framebuffer_init(framebuffer, width, height, format, buffer, buffer_length, transfer,
+                                  transfer_length);
+}
+
+returncode_t libtocksync_framebuffer_flush(libtock_framebuffer_t* framebuffer) {
+  struct framebuffer_data data = {.fired = false};
+  returncode_t ret;
+
+  ret = libtock_framebuffer_flush(framebuffer, framebuffer_cb, &data);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&data.fired);
+  return data.ret;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <libtock/display/framebuffer.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Initialize a framebuffer for the screen's current resolution and pixel
+// format. See `libtock_framebuffer_init()` for the buffers.
+returncode_t libtocksync_framebuffer_init(libtock_framebuffer_t* framebuffer, uint8_t* buffer,
+                                          uint32_t buffer_length, uint8_t* transfer, uint32_t transfer_length);
+
+// Send the dirty rectangles to the screen and wait until they are written.
+returncode_t libtocksync_framebuffer_flush(libtock_framebuffer_t* framebuffer);
+
+#ifdef __cplusplus
+}
+#endif
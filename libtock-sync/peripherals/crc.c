@@ -31,3 +31,29 @@ returncode_t libtocksync_crc_compute(const uint8_t* buf, size_t buflen, libtock_
 
   return RETURNCODE_SUCCESS;
 }
+
+returncode_t libtocksync_crc_update(libtock_crc_t* crc, const uint8_t* buf, uint32_t length) {
+  // Whether the driver exists does not change, only ask the kernel once.
+  static enum { UNKNOWN, PRESENT, MISSING } driver = UNKNOWN;
+  returncode_t ret;
+  uint32_t chunk_crc;
+
+  if (length >= LIBTOCKSYNC_CRC_HARDWARE_MIN_LENGTH) {
+    if (driver == UNKNOWN) {
+      driver = libtock_crc_exists() ? PRESENT : MISSING;
+    }
+
+    if (driver == PRESENT) {
+      ret = libtocksync_crc_compute(buf, length, crc->algorithm, &chunk_crc);
+      if (ret == RETURNCODE_SUCCESS) {
+        libtock_crc_append(crc, chunk_crc, length);
+        return RETURNCODE_SUCCESS;
+      }
+      // The driver may not take buffers this large.
+      if (ret != RETURNCODE_ESIZE) return ret;
+    }
+  }
+
+  libtock_crc_update(crc, buf, length);
+  return RETURNCODE_SUCCESS;
+}
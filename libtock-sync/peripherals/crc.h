@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libtock/peripherals/crc.h>
+#include <libtock/peripherals/crc_software.h>
 #include <libtock/tock.h>
 
 #ifdef __cplusplus
@@ -14,6 +15,18 @@ extern "C" {
 // Returns `ESIZE` if the buffer is too big for the unit.
 returncode_t libtocksync_crc_compute(const uint8_t* buf, size_t buflen, libtock_crc_alg_t algorithm, uint32_t* result);
 
+// Chunks of at least this many bytes are passed to the CRC driver by
+// `libtocksync_crc_update()`. Shorter ones take less time in software than
+// the syscalls would.
+#define LIBTOCKSYNC_CRC_HARDWARE_MIN_LENGTH 512
+
+// Add `length` bytes from `buf` to an incremental CRC started with
+// `libtock_crc_begin()`.
+//
+// Long chunks are computed by the CRC driver if there is one, everything else
+// in software, so this always succeeds unless the driver reports an error.
+returncode_t libtocksync_crc_update(libtock_crc_t* crc, const uint8_t* buf, uint32_t length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,236 @@
+#include <string.h>
+
+#include <libtock/peripherals/i2c_master.h>
+
+#include "regmap.h"
+#include "spi_controller.h"
+
+#define REGMAP_VALID    0x01
+#define REGMAP_DIRTY    0x02
+#define REGMAP_VOLATILE 0x04
+
+// Clean registers worth rewriting to join two dirty runs into one transfer.
+// Starting another transfer costs at least the device and register address.
+#define REGMAP_MAX_GAP 2
+
+static returncode_t regmap_check(libtocksync_regmap_t* map, uint32_t reg, uint32_t count) {
+  if (count == 0 || reg >= map->register_count || count > map->register_count - reg) return RETURNCODE_EINVAL;
+  return RETURNCODE_SUCCESS;
+}
+
+static uint8_t regmap_address(libtocksync_regmap_t* map, uint32_t reg, uint32_t count) {
+  return (uint8_t) (count > 1 ? reg | map->config.burst_mask : reg);
+}
+
+// Read up to `LIBTOCKSYNC_REGMAP_MAX_BURST` registers from the device.
+static returncode_t regmap_bus_read(libtocksync_regmap_t* map, uint32_t reg, uint8_t* values, uint32_t count) {
+  returncode_t ret;
+
+  map->tx[0] = regmap_address(map, reg, count);
+  map->bus_reads++;
+
+  if (map->config.bus == LIBTOCKSYNC_REGMAP_I2C) {
+    ret = i2c_master_write_read_sync(map->config.i2c_address, map->tx, 1, count);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    memcpy(values, map->tx, count);
+  } else {
+    map->tx[0] |= map->config.spi_read_mask;
+    memset(map->tx + 1, 0, count);
+    ret = libtocksync_spi_controller_read_write(map->tx, map->rx, count + 1);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    memcpy(values, map->rx + 1, count);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+// Write up to `LIBTOCKSYNC_REGMAP_MAX_BURST` registers to the device.
+static returncode_t regmap_bus_write(libtocksync_regmap_t* map, uint32_t reg, const uint8_t* values,
+                                     uint32_t count) {
+  map->tx[0] = regmap_address(map, reg, count);
+  memcpy(map->tx + 1, values, count);
+  map->bus_writes++;
+
+  if (map->config.bus == LIBTOCKSYNC_REGMAP_I2C) {
+    return i2c_master_write_sync(map->config.i2c_address, map->tx, count + 1);
+  } else {
+    return libtocksync_spi_controller_write(map->tx, count + 1);
+  }
+}
+
+// Whether reading `reg` needs the bus.
+static bool regmap_uncached(libtocksync_regmap_t* map, uint32_t reg) {
+  uint8_t flags = map->flags[reg];
+  return (flags & REGMAP_VOLATILE) || !(flags & REGMAP_VALID);
+}
+
+returncode_t libtocksync_regmap_init(libtocksync_regmap_t* map, const libtocksync_regmap_config_t* config,
+                                     uint8_t* values, uint8_t* flags, uint32_t register_count) {
+  if (register_count == 0 || register_count > 256) return RETURNCODE_EINVAL;
+
+  memset(map, 0, sizeof(libtocksync_regmap_t));
+  map->config         = *config;
+  map->register_count = register_count;
+  map->values         = values;
+  map->flags          = flags;
+  memset(flags, 0, register_count);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_regmap_set_volatile(libtocksync_regmap_t* map, uint32_t reg, uint32_t count) {
+  returncode_t ret = regmap_check(map, reg, count);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  for (uint32_t i = reg; i < reg + count; i++) {
+    map->flags[i] = REGMAP_VOLATILE;
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_regmap_set_defaults(libtocksync_regmap_t* map, uint32_t reg, const uint8_t* values,
+                                             uint32_t count) {
+  returncode_t ret = regmap_check(map, reg, count);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (map->flags[reg + i] & REGMAP_VOLATILE) continue;
+    map->values[reg + i] = values[i];
+    map->flags[reg + i]  = REGMAP_VALID;
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+void libtocksync_regmap_invalidate(libtocksync_regmap_t* map) {
+  for (uint32_t i = 0; i < map->register_count; i++) {
+    map->flags[i] &= REGMAP_VOLATILE;
+  }
+}
+
+returncode_t libtocksync_regmap_read(libtocksync_regmap_t* map, uint32_t reg, uint8_t* value) {
+  return libtocksync_regmap_read_bulk(map, reg, value, 1);
+}
+
+returncode_t libtocksync_regmap_read_bulk(libtocksync_regmap_t* map, uint32_t reg, uint8_t* values,
+                                          uint32_t count) {
+  returncode_t ret = regmap_check(map, reg, count);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Only the span from the first to the last register that is not cached has
+  // to be read.
+  uint32_t first = reg + count;
+  uint32_t last  = reg;
+  for (uint32_t i = reg; i < reg + count; i++) {
+    if (regmap_uncached(map, i)) {
+      if (first == reg + count) first = i;
+      last = i + 1;
+    }
+  }
+
+  for (uint32_t i = reg; i < reg + count; i++) {
+    if (i < first || i >= last) {
+      values[i - reg] = map->values[i];
+      map->cache_hits++;
+    }
+  }
+
+  for (uint32_t start = first; start < last; start += LIBTOCKSYNC_REGMAP_MAX_BURST) {
+    uint32_t length = last - start < LIBTOCKSYNC_REGMAP_MAX_BURST ? last - start : LIBTOCKSYNC_REGMAP_MAX_BURST;
+    uint8_t* out    = values + (start - reg);
+
+    ret = regmap_bus_read(map, start, out, length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    for (uint32_t i = start; i < start + length; i++) {
+      uint8_t flags = map->flags[i];
+      if (flags & REGMAP_DIRTY) {
+        // The pending value wins over what the device holds now.
+        out[i - start] = map->values[i];
+      } else if (!(flags & REGMAP_VOLATILE)) {
+        map->values[i] = out[i - start];
+        map->flags[i] |= REGMAP_VALID;
+      }
+    }
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_regmap_write(libtocksync_regmap_t* map, uint32_t reg, uint8_t value) {
+  return libtocksync_regmap_write_bulk(map, reg, &value, 1);
+}
+
+returncode_t libtocksync_regmap_write_bulk(libtocksync_regmap_t* map, uint32_t reg, const uint8_t* values,
+                                           uint32_t count) {
+  returncode_t ret = regmap_check(map, reg, count);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  uint32_t i = reg;
+  while (i < reg + count) {
+    if (!(map->flags[i] & REGMAP_VOLATILE)) {
+      uint8_t flags = map->flags[i];
+      uint8_t value = values[i - reg];
+      if (!(flags & REGMAP_VALID) || map->values[i] != value) {
+        map->values[i] = value;
+        map->flags[i]  = REGMAP_VALID | REGMAP_DIRTY;
+      }
+      i++;
+      continue;
+    }
+
+    // Volatile registers may trigger actions that depend on the configuration,
+    // so pending writes go first.
+    ret = libtocksync_regmap_sync(map);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    uint32_t end = i;
+    while (end < reg + count && (map->flags[end] & REGMAP_VOLATILE) && end - i < LIBTOCKSYNC_REGMAP_MAX_BURST) {
+      end++;
+    }
+    ret = regmap_bus_write(map, i, values + (i - reg), end - i);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    i = end;
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_regmap_update_bits(libtocksync_regmap_t* map, uint32_t reg, uint8_t mask, uint8_t value) {
+  uint8_t old;
+  returncode_t ret;
+
+  ret = libtocksync_regmap_read(map, reg, &old);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return libtocksync_regmap_write(map, reg, (uint8_t) ((old & ~mask) | (value & mask)));
+}
+
+returncode_t libtocksync_regmap_sync(libtocksync_regmap_t* map) {
+  uint32_t i = 0;
+
+  while (i < map->register_count) {
+    if (!(map->flags[i] & REGMAP_DIRTY)) {
+      i++;
+      continue;
+    }
+
+    // Extend the run over further dirty registers and short gaps of clean
+    // cached ones.
+    uint32_t start      = i;
+    uint32_t last_dirty = i;
+    for (uint32_t j = i + 1; j < map->register_count && j - start < LIBTOCKSYNC_REGMAP_MAX_BURST; j++) {
+      uint8_t flags = map->flags[j];
+      if (flags & REGMAP_DIRTY) {
+        last_dirty = j;
+      } else if (j - last_dirty > REGMAP_MAX_GAP || (flags & REGMAP_VOLATILE) || !(flags & REGMAP_VALID)) {
+        break;
+      }
+    }
+
+    uint32_t length  = last_dirty + 1 - start;
+    returncode_t ret = regmap_bus_write(map, start, map->values + start, length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    for (uint32_t j = start; j <= last_dirty; j++) {
+      map->flags[j] &= ~REGMAP_DIRTY;
+    }
+    i = last_dirty + 1;
+  }
+  return RETURNCODE_SUCCESS;
+}
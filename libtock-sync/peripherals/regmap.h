@@ -0,0 +1,120 @@
+#pragma once
+
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cached register map of an I2C or SPI device with 8-bit registers.
+//
+// Reads of registers that only change when written (configuration) are
+// answered from a cache after the first read. Registers marked volatile
+// (status, data, FIFOs, commands) always go to the bus.
+//
+// Writes to cached registers only update the cache and mark the register
+// dirty. `libtocksync_regmap_sync()` writes all dirty registers, merging runs
+// of neighbouring registers into one burst transfer; small gaps of clean
+// cached registers inside a run are rewritten with their cached value when
+// that is cheaper than starting another transfer. Writes to volatile registers
+// go to the bus right away. `libtocksync_regmap_update_bits()` does a
+// read-modify-write without touching the bus when the register is cached.
+//
+// Multi-register reads go out as burst reads, split at
+// `LIBTOCKSYNC_REGMAP_MAX_BURST` registers.
+//
+// For SPI devices, the chip select must be set up by the app.
+//
+// Example:
+//
+//     static uint8_t values[0x40], flags[0x40];
+//     libtocksync_regmap_config_t config = {
+//       .bus = LIBTOCKSYNC_REGMAP_I2C, .i2c_address = 0x18, .burst_mask = 0x80,
+//     };
+//     libtocksync_regmap_init(&map, &config, values, flags, sizeof(values));
+//     libtocksync_regmap_set_volatile(&map, 0x27, 7);  // status and data
+//
+//     libtocksync_regmap_update_bits(&map, 0x20, 0xF0, 0x50);  // data rate
+//     libtocksync_regmap_update_bits(&map, 0x23, 0x30, 0x10);  // range
+//     libtocksync_regmap_sync(&map);
+//
+//     libtocksync_regmap_read_bulk(&map, 0x28, sample, 6);
+
+// Largest number of registers in one bus transfer.
+#define LIBTOCKSYNC_REGMAP_MAX_BURST 32
+
+typedef enum {
+  LIBTOCKSYNC_REGMAP_I2C,
+  LIBTOCKSYNC_REGMAP_SPI,
+} libtocksync_regmap_bus_t;
+
+typedef struct {
+  libtocksync_regmap_bus_t bus;
+  // 7-bit address of an I2C device.
+  uint8_t i2c_address;
+  // Bits set in the register address of SPI reads, often 0x80.
+  uint8_t spi_read_mask;
+  // Bits set in the register address of transfers of more than one register
+  // when the device needs them to auto-increment the address.
+  uint8_t burst_mask;
+} libtocksync_regmap_config_t;
+
+typedef struct {
+  libtocksync_regmap_config_t config;
+  uint32_t register_count;
+  uint8_t* values;
+  uint8_t* flags;
+
+  // Transfer buffers: register address followed by the data.
+  uint8_t tx[LIBTOCKSYNC_REGMAP_MAX_BURST + 1];
+  uint8_t rx[LIBTOCKSYNC_REGMAP_MAX_BURST + 1];
+
+  // Statistics.
+  uint32_t cache_hits;
+  uint32_t bus_reads;
+  uint32_t bus_writes;
+} libtocksync_regmap_t;
+
+// Initialize a register map of `register_count` registers, numbered from 0.
+// `values` and `flags` must hold `register_count` bytes each. All registers
+// start out cacheable with unknown values.
+returncode_t libtocksync_regmap_init(libtocksync_regmap_t* map, const libtocksync_regmap_config_t* config,
+                                     uint8_t* values, uint8_t* flags, uint32_t register_count);
+
+// Mark `count` registers starting at `reg` as volatile.
+returncode_t libtocksync_regmap_set_volatile(libtocksync_regmap_t* map, uint32_t reg, uint32_t count);
+
+// Seed the cache with known values, such as the reset values from the data
+// sheet, so they need not be read first.
+returncode_t libtocksync_regmap_set_defaults(libtocksync_regmap_t* map, uint32_t reg, const uint8_t* values,
+                                             uint32_t count);
+
+// Forget all cached values, for example after resetting the device. Pending
+// writes are dropped.
+void libtocksync_regmap_invalidate(libtocksync_regmap_t* map);
+
+// Read one register.
+returncode_t libtocksync_regmap_read(libtocksync_regmap_t* map, uint32_t reg, uint8_t* value);
+
+// Read `count` consecutive registers starting at `reg`. Registers with pending
+// writes read as the value that will be written.
+returncode_t libtocksync_regmap_read_bulk(libtocksync_regmap_t* map, uint32_t reg, uint8_t* values,
+                                          uint32_t count);
+
+// Write one register: to the cache for cached registers, to the bus for
+// volatile ones.
+returncode_t libtocksync_regmap_write(libtocksync_regmap_t* map, uint32_t reg, uint8_t value);
+
+// Write `count` consecutive registers starting at `reg`.
+returncode_t libtocksync_regmap_write_bulk(libtocksync_regmap_t* map, uint32_t reg, const uint8_t* values,
+                                           uint32_t count);
+
+// Replace the bits of `mask` in a register with those of `value`.
+returncode_t libtocksync_regmap_update_bits(libtocksync_regmap_t* map, uint32_t reg, uint8_t mask, uint8_t value);
+
+// Write all pending register writes to the device.
+returncode_t libtocksync_regmap_sync(libtocksync_regmap_t* map);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+#include "entropy_pool.h"
+
+returncode_t libtocksync_entropy_pool_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length) {
+  returncode_t ret;
+
+  while (length > 0) {
+    // Take what the pool can hold at most, and wait for refills between
+    // pieces.
+    uint32_t n = length < pool->size ? length : pool->size;
+
+    ret = libtock_entropy_pool_get(pool, buffer, n);
+    if (ret == RETURNCODE_EBUSY) {
+      yield();
+      continue;
+    }
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    buffer += n;
+    length -= n;
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_entropy_pool_drbg_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length) {
+  returncode_t ret;
+
+  // Only seeding can be waited for, generating never blocks.
+  while ((ret = libtock_entropy_pool_drbg_get(pool, buffer, length)) == RETURNCODE_EBUSY) {
+    yield();
+  }
+  return ret;
+}
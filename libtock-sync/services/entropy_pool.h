@@ -0,0 +1,20 @@
+#pragma once
+
+#include <libtock/services/entropy_pool.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Copy `length` random bytes from the pool into `buffer`, waiting for
+// refills when the pool runs low. `length` may exceed the pool size.
+returncode_t libtocksync_entropy_pool_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length);
+
+// Fill `buffer` with `length` bytes of CTR-DRBG output, waiting for seed
+// material if the DRBG has to be seeded or reseeded.
+returncode_t libtocksync_entropy_pool_drbg_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+#include <string.h>
+
+#include "sensor_sampler.h"
+
+struct sensor_sampler_data {
+  bool fired;
+  libtock_sensor_sampler_record_t* record;
+};
+
+static void sensor_sampler_cb(const libtock_sensor_sampler_record_t* record, void* opaque) {
+  struct sensor_sampler_data* data = (struct sensor_sampler_data*) opaque;
+  memcpy(data->record, record, sizeof(libtock_sensor_sampler_record_t));
+  data->fired = true;
+}
+
+returncode_t libtocksync_sensor_sampler_sample(libtock_sensor_sampler_t* sampler,
+                                               libtock_sensor_sampler_record_t* record) {
+  struct sensor_sampler_data data = {.fired = false, .record = record};
+  returncode_t ret;
+
+  ret = libtock_sensor_sampler_sample(sampler, sensor_sampler_cb, &data);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  yield_for(&data.fired);
+  return RETURNCODE_SUCCESS;
+}
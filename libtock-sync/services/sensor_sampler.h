@@ -0,0 +1,17 @@
+#pragma once
+
+#include <libtock/services/sensor_sampler.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Run one sampling cycle on all configured sensors and wait for it to
+// complete. The results are copied to `record`.
+returncode_t libtocksync_sensor_sampler_sample(libtock_sensor_sampler_t* sampler,
+                                               libtock_sensor_sampler_record_t* record);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,10 @@ extern "C" {
 // Save the application state.
 returncode_t libtocksync_app_state_save(void);
 
+// Save the leveled application state as a new record. Returns immediately if
+// the state is unchanged.
+returncode_t libtocksync_app_state_leveled_save(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,852 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <libtock-sync/interface/console.h>
+
+#include "fat.h"
+#include "sdcard.h"
+
+#define SECTOR_SIZE LIBTOCKSYNC_FAT_SECTOR_SIZE
+#define NO_SECTOR   UINT32_MAX
+
+#define ENTRY_SIZE     32
+#define ENTRY_FREE     0xE5
+#define ATTR_READ_ONLY 0x01
+#define ATTR_VOLUME_ID 0x08
+#define ATTR_DIRECTORY 0x10
+#define ATTR_ARCHIVE   0x20
+
+#define FAT32_CLUSTER_MASK 0x0FFFFFFF
+
+// File system used by the newlib system calls at the end of this file.
+static libtocksync_fat_t* newlib_fs = NULL;
+
+static uint16_t get16(const uint8_t* buf) {
+  return buf[0] | (buf[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* buf) {
+  return get16(buf) | ((uint32_t) get16(buf + 2) << 16);
+}
+
+static void put16(uint8_t* buf, uint16_t val) {
+  buf[0] = val;
+  buf[1] = val >> 8;
+}
+
+static void put32(uint8_t* buf, uint32_t val) {
+  put16(buf, val);
+  put16(buf + 2, val >> 16);
+}
+
+// All internal functions return 0 or a negative errno value, which the newlib
+// calls hand to the C library.
+
+static int sd_read(libtocksync_fat_t* fs, uint32_t sector, uint8_t* buf) {
+  fs->sectors_read++;
+  return libtocksync_sdcard_read_block(sector, buf, SECTOR_SIZE) == RETURNCODE_SUCCESS ? 0 : -EIO;
+}
+
+static int sd_write(libtocksync_fat_t* fs, uint32_t sector, uint8_t* buf) {
+  fs->sectors_written++;
+  return libtocksync_sdcard_write_block(sector, buf, SECTOR_SIZE) == RETURNCODE_SUCCESS ? 0 : -EIO;
+}
+
+static int sector_flush(libtocksync_fat_t* fs, libtocksync_fat_sector_t* cache) {
+  int err;
+
+  if (!cache->dirty) return 0;
+
+  err = sd_write(fs, cache->sector, cache->data);
+  if (err < 0) return err;
+
+  // Keep the other copies of the FAT in step.
+  if (cache == &fs->fat_cache) {
+    for (uint32_t n = 1; n < fs->fat_count; n++) {
+      err = sd_write(fs, cache->sector + n * fs->fat_sectors, cache->data);
+      if (err < 0) return err;
+    }
+  }
+
+  cache->dirty = false;
+  return 0;
+}
+
+static int sector_load(libtocksync_fat_t* fs, libtocksync_fat_sector_t* cache, uint32_t sector) {
+  int err;
+
+  if (cache->sector == sector) return 0;
+
+  err = sector_flush(fs, cache);
+  if (err < 0) return err;
+
+  cache->sector = NO_SECTOR;
+  err = sd_read(fs, sector, cache->data);
+  if (err < 0) return err;
+
+  cache->sector = sector;
+  return 0;
+}
+
+// Transfer whole sectors between the card and `buf`, bypassing the data
+// cache. A cached copy of one of the sectors is written back first and, for
+// writes, dropped.
+static int sector_transfer(libtocksync_fat_t* fs, uint32_t sector, uint32_t count, uint8_t* buf, bool write) {
+  int err;
+  libtocksync_fat_sector_t* cache = &fs->data_cache;
+
+  if (cache->sector != NO_SECTOR && cache->sector >= sector && cache->sector < sector + count) {
+    err = sector_flush(fs, cache);
+    if (err < 0) return err;
+    if (write) {
+      cache->sector = NO_SECTOR;
+    }
+  }
+
+  for (uint32_t n = 0; n < count; n++) {
+    err = write ? sd_write(fs, sector + n, buf + n * SECTOR_SIZE) : sd_read(fs, sector + n, buf + n * SECTOR_SIZE);
+    if (err < 0) return err;
+  }
+  return 0;
+}
+
+static bool fat_is_end(libtocksync_fat_t* fs, uint32_t value) {
+  // Free and bad cluster values also end a chain, so a corrupted FAT cannot
+  // send a walk off into other files.
+  return value < 2 || (fs->fat_type == 16 ? value >= 0xFFF7 : value >= 0x0FFFFFF7);
+}
+
+static uint32_t fat_end_marker(libtocksync_fat_t* fs) {
+  return fs->fat_type == 16 ? 0xFFFF : FAT32_CLUSTER_MASK;
+}
+
+static int fat_get(libtocksync_fat_t* fs, uint32_t cluster, uint32_t* value) {
+  int err;
+  uint32_t offset = cluster * (fs->fat_type / 8);
+
+  err = sector_load(fs, &fs->fat_cache, fs->fat_start + offset / SECTOR_SIZE);
+  if (err < 0) return err;
+
+  uint8_t* entry = fs->fat_cache.data + offset % SECTOR_SIZE;
+  *value = fs->fat_type == 16 ? get16(entry) : get32(entry) & FAT32_CLUSTER_MASK;
+  return 0;
+}
+
+static int fat_set(libtocksync_fat_t* fs, uint32_t cluster, uint32_t value) {
+  int err;
+  uint32_t offset = cluster * (fs->fat_type / 8);
+
+  err = sector_load(fs, &fs->fat_cache, fs->fat_start + offset / SECTOR_SIZE);
+  if (err < 0) return err;
+
+  uint8_t* entry = fs->fat_cache.data + offset % SECTOR_SIZE;
+  if (fs->fat_type == 16) {
+    put16(entry, value);
+  } else {
+    // The top four bits are reserved and must be preserved.
+    put32(entry, (get32(entry) & ~FAT32_CLUSTER_MASK) | value);
+  }
+  fs->fat_cache.dirty = true;
+  return 0;
+}
+
+static uint32_t cluster_sector(libtocksync_fat_t* fs, uint32_t cluster) {
+  return fs->data_start + (cluster - 2) * fs->sectors_per_cluster;
+}
+
+// Allocate a free cluster and link it to the end of the chain at `previous`,
+// if not 0. The cluster right after `previous` is preferred so that files
+// stay contiguous.
+static int cluster_allocate(libtocksync_fat_t* fs, uint32_t previous, uint32_t* cluster) {
+  int err;
+  uint32_t start = previous != 0 ? previous + 1 : fs->next_free;
+
+  for (uint32_t n = 0; n < fs->cluster_count; n++) {
+    uint32_t candidate = 2 + (start - 2 + n) % fs->cluster_count;
+    uint32_t value;
+
+    err = fat_get(fs, candidate, &value);
+    if (err < 0) return err;
+    if (value != 0) continue;
+
+    err = fat_set(fs, candidate, fat_end_marker(fs));
+    if (err < 0) return err;
+
+    if (previous != 0) {
+      err = fat_set(fs, previous, candidate);
+      if (err < 0) return err;
+    }
+
+    fs->next_free = candidate + 1;
+    *cluster      = candidate;
+    return 0;
+  }
+  return -ENOSPC;
+}
+
+static int cluster_free_chain(libtocksync_fat_t* fs, uint32_t cluster) {
+  int err;
+
+  while (!fat_is_end(fs, cluster)) {
+    uint32_t next;
+    err = fat_get(fs, cluster, &next);
+    if (err < 0) return err;
+
+    err = fat_set(fs, cluster, 0);
+    if (err < 0) return err;
+    cluster = next;
+  }
+  return 0;
+}
+
+// Cluster of the root directory, 0 for the fixed FAT16 root directory.
+static uint32_t root_dir(libtocksync_fat_t* fs) {
+  return fs->fat_type == 16 ? 0 : fs->root_cluster;
+}
+
+static uint32_t entry_cluster(libtocksync_fat_t* fs, const uint8_t* entry) {
+  uint32_t cluster = get16(entry + 26);
+  if (fs->fat_type == 32) {
+    cluster |= (uint32_t) get16(entry + 20) << 16;
+  }
+  return cluster;
+}
+
+// Find sector `n` of the directory starting at `dir`. Returns -ENOENT past
+// the end, unless `extend` is set, in which case an empty cluster is added.
+static int dir_sector(libtocksync_fat_t* fs, uint32_t dir, uint32_t n, uint32_t* sector, bool extend) {
+  int err;
+
+  if (dir == 0) {
+    if (n >= fs->root_sectors) return extend ? -ENOSPC : -ENOENT;
+    *sector = fs->root_start + n;
+    return 0;
+  }
+
+  uint32_t cluster = dir;
+  for (uint32_t k = n / fs->sectors_per_cluster; k > 0; k--) {
+    uint32_t next;
+    err = fat_get(fs, cluster, &next);
+    if (err < 0) return err;
+
+    if (fat_is_end(fs, next)) {
+      if (!extend) return -ENOENT;
+
+      err = cluster_allocate(fs, cluster, &next);
+      if (err < 0) return err;
+
+      // New directory clusters must read as empty.
+      libtocksync_fat_sector_t* cache = &fs->data_cache;
+      err = sector_flush(fs, cache);
+      if (err < 0) return err;
+      memset(cache->data, 0, SECTOR_SIZE);
+      for (uint32_t s = 0; s < fs->sectors_per_cluster; s++) {
+        cache->sector = cluster_sector(fs, next) + s;
+        err = sd_write(fs, cache->sector, cache->data);
+        if (err < 0) {
+          cache->sector = NO_SECTOR;
+          return err;
+        }
+      }
+    }
+    cluster = next;
+  }
+
+  *sector = cluster_sector(fs, cluster) + n % fs->sectors_per_cluster;
+  return 0;
+}
+
+// Look for the entry called `name` in the directory at `dir`. If it is not
+// found, `sector` and `offset` point at a free entry instead, the directory
+// is extended when it is full and `create` is set, or `sector` is
+// `NO_SECTOR`.
+static int dir_find(libtocksync_fat_t* fs, uint32_t dir, const uint8_t* name, bool create, bool* found,
+                    uint32_t* sector, uint32_t* offset) {
+  int err;
+  uint32_t n;
+
+  *found  = false;
+  *sector = NO_SECTOR;
+
+  for (n = 0; ; n++) {
+    uint32_t s;
+    err = dir_sector(fs, dir, n, &s, false);
+    if (err == -ENOENT) break;
+    if (err < 0) return err;
+
+    err = sector_load(fs, &fs->data_cache, s);
+    if (err < 0) return err;
+
+    for (uint32_t off = 0; off < SECTOR_SIZE; off += ENTRY_SIZE) {
+      const uint8_t* entry = fs->data_cache.data + off;
+
+      if (entry[0] == 0 || entry[0] == ENTRY_FREE) {
+        if (*sector == NO_SECTOR) {
+          *sector = s;
+          *offset = off;
+        }
+        // A zero first byte marks the end of the directory.
+        if (entry[0] == 0) return 0;
+        continue;
+      }
+
+      // Skip long file name entries and the volume label.
+      if (entry[11] & ATTR_VOLUME_ID) continue;
+
+      if (memcmp(entry, name, 11) == 0) {
+        *found  = true;
+        *sector = s;
+        *offset = off;
+        return 0;
+      }
+    }
+  }
+
+  if (*sector == NO_SECTOR && create) {
+    err = dir_sector(fs, dir, n, sector, true);
+    if (err < 0) return err;
+    *offset = 0;
+  }
+  return 0;
+}
+
+// Convert one path component to a space padded 8.3 directory entry name.
+static int name_to_entry(const char* component, uint32_t len, uint8_t* name) {
+  uint32_t pos = 0;
+  uint32_t limit = 8;
+
+  memset(name, ' ', 11);
+
+  // "." and ".." are stored as they are.
+  if ((len == 1 || len == 2) && component[0] == '.' && component[len - 1] == '.') {
+    memcpy(name, component, len);
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < len; i++) {
+    char c = component[i];
+
+    if (c == '.' && limit == 8 && i > 0) {
+      pos   = 8;
+      limit = 11;
+      continue;
+    }
+    if (c <= ' ' || strchr("\"*+,./:;<=>?[\\]|", c) != NULL) return -EINVAL;
+    if (pos == limit) return -ENAMETOOLONG;
+
+    name[pos++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+  }
+  return pos > 0 ? 0 : -EINVAL;
+}
+
+// Resolve all but the last component of `path` to a directory and return the
+// entry name for the last component.
+static int path_resolve(libtocksync_fat_t* fs, const char* path, uint32_t* dir, uint8_t* name) {
+  int err;
+
+  *dir = root_dir(fs);
+  while (true) {
+    while (*path == '/') {
+      path++;
+    }
+
+    const char* end = strchr(path, '/');
+    uint32_t len    = end != NULL ? (uint32_t) (end - path) : strlen(path);
+    if (len == 0) return -EISDIR;
+
+    err = name_to_entry(path, len, name);
+    if (err < 0) return err;
+
+    // Stop at the last component, allowing a trailing slash only for
+    // directories, which cannot be opened.
+    const char* rest = path + len;
+    while (*rest == '/') {
+      rest++;
+    }
+    if (*rest == '\0') return end != NULL ? -EISDIR : 0;
+
+    bool found;
+    uint32_t sector, offset;
+    err = dir_find(fs, *dir, name, false, &found, &sector, &offset);
+    if (err < 0) return err;
+    if (!found) return -ENOENT;
+
+    const uint8_t* entry = fs->data_cache.data + offset;
+    if (!(entry[11] & ATTR_DIRECTORY)) return -ENOTDIR;
+
+    // ".." of a first level directory points at cluster 0.
+    *dir = entry_cluster(fs, entry);
+    if (*dir == 0) {
+      *dir = root_dir(fs);
+    }
+    path = rest;
+  }
+}
+
+// Find the cluster holding byte `position` of `file`, extending the chain if
+// `allocate` is set.
+static int file_cluster(libtocksync_fat_t* fs, libtocksync_fat_file_t* file, uint32_t position, bool allocate,
+                        uint32_t* cluster) {
+  int err;
+  uint32_t index = position / (fs->sectors_per_cluster * SECTOR_SIZE);
+
+  if (file->first_cluster == 0) {
+    if (!allocate) return -EIO;
+
+    err = cluster_allocate(fs, 0, &file->first_cluster);
+    if (err < 0) return err;
+    file->entry_dirty   = true;
+    file->chain_cluster = 0;
+  }
+
+  // Continue from the cached chain position unless it is past `position`.
+  if (file->chain_cluster == 0 || index < file->chain_index) {
+    file->chain_index   = 0;
+    file->chain_cluster = file->first_cluster;
+  }
+
+  while (file->chain_index < index) {
+    uint32_t next;
+    err = fat_get(fs, file->chain_cluster, &next);
+    if (err < 0) return err;
+
+    if (fat_is_end(fs, next)) {
+      if (!allocate) return -EIO;
+
+      err = cluster_allocate(fs, file->chain_cluster, &next);
+      if (err < 0) return err;
+    }
+
+    file->chain_cluster = next;
+    file->chain_index++;
+  }
+
+  *cluster = file->chain_cluster;
+  return 0;
+}
+
+// Read or write up to `count` bytes at the file position. Returns the number
+// of bytes transferred or a negative errno value.
+static int file_transfer(libtocksync_fat_t* fs, libtocksync_fat_file_t* file, uint8_t* buf, uint32_t count,
+                         bool write) {
+  int err = 0;
+  uint32_t done = 0;
+  uint32_t cluster_size = fs->sectors_per_cluster * SECTOR_SIZE;
+
+  while (done < count) {
+    uint32_t position = file->position;
+    uint32_t cluster;
+
+    err = file_cluster(fs, file, position, write, &cluster);
+    if (err < 0) break;
+
+    uint32_t in_cluster = position % cluster_size;
+    uint32_t in_sector  = position % SECTOR_SIZE;
+    uint32_t sector     = cluster_sector(fs, cluster) + in_cluster / SECTOR_SIZE;
+    uint32_t chunk;
+
+    if (in_sector == 0 && count - done >= SECTOR_SIZE) {
+      // Whole sectors go directly to or from the caller's buffer.
+      uint32_t sectors = (count - done) / SECTOR_SIZE;
+      uint32_t left    = fs->sectors_per_cluster - in_cluster / SECTOR_SIZE;
+      if (sectors > left) sectors = left;
+
+      err = sector_transfer(fs, sector, sectors, buf + done, write);
+      if (err < 0) break;
+      chunk = sectors * SECTOR_SIZE;
+    } else {
+      libtocksync_fat_sector_t* cache = &fs->data_cache;
+      chunk = SECTOR_SIZE - in_sector;
+      if (chunk > count - done) chunk = count - done;
+
+      if (write && in_sector == 0 && position >= file->size) {
+        // Nothing of the file is in this sector yet, so skip reading it.
+        err = sector_flush(fs, cache);
+        if (err < 0) break;
+        memset(cache->data, 0, SECTOR_SIZE);
+        cache->sector = sector;
+      } else {
+        err = sector_load(fs, cache, sector);
+        if (err < 0) break;
+      }
+
+      if (write) {
+        memcpy(cache->data + in_sector, buf + done, chunk);
+        cache->dirty = true;
+      } else {
+        memcpy(buf + done, cache->data + in_sector, chunk);
+      }
+    }
+
+    done          += chunk;
+    file->position = position + chunk;
+    if (file->position > file->size) {
+      file->size        = file->position;
+      file->entry_dirty = true;
+    }
+  }
+
+  return done > 0 ? (int) done : err;
+}
+
+// Write the size and first cluster of `file` to its directory entry.
+static int file_sync(libtocksync_fat_t* fs, libtocksync_fat_file_t* file) {
+  int err;
+
+  if (!file->entry_dirty) return 0;
+
+  err = sector_load(fs, &fs->data_cache, file->entry_sector);
+  if (err < 0) return err;
+
+  uint8_t* entry = fs->data_cache.data + file->entry_offset;
+  put16(entry + 26, file->first_cluster);
+  if (fs->fat_type == 32) {
+    put16(entry + 20, file->first_cluster >> 16);
+  }
+  put32(entry + 28, file->size);
+  fs->data_cache.dirty = true;
+
+  file->entry_dirty = false;
+  return 0;
+}
+
+static int fs_sync(libtocksync_fat_t* fs) {
+  int err;
+
+  for (int i = 0; i < LIBTOCKSYNC_FAT_MAX_FILES; i++) {
+    if (fs->files[i].open) {
+      err = file_sync(fs, &fs->files[i]);
+      if (err < 0) return err;
+    }
+  }
+
+  err = sector_flush(fs, &fs->fat_cache);
+  if (err < 0) return err;
+  return sector_flush(fs, &fs->data_cache);
+}
+
+static libtocksync_fat_file_t* fs_file(libtocksync_fat_t* fs, int fd) {
+  int slot = fd - LIBTOCKSYNC_FAT_FIRST_FD;
+  if (fs == NULL || slot < 0 || slot >= LIBTOCKSYNC_FAT_MAX_FILES) return NULL;
+  return fs->files[slot].open ? &fs->files[slot] : NULL;
+}
+
+// Open a file, returning its file descriptor.
+static int fs_open(libtocksync_fat_t* fs, const char* path, int flags) {
+  int err;
+  bool writable = (flags & O_ACCMODE) != O_RDONLY;
+
+  int slot;
+  for (slot = 0; slot < LIBTOCKSYNC_FAT_MAX_FILES; slot++) {
+    if (!fs->files[slot].open) break;
+  }
+  if (slot == LIBTOCKSYNC_FAT_MAX_FILES) return -EMFILE;
+
+  uint32_t dir;
+  uint8_t name[11];
+  err = path_resolve(fs, path, &dir, name);
+  if (err < 0) return err;
+
+  bool found;
+  uint32_t sector, offset;
+  err = dir_find(fs, dir, name, flags & O_CREAT, &found, &sector, &offset);
+  if (err < 0) return err;
+
+  if (!found && !(flags & O_CREAT)) return -ENOENT;
+  if (found && (flags & O_CREAT) && (flags & O_EXCL)) return -EEXIST;
+  if (sector == NO_SECTOR) return -ENOSPC;
+
+  // Two handles to the same file would each keep their own size.
+  for (int i = 0; i < LIBTOCKSYNC_FAT_MAX_FILES; i++) {
+    libtocksync_fat_file_t* other = &fs->files[i];
+    if (other->open && other->entry_sector == sector && other->entry_offset == offset) return -EBUSY;
+  }
+
+  err = sector_load(fs, &fs->data_cache, sector);
+  if (err < 0) return err;
+  uint8_t* entry = fs->data_cache.data + offset;
+
+  libtocksync_fat_file_t* file = &fs->files[slot];
+  memset(file, 0, sizeof(libtocksync_fat_file_t));
+  file->flags        = flags;
+  file->entry_sector = sector;
+  file->entry_offset = offset;
+
+  if (found) {
+    if (entry[11] & ATTR_DIRECTORY) return -EISDIR;
+    if (writable && (entry[11] & ATTR_READ_ONLY)) return -EACCES;
+
+    file->first_cluster = entry_cluster(fs, entry);
+    file->size          = get32(entry + 28);
+  } else {
+    memset(entry, 0, ENTRY_SIZE);
+    memcpy(entry, name, 11);
+    entry[11] = ATTR_ARCHIVE;
+    fs->data_cache.dirty = true;
+  }
+
+  // An empty file may still own clusters.
+  if (writable && (flags & O_TRUNC) && (file->first_cluster != 0 || file->size > 0)) {
+    err = cluster_free_chain(fs, file->first_cluster);
+    if (err < 0) return err;
+
+    file->first_cluster = 0;
+    file->size          = 0;
+    file->entry_dirty   = true;
+  }
+
+  file->open = true;
+  return LIBTOCKSYNC_FAT_FIRST_FD + slot;
+}
+
+static int fs_close(libtocksync_fat_t* fs, libtocksync_fat_file_t* file) {
+  int err = file_sync(fs, file);
+  file->open = false;
+  if (err < 0) return err;
+
+  return fs_sync(fs);
+}
+
+static int fs_unlink(libtocksync_fat_t* fs, const char* path) {
+  int err;
+
+  uint32_t dir;
+  uint8_t name[11];
+  err = path_resolve(fs, path, &dir, name);
+  if (err < 0) return err;
+
+  bool found;
+  uint32_t sector, offset;
+  err = dir_find(fs, dir, name, false, &found, &sector, &offset);
+  if (err < 0) return err;
+  if (!found) return -ENOENT;
+
+  for (int i = 0; i < LIBTOCKSYNC_FAT_MAX_FILES; i++) {
+    libtocksync_fat_file_t* file = &fs->files[i];
+    if (file->open && file->entry_sector == sector && file->entry_offset == offset) return -EBUSY;
+  }
+
+  uint8_t* entry = fs->data_cache.data + offset;
+  if (entry[11] & ATTR_DIRECTORY) return -EISDIR;
+
+  uint32_t cluster = entry_cluster(fs, entry);
+  entry[0] = ENTRY_FREE;
+  fs->data_cache.dirty = true;
+
+  if (cluster != 0) {
+    err = cluster_free_chain(fs, cluster);
+    if (err < 0) return err;
+  }
+  return fs_sync(fs);
+}
+
+// A boot sector with a BIOS parameter block we can use.
+static bool boot_sector_valid(const uint8_t* boot) {
+  uint8_t sectors_per_cluster = boot[13];
+
+  return get16(boot + 510) == 0xAA55 && get16(boot + 11) == SECTOR_SIZE && sectors_per_cluster != 0 &&
+         (sectors_per_cluster & (sectors_per_cluster - 1)) == 0 && get16(boot + 14) != 0 && boot[16] != 0;
+}
+
+returncode_t libtocksync_fat_mount(libtocksync_fat_t* fs) {
+  returncode_t ret;
+  uint32_t block_size;
+
+  ret = libtocksync_sdcard_initialize(&block_size, NULL);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (block_size != SECTOR_SIZE) return RETURNCODE_ENOSUPPORT;
+
+  memset(fs, 0, sizeof(libtocksync_fat_t));
+  fs->fat_cache.sector  = NO_SECTOR;
+  fs->data_cache.sector = NO_SECTOR;
+
+  // Either the card starts with the volume or with a partition table.
+  uint8_t* boot  = fs->data_cache.data;
+  uint32_t start = 0;
+  if (sd_read(fs, 0, boot) < 0) return RETURNCODE_FAIL;
+
+  if (!boot_sector_valid(boot)) {
+    if (get16(boot + 510) != 0xAA55) return RETURNCODE_ENOSUPPORT;
+
+    for (int i = 0; i < 4 && start == 0; i++) {
+      const uint8_t* partition = boot + 446 + 16 * i;
+      switch (partition[4]) {
+        // FAT16 and FAT32 partition types.
+        case 0x04:
+        case 0x06:
+        case 0x0B:
+        case 0x0C:
+        case 0x0E:
+          start = get32(partition + 8);
+          break;
+      }
+    }
+    if (start == 0) return RETURNCODE_ENOSUPPORT;
+
+    if (sd_read(fs, start, boot) < 0) return RETURNCODE_FAIL;
+    if (!boot_sector_valid(boot)) return RETURNCODE_ENOSUPPORT;
+  }
+
+  uint32_t root_entries = get16(boot + 17);
+  uint32_t fat_sectors  = get16(boot + 22) != 0 ? get16(boot + 22) : get32(boot + 36);
+  uint32_t total        = get16(boot + 19) != 0 ? get16(boot + 19) : get32(boot + 32);
+
+  fs->sectors_per_cluster = boot[13];
+  fs->fat_count    = boot[16];
+  fs->fat_sectors  = fat_sectors;
+  fs->fat_start    = start + get16(boot + 14);
+  fs->root_start   = fs->fat_start + fs->fat_count * fat_sectors;
+  fs->root_sectors = (root_entries * ENTRY_SIZE + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  fs->data_start   = fs->root_start + fs->root_sectors;
+  if (total <= fs->data_start - start) return RETURNCODE_ENOSUPPORT;
+  fs->cluster_count = (total - (fs->data_start - start)) / fs->sectors_per_cluster;
+
+  // The FAT type follows from the number of clusters alone. FAT12 is not
+  // supported.
+  if (fs->cluster_count < 4085) return RETURNCODE_ENOSUPPORT;
+  if (fs->cluster_count < 65525) {
+    fs->fat_type = 16;
+  } else {
+    fs->fat_type     = 32;
+    fs->root_cluster = get32(boot + 44);
+  }
+  fs->next_free = 2;
+
+  // The free cluster count and next free hint in the FAT32 FSInfo sector are
+  // not kept up to date, so mark them unknown for other systems to recount.
+  uint32_t fsinfo = fs->fat_type == 32 ? get16(boot + 48) : 0;
+  if (fsinfo != 0 && fsinfo != 0xFFFF) {
+    if (sector_load(fs, &fs->data_cache, start + fsinfo) < 0) return RETURNCODE_FAIL;
+
+    uint8_t* info = fs->data_cache.data;
+    if (get32(info) == 0x41615252 && get32(info + 484) == 0x61417272 &&
+        (get32(info + 488) != 0xFFFFFFFF || get32(info + 492) != 0xFFFFFFFF)) {
+      put32(info + 488, 0xFFFFFFFF);
+      put32(info + 492, 0xFFFFFFFF);
+      fs->data_cache.dirty = true;
+      if (sector_flush(fs, &fs->data_cache) < 0) return RETURNCODE_FAIL;
+    }
+  }
+
+  newlib_fs = fs;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_fat_sync(libtocksync_fat_t* fs) {
+  return fs_sync(fs) < 0 ? RETURNCODE_FAIL : RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_fat_unmount(libtocksync_fat_t* fs) {
+  int err = fs_sync(fs);
+
+  for (int i = 0; i < LIBTOCKSYNC_FAT_MAX_FILES; i++) {
+    fs->files[i].open = false;
+  }
+  if (newlib_fs == fs) {
+    newlib_fs = NULL;
+  }
+  return err < 0 ? RETURNCODE_FAIL : RETURNCODE_SUCCESS;
+}
+
+static int newlib_result(int ret) {
+  if (ret < 0) {
+    errno = -ret;
+    return -1;
+  }
+  return ret;
+}
+
+// ------------------------------
+// FILE SYSTEM LIBC SUPPORT
+// ------------------------------
+//
+// These replace the weak stubs in libtock/sys.c and libtock-sync/sys.c. They
+// are only linked into apps that call `libtocksync_fat_mount()`.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-declarations"
+#pragma GCC diagnostic ignored "-Wmissing-prototypes"
+
+int _open(const char* path, int flags, ...) {
+  if (newlib_fs == NULL) return newlib_result(-ENODEV);
+  return newlib_result(fs_open(newlib_fs, path, flags));
+}
+
+int _close(int fd) {
+  libtocksync_fat_file_t* file = fs_file(newlib_fs, fd);
+  if (file == NULL) return newlib_result(-EBADF);
+  return newlib_result(fs_close(newlib_fs, file));
+}
+
+int _read(int fd, void* buf, uint32_t count) {
+  libtocksync_fat_file_t* file = fs_file(newlib_fs, fd);
+  if (fd < LIBTOCKSYNC_FAT_FIRST_FD) return 0;
+  if (file == NULL || (file->flags & O_ACCMODE) == O_WRONLY) return newlib_result(-EBADF);
+
+  if (file->position >= file->size) return 0;
+  if (count > file->size - file->position) {
+    count = file->size - file->position;
+  }
+  return newlib_result(file_transfer(newlib_fs, file, buf, count, false));
+}
+
+int _write(int fd, const void* buf, uint32_t count) {
+  if (fd < LIBTOCKSYNC_FAT_FIRST_FD) {
+    int written;
+    libtocksync_console_write((const uint8_t*) buf, count, &written);
+    return written;
+  }
+
+  libtocksync_fat_file_t* file = fs_file(newlib_fs, fd);
+  if (file == NULL || (file->flags & O_ACCMODE) == O_RDONLY) return newlib_result(-EBADF);
+
+  if (file->flags & O_APPEND) {
+    file->position = file->size;
+  }
+  return newlib_result(file_transfer(newlib_fs, file, (uint8_t*) buf, count, true));
+}
+
+int _lseek(int fd, uint32_t offset, int whence) {
+  libtocksync_fat_file_t* file = fs_file(newlib_fs, fd);
+  if (fd < LIBTOCKSYNC_FAT_FIRST_FD) return 0;
+  if (file == NULL) return newlib_result(-EBADF);
+
+  int64_t position = (int32_t) offset;
+  switch (whence) {
+    case SEEK_SET: break;
+    case SEEK_CUR: position += file->position; break;
+    case SEEK_END: position += file->size; break;
+    default: return newlib_result(-EINVAL);
+  }
+
+  // Seeking past the end would leave a gap FAT cannot represent sparsely.
+  if (position < 0 || position > file->size) return newlib_result(-EINVAL);
+
+  file->position = position;
+  return position;
+}
+
+int _fstat(int fd, struct stat* st) {
+  libtocksync_fat_file_t* file = fs_file(newlib_fs, fd);
+
+  memset(st, 0, sizeof(struct stat));
+  if (file == NULL) {
+    st->st_mode = S_IFCHR;
+    return 0;
+  }
+
+  st->st_mode    = S_IFREG;
+  st->st_size    = file->size;
+  st->st_blksize = SECTOR_SIZE;
+  return 0;
+}
+
+int _unlink(const char* path) {
+  if (newlib_fs == NULL) return newlib_result(-ENODEV);
+  return newlib_result(fs_unlink(newlib_fs, path));
+}
+
+#pragma GCC diagnostic pop
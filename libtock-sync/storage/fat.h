@@ -0,0 +1,121 @@
+#pragma once
+
+#include <libtock/storage/sdcard.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FAT16/FAT32 file system on the SD card, accessed through newlib.
+//
+// After `libtocksync_fat_mount()` the usual C library calls (`fopen()`,
+// `fread()`, `fwrite()`, `fseek()`, `fclose()`, `remove()`, or `open()`,
+// `read()`, `write()`, `lseek()`, `close()`) work on files of the mounted
+// volume. Paths are absolute or relative to the root directory, use `/` as
+// separator, and every component must be a short (8.3) name. Long file names
+// on the card are ignored. Existing subdirectories can be used, but new
+// directories cannot be created.
+//
+// The volume is either the whole card or the first FAT partition in the MBR.
+// Only cards with 512 byte blocks are supported. Mounting a FAT32 volume marks
+// the free cluster count in its FSInfo sector as unknown, since it is not
+// updated as clusters are allocated and freed.
+//
+// Caching:
+//
+// - One sector of the FAT and one sector of directory or file data are cached
+//   and written back when another sector is needed, on `close()` and on
+//   `libtocksync_fat_sync()`.
+// - Every open file remembers where it is in its cluster chain, so sequential
+//   access never walks the chain from the start.
+// - Whole sectors of a read or write are transferred directly between the
+//   card and the caller's buffer, back to back for as long as the clusters are
+//   contiguous, without going through the sector cache.
+//
+// Data written to a file is only guaranteed to be on the card after
+// `fclose()`/`fflush()` and `libtocksync_fat_sync()` or `close()`.
+//
+// Example:
+//
+//     static libtocksync_fat_t fs;
+//
+//     libtocksync_fat_mount(&fs);
+//     FILE* log = fopen("/LOG.CSV", "a");
+//     fprintf(log, "%d,%d\n", time, value);
+//     fclose(log);
+
+#define LIBTOCKSYNC_FAT_SECTOR_SIZE 512
+
+// Number of files that can be open at the same time.
+#define LIBTOCKSYNC_FAT_MAX_FILES 4
+
+// File descriptor of the first file, 0 to 2 are the console.
+#define LIBTOCKSYNC_FAT_FIRST_FD 3
+
+typedef struct {
+  // Sector held in `data`, `UINT32_MAX` if none.
+  uint32_t sector;
+  bool dirty;
+  uint8_t data[LIBTOCKSYNC_FAT_SECTOR_SIZE];
+} libtocksync_fat_sector_t;
+
+typedef struct {
+  bool open;
+  int flags;
+  uint32_t first_cluster;
+  uint32_t size;
+  uint32_t position;
+
+  // Location of the directory entry, updated on close.
+  uint32_t entry_sector;
+  uint32_t entry_offset;
+  bool entry_dirty;
+
+  // Cached position in the cluster chain: cluster number `chain_index` of
+  // the file is `chain_cluster`.
+  uint32_t chain_index;
+  uint32_t chain_cluster;
+} libtocksync_fat_file_t;
+
+typedef struct {
+  // Volume layout, in sectors from the start of the card.
+  uint8_t fat_type;
+  uint8_t fat_count;
+  uint8_t sectors_per_cluster;
+  uint32_t fat_start;
+  uint32_t fat_sectors;
+  uint32_t root_start;
+  uint32_t root_sectors;
+  uint32_t root_cluster;
+  uint32_t data_start;
+  uint32_t cluster_count;
+
+  // Where to start looking for a free cluster.
+  uint32_t next_free;
+
+  libtocksync_fat_sector_t fat_cache;
+  libtocksync_fat_sector_t data_cache;
+  libtocksync_fat_file_t files[LIBTOCKSYNC_FAT_MAX_FILES];
+
+  // Statistics.
+  uint32_t sectors_read;
+  uint32_t sectors_written;
+} libtocksync_fat_t;
+
+// Initialize the SD card, mount the FAT volume on it and make it the file
+// system used by newlib.
+//
+// Returns `RETURNCODE_ENOSUPPORT` if the card holds no FAT16 or FAT32 volume.
+returncode_t libtocksync_fat_mount(libtocksync_fat_t* fs);
+
+// Write all cached sectors and the directory entries of open files to the
+// card.
+returncode_t libtocksync_fat_sync(libtocksync_fat_t* fs);
+
+// Sync and detach the file system from newlib. Files still open are closed.
+returncode_t libtocksync_fat_unmount(libtocksync_fat_t* fs);
+
+#ifdef __cplusplus
+}
+#endif
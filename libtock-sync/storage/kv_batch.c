@@ -0,0 +1,29 @@
+#include "kv_batch.h"
+
+struct kv_batch_data {
+  bool fired;
+  int written;
+  returncode_t ret;
+};
+
+static struct kv_batch_data result = {.fired = false};
+
+static void kv_batch_cb_flush(returncode_t ret, int written) {
+  result.fired   = true;
+  result.written = written;
+  result.ret     = ret;
+}
+
+returncode_t libtocksync_kv_batch_flush(libtock_kv_batch_t* batch, int* written) {
+  returncode_t err;
+  result.fired = false;
+
+  err = libtock_kv_batch_flush(batch, kv_batch_cb_flush);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+
+  *written = result.written;
+  return result.ret;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <libtock/storage/kv_batch.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Flush all mutations queued in `batch` and wait for the flush to finish.
+//
+// `written` is set to the number of mutations written to the kernel. See
+// `libtock_kv_batch_flush()` for the error semantics.
+returncode_t libtocksync_kv_batch_flush(libtock_kv_batch_t* batch, int* written);
+
+#ifdef __cplusplus
+}
+#endif
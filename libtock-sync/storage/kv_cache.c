@@ -0,0 +1,79 @@
+#include "kv_cache.h"
+
+struct kv_cache_data {
+  bool fired;
+  int length;
+  returncode_t ret;
+};
+
+static struct kv_cache_data result = {.fired = false};
+
+static void kv_cache_cb_get(returncode_t ret, int length) {
+  result.fired  = true;
+  result.length = length;
+  result.ret    = ret;
+}
+
+static void kv_cache_cb_done(returncode_t ret) {
+  result.fired = true;
+  result.ret   = ret;
+}
+
+returncode_t libtocksync_kv_cache_get(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      uint8_t* ret_buffer, uint32_t ret_len, uint32_t* value_len) {
+  returncode_t err;
+  result.fired = false;
+
+  err = libtock_kv_cache_get(cache, key_buffer, key_len, ret_buffer, ret_len, kv_cache_cb_get);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback. Cache hits complete on the first yield.
+  yield_for(&result.fired);
+
+  // Report the full length of the value, even if it was truncated.
+  *value_len = result.length;
+  return result.ret;
+}
+
+static returncode_t kv_cache_insert(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                    const uint8_t* val_buffer, uint32_t val_len,
+                                    returncode_t (*op_fn)(libtock_kv_cache_t*, const uint8_t*, uint32_t,
+                                                          const uint8_t*, uint32_t, libtock_kv_callback_done)) {
+  returncode_t err;
+  result.fired = false;
+
+  // Do the requested set/add/update operation.
+  err = op_fn(cache, key_buffer, key_len, val_buffer, val_len, kv_cache_cb_done);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_kv_cache_set(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      const uint8_t* val_buffer, uint32_t val_len) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_cache_set);
+}
+
+returncode_t libtocksync_kv_cache_add(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      const uint8_t* val_buffer, uint32_t val_len) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_cache_add);
+}
+
+returncode_t libtocksync_kv_cache_update(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                         const uint8_t* val_buffer, uint32_t val_len) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_cache_update);
+}
+
+returncode_t libtocksync_kv_cache_delete(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len) {
+  returncode_t err;
+  result.fired = false;
+
+  err = libtock_kv_cache_delete(cache, key_buffer, key_len, kv_cache_cb_done);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <libtock/storage/kv_cache.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Synchronous versions of the `libtock_kv_cache_*` operations. See
+// `libtock/storage/kv_cache.h` for the caching semantics.
+
+returncode_t libtocksync_kv_cache_get(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      uint8_t* ret_buffer, uint32_t ret_len, uint32_t* value_len);
+
+returncode_t libtocksync_kv_cache_set(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      const uint8_t* val_buffer, uint32_t val_len);
+
+returncode_t libtocksync_kv_cache_add(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                      const uint8_t* val_buffer, uint32_t val_len);
+
+returncode_t libtocksync_kv_cache_update(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                         const uint8_t* val_buffer, uint32_t val_len);
+
+returncode_t libtocksync_kv_cache_delete(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len);
+
+#ifdef __cplusplus
+}
+#endif
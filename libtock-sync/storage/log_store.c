@@ -0,0 +1,399 @@
+#include <string.h>
+
+#include "log_store.h"
+#include "nonvolatile_storage.h"
+
+#define SEGMENT_MAGIC        0x544c5347
+#define SEGMENT_MAGIC_ERASED 0x544c5345
+#define BLOCK_MAGIC          0x544c424b
+#define SEGMENT_HEADER_LEN   16
+#define BLOCK_HEADER_LEN     24
+
+// Segment header: magic, sequence, first timestamp, CRC over sequence and
+// first timestamp. Erased segments keep a header with a different magic so
+// that sequence numbers keep increasing across an erase.
+//
+// Block header: magic, segment sequence, payload length, first timestamp,
+// last timestamp, CRC over the header fields after the magic and the payload.
+//
+// Record: timestamp (4 bytes), data length (2 bytes), data.
+
+static uint32_t log_crc32(uint32_t crc, const uint8_t* buf, uint32_t len) {
+  // CRC-32 (IEEE 802.3), one nibble at a time to keep the table small.
+  static const uint32_t table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+  };
+
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc = table[(crc ^ buf[i]) & 0x0f] ^ (crc >> 4);
+    crc = table[(crc ^ (buf[i] >> 4)) & 0x0f] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static uint32_t get32(const uint8_t* buf) {
+  uint32_t val;
+  memcpy(&val, buf, sizeof(val));
+  return val;
+}
+
+static void put32(uint8_t* buf, uint32_t val) {
+  memcpy(buf, &val, sizeof(val));
+}
+
+static uint32_t segment_address(libtocksync_log_store_t* store, uint32_t segment) {
+  return store->storage_offset + segment * store->segment_size;
+}
+
+static returncode_t log_read(uint32_t offset, uint8_t* buf, uint32_t len) {
+  int length_read;
+  returncode_t ret = libtocksync_nonvolatile_storage_read(offset, len, buf, len, &length_read);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  return (uint32_t) length_read == len ? RETURNCODE_SUCCESS : RETURNCODE_FAIL;
+}
+
+static returncode_t log_write(libtocksync_log_store_t* store, uint32_t offset, uint8_t* buf, uint32_t len) {
+  int length_written;
+  returncode_t ret = libtocksync_nonvolatile_storage_write(offset, len, buf, len, &length_written);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  store->bytes_written += len;
+  return (uint32_t) length_written == len ? RETURNCODE_SUCCESS : RETURNCODE_FAIL;
+}
+
+typedef struct {
+  uint32_t length;
+  uint32_t first_timestamp;
+  uint32_t last_timestamp;
+  // CRC over the header fields, to be extended over the payload.
+  uint32_t header_crc;
+  uint32_t stored_crc;
+} block_header_t;
+
+// Read the header of the block at `offset` within `segment`. Returns false if
+// there is no block of the current generation of this segment there.
+static bool read_block_header(libtocksync_log_store_t* store, uint32_t segment, uint32_t offset,
+                              block_header_t* header) {
+  uint8_t raw[BLOCK_HEADER_LEN];
+
+  if (offset + BLOCK_HEADER_LEN > store->segment_size) return false;
+  if (log_read(segment_address(store, segment) + offset, raw, BLOCK_HEADER_LEN) != RETURNCODE_SUCCESS) return false;
+
+  // Blocks left over from before the segment was recycled carry an older
+  // sequence number.
+  if (get32(raw) != BLOCK_MAGIC || get32(raw + 4) != store->index[segment].sequence) return false;
+
+  header->length          = get32(raw + 8);
+  header->first_timestamp = get32(raw + 12);
+  header->last_timestamp  = get32(raw + 16);
+  header->header_crc      = log_crc32(0, raw + 4, 16);
+  header->stored_crc      = get32(raw + 20);
+  return header->length <= store->segment_size - offset - BLOCK_HEADER_LEN;
+}
+
+// Read and verify the payload of a block. If the payload fits in `buf` it is
+// left there, larger payloads are only verified.
+static bool read_block_payload(libtocksync_log_store_t* store, uint32_t segment, uint32_t offset,
+                               block_header_t* header, uint8_t* buf, uint32_t buf_len) {
+  uint32_t crc       = header->header_crc;
+  uint32_t address   = segment_address(store, segment) + offset + BLOCK_HEADER_LEN;
+  uint32_t remaining = header->length;
+  while (remaining > 0) {
+    uint32_t chunk = remaining < buf_len ? remaining : buf_len;
+    if (log_read(address, buf, chunk) != RETURNCODE_SUCCESS) return false;
+    crc        = log_crc32(crc, buf, chunk);
+    address   += chunk;
+    remaining -= chunk;
+  }
+  return crc == header->stored_crc;
+}
+
+// Call `cb` for the records in `payload` within `[start, end]`. Returns false
+// once `cb` asks to stop or the records pass `end`.
+static bool visit_records(const uint8_t* payload, uint32_t len, uint32_t start, uint32_t end,
+                          libtocksync_log_store_record_callback cb, void* opaque) {
+  uint32_t pos = 0;
+  while (pos + LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD <= len) {
+    uint32_t timestamp = get32(payload + pos);
+    uint16_t data_len;
+    memcpy(&data_len, payload + pos + 4, sizeof(data_len));
+
+    const uint8_t* data = payload + pos + LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD;
+    pos += LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD + data_len;
+    if (pos > len) break;
+
+    if (timestamp > end) return false;
+    if (timestamp >= start && !cb(timestamp, data, data_len, opaque)) return false;
+  }
+  return true;
+}
+
+// Start an empty log. New segments are numbered after `sequence`.
+static void reset_head(libtocksync_log_store_t* store, uint32_t sequence) {
+  // Mark the last segment as full so the first flush opens segment 0.
+  store->head_segment   = store->segment_count - 1;
+  store->head_offset    = store->segment_size;
+  store->last_timestamp = 0;
+  store->last_sequence  = sequence;
+  store->index[store->head_segment].sequence = sequence;
+}
+
+// Point the head at the valid segment with the newest sequence number.
+static bool find_newest_segment(libtocksync_log_store_t* store) {
+  bool found = false;
+  for (uint32_t segment = 0; segment < store->segment_count; segment++) {
+    libtocksync_log_store_segment_t* entry = &store->index[segment];
+    if (!entry->valid) continue;
+
+    // Sequence numbers are compared so that they may wrap.
+    if (!found || (int32_t) (entry->sequence - store->index[store->head_segment].sequence) > 0) {
+      store->head_segment = segment;
+      found = true;
+    }
+  }
+  return found;
+}
+
+returncode_t libtocksync_log_store_mount(libtocksync_log_store_t* store, uint32_t storage_offset,
+                                         uint32_t segment_size, uint32_t segment_count, uint8_t* buffer,
+                                         uint32_t buffer_len, libtocksync_log_store_segment_t* index) {
+  returncode_t ret;
+  uint32_t number_bytes;
+
+  if (segment_count < 2) return RETURNCODE_EINVAL;
+  if (buffer_len <= LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD + LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD) {
+    return RETURNCODE_ESIZE;
+  }
+  if (buffer_len > segment_size) return RETURNCODE_ESIZE;
+
+  ret = libtock_nonvolatile_storage_get_number_bytes(&number_bytes);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (storage_offset + segment_count * segment_size > number_bytes) return RETURNCODE_ESIZE;
+
+  memset(store, 0, sizeof(libtocksync_log_store_t));
+  store->storage_offset = storage_offset;
+  store->segment_size   = segment_size;
+  store->segment_count  = segment_count;
+  store->index          = index;
+  store->buffer         = buffer;
+  store->buffer_len     = buffer_len;
+
+  // Build the sparse index from the segment headers. New segments must be
+  // numbered after every header found, valid, erased or dropped, so a
+  // sequence number is never used twice.
+  bool sequence_seen = false;
+  for (uint32_t segment = 0; segment < segment_count; segment++) {
+    uint8_t raw[SEGMENT_HEADER_LEN];
+    ret = log_read(segment_address(store, segment), raw, SEGMENT_HEADER_LEN);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    libtocksync_log_store_segment_t* entry = &index[segment];
+    bool crc_ok = log_crc32(0, raw + 4, 8) == get32(raw + 12);
+
+    entry->valid           = crc_ok && get32(raw) == SEGMENT_MAGIC;
+    entry->sequence        = get32(raw + 4);
+    entry->first_timestamp = get32(raw + 8);
+
+    if (crc_ok && (get32(raw) == SEGMENT_MAGIC || get32(raw) == SEGMENT_MAGIC_ERASED)) {
+      if (!sequence_seen || (int32_t) (entry->sequence - store->last_sequence) > 0) {
+        store->last_sequence = entry->sequence;
+      }
+      sequence_seen = true;
+    }
+  }
+
+  // Find the end of the log: the first block in the newest segment that does
+  // not verify. A segment whose first block never fully made it to storage
+  // is dropped, and the log ends in the segment before it instead.
+  while (find_newest_segment(store)) {
+    uint32_t offset = SEGMENT_HEADER_LEN;
+    while (true) {
+      block_header_t header;
+      if (!read_block_header(store, store->head_segment, offset, &header)) break;
+      if (!read_block_payload(store, store->head_segment, offset, &header, buffer, buffer_len)) break;
+
+      store->last_timestamp = header.last_timestamp;
+      offset += BLOCK_HEADER_LEN + header.length;
+    }
+
+    if (offset > SEGMENT_HEADER_LEN) {
+      store->head_offset = offset;
+      return RETURNCODE_SUCCESS;
+    }
+
+    index[store->head_segment].valid = false;
+  }
+
+  reset_head(store, store->last_sequence);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_log_store_append(libtocksync_log_store_t* store, uint32_t timestamp, const uint8_t* data,
+                                          uint32_t len) {
+  returncode_t ret;
+  uint32_t capacity   = store->buffer_len - LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD;
+  uint32_t record_len = LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD + len;
+
+  if (timestamp < store->last_timestamp) return RETURNCODE_EINVAL;
+  if (record_len > capacity || len > UINT16_MAX) return RETURNCODE_ESIZE;
+
+  if (store->buffer_used + record_len > capacity) {
+    ret = libtocksync_log_store_flush(store);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+
+  if (store->buffer_used == 0) {
+    store->block_first_timestamp = timestamp;
+  }
+
+  uint8_t* record   = store->buffer + LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD + store->buffer_used;
+  uint16_t data_len = len;
+  put32(record, timestamp);
+  memcpy(record + 4, &data_len, sizeof(data_len));
+  memcpy(record + LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD, data, len);
+
+  store->buffer_used         += record_len;
+  store->block_last_timestamp = timestamp;
+  store->last_timestamp       = timestamp;
+  store->records_appended++;
+  store->bytes_appended += len;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_log_store_flush(libtocksync_log_store_t* store) {
+  returncode_t ret;
+
+  if (store->buffer_used == 0) return RETURNCODE_SUCCESS;
+
+  uint32_t block_len = BLOCK_HEADER_LEN + store->buffer_used;
+  uint32_t segment   = store->head_segment;
+  uint32_t sequence  = store->index[segment].sequence;
+  bool open_segment  = store->head_offset + block_len > store->segment_size;
+
+  // The segment and block headers sit in front of the payload in the write
+  // buffer, so each flush is a single write.
+  uint8_t* block = store->buffer + SEGMENT_HEADER_LEN;
+  uint8_t* write_start;
+  uint32_t write_address;
+
+  if (open_segment) {
+    // Move on to the oldest segment, recycling it.
+    segment  = (segment + 1) % store->segment_count;
+    sequence = store->last_sequence + 1;
+
+    put32(store->buffer, SEGMENT_MAGIC);
+    put32(store->buffer + 4, sequence);
+    put32(store->buffer + 8, store->block_first_timestamp);
+    put32(store->buffer + 12, log_crc32(0, store->buffer + 4, 8));
+
+    write_start   = store->buffer;
+    write_address = segment_address(store, segment);
+  } else {
+    write_start   = block;
+    write_address = segment_address(store, segment) + store->head_offset;
+  }
+
+  put32(block, BLOCK_MAGIC);
+  put32(block + 4, sequence);
+  put32(block + 8, store->buffer_used);
+  put32(block + 12, store->block_first_timestamp);
+  put32(block + 16, store->block_last_timestamp);
+  uint32_t crc = log_crc32(0, block + 4, 16);
+  put32(block + 20, log_crc32(crc, block + BLOCK_HEADER_LEN, store->buffer_used));
+
+  uint32_t write_len = (block + block_len) - write_start;
+  ret = log_write(store, write_address, write_start, write_len);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  if (open_segment) {
+    libtocksync_log_store_segment_t* entry = &store->index[segment];
+    if (entry->valid) {
+      store->segments_recycled++;
+    }
+    entry->valid           = true;
+    entry->sequence        = sequence;
+    entry->first_timestamp = store->block_first_timestamp;
+
+    store->head_segment  = segment;
+    store->head_offset   = SEGMENT_HEADER_LEN;
+    store->last_sequence = sequence;
+  }
+
+  store->head_offset += block_len;
+  store->buffer_used  = 0;
+  store->blocks_written++;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_log_store_read_range(libtocksync_log_store_t* store, uint32_t start, uint32_t end,
+                                              uint8_t* scratch, uint32_t scratch_len,
+                                              libtocksync_log_store_record_callback cb, void* opaque) {
+  if (scratch_len < store->buffer_len - LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD) return RETURNCODE_ESIZE;
+
+  // Walk the segments from the oldest to the head.
+  for (uint32_t k = 1; k <= store->segment_count; k++) {
+    uint32_t segment = (store->head_segment + k) % store->segment_count;
+    libtocksync_log_store_segment_t* entry = &store->index[segment];
+    if (!entry->valid) continue;
+    if (entry->first_timestamp > end) break;
+
+    // Skip the segment if the next one already starts before `start`.
+    bool skip = false;
+    for (uint32_t n = k + 1; n <= store->segment_count; n++) {
+      libtocksync_log_store_segment_t* next = &store->index[(store->head_segment + n) % store->segment_count];
+      if (next->valid) {
+        skip = next->first_timestamp < start;
+        break;
+      }
+    }
+    if (skip) continue;
+
+    uint32_t limit  = segment == store->head_segment ? store->head_offset : store->segment_size;
+    uint32_t offset = SEGMENT_HEADER_LEN;
+    while (offset < limit) {
+      block_header_t header;
+      if (!read_block_header(store, segment, offset, &header)) break;
+      if (header.first_timestamp > end) return RETURNCODE_SUCCESS;
+
+      // Only read the payload of blocks that overlap the range.
+      if (header.last_timestamp >= start) {
+        if (header.length > scratch_len) return RETURNCODE_ESIZE;
+        if (!read_block_payload(store, segment, offset, &header, scratch, scratch_len)) break;
+        if (!visit_records(scratch, header.length, start, end, cb, opaque)) return RETURNCODE_SUCCESS;
+      }
+
+      offset += BLOCK_HEADER_LEN + header.length;
+    }
+  }
+
+  // Finally the records that are still in the write buffer.
+  visit_records(store->buffer + LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD, store->buffer_used, start, end, cb, opaque);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_log_store_erase(libtocksync_log_store_t* store) {
+  returncode_t ret;
+  uint8_t header[SEGMENT_HEADER_LEN];
+
+  // Replace every segment header with an erased marker that is newer than
+  // all existing segments. Old blocks then never match a future segment.
+  uint32_t sequence = store->last_sequence + 1;
+  put32(header, SEGMENT_MAGIC_ERASED);
+  put32(header + 4, sequence);
+  put32(header + 8, 0);
+  put32(header + 12, log_crc32(0, header + 4, 8));
+
+  for (uint32_t segment = 0; segment < store->segment_count; segment++) {
+    if (!store->index[segment].valid) continue;
+
+    ret = log_write(store, segment_address(store, segment), header, SEGMENT_HEADER_LEN);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+    store->index[segment].valid = false;
+  }
+
+  store->buffer_used = 0;
+  reset_head(store, sequence);
+  return RETURNCODE_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <libtock/storage/nonvolatile_storage.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Append-only, log-structured record store over nonvolatile storage.
+//
+// The store divides a range of nonvolatile storage into equally sized
+// segments that are used as a ring. Each record is a timestamp plus up to a
+// few hundred bytes of data. Appends are collected in a RAM buffer and written
+// as one block when the buffer fills up (or on `libtocksync_log_store_flush()`),
+// so the storage sees few, large, sequential writes. When the newest segment
+// is full the oldest segment is recycled.
+//
+// On flash, every segment starts with a header holding a sequence number and
+// the timestamp of its first record, followed by blocks. Every block carries
+// the sequence number of its segment, the first and last timestamp it holds
+// and a CRC-32 over its contents. Mounting finds the newest segment and walks
+// its blocks until the first one that does not verify, so records from a
+// block that was being written during a reset are dropped and the log
+// continues after the last good block.
+//
+// A sparse index with the first timestamp of every segment is kept in RAM and
+// used, together with the per-block timestamp ranges, to skip data outside of
+// the range passed to `libtocksync_log_store_read_range()`.
+//
+// Record timestamps are chosen by the caller and must not decrease.
+//
+// Example:
+//
+//     static uint8_t buffer[512];
+//     static libtocksync_log_store_segment_t index[16];
+//     static libtocksync_log_store_t store;
+//
+//     libtocksync_log_store_mount(&store, 0, 4096, 16, buffer, sizeof(buffer), index);
+//     libtocksync_log_store_append(&store, now, sample, sizeof(sample));
+
+// Bytes at the start of the write buffer reserved for block framing.
+#define LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD 40
+
+// Bytes of framing stored with every record.
+#define LIBTOCKSYNC_LOG_STORE_RECORD_OVERHEAD 6
+
+// Sparse index entry for one segment.
+typedef struct {
+  bool valid;
+  uint32_t sequence;
+  uint32_t first_timestamp;
+} libtocksync_log_store_segment_t;
+
+typedef struct {
+  // Layout in nonvolatile storage.
+  uint32_t storage_offset;
+  uint32_t segment_size;
+  uint32_t segment_count;
+  libtocksync_log_store_segment_t* index;
+
+  // RAM write buffer holding the block being assembled.
+  uint8_t* buffer;
+  uint32_t buffer_len;
+  uint32_t buffer_used;
+  uint32_t block_first_timestamp;
+  uint32_t block_last_timestamp;
+
+  // Position of the end of the log.
+  uint32_t head_segment;
+  uint32_t head_offset;
+  uint32_t last_timestamp;
+  // Newest sequence number written or found in storage, including dropped
+  // and erased segments. New segments are numbered after it.
+  uint32_t last_sequence;
+
+  // Statistics.
+  uint32_t records_appended;
+  uint32_t bytes_appended;
+  uint32_t bytes_written;
+  uint32_t blocks_written;
+  uint32_t segments_recycled;
+} libtocksync_log_store_t;
+
+// Function signature for records returned by
+// `libtocksync_log_store_read_range()`.
+//
+// Returning `false` stops the read.
+typedef bool (*libtocksync_log_store_record_callback)(uint32_t timestamp, const uint8_t* data, uint32_t len,
+                                                      void* opaque);
+
+// Mount a log store on `segment_count` segments of `segment_size` bytes
+// starting at `storage_offset` in nonvolatile storage, recovering any log
+// already stored there.
+//
+// `buffer` is the RAM write buffer. It bounds the size of a block, so a larger
+// buffer means fewer writes. It must be larger than
+// `LIBTOCKSYNC_LOG_STORE_BUFFER_OVERHEAD` and no larger than a segment.
+// `index` must have room for `segment_count` entries. The store keeps using
+// both until it is no longer needed.
+returncode_t libtocksync_log_store_mount(libtocksync_log_store_t* store, uint32_t storage_offset,
+                                         uint32_t segment_size, uint32_t segment_count, uint8_t* buffer,
+                                         uint32_t buffer_len, libtocksync_log_store_segment_t* index);
+
+// Append a record. Only writes to storage when the write buffer is full.
+//
+// Returns `RETURNCODE_EINVAL` if `timestamp` is older than the last appended
+// record and `RETURNCODE_ESIZE` if the record can never fit in the write
+// buffer.
+returncode_t libtocksync_log_store_append(libtocksync_log_store_t* store, uint32_t timestamp, const uint8_t* data,
+                                          uint32_t len);
+
+// Write any buffered records to storage.
+returncode_t libtocksync_log_store_flush(libtocksync_log_store_t* store);
+
+// Call `cb` for every record, oldest first, whose timestamp is within
+// `[start, end]`, including records that have not been flushed yet.
+//
+// `scratch` holds one block while its records are returned and must be at
+// least as large as the write buffer.
+returncode_t libtocksync_log_store_read_range(libtocksync_log_store_t* store, uint32_t start, uint32_t end,
+                                              uint8_t* scratch, uint32_t scratch_len,
+                                              libtocksync_log_store_record_callback cb, void* opaque);
+
+// Forget all records. The segments are invalidated in storage.
+returncode_t libtocksync_log_store_erase(libtocksync_log_store_t* store);
+
+#ifdef __cplusplus
+}
+#endif
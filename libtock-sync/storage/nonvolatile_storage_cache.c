@@ -0,0 +1,192 @@
+#include <string.h>
+
+#include "nonvolatile_storage.h"
+#include "nonvolatile_storage_cache.h"
+
+static int cache_find(libtocksync_nonvolatile_storage_cache_t* cache, uint32_t block_offset) {
+  for (uint32_t i = 0; i < cache->block_count; i++) {
+    if (cache->blocks[i].valid && cache->blocks[i].offset == block_offset) return i;
+  }
+  return -1;
+}
+
+// Age of the most recently used block in `count` slots starting at `first`.
+// Empty slots count as infinitely old.
+static uint32_t cache_window_age(libtocksync_nonvolatile_storage_cache_t* cache, uint32_t first, uint32_t count) {
+  uint32_t age = UINT32_MAX;
+  for (uint32_t i = first; i < first + count; i++) {
+    libtocksync_nonvolatile_storage_cache_block_t* block = &cache->blocks[i];
+    // Compare ages rather than raw clock values so wrap-around is harmless.
+    if (block->valid && cache->clock - block->last_used < age) {
+      age = cache->clock - block->last_used;
+    }
+  }
+  return age;
+}
+
+// Load up to `count` blocks starting with the block at `block_offset` into
+// consecutive slots with one storage read. `slot` is set to the slot of the
+// first block.
+static returncode_t cache_fill(libtocksync_nonvolatile_storage_cache_t* cache, uint32_t block_offset, uint32_t count,
+                               int* slot) {
+  returncode_t ret;
+  uint32_t block_size = cache->block_size;
+
+  // Never read past the end of storage or load a block that is cached
+  // already.
+  uint32_t available = (cache->storage_size - block_offset + block_size - 1) / block_size;
+  if (count > available) count = available;
+  if (count > cache->block_count) count = cache->block_count;
+  for (uint32_t n = 1; n < count; n++) {
+    if (cache_find(cache, block_offset + n * block_size) >= 0) {
+      count = n;
+      break;
+    }
+  }
+
+  // Replace the run of slots whose newest block is the oldest.
+  uint32_t first    = 0;
+  uint32_t best_age = 0;
+  for (uint32_t i = 0; i + count <= cache->block_count; i++) {
+    uint32_t age = cache_window_age(cache, i, count);
+    if (i == 0 || age > best_age) {
+      first    = i;
+      best_age = age;
+    }
+  }
+
+  uint32_t length = count * block_size;
+  if (length > cache->storage_size - block_offset) {
+    length = cache->storage_size - block_offset;
+  }
+
+  for (uint32_t n = 0; n < count; n++) {
+    cache->blocks[first + n].valid = false;
+  }
+
+  int length_read;
+  uint8_t* memory = cache->memory + first * block_size;
+  cache->storage_reads++;
+  ret = libtocksync_nonvolatile_storage_read(block_offset, length, memory, length, &length_read);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if ((uint32_t) length_read != length) return RETURNCODE_FAIL;
+
+  cache->clock++;
+  for (uint32_t n = 0; n < count; n++) {
+    libtocksync_nonvolatile_storage_cache_block_t* block = &cache->blocks[first + n];
+    block->valid     = true;
+    block->offset    = block_offset + n * block_size;
+    block->last_used = cache->clock;
+  }
+  *slot = first;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_nonvolatile_storage_cache_init(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                        uint8_t* memory, uint32_t block_size, uint32_t block_count,
+                                                        libtocksync_nonvolatile_storage_cache_block_t* blocks,
+                                                        uint32_t readahead) {
+  returncode_t ret;
+
+  if (block_size == 0 || block_count == 0) return RETURNCODE_EINVAL;
+  if (readahead == 0 || readahead > block_count) return RETURNCODE_EINVAL;
+
+  memset(cache, 0, sizeof(libtocksync_nonvolatile_storage_cache_t));
+  cache->memory      = memory;
+  cache->block_size  = block_size;
+  cache->block_count = block_count;
+  cache->blocks      = blocks;
+  cache->readahead   = readahead;
+
+  ret = libtock_nonvolatile_storage_get_number_bytes(&cache->storage_size);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  libtocksync_nonvolatile_storage_cache_invalidate(cache);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtocksync_nonvolatile_storage_cache_invalidate(libtocksync_nonvolatile_storage_cache_t* cache) {
+  for (uint32_t i = 0; i < cache->block_count; i++) {
+    cache->blocks[i].valid = false;
+  }
+}
+
+returncode_t libtocksync_nonvolatile_storage_cache_read(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                        uint32_t offset, uint32_t length, uint8_t* buffer,
+                                                        uint32_t buffer_length, int* length_read) {
+  uint32_t block_size = cache->block_size;
+
+  if (length > buffer_length) return RETURNCODE_ESIZE;
+  if (offset > cache->storage_size || length > cache->storage_size - offset) return RETURNCODE_EINVAL;
+
+  // Large reads would only evict everything, send them to storage directly.
+  if (length >= block_size * cache->block_count) {
+    cache->storage_reads++;
+    cache->next_offset = offset + length;
+    return libtocksync_nonvolatile_storage_read(offset, length, buffer, buffer_length, length_read);
+  }
+
+  bool sequential = offset == cache->next_offset;
+  uint32_t done   = 0;
+  while (done < length) {
+    uint32_t position     = offset + done;
+    uint32_t block_offset = position - position % block_size;
+
+    int slot = cache_find(cache, block_offset);
+    if (slot >= 0) {
+      cache->hits++;
+      cache->blocks[slot].last_used = ++cache->clock;
+    } else {
+      cache->misses++;
+      returncode_t ret = cache_fill(cache, block_offset, sequential ? cache->readahead : 1, &slot);
+      if (ret != RETURNCODE_SUCCESS) return ret;
+    }
+
+    uint32_t start = position - block_offset;
+    uint32_t chunk = block_size - start;
+    if (chunk > length - done) chunk = length - done;
+    memcpy(buffer + done, cache->memory + slot * block_size + start, chunk);
+    done += chunk;
+
+    // A read spanning several blocks is sequential after the first one.
+    sequential = true;
+  }
+
+  cache->next_offset = offset + length;
+  *length_read       = length;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtocksync_nonvolatile_storage_cache_write(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                         uint32_t offset, uint32_t length, uint8_t* buffer,
+                                                         uint32_t buffer_length, int* length_written) {
+  returncode_t ret;
+
+  ret = libtocksync_nonvolatile_storage_write(offset, length, buffer, buffer_length, length_written);
+
+  // Only the bytes that reached storage are known.
+  uint32_t written = 0;
+  if (ret == RETURNCODE_SUCCESS && *length_written > 0) {
+    written = (uint32_t) *length_written < length ? (uint32_t) *length_written : length;
+  }
+
+  // Update the cached copy of every block the write overlaps. Blocks that
+  // overlap a part that may not have been written are dropped instead.
+  for (uint32_t i = 0; i < cache->block_count; i++) {
+    libtocksync_nonvolatile_storage_cache_block_t* block = &cache->blocks[i];
+    if (!block->valid) continue;
+    if (block->offset >= offset + length || block->offset + cache->block_size <= offset) continue;
+
+    if (written < length && block->offset + cache->block_size > offset + written) {
+      block->valid = false;
+      continue;
+    }
+
+    uint32_t start = block->offset > offset ? block->offset : offset;
+    uint32_t end   = block->offset + cache->block_size < offset + length ? block->offset + cache->block_size :
+                     offset + length;
+    memcpy(cache->memory + i * cache->block_size + (start - block->offset), buffer + (start - offset), end - start);
+  }
+
+  return ret;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <libtock/storage/nonvolatile_storage.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block cache with sequential read-ahead in front of nonvolatile storage.
+//
+// Reads are served from a set of fixed-size blocks aligned to `block_size`.
+// A miss loads the block from storage. When a read continues where the
+// previous one ended, a miss instead loads up to `readahead` consecutive
+// blocks with a single storage read, so a scan over small records turns into
+// a few large reads. The least recently used blocks are replaced first.
+//
+// Writes through the cache go straight to storage and update any cached copy
+// of the bytes written. Writes that bypass the cache are not observed, call
+// `libtocksync_nonvolatile_storage_cache_invalidate()` after them.
+//
+// Example:
+//
+//     static uint8_t memory[4 * 256];
+//     static libtocksync_nonvolatile_storage_cache_block_t blocks[4];
+//     static libtocksync_nonvolatile_storage_cache_t cache;
+//
+//     libtocksync_nonvolatile_storage_cache_init(&cache, memory, 256, 4, blocks, 2);
+//     libtocksync_nonvolatile_storage_cache_read(&cache, offset, 16, buf, sizeof(buf), &length_read);
+
+typedef struct {
+  bool valid;
+  // Storage offset of the first byte in the block.
+  uint32_t offset;
+  // Value of the cache clock when this block was last used.
+  uint32_t last_used;
+} libtocksync_nonvolatile_storage_cache_block_t;
+
+typedef struct {
+  uint8_t* memory;
+  uint32_t block_size;
+  uint32_t block_count;
+  libtocksync_nonvolatile_storage_cache_block_t* blocks;
+  uint32_t readahead;
+  uint32_t storage_size;
+
+  uint32_t clock;
+  // Offset right after the last read, used to detect sequential reads.
+  uint32_t next_offset;
+
+  // Number of blocks found in the cache.
+  uint32_t hits;
+  // Number of blocks that had to be loaded from storage.
+  uint32_t misses;
+  // Number of reads issued to the storage driver.
+  uint32_t storage_reads;
+} libtocksync_nonvolatile_storage_cache_t;
+
+// Initialize an empty cache of `block_count` blocks of `block_size` bytes.
+//
+// `memory` must hold `block_count * block_size` bytes and `blocks` must have
+// `block_count` entries. `readahead` is the largest number of blocks loaded
+// by a single sequential miss, 1 disables read-ahead.
+returncode_t libtocksync_nonvolatile_storage_cache_init(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                        uint8_t* memory, uint32_t block_size, uint32_t block_count,
+                                                        libtocksync_nonvolatile_storage_cache_block_t* blocks,
+                                                        uint32_t readahead);
+
+// Drop all cached blocks.
+void libtocksync_nonvolatile_storage_cache_invalidate(libtocksync_nonvolatile_storage_cache_t* cache);
+
+// Read `length` bytes into `buffer` from the nonvolatile storage starting at
+// `offset`, using cached blocks where possible.
+//
+// Reads at least as large as the whole cache go straight to storage.
+returncode_t libtocksync_nonvolatile_storage_cache_read(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                        uint32_t offset, uint32_t length, uint8_t* buffer,
+                                                        uint32_t buffer_length, int* length_read);
+
+// Write `length` bytes from `buffer` to the nonvolatile storage starting at
+// `offset` and update the cached blocks.
+returncode_t libtocksync_nonvolatile_storage_cache_write(libtocksync_nonvolatile_storage_cache_t* cache,
+                                                         uint32_t offset, uint32_t length, uint8_t* buffer,
+                                                         uint32_t buffer_length, int* length_written);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,52 @@
+#include "sdcard_queue.h"
+
+// Requests of other callers may be queued ahead of ours, so every call waits
+// on its own completion flag, passed through the request's opaque pointer.
+struct sdcard_queue_data {
+  bool fired;
+  returncode_t ret;
+};
+
+static void sdcard_queue_cb(returncode_t ret, void* opaque) {
+  struct sdcard_queue_data* result = (struct sdcard_queue_data*) opaque;
+  result->fired = true;
+  result->ret   = ret;
+}
+
+returncode_t libtocksync_sdcard_queue_read(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                           uint8_t* buffer) {
+  returncode_t err;
+  struct sdcard_queue_data result = {.fired = false};
+
+  err = libtock_sdcard_queue_read(queue, sector, count, buffer, sdcard_queue_cb, &result);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_sdcard_queue_write(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                            uint8_t* buffer) {
+  returncode_t err;
+  struct sdcard_queue_data result = {.fired = false};
+
+  err = libtock_sdcard_queue_write(queue, sector, count, buffer, sdcard_queue_cb, &result);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
+
+returncode_t libtocksync_sdcard_queue_flush(libtock_sdcard_queue_t* queue) {
+  returncode_t err;
+  struct sdcard_queue_data result = {.fired = false};
+
+  err = libtock_sdcard_queue_flush(queue, sdcard_queue_cb, &result);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Wait for the callback.
+  yield_for(&result.fired);
+  return result.ret;
+}
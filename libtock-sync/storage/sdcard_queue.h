@@ -0,0 +1,25 @@
+#pragma once
+
+#include <libtock/storage/sdcard_queue.h>
+#include <libtock/tock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queue a read of `count` sectors and wait for it, along with every request
+// queued before it, to complete.
+returncode_t libtocksync_sdcard_queue_read(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                           uint8_t* buffer);
+
+// Queue a write of `count` sectors and wait until the data is in the cache or
+// on the card.
+returncode_t libtocksync_sdcard_queue_write(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                            uint8_t* buffer);
+
+// Write every cached sector back to the card and wait for it to finish.
+returncode_t libtocksync_sdcard_queue_flush(libtock_sdcard_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
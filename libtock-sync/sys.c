@@ -11,6 +11,8 @@
 // SYNCHRONOUS LIBC SUPPORT STUBS
 // ------------------------------
 
+// Weak so that a file system can also handle writes to files.
+__attribute__ ((weak))
 int _write(__attribute__ ((unused)) int fd, const void* buf, uint32_t count) {
   int written;
   libtocksync_console_write((const uint8_t*) buf, count, &written);
@@ -0,0 +1,162 @@
+#include "aes_bulk.h"
+
+// Allow the next chunk of the input and output buffers.
+static returncode_t bulk_allow_chunk(libtock_aes_bulk_t* op) {
+  returncode_t ret;
+  uint32_t length = op->length - op->offset;
+  if (length > op->chunk_length) length = op->chunk_length;
+
+  ret = libtock_aes_set_readonly_allow_source_buffer(op->input + op->offset, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_readwrite_allow_dest_buffer(op->output + op->offset, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  op->in_flight = length;
+  return RETURNCODE_SUCCESS;
+}
+
+// Release the engine and the data buffers.
+static void bulk_release(void) {
+  libtock_aes_finish();
+  libtock_aes_set_readonly_allow_source_buffer(NULL, 0);
+  libtock_aes_set_readwrite_allow_dest_buffer(NULL, 0);
+}
+
+static void bulk_done(libtock_aes_bulk_t* op, returncode_t ret) {
+  bulk_release();
+  op->cb(ret, op->offset, op->opaque);
+}
+
+// Fail an operation whose algorithm was set but which could not be started.
+static returncode_t bulk_abort(returncode_t ret) {
+  bulk_release();
+  return ret;
+}
+
+static void aes_bulk_upcall(int                          result,
+                            __attribute__ ((unused)) int length,
+                            int                          verified,
+                            void*                        opaque) {
+  libtock_aes_bulk_t* op = (libtock_aes_bulk_t*) opaque;
+  returncode_t ret;
+
+  if (result != RETURNCODE_SUCCESS) {
+    bulk_done(op, (returncode_t) result);
+    return;
+  }
+
+  op->offset += op->in_flight;
+  if (op->ccm) {
+    bulk_done(op, op->decrypting && !verified ? RETURNCODE_FAIL : RETURNCODE_SUCCESS);
+    return;
+  }
+  if (op->offset == op->length) {
+    bulk_done(op, RETURNCODE_SUCCESS);
+    return;
+  }
+
+  // Start the next chunk straight away. The driver carries the counter or
+  // chaining value over from the previous one.
+  ret = bulk_allow_chunk(op);
+  if (ret == RETURNCODE_SUCCESS) {
+    ret = libtock_aes_crypt();
+  }
+  if (ret != RETURNCODE_SUCCESS) {
+    bulk_done(op, ret);
+  }
+}
+
+// Share the key, IV or nonce and the first chunk with the driver and start
+// the operation. The algorithm must already be set.
+static returncode_t bulk_start(libtock_aes_bulk_t* op, libtock_aes_algorithm_t algorithm, const uint8_t* key,
+                               const uint8_t* iv, uint32_t iv_length) {
+  returncode_t ret;
+
+  ret = libtock_aes_set_readonly_allow_key_buffer(key, LIBTOCK_AES_BLOCK_LENGTH);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  if (iv != NULL) {
+    if (algorithm == LIBTOCK_AES128CCM) {
+      ret = libtock_aes_set_readonly_allow_nonce_buffer(iv, iv_length);
+    } else {
+      ret = libtock_aes_set_readonly_allow_iv_buffer(iv, iv_length);
+    }
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+
+  ret = bulk_allow_chunk(op);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_set_upcall(aes_bulk_upcall, op);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return libtock_aes_setup();
+}
+
+returncode_t libtock_aes_bulk_crypt(libtock_aes_bulk_t* op, libtock_aes_algorithm_t algorithm, bool encrypting,
+                                    const uint8_t* key, const uint8_t* iv,
+                                    const uint8_t* input, uint8_t* output, uint32_t length,
+                                    uint32_t chunk_length, libtock_aes_bulk_callback cb, void* opaque) {
+  returncode_t ret;
+
+  if (algorithm == LIBTOCK_AES128CCM) return RETURNCODE_EINVAL;
+  if (length == 0 || chunk_length == 0 || chunk_length % LIBTOCK_AES_BLOCK_LENGTH != 0) return RETURNCODE_EINVAL;
+  if (algorithm != LIBTOCK_AES128Ctr && length % LIBTOCK_AES_BLOCK_LENGTH != 0) return RETURNCODE_EINVAL;
+
+  op->input        = input;
+  op->output       = output;
+  op->length       = length;
+  op->chunk_length = chunk_length;
+  op->offset       = 0;
+  op->ccm          = false;
+  op->decrypting   = !encrypting;
+  op->cb           = cb;
+  op->opaque       = opaque;
+
+  ret = libtock_aes_set_algorithm(algorithm, encrypting);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = bulk_start(op, algorithm, key, algorithm == LIBTOCK_AES128ECB ? NULL : iv, LIBTOCK_AES_BLOCK_LENGTH);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_aes_bulk_ccm(libtock_aes_bulk_t* op, bool encrypting,
+                                  const uint8_t* key, const uint8_t* nonce, uint32_t nonce_length,
+                                  const uint8_t* input, uint8_t* output, uint32_t length,
+                                  uint32_t a_offset, uint32_t m_offset, uint32_t mic_length,
+                                  libtock_aes_bulk_callback cb, void* opaque) {
+  returncode_t ret;
+
+  if (length == 0) return RETURNCODE_EINVAL;
+
+  op->input        = input;
+  op->output       = output;
+  op->length       = length;
+  op->chunk_length = length;
+  op->offset       = 0;
+  op->ccm          = true;
+  op->decrypting   = !encrypting;
+  op->cb           = cb;
+  op->opaque       = opaque;
+
+  ret = libtock_aes_set_algorithm(LIBTOCK_AES128CCM, encrypting);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_aes_ccm_set_a_off(a_offset);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+
+  ret = libtock_aes_ccm_set_m_off(m_offset);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+
+  ret = libtock_aes_ccm_set_mic_len(mic_length);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+
+  ret = libtock_aes_ccm_set_confidential(true);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+
+  ret = bulk_start(op, LIBTOCK_AES128CCM, key, nonce, nonce_length);
+  if (ret != RETURNCODE_SUCCESS) return bulk_abort(ret);
+  return RETURNCODE_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../tock.h"
+#include "aes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bulk AES encryption and decryption.
+//
+// `libtock_aes_bulk_crypt()` runs AES-128 in CTR, CBC or ECB mode over an
+// input of any length. The input is handed to the kernel `chunk_length`
+// bytes at a time by allowing the next part of the input and output buffers
+// directly, and the next chunk is started from the completion upcall of the
+// previous one. The callback is called once, when all data is processed.
+//
+// `libtock_aes_bulk_ccm()` runs a complete AES-128 CCM operation over one
+// buffer.
+//
+// Only one operation can run at a time.
+
+// Default number of bytes handed to the kernel per crypt operation.
+#define LIBTOCK_AES_BULK_CHUNK_LENGTH 128
+
+#define LIBTOCK_AES_BLOCK_LENGTH 16
+
+// Function signature for bulk AES callbacks.
+//
+// - `arg1` (`returncode_t`): Status of the operation. A CCM decryption whose
+//   MIC does not match reports `RETURNCODE_FAIL`.
+// - `arg2` (`uint32_t`): Number of bytes processed.
+// - `arg3` (`void*`): The `opaque` pointer passed to the operation.
+typedef void (*libtock_aes_bulk_callback)(returncode_t, uint32_t, void*);
+
+// State for one operation. Allocated by the caller and kept until the
+// callback is called.
+typedef struct {
+  const uint8_t* input;
+  uint8_t* output;
+  uint32_t length;
+  uint32_t chunk_length;
+  // Start and length of the chunk the kernel is processing.
+  uint32_t offset;
+  uint32_t in_flight;
+  // Whether the operation runs as a single CCM pass.
+  bool ccm;
+  bool decrypting;
+  libtock_aes_bulk_callback cb;
+  void* opaque;
+} libtock_aes_bulk_t;
+
+// Encrypt or decrypt `length` bytes from `input` into `output`.
+//
+// `algorithm` is one of `LIBTOCK_AES128Ctr`, `LIBTOCK_AES128CBC` and
+// `LIBTOCK_AES128ECB`. `key` is 16 bytes, `iv` is the 16 byte IV or initial
+// counter and is ignored for ECB. `input` may be in flash and may be the same
+// buffer as `output`. `chunk_length` must be a multiple of 16, as must
+// `length` for CBC and ECB.
+//
+// `key`, `iv`, `input` and `output` must stay valid until `cb` is called.
+returncode_t libtock_aes_bulk_crypt(libtock_aes_bulk_t* op, libtock_aes_algorithm_t algorithm, bool encrypting,
+                                    const uint8_t* key, const uint8_t* iv,
+                                    const uint8_t* input, uint8_t* output, uint32_t length,
+                                    uint32_t chunk_length, libtock_aes_bulk_callback cb, void* opaque);
+
+// Run a confidential AES-128 CCM operation over the `length` bytes of
+// `input`, writing the result to `output`.
+//
+// The additional data starts at `a_offset` and the message at `m_offset` of
+// `input`, laid out as the driver expects. `mic_length` is the MIC length in
+// bytes. A decryption whose MIC does not verify fails.
+//
+// `key`, `nonce`, `input` and `output` must stay valid until `cb` is called.
+returncode_t libtock_aes_bulk_ccm(libtock_aes_bulk_t* op, bool encrypting,
+                                  const uint8_t* key, const uint8_t* nonce, uint32_t nonce_length,
+                                  const uint8_t* input, uint8_t* output, uint32_t length,
+                                  uint32_t a_offset, uint32_t m_offset, uint32_t mic_length,
+                                  libtock_aes_bulk_callback cb, void* opaque);
+
+#ifdef __cplusplus
+}
+#endif
@@ -35,3 +35,41 @@ returncode_t libtock_hmac_simple(libtock_hmac_algorithm_t hmac_type,
   return ret;
 
 }
+
+returncode_t libtock_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length) {
+  returncode_t ret;
+
+  ret = libtock_hmac_command_set_algorithm((uint32_t) hmac_type);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_readonly_allow_key_buffer(key_buffer, key_length);
+  return ret;
+}
+
+returncode_t libtock_hmac_update(const uint8_t* input_buffer, uint32_t input_length, libtock_hmac_callback_hmac cb) {
+  returncode_t ret;
+
+  if (input_length == 0) return RETURNCODE_EINVAL;
+
+  ret = libtock_hmac_set_readonly_allow_data_buffer(input_buffer, input_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_upcall(hmac_upcall, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_command_update();
+  return ret;
+}
+
+returncode_t libtock_hmac_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_hmac_callback_hmac cb) {
+  returncode_t ret;
+
+  ret = libtock_hmac_set_readwrite_allow_destination_buffer(hash_buffer, hash_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_set_upcall(hmac_upcall, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_hmac_command_finish();
+  return ret;
+}
@@ -30,6 +30,29 @@ returncode_t libtock_hmac_simple(libtock_hmac_algorithm_t hmac_type,
                                  uint8_t* hash_buffer, uint32_t hash_length,
                                  libtock_hmac_callback_hmac cb);
 
+// Streaming HMAC.
+//
+// An HMAC over input that is not in one buffer is computed with
+// `libtock_hmac_init()`, any number of `libtock_hmac_update()` calls and a
+// final `libtock_hmac_finish()`. Each step must complete before the next one
+// is started. Input buffers may be in flash.
+
+// Start a new streaming HMAC with algorithm `hmac_type` and the given key.
+//
+// `key_buffer` must stay valid until `libtock_hmac_finish()` completes.
+returncode_t libtock_hmac_init(libtock_hmac_algorithm_t hmac_type, const uint8_t* key_buffer, uint32_t key_length);
+
+// Add `input_length` bytes from `input_buffer` to the HMAC.
+//
+// The callback is called once the kernel has consumed the input, after which
+// `input_buffer` may be refilled.
+returncode_t libtock_hmac_update(const uint8_t* input_buffer, uint32_t input_length, libtock_hmac_callback_hmac cb);
+
+// Finish the HMAC and store it in `hash_buffer`.
+//
+// The callback will be called when the HMAC is available.
+returncode_t libtock_hmac_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_hmac_callback_hmac cb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,19 @@ static void sha_upcall(int ret,
   cb((returncode_t) ret);
 }
 
+bool libtock_sha_uses_software(libtock_sha_algorithm_t hash_type, uint32_t input_length) {
+  // Whether the driver exists does not change, only ask the kernel once.
+  static enum { UNKNOWN, PRESENT, MISSING } driver = UNKNOWN;
+
+  if (hash_type != LIBTOCK_SHA256) return false;
+  if (input_length <= LIBTOCK_SHA_SOFTWARE_MAX_LENGTH) return true;
+
+  if (driver == UNKNOWN) {
+    driver = libtock_sha_exists() ? PRESENT : MISSING;
+  }
+  return driver == MISSING;
+}
+
 returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                      uint8_t* input_buffer, uint32_t input_length,
                                      uint8_t* hash_buffer, uint32_t hash_length,
@@ -14,6 +27,16 @@ returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
 
   returncode_t ret;
 
+  if (libtock_sha_uses_software(hash_type, input_length)) {
+    if (hash_length < LIBTOCK_SHA256_DIGEST_LENGTH) return RETURNCODE_ESIZE;
+
+    libtock_sha256_software(input_buffer, input_length, hash_buffer);
+
+    // Report the result from an upcall, as the driver would.
+    if (tock_enqueue(sha_upcall, RETURNCODE_SUCCESS, 0, 0, cb) < 0) return RETURNCODE_EBUSY;
+    return RETURNCODE_SUCCESS;
+  }
+
   ret = libtock_sha_command_set_algorithm((uint8_t) hash_type);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
@@ -29,3 +52,35 @@ returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
   ret = libtock_sha_command_run();
   return ret;
 }
+
+returncode_t libtock_sha_init(libtock_sha_algorithm_t hash_type) {
+  return libtock_sha_command_set_algorithm((uint8_t) hash_type);
+}
+
+returncode_t libtock_sha_update(const uint8_t* input_buffer, uint32_t input_length, libtock_sha_callback_hash cb) {
+  returncode_t ret;
+
+  if (input_length == 0) return RETURNCODE_EINVAL;
+
+  ret = libtock_sha_set_readonly_allow_data_buffer((uint8_t*) input_buffer, input_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sha_set_upcall(sha_upcall, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sha_command_update();
+  return ret;
+}
+
+returncode_t libtock_sha_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_sha_callback_hash cb) {
+  returncode_t ret;
+
+  ret = libtock_sha_set_readwrite_allow_destination_buffer(hash_buffer, hash_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sha_set_upcall(sha_upcall, cb);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sha_command_finish();
+  return ret;
+}
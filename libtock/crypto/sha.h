@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../tock.h"
+#include "sha256_software.h"
 #include "syscalls/sha_syscalls.h"
 
 #ifdef __cplusplus
@@ -20,14 +21,48 @@ typedef enum {
 
 
 
+// SHA-256 hashes of at most this many bytes are computed in software, as the
+// syscalls needed to use the driver take longer than hashing them.
+#define LIBTOCK_SHA_SOFTWARE_MAX_LENGTH 128
+
+// Whether `libtock_sha_simple_hash()` computes this hash in software, either
+// because it is short or because there is no SHA driver.
+bool libtock_sha_uses_software(libtock_sha_algorithm_t hash_type, uint32_t input_length);
+
 // Compute a SHA hash over `input_buffer` and store the hash in `hash_buffer`.
 //
+// SHA-256 hashes are computed in software when
+// `libtock_sha_uses_software()` says so. The callback is still called from
+// an upcall.
+//
 // The callback will be called when the hash is available.
 returncode_t libtock_sha_simple_hash(libtock_sha_algorithm_t hash_type,
                                      uint8_t* input_buffer, uint32_t input_length,
                                      uint8_t* hash_buffer, uint32_t hash_length,
                                      libtock_sha_callback_hash cb);
 
+// Streaming hash.
+//
+// A hash over input that is not in one buffer is computed with
+// `libtock_sha_init()`, any number of `libtock_sha_update()` calls and a
+// final `libtock_sha_finish()`. Each step must complete before the next one
+// is started. Input buffers may be in flash, so an app image or other
+// read-only data can be hashed without copying it into RAM.
+
+// Start a new streaming hash with algorithm `hash_type`.
+returncode_t libtock_sha_init(libtock_sha_algorithm_t hash_type);
+
+// Add `input_length` bytes from `input_buffer` to the hash.
+//
+// The callback is called once the kernel has consumed the input, after which
+// `input_buffer` may be refilled.
+returncode_t libtock_sha_update(const uint8_t* input_buffer, uint32_t input_length, libtock_sha_callback_hash cb);
+
+// Finish the hash and store it in `hash_buffer`.
+//
+// The callback will be called when the hash is available.
+returncode_t libtock_sha_finish(uint8_t* hash_buffer, uint32_t hash_length, libtock_sha_callback_hash cb);
+
 #ifdef __cplusplus
 }
 #endif
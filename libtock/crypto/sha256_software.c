@@ -0,0 +1,185 @@
+#include <string.h>
+
+#include "sha256_software.h"
+
+static const uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t initial_state[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define S0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define s1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static uint32_t load_be32(const uint8_t* p) {
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static void store_be32(uint8_t* p, uint32_t v) {
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+// Compact compression function. The message schedule is kept in a rolling
+// window of 16 words, and the working variables in an array that is rotated
+// by index instead of by moving values.
+static void compress_small(uint32_t* state, const uint8_t* block) {
+  uint32_t w[16];
+  uint32_t v[8];
+
+  memcpy(v, state, sizeof(v));
+  for (int i = 0; i < 64; i++) {
+    uint32_t word;
+    if (i < 16) {
+      word = load_be32(block + 4 * i);
+    } else {
+      word = s1(w[(i - 2) & 15]) + w[(i - 7) & 15] + s0(w[(i - 15) & 15]) + w[i & 15];
+    }
+    w[i & 15] = word;
+
+    // v[(8 - i) & 7] is `a`, v[(9 - i) & 7] is `b`, and so on.
+    uint32_t a  = v[(8 - i) & 7];
+    uint32_t e  = v[(12 - i) & 7];
+    uint32_t t1 = v[(15 - i) & 7] + S1(e) + CH(e, v[(13 - i) & 7], v[(14 - i) & 7]) + k[i] + word;
+    uint32_t t2 = S0(a) + MAJ(a, v[(9 - i) & 7], v[(10 - i) & 7]);
+    v[(11 - i) & 7] += t1;
+    v[(15 - i) & 7]  = t1 + t2;
+  }
+  for (int i = 0; i < 8; i++) {
+    state[i] += v[i];
+  }
+}
+
+// One round with the working variables named by position, so the unrolled
+// code never moves them between registers.
+#define ROUND(a, b, c, d, e, f, g, h, i, word) \
+  do { \
+    uint32_t t1 = h + S1(e) + CH(e, f, g) + k[i] + (word); \
+    d += t1; \
+    h  = t1 + S0(a) + MAJ(a, b, c); \
+  } while (0)
+
+#define W(i) (w[(i) & 15] = s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + s0(w[((i) - 15) & 15]) + w[(i) & 15])
+
+#define ROUNDS8(i, word) \
+  ROUND(a, b, c, d, e, f, g, h, (i) + 0, word((i) + 0)); \
+  ROUND(h, a, b, c, d, e, f, g, (i) + 1, word((i) + 1)); \
+  ROUND(g, h, a, b, c, d, e, f, (i) + 2, word((i) + 2)); \
+  ROUND(f, g, h, a, b, c, d, e, (i) + 3, word((i) + 3)); \
+  ROUND(e, f, g, h, a, b, c, d, (i) + 4, word((i) + 4)); \
+  ROUND(d, e, f, g, h, a, b, c, (i) + 5, word((i) + 5)); \
+  ROUND(c, d, e, f, g, h, a, b, (i) + 6, word((i) + 6)); \
+  ROUND(b, c, d, e, f, g, h, a, (i) + 7, word((i) + 7))
+
+#define LOAD(i) (w[i] = load_be32(block + 4 * (i)))
+
+// Fully unrolled compression function.
+static void compress_fast(uint32_t* state, const uint8_t* block) {
+  uint32_t w[16];
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+  ROUNDS8(0, LOAD);
+  ROUNDS8(8, LOAD);
+  ROUNDS8(16, W);
+  ROUNDS8(24, W);
+  ROUNDS8(32, W);
+  ROUNDS8(40, W);
+  ROUNDS8(48, W);
+  ROUNDS8(56, W);
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+static void sha256_start(libtock_sha256_software_t* ctx, void (*compress)(uint32_t*, const uint8_t*)) {
+  memcpy(ctx->state, initial_state, sizeof(initial_state));
+  ctx->length       = 0;
+  ctx->block_length = 0;
+  ctx->compress     = compress;
+}
+
+void libtock_sha256_software_init(libtock_sha256_software_t* ctx) {
+  sha256_start(ctx, compress_small);
+}
+
+void libtock_sha256_software_init_fast(libtock_sha256_software_t* ctx) {
+  sha256_start(ctx, compress_fast);
+}
+
+void libtock_sha256_software_update(libtock_sha256_software_t* ctx, const uint8_t* data, uint32_t length) {
+  ctx->length += length;
+
+  // Complete a partial block first.
+  if (ctx->block_length > 0) {
+    uint32_t n = LIBTOCK_SHA256_BLOCK_LENGTH - ctx->block_length;
+    if (n > length) n = length;
+    memcpy(ctx->block + ctx->block_length, data, n);
+    ctx->block_length += n;
+    data   += n;
+    length -= n;
+    if (ctx->block_length < LIBTOCK_SHA256_BLOCK_LENGTH) return;
+    ctx->compress(ctx->state, ctx->block);
+    ctx->block_length = 0;
+  }
+
+  // Whole blocks are hashed in place.
+  while (length >= LIBTOCK_SHA256_BLOCK_LENGTH) {
+    ctx->compress(ctx->state, data);
+    data   += LIBTOCK_SHA256_BLOCK_LENGTH;
+    length -= LIBTOCK_SHA256_BLOCK_LENGTH;
+  }
+
+  memcpy(ctx->block, data, length);
+  ctx->block_length = length;
+}
+
+void libtock_sha256_software_finish(libtock_sha256_software_t* ctx, uint8_t* digest) {
+  uint64_t bits = ctx->length * 8;
+
+  // Append 0x80, pad with zeros and end the last block with the length.
+  ctx->block[ctx->block_length++] = 0x80;
+  if (ctx->block_length > LIBTOCK_SHA256_BLOCK_LENGTH - 8) {
+    memset(ctx->block + ctx->block_length, 0, LIBTOCK_SHA256_BLOCK_LENGTH - ctx->block_length);
+    ctx->compress(ctx->state, ctx->block);
+    ctx->block_length = 0;
+  }
+  memset(ctx->block + ctx->block_length, 0, LIBTOCK_SHA256_BLOCK_LENGTH - 8 - ctx->block_length);
+  store_be32(ctx->block + 56, bits >> 32);
+  store_be32(ctx->block + 60, bits);
+  ctx->compress(ctx->state, ctx->block);
+
+  for (int i = 0; i < 8; i++) {
+    store_be32(digest + 4 * i, ctx->state[i]);
+  }
+}
+
+void libtock_sha256_software(const uint8_t* data, uint32_t length, uint8_t* digest) {
+  libtock_sha256_software_t ctx;
+
+  libtock_sha256_software_init(&ctx);
+  libtock_sha256_software_update(&ctx, data, length);
+  libtock_sha256_software_finish(&ctx, digest);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SHA-256 computed on the CPU, for boards without a SHA driver and for
+// messages so short that the syscalls of the driver cost more than the hash.
+//
+// There are two implementations of the compression function:
+//
+// - `libtock_sha256_software_init()` uses a compact loop (about 1 kB of code).
+// - `libtock_sha256_software_init_fast()` uses fully unrolled rounds, which
+//   are several times larger but avoid the loop and message schedule
+//   bookkeeping.
+//
+// Only the variant that is initialized gets linked into the app.
+
+#define LIBTOCK_SHA256_DIGEST_LENGTH 32
+#define LIBTOCK_SHA256_BLOCK_LENGTH  64
+
+typedef struct libtock_sha256_software libtock_sha256_software_t;
+
+struct libtock_sha256_software {
+  uint32_t state[8];
+  // Total number of bytes hashed so far.
+  uint64_t length;
+  uint8_t block[LIBTOCK_SHA256_BLOCK_LENGTH];
+  uint32_t block_length;
+  void (*compress)(uint32_t* state, const uint8_t* block);
+};
+
+// Start a hash with the compact implementation.
+void libtock_sha256_software_init(libtock_sha256_software_t* ctx);
+
+// Start a hash with the unrolled implementation.
+void libtock_sha256_software_init_fast(libtock_sha256_software_t* ctx);
+
+// Add `length` bytes to the hash.
+void libtock_sha256_software_update(libtock_sha256_software_t* ctx, const uint8_t* data, uint32_t length);
+
+// Finish the hash and store the 32 byte digest in `digest`.
+void libtock_sha256_software_finish(libtock_sha256_software_t* ctx, uint8_t* digest);
+
+// Hash `length` bytes of `data` in one call with the compact implementation.
+void libtock_sha256_software(const uint8_t* data, uint32_t length, uint8_t* digest);
+
+#ifdef __cplusplus
+}
+#endif
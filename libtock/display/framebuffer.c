@@ -0,0 +1,392 @@
+#include <string.h>
+
+#include "framebuffer.h"
+#include "pixel.h"
+
+// The screen callbacks carry no user data, so the framebuffer being flushed
+// is kept here.
+static libtock_framebuffer_t* flushing_framebuffer;
+
+static uint32_t line_height(const libtock_framebuffer_t* framebuffer) {
+  return framebuffer->format == MONO ? 8 : 1;
+}
+
+static uint32_t area(const libtock_framebuffer_region_t* region) {
+  return (uint32_t) region->width * region->height;
+}
+
+static libtock_framebuffer_region_t region_union(const libtock_framebuffer_region_t* a,
+                                                 const libtock_framebuffer_region_t* b) {
+  uint32_t left   = a->x < b->x ? a->x : b->x;
+  uint32_t top    = a->y < b->y ? a->y : b->y;
+  uint32_t right  = a->x + a->width > b->x + b->width ? a->x + a->width : b->x + b->width;
+  uint32_t bottom = a->y + a->height > b->y + b->height ? a->y + a->height : b->y + b->height;
+
+  libtock_framebuffer_region_t result = {
+    .x      = left,
+    .y      = top,
+    .width  = right - left,
+    .height = bottom - top,
+  };
+  return result;
+}
+
+// Pixels saved by sending the union of `a` and `b` rather than both, which
+// is negative if it costs more.
+static int64_t merge_saving(const libtock_framebuffer_t* framebuffer, const libtock_framebuffer_region_t* a,
+                            const libtock_framebuffer_region_t* b) {
+  libtock_framebuffer_region_t merged = region_union(a, b);
+  return (int64_t) area(a) + area(b) + framebuffer->merge_cost - area(&merged);
+}
+
+static void remove_region(libtock_framebuffer_t* framebuffer, uint32_t index) {
+  framebuffer->dirty[index] = framebuffer->dirty[--framebuffer->dirty_count];
+}
+
+static void add_region(libtock_framebuffer_t* framebuffer, libtock_framebuffer_region_t region) {
+  bool merged;
+
+  // Merge with every region it is worth merging with, including those that
+  // only become worth it once the region has grown.
+  do {
+    merged = false;
+    for (uint32_t i = 0; i < framebuffer->dirty_count; i++) {
+      if (merge_saving(framebuffer, &region, &framebuffer->dirty[i]) >= 0) {
+        region = region_union(&region, &framebuffer->dirty[i]);
+        remove_region(framebuffer, i);
+        merged = true;
+        break;
+      }
+    }
+  } while (merged);
+
+  if (framebuffer->dirty_count == LIBTOCK_FRAMEBUFFER_MAX_REGIONS) {
+    // Out of space, merge with the region that adds the fewest pixels.
+    uint32_t best       = 0;
+    int64_t best_saving = merge_saving(framebuffer, &region, &framebuffer->dirty[0]);
+    for (uint32_t i = 1; i < framebuffer->dirty_count; i++) {
+      int64_t saving = merge_saving(framebuffer, &region, &framebuffer->dirty[i]);
+      if (saving > best_saving) {
+        best        = i;
+        best_saving = saving;
+      }
+    }
+    region = region_union(&region, &framebuffer->dirty[best]);
+    remove_region(framebuffer, best);
+    add_region(framebuffer, region);
+    return;
+  }
+
+  framebuffer->dirty[framebuffer->dirty_count++] = region;
+}
+
+// Clip a rectangle to the screen, returns false if nothing is left.
+static bool clip(const libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                 libtock_framebuffer_region_t* region) {
+  if (x >= framebuffer->width || y >= framebuffer->height || width == 0 || height == 0) return false;
+
+  region->x      = x;
+  region->y      = y;
+  region->width  = (uint32_t) x + width > framebuffer->width ? framebuffer->width - x : width;
+  region->height = (uint32_t) y + height > framebuffer->height ? framebuffer->height - y : height;
+  return true;
+}
+
+static void invalidate_region(libtock_framebuffer_t* framebuffer, libtock_framebuffer_region_t region) {
+  if (framebuffer->format == MONO) {
+    // Round out to whole pages.
+    uint32_t bottom = (region.y + region.height + 7) & ~7u;
+    region.y      &= ~7u;
+    region.height  = (bottom > framebuffer->height ? framebuffer->height : bottom) - region.y;
+  }
+  if (framebuffer->transfer == NULL) {
+    region.x     = 0;
+    region.width = framebuffer->width;
+  }
+  add_region(framebuffer, region);
+}
+
+static void put_mono(libtock_framebuffer_t* framebuffer, uint32_t x, uint32_t y, bool on) {
+  uint8_t* byte = &framebuffer->buffer[(y >> 3) * framebuffer->stride + x];
+  if (on) {
+    *byte |= 1 << (y & 7);
+  } else {
+    *byte &= ~(1 << (y & 7));
+  }
+}
+
+// Set or clear the bits in `mask` of `count` bytes, a word at a time.
+static void mono_fill_columns(uint8_t* column, uint32_t count, uint8_t mask, bool on) {
+  uint32_t word_mask = mask * 0x01010101u;
+  uint8_t* end       = column + count;
+
+  for ( ; column < end && ((uintptr_t) column & 3); column++) {
+    *column = on ? *column | mask : *column & ~mask;
+  }
+  for ( ; column + 4 <= end; column += 4) {
+    libtock_pixel_word_t* word = (libtock_pixel_word_t*) column;
+    *word = on ? *word | word_mask : *word & ~word_mask;
+  }
+  for ( ; column < end; column++) {
+    *column = on ? *column | mask : *column & ~mask;
+  }
+}
+
+uint32_t libtock_framebuffer_length(uint16_t width, uint16_t height, libtock_screen_format_t format) {
+  if (format == MONO) {
+    return (uint32_t) width * ((height + 7) / 8);
+  }
+  return (uint32_t) width * height * (libtock_screen_get_bits_per_pixel(format) / 8);
+}
+
+returncode_t libtock_framebuffer_init(libtock_framebuffer_t* framebuffer, uint16_t width, uint16_t height,
+                                      libtock_screen_format_t format, uint8_t* buffer, uint32_t buffer_length,
+                                      uint8_t* transfer, uint32_t transfer_length) {
+  if (width == 0 || height == 0 || libtock_screen_get_bits_per_pixel(format) == 0) return RETURNCODE_EINVAL;
+  if (buffer_length < libtock_framebuffer_length(width, height, format)) return RETURNCODE_ESIZE;
+
+  memset(framebuffer, 0, sizeof(libtock_framebuffer_t));
+  framebuffer->width           = width;
+  framebuffer->height          = height;
+  framebuffer->format          = format;
+  framebuffer->pixel_bytes     = libtock_screen_get_bits_per_pixel(format) / 8;
+  framebuffer->stride          = format == MONO ? width : (uint32_t) width * framebuffer->pixel_bytes;
+  framebuffer->buffer          = buffer;
+  framebuffer->transfer        = transfer_length > 0 ? transfer : NULL;
+  framebuffer->transfer_length = transfer != NULL ? transfer_length : 0;
+  framebuffer->merge_cost      = LIBTOCK_FRAMEBUFFER_MERGE_COST_DEFAULT;
+
+  libtock_framebuffer_invalidate_all(framebuffer);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_framebuffer_invalidate(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                                    uint16_t height) {
+  libtock_framebuffer_region_t region;
+  if (clip(framebuffer, x, y, width, height, &region)) {
+    invalidate_region(framebuffer, region);
+  }
+}
+
+void libtock_framebuffer_invalidate_all(libtock_framebuffer_t* framebuffer) {
+  libtock_framebuffer_region_t region = {0, 0, framebuffer->width, framebuffer->height};
+  framebuffer->dirty_count = 0;
+  add_region(framebuffer, region);
+}
+
+bool libtock_framebuffer_is_dirty(const libtock_framebuffer_t* framebuffer) {
+  return framebuffer->dirty_count > 0;
+}
+
+void libtock_framebuffer_set_pixel(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint32_t color) {
+  libtock_framebuffer_fill_rect(framebuffer, x, y, 1, 1, color);
+}
+
+uint32_t libtock_framebuffer_get_pixel(const libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y) {
+  if (x >= framebuffer->width || y >= framebuffer->height) return 0;
+
+  if (framebuffer->format == MONO) {
+    return (framebuffer->buffer[(y >> 3) * framebuffer->stride + x] >> (y & 7)) & 1;
+  }
+  return libtock_pixel_read(framebuffer->format, framebuffer->buffer + y * framebuffer->stride, x);
+}
+
+void libtock_framebuffer_fill_rect(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                                   uint16_t height, uint32_t color) {
+  libtock_framebuffer_region_t region;
+  if (!clip(framebuffer, x, y, width, height, &region)) return;
+
+  if (framebuffer->format == MONO) {
+    // A page at a time, with the bits of the rows it covers.
+    uint32_t bottom = (uint32_t) region.y + region.height;
+    for (uint32_t top = region.y; top < bottom; top = (top | 7) + 1) {
+      uint32_t rows = ((top | 7) + 1 < bottom ? (top | 7) + 1 : bottom) - top;
+      uint8_t mask  = ((1u << rows) - 1) << (top & 7);
+      mono_fill_columns(framebuffer->buffer + (top >> 3) * framebuffer->stride + region.x, region.width, mask,
+                        color & 1);
+    }
+  } else {
+    for (uint32_t row = region.y; row < (uint32_t) region.y + region.height; row++) {
+      libtock_pixel_fill(framebuffer->format,
+                         framebuffer->buffer + row * framebuffer->stride + region.x * framebuffer->pixel_bytes,
+                         region.width, color);
+    }
+  }
+  invalidate_region(framebuffer, region);
+}
+
+void libtock_framebuffer_blit(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                              uint16_t height, const uint8_t* source, uint32_t source_stride) {
+  libtock_framebuffer_region_t region;
+  if (!clip(framebuffer, x, y, width, height, &region)) return;
+
+  for (uint32_t row = 0; row < region.height; row++) {
+    const uint8_t* line = source + row * source_stride;
+    if (framebuffer->format == MONO) {
+      for (uint32_t column = 0; column < region.width; column++) {
+        put_mono(framebuffer, region.x + column, region.y + row, libtock_pixel_read(MONO, line, column));
+      }
+    } else {
+      memcpy(framebuffer->buffer + (region.y + row) * framebuffer->stride + region.x * framebuffer->pixel_bytes,
+             line, region.width * framebuffer->pixel_bytes);
+    }
+  }
+  invalidate_region(framebuffer, region);
+}
+
+static void flush_finish(libtock_framebuffer_t* framebuffer, returncode_t ret) {
+  libtock_screen_set_readonly_allow(NULL, 0);
+
+  // Whatever was not sent is still dirty.
+  if (ret != RETURNCODE_SUCCESS) {
+    for (uint32_t i = framebuffer->flushing_index; i < framebuffer->flushing_count; i++) {
+      add_region(framebuffer, framebuffer->flushing[i]);
+    }
+  }
+
+  framebuffer->busy    = false;
+  flushing_framebuffer = NULL;
+  if (framebuffer->cb) framebuffer->cb(ret, framebuffer->opaque);
+}
+
+static void flush_frame_done(returncode_t ret);
+static void flush_write_done(returncode_t ret);
+
+// Prepare the next chunk of the current region and set the frame for it.
+static returncode_t flush_next(libtock_framebuffer_t* framebuffer) {
+  libtock_framebuffer_region_t* region = &framebuffer->flushing[framebuffer->flushing_index];
+  uint32_t height     = line_height(framebuffer);
+  uint32_t first_line = region->y / height + framebuffer->flushing_line;
+  uint32_t remaining  = (region->height + height - 1) / height - framebuffer->flushing_line;
+
+  if (region->width == framebuffer->width) {
+    // Full-width lines are contiguous in the framebuffer.
+    framebuffer->chunk_lines  = remaining;
+    framebuffer->chunk        = framebuffer->buffer + first_line * framebuffer->stride;
+    framebuffer->chunk_length = remaining * framebuffer->stride;
+  } else {
+    uint32_t offset     = framebuffer->format == MONO ? region->x : region->x * framebuffer->pixel_bytes;
+    uint32_t line_bytes = framebuffer->format == MONO ? region->width : region->width * framebuffer->pixel_bytes;
+    uint32_t lines      = framebuffer->transfer_length / line_bytes;
+
+    framebuffer->chunk_lines  = lines < remaining ? lines : remaining;
+    framebuffer->chunk        = framebuffer->transfer;
+    framebuffer->chunk_length = framebuffer->chunk_lines * line_bytes;
+    for (uint32_t i = 0; i < framebuffer->chunk_lines; i++) {
+      memcpy(framebuffer->transfer + i * line_bytes,
+             framebuffer->buffer + (first_line + i) * framebuffer->stride + offset, line_bytes);
+    }
+  }
+
+  uint32_t top    = first_line * height;
+  uint32_t bottom = top + framebuffer->chunk_lines * height;
+  if (bottom > framebuffer->height) bottom = framebuffer->height;
+  return libtock_screen_set_frame(region->x, top, region->width, bottom - top, flush_frame_done);
+}
+
+static void flush_frame_done(returncode_t ret) {
+  libtock_framebuffer_t* framebuffer = flushing_framebuffer;
+
+  if (ret == RETURNCODE_SUCCESS) {
+    ret = libtock_screen_write(framebuffer->chunk, framebuffer->chunk_length, framebuffer->chunk_length,
+                               flush_write_done);
+  }
+  if (ret != RETURNCODE_SUCCESS) flush_finish(framebuffer, ret);
+}
+
+static void flush_write_done(returncode_t ret) {
+  libtock_framebuffer_t* framebuffer = flushing_framebuffer;
+
+  if (ret != RETURNCODE_SUCCESS) {
+    flush_finish(framebuffer, ret);
+    return;
+  }
+
+  framebuffer->writes++;
+  framebuffer->bytes += framebuffer->chunk_length;
+
+  libtock_framebuffer_region_t* region = &framebuffer->flushing[framebuffer->flushing_index];
+  uint32_t height = line_height(framebuffer);
+  framebuffer->flushing_line += framebuffer->chunk_lines;
+  if (framebuffer->flushing_line * height >= region->height) {
+    framebuffer->flushing_index++;
+    framebuffer->flushing_line = 0;
+  }
+
+  if (framebuffer->flushing_index == framebuffer->flushing_count) {
+    flush_finish(framebuffer, RETURNCODE_SUCCESS);
+    return;
+  }
+
+  ret = flush_next(framebuffer);
+  if (ret != RETURNCODE_SUCCESS) flush_finish(framebuffer, ret);
+}
+
+static void flush_empty(__attribute__ ((unused)) int unused0,
+                        __attribute__ ((unused)) int unused1,
+                        __attribute__ ((unused)) int unused2,
+                        void*                        opaque) {
+  libtock_framebuffer_t* framebuffer = (libtock_framebuffer_t*) opaque;
+
+  framebuffer->busy = false;
+  if (framebuffer->cb) framebuffer->cb(RETURNCODE_SUCCESS, framebuffer->opaque);
+}
+
+returncode_t libtock_framebuffer_flush(libtock_framebuffer_t* framebuffer, libtock_framebuffer_callback_flushed cb,
+                                       void* opaque) {
+  returncode_t ret;
+
+  if (framebuffer->busy || flushing_framebuffer != NULL) return RETURNCODE_EBUSY;
+
+  framebuffer->cb     = cb;
+  framebuffer->opaque = opaque;
+  framebuffer->writes = 0;
+  framebuffer->bytes  = 0;
+
+  if (framebuffer->dirty_count == 0) {
+    if (tock_enqueue(flush_empty, 0, 0, 0, framebuffer) < 0) return RETURNCODE_EBUSY;
+    framebuffer->busy = true;
+    return RETURNCODE_SUCCESS;
+  }
+
+  // Take the dirty regions, anything drawn from now on goes to the next
+  // flush. A region is sent from the framebuffer at the full width of the
+  // screen if it is too wide for the transfer buffer, or if the extra pixels
+  // cost less than the pairs needed to send it through the transfer buffer.
+  for (uint32_t i = 0; i < framebuffer->dirty_count; i++) {
+    libtock_framebuffer_region_t* region = &framebuffer->flushing[i];
+    uint32_t height = line_height(framebuffer);
+    uint32_t line_bytes, lines_per_chunk, chunks;
+
+    *region    = framebuffer->dirty[i];
+    line_bytes = framebuffer->format == MONO ? region->width : region->width * framebuffer->pixel_bytes;
+    if (line_bytes <= framebuffer->transfer_length) {
+      uint32_t lines = (region->height + height - 1) / height;
+      lines_per_chunk = framebuffer->transfer_length / line_bytes;
+      chunks          = (lines + lines_per_chunk - 1) / lines_per_chunk;
+      if ((uint32_t) (framebuffer->width - region->width) * region->height >
+          (chunks - 1) * framebuffer->merge_cost) {
+        continue;
+      }
+    }
+    region->x     = 0;
+    region->width = framebuffer->width;
+  }
+  framebuffer->flushing_count = framebuffer->dirty_count;
+  framebuffer->flushing_index = 0;
+  framebuffer->flushing_line  = 0;
+  framebuffer->dirty_count    = 0;
+
+  framebuffer->busy    = true;
+  flushing_framebuffer = framebuffer;
+
+  ret = flush_next(framebuffer);
+  if (ret != RETURNCODE_SUCCESS) {
+    for (uint32_t i = 0; i < framebuffer->flushing_count; i++) {
+      add_region(framebuffer, framebuffer->flushing[i]);
+    }
+    framebuffer->busy    = false;
+    flushing_framebuffer = NULL;
+  }
+  return ret;
+}
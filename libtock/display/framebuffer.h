@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../tock.h"
+#include "screen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Off-screen framebuffer that only sends changed areas to the screen.
+//
+// Drawing into the framebuffer marks the rectangles it touched as dirty.
+// Overlapping or nearby dirty rectangles are merged whenever sending their
+// union costs less than sending them separately, where each extra
+// `libtock_screen_set_frame()` and `libtock_screen_write()` pair is counted as
+// `merge_cost` pixels. A flush then sends each remaining rectangle with as
+// few pairs as the transfer buffer allows.
+//
+// Pixels are stored in the screen's pixel format, as returned by
+// `libtock_screen_get_pixel_format()`:
+//
+// - `RGB_233`, `RGB_565`, `RGB_888` and `ARGB_8888` pixels are stored row by
+//   row, each pixel most significant byte first.
+// - `MONO` pixels are stored in pages of 8 rows, one byte per column with the
+//   top row in the least significant bit, as SSD1306-style controllers expect.
+//   Dirty rectangles are rounded out to whole pages. This is not the packed
+//   row layout of the `MONO` pixel kernels in `pixel.h`, which is only used
+//   for images passed to `libtock_framebuffer_blit()`.
+//
+// Rectangles that span the full width of the screen are contiguous in the
+// framebuffer and are written from it directly. Others are copied a few lines
+// at a time into the transfer buffer. Without a transfer buffer, every dirty
+// rectangle is widened to the full width of the screen.
+//
+// Only one framebuffer can be flushed at a time, as it owns the screen's
+// upcall while it does.
+
+// Most dirty rectangles tracked before the closest ones are merged.
+#define LIBTOCK_FRAMEBUFFER_MAX_REGIONS 8
+
+// Default cost of a set frame and write pair, in pixels.
+#define LIBTOCK_FRAMEBUFFER_MERGE_COST_DEFAULT 256
+
+// Callback when a flush has completed.
+//
+// - `arg1` (`returncode_t`): Status of the screen operations.
+// - `arg2` (`void*`): The opaque pointer passed to `libtock_framebuffer_flush()`.
+typedef void (*libtock_framebuffer_callback_flushed)(returncode_t, void*);
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+} libtock_framebuffer_region_t;
+
+typedef struct {
+  uint16_t width;
+  uint16_t height;
+  libtock_screen_format_t format;
+  // Bytes per pixel, 0 for `MONO`.
+  uint32_t pixel_bytes;
+  // Bytes from one row (or page, for `MONO`) to the next.
+  uint32_t stride;
+
+  uint8_t* buffer;
+  uint8_t* transfer;
+  uint32_t transfer_length;
+
+  // Cost of a set frame and write pair in pixels. May be changed at any time.
+  uint32_t merge_cost;
+
+  libtock_framebuffer_region_t dirty[LIBTOCK_FRAMEBUFFER_MAX_REGIONS];
+  uint32_t dirty_count;
+
+  // Flush in progress: the regions being sent, and the next line of the
+  // current one.
+  libtock_framebuffer_region_t flushing[LIBTOCK_FRAMEBUFFER_MAX_REGIONS];
+  uint32_t flushing_count;
+  uint32_t flushing_index;
+  uint32_t flushing_line;
+  uint32_t chunk_lines;
+  uint8_t* chunk;
+  uint32_t chunk_length;
+  bool busy;
+  libtock_framebuffer_callback_flushed cb;
+  void* opaque;
+
+  // Set frame and write pairs and bytes sent by the last flush.
+  uint32_t writes;
+  uint32_t bytes;
+} libtock_framebuffer_t;
+
+// Size in bytes of a framebuffer for a `width` by `height` screen.
+uint32_t libtock_framebuffer_length(uint16_t width, uint16_t height, libtock_screen_format_t format);
+
+// Initialize a framebuffer for a `width` by `height` screen in `format`.
+//
+// `buffer` holds the pixels and must be at least
+// `libtock_framebuffer_length()` bytes. `transfer` is used to send rectangles
+// narrower than the screen, and may be NULL. The whole framebuffer starts
+// dirty, so the first flush draws every pixel.
+//
+// Returns `RETURNCODE_EINVAL` for an unknown format or an empty screen, and
+// `RETURNCODE_ESIZE` if `buffer` is too small.
+returncode_t libtock_framebuffer_init(libtock_framebuffer_t* framebuffer, uint16_t width, uint16_t height,
+                                      libtock_screen_format_t format, uint8_t* buffer, uint32_t buffer_length,
+                                      uint8_t* transfer, uint32_t transfer_length);
+
+// Mark a rectangle as dirty after changing `buffer` directly. The rectangle is
+// clipped to the screen.
+void libtock_framebuffer_invalidate(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                                    uint16_t height);
+
+// Mark the whole screen as dirty.
+void libtock_framebuffer_invalidate_all(libtock_framebuffer_t* framebuffer);
+
+// Whether any part of the framebuffer has changed since it was last flushed.
+bool libtock_framebuffer_is_dirty(const libtock_framebuffer_t* framebuffer);
+
+// Set one pixel to `color`, a pixel value in the framebuffer's format. Pixels
+// outside the screen are ignored.
+void libtock_framebuffer_set_pixel(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint32_t color);
+
+// Read one pixel, 0 outside the screen.
+uint32_t libtock_framebuffer_get_pixel(const libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y);
+
+// Fill a rectangle with `color`, clipped to the screen.
+void libtock_framebuffer_fill_rect(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                                   uint16_t height, uint32_t color);
+
+// Copy a `width` by `height` image to `x`, `y`, clipped to the screen. The
+// image is in the framebuffer's format with rows `source_stride` bytes apart.
+// For `MONO`, image rows are one bit per pixel with the leftmost pixel in the
+// most significant bit.
+void libtock_framebuffer_blit(libtock_framebuffer_t* framebuffer, uint16_t x, uint16_t y, uint16_t width,
+                              uint16_t height, const uint8_t* source, uint32_t source_stride);
+
+// Send the dirty rectangles to the screen. Drawing may continue during the
+// flush, and anything drawn is sent by the next one. The callback is called
+// once every rectangle has been sent or an operation failed.
+//
+// Returns `RETURNCODE_EBUSY` if a flush is already in progress. If nothing is
+// dirty the callback is still called, from a deferred call.
+returncode_t libtock_framebuffer_flush(libtock_framebuffer_t* framebuffer, libtock_framebuffer_callback_flushed cb,
+                                       void* opaque);
+
+#ifdef __cplusplus
+}
+#endif
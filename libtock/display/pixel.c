@@ -0,0 +1,544 @@
+#include <string.h>
+
+#include "pixel.h"
+
+static const uint8_t pixel_bytes[] = {
+  [MONO]      = 0,
+  [RGB_233]   = 1,
+  [RGB_565]   = 2,
+  [RGB_888]   = 3,
+  [ARGB_8888] = 4,
+};
+
+// RGB_565 with its green field moved to the upper half-word, leaving room for
+// each field to be multiplied by a 5-bit alpha.
+#define SPREAD_565_MASK 0x07E0F81Fu
+
+static bool valid(libtock_screen_format_t format) {
+  return (uint32_t) format <= ARGB_8888;
+}
+
+static bool aligned(const void* pointer, uintptr_t alignment) {
+  return ((uintptr_t) pointer & (alignment - 1)) == 0;
+}
+
+// Between native words and words of big-endian bytes.
+static uint32_t swap_be(uint32_t word) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return __builtin_bswap32(word);
+#else
+  return word;
+#endif
+}
+
+// Native word holding two half-words in memory order.
+static uint32_t pack_halves(uint16_t first, uint16_t second) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return first | ((uint32_t) second << 16);
+#else
+  return ((uint32_t) first << 16) | second;
+#endif
+}
+
+static uint32_t load(const uint8_t* pixel, uint32_t size) {
+  switch (size) {
+    case 1:
+      return pixel[0];
+    case 2:
+      return (pixel[0] << 8) | pixel[1];
+    case 3:
+      return (pixel[0] << 16) | (pixel[1] << 8) | pixel[2];
+    default:
+      return ((uint32_t) pixel[0] << 24) | (pixel[1] << 16) | (pixel[2] << 8) | pixel[3];
+  }
+}
+
+static void store(uint8_t* pixel, uint32_t size, uint32_t value) {
+  switch (size) {
+    case 1:
+      pixel[0] = value;
+      break;
+    case 2:
+      pixel[0] = value >> 8;
+      pixel[1] = value;
+      break;
+    case 3:
+      pixel[0] = value >> 16;
+      pixel[1] = value >> 8;
+      pixel[2] = value;
+      break;
+    default:
+      pixel[0] = value >> 24;
+      pixel[1] = value >> 16;
+      pixel[2] = value >> 8;
+      pixel[3] = value;
+      break;
+  }
+}
+
+static uint32_t argb_to_565(uint32_t argb) {
+  return ((argb >> 8) & 0xF800) | ((argb >> 5) & 0x07E0) | ((argb >> 3) & 0x001F);
+}
+
+static uint32_t spread_565(uint32_t pixel) {
+  return (pixel | (pixel << 16)) & SPREAD_565_MASK;
+}
+
+static uint32_t unspread_565(uint32_t spread) {
+  return (spread | (spread >> 16)) & 0xFFFF;
+}
+
+// Divide each 16-bit lane of `x` selected by `mask` by 255, rounding to
+// nearest.
+static uint32_t div255_lanes(uint32_t x, uint32_t mask, uint32_t half) {
+  x += half;
+  return ((x + ((x >> 8) & mask)) >> 8) & mask;
+}
+
+// Blend the RGB channels of `argb` over `destination` with alpha `alpha`,
+// two channels per multiply.
+static uint32_t blend_rgb(uint32_t argb, uint32_t destination, uint32_t alpha) {
+  uint32_t inverse = 255 - alpha;
+  uint32_t rb      = (argb & 0xFF00FF) * alpha + (destination & 0xFF00FF) * inverse;
+  uint32_t g       = (argb & 0x00FF00) * alpha + (destination & 0x00FF00) * inverse;
+  return div255_lanes(rb, 0xFF00FF, 0x800080) | div255_lanes(g, 0xFF00, 0x8000);
+}
+
+static uint32_t blend_alpha(uint32_t alpha, uint32_t destination_alpha) {
+  return alpha + div255_lanes(destination_alpha * (255 - alpha), 0xFF, 0x80);
+}
+
+uint32_t libtock_pixel_from_argb(libtock_screen_format_t format, uint32_t argb) {
+  uint32_t r = (argb >> 16) & 0xFF;
+  uint32_t g = (argb >> 8) & 0xFF;
+  uint32_t b = argb & 0xFF;
+
+  switch (format) {
+    case MONO:
+      return r * 77 + g * 150 + b * 29 >= 128 * 256;
+
+    case RGB_233:
+      return (r & 0xC0) | ((g >> 2) & 0x38) | (b >> 5);
+
+    case RGB_565:
+      return argb_to_565(argb);
+
+    case RGB_888:
+      return argb & 0xFFFFFF;
+
+    case ARGB_8888:
+      return argb;
+
+    default:
+      return 0;
+  }
+}
+
+uint32_t libtock_pixel_to_argb(libtock_screen_format_t format, uint32_t pixel) {
+  uint32_t r, g, b;
+
+  switch (format) {
+    case MONO:
+      return pixel & 1 ? 0xFFFFFFFF : 0xFF000000;
+
+    case RGB_233:
+      r = ((pixel >> 6) & 0x3) * 0x55;
+      g = (pixel >> 3) & 0x7;
+      g = (g << 5) | (g << 2) | (g >> 1);
+      b = pixel & 0x7;
+      b = (b << 5) | (b << 2) | (b >> 1);
+      break;
+
+    case RGB_565:
+      r = (pixel >> 11) & 0x1F;
+      r = (r << 3) | (r >> 2);
+      g = (pixel >> 5) & 0x3F;
+      g = (g << 2) | (g >> 4);
+      b = pixel & 0x1F;
+      b = (b << 3) | (b >> 2);
+      break;
+
+    case RGB_888:
+      return 0xFF000000 | pixel;
+
+    case ARGB_8888:
+      return pixel;
+
+    default:
+      return 0;
+  }
+  return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+uint32_t libtock_pixel_read(libtock_screen_format_t format, const uint8_t* row, uint32_t index) {
+  if (!valid(format)) return 0;
+
+  if (format == MONO) {
+    return (row[index >> 3] >> (7 - (index & 7))) & 1;
+  }
+  return load(row + index * pixel_bytes[format], pixel_bytes[format]);
+}
+
+void libtock_pixel_write(libtock_screen_format_t format, uint8_t* row, uint32_t index, uint32_t pixel) {
+  if (!valid(format)) return;
+
+  if (format == MONO) {
+    uint8_t bit = 0x80 >> (index & 7);
+    if (pixel & 1) {
+      row[index >> 3] |= bit;
+    } else {
+      row[index >> 3] &= ~bit;
+    }
+    return;
+  }
+  store(row + index * pixel_bytes[format], pixel_bytes[format], pixel);
+}
+
+returncode_t libtock_pixel_fill(libtock_screen_format_t format, uint8_t* row, uint32_t count, uint32_t pixel) {
+  if (!valid(format)) return RETURNCODE_EINVAL;
+
+  if (format == MONO) {
+    memset(row, pixel & 1 ? 0xFF : 0x00, count >> 3);
+    for (uint32_t i = count & ~7u; i < count; i++) {
+      libtock_pixel_write(format, row, i, pixel);
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  uint32_t size = pixel_bytes[format];
+  if (size == 1) {
+    memset(row, pixel, count);
+    return RETURNCODE_SUCCESS;
+  }
+
+  // The bytes of a row repeat every `period` bytes, a whole number of both
+  // pixels and words. Two periods let any word of the pattern be loaded
+  // without wrapping.
+  uint32_t period = size == 3 ? 12 : 4;
+  uint8_t pattern[24];
+  for (uint32_t i = 0; i < 2 * period; i += size) {
+    store(pattern + i, size, pixel);
+  }
+
+  uint32_t length = count * size;
+  uint32_t i      = 0;
+  for ( ; i < length && !aligned(row + i, 4); i++) {
+    row[i] = pattern[i % period];
+  }
+
+  uint32_t phase = i % period;
+  uint32_t words[3];
+  memcpy(words, pattern + phase, period);
+
+  libtock_pixel_word_t* out  = (libtock_pixel_word_t*) (row + i);
+  uint32_t n                 = (length - i) / 4;
+  libtock_pixel_word_t* last = out + n;
+  if (period == 4) {
+    for ( ; out + 4 <= last; out += 4) {
+      out[0] = words[0];
+      out[1] = words[0];
+      out[2] = words[0];
+      out[3] = words[0];
+    }
+    while (out < last) *out++ = words[0];
+  } else {
+    for ( ; out + 3 <= last; out += 3) {
+      out[0] = words[0];
+      out[1] = words[1];
+      out[2] = words[2];
+    }
+    for (uint32_t j = 0; out < last; j++) *out++ = words[j];
+  }
+
+  for (i += n * 4; i < length; i++) {
+    row[i] = pattern[i % period];
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+// ARGB_8888 or RGB_888 to RGB_565, a word of two destination pixels at a
+// time when both rows are aligned.
+static void convert_to_565(uint8_t* destination, libtock_screen_format_t source_format, const uint8_t* source,
+                           uint32_t count) {
+  uint32_t size = pixel_bytes[source_format];
+  uint32_t i    = 0;
+
+  if (aligned(destination, 2)) {
+    if (count > 0 && !aligned(destination, 4)) {
+      store(destination, 2, argb_to_565(load(source, size)));
+      i = 1;
+    }
+
+    const libtock_pixel_word_t* in = (const libtock_pixel_word_t*) (source + i * size);
+    libtock_pixel_word_t* out      = (libtock_pixel_word_t*) (destination + i * 2);
+    if (aligned(in, 4) && size == 4) {
+      for ( ; i + 2 <= count; i += 2) {
+        uint32_t first  = argb_to_565(swap_be(in[0]));
+        uint32_t second = argb_to_565(swap_be(in[1]));
+        *out++ = swap_be((first << 16) | second);
+        in    += 2;
+      }
+    } else if (aligned(in, 4)) {
+      // Four RGB_888 pixels in three words: RGBR GBRG BRGB.
+      for ( ; i + 4 <= count; i += 4) {
+        uint32_t a = swap_be(in[0]);
+        uint32_t b = swap_be(in[1]);
+        uint32_t c = swap_be(in[2]);
+        out[0] = swap_be((argb_to_565(a >> 8) << 16) | argb_to_565((a << 16) | (b >> 16)));
+        out[1] = swap_be((argb_to_565((b << 8) | (c >> 24)) << 16) | argb_to_565(c));
+        out   += 2;
+        in    += 3;
+      }
+    }
+  }
+
+  for ( ; i < count; i++) {
+    store(destination + i * 2, 2, argb_to_565(load(source + i * size, size)));
+  }
+}
+
+returncode_t libtock_pixel_convert(libtock_screen_format_t destination_format, uint8_t* destination,
+                                   libtock_screen_format_t source_format, const uint8_t* source, uint32_t count) {
+  if (!valid(destination_format) || !valid(source_format)) return RETURNCODE_EINVAL;
+
+  if (destination_format == source_format) {
+    if (destination_format == MONO) {
+      memcpy(destination, source, count >> 3);
+      for (uint32_t i = count & ~7u; i < count; i++) {
+        libtock_pixel_write(MONO, destination, i, libtock_pixel_read(MONO, source, i));
+      }
+    } else {
+      memcpy(destination, source, count * pixel_bytes[destination_format]);
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  if (destination_format == RGB_565 && (source_format == ARGB_8888 || source_format == RGB_888)) {
+    convert_to_565(destination, source_format, source, count);
+    return RETURNCODE_SUCCESS;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t argb = libtock_pixel_to_argb(source_format, libtock_pixel_read(source_format, source, i));
+    libtock_pixel_write(destination_format, destination, i, libtock_pixel_from_argb(destination_format, argb));
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+// Blend one color over one pixel of a format without a specialized kernel.
+static void blend_generic(libtock_screen_format_t format, uint8_t* row, uint32_t index, uint32_t argb) {
+  uint32_t destination = libtock_pixel_to_argb(format, libtock_pixel_read(format, row, index));
+  uint32_t blended     = blend_rgb(argb, destination, argb >> 24);
+  libtock_pixel_write(format, row, index, libtock_pixel_from_argb(format, blended));
+}
+
+static void blend_565(uint8_t* pixel, uint32_t argb) {
+  uint32_t alpha = ((argb >> 24) + 4) >> 3;
+  uint32_t mixed = spread_565(argb_to_565(argb)) * alpha + spread_565(load(pixel, 2)) * (32 - alpha);
+  store(pixel, 2, unspread_565((mixed >> 5) & SPREAD_565_MASK));
+}
+
+returncode_t libtock_pixel_blend(libtock_screen_format_t format, uint8_t* row, const uint32_t* argb, uint32_t count) {
+  if (!valid(format)) return RETURNCODE_EINVAL;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t color = argb[i];
+    uint32_t alpha = color >> 24;
+
+    if (alpha == 0) continue;
+    switch (format) {
+      case RGB_565:
+        blend_565(row + i * 2, color);
+        break;
+
+      case RGB_888:
+        store(row + i * 3, 3, blend_rgb(color, load(row + i * 3, 3), alpha));
+        break;
+
+      case ARGB_8888: {
+        uint32_t destination = load(row + i * 4, 4);
+        store(row + i * 4, 4, (blend_alpha(alpha, destination >> 24) << 24) | blend_rgb(color, destination, alpha));
+        break;
+      }
+
+      default:
+        blend_generic(format, row, i, color);
+        break;
+    }
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+// One color over RGB_565 pixels, with the color's share of the blend
+// computed once and two pixels per word where the row is aligned.
+static void blend_color_565(uint8_t* row, uint32_t count, uint32_t argb) {
+  uint32_t alpha   = ((argb >> 24) + 4) >> 3;
+  uint32_t inverse = 32 - alpha;
+  uint32_t source  = spread_565(argb_to_565(argb)) * alpha;
+  uint32_t i       = 0;
+
+#define BLEND_565(pixel) unspread_565(((source + spread_565(pixel) * inverse) >> 5) & SPREAD_565_MASK)
+
+  if (aligned(row, 2)) {
+    if (count > 0 && !aligned(row, 4)) {
+      store(row, 2, BLEND_565(load(row, 2)));
+      i = 1;
+    }
+    for (libtock_pixel_word_t* word = (libtock_pixel_word_t*) (row + i * 2); i + 2 <= count; i += 2, word++) {
+      uint32_t pair = swap_be(*word);
+      *word = swap_be((BLEND_565(pair >> 16) << 16) | BLEND_565(pair & 0xFFFF));
+    }
+  }
+  for ( ; i < count; i++) {
+    store(row + i * 2, 2, BLEND_565(load(row + i * 2, 2)));
+  }
+
+#undef BLEND_565
+}
+
+returncode_t libtock_pixel_blend_color(libtock_screen_format_t format, uint8_t* row, uint32_t count, uint32_t argb) {
+  uint32_t alpha = argb >> 24;
+
+  if (!valid(format)) return RETURNCODE_EINVAL;
+  if (alpha == 0) return RETURNCODE_SUCCESS;
+  if (alpha == 255) return libtock_pixel_fill(format, row, count, libtock_pixel_from_argb(format, argb));
+
+  switch (format) {
+    case RGB_565:
+      blend_color_565(row, count, argb);
+      break;
+
+    case RGB_888:
+    case ARGB_8888: {
+      uint32_t size    = pixel_bytes[format];
+      uint32_t inverse = 255 - alpha;
+      uint32_t rb      = (argb & 0xFF00FF) * alpha;
+      uint32_t g       = (argb & 0x00FF00) * alpha;
+
+      for (uint8_t* pixel = row; pixel < row + count * size; pixel += size) {
+        uint32_t destination = load(pixel, size);
+        uint32_t blended     = div255_lanes(rb + (destination & 0xFF00FF) * inverse, 0xFF00FF, 0x800080) |
+                               div255_lanes(g + (destination & 0x00FF00) * inverse, 0xFF00, 0x8000);
+        if (size == 4) blended |= blend_alpha(alpha, destination >> 24) << 24;
+        store(pixel, size, blended);
+      }
+      break;
+    }
+
+    default:
+      for (uint32_t i = 0; i < count; i++) {
+        blend_generic(format, row, i, argb);
+      }
+      break;
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+// Destination of source pixel `x`, `y` turned by `rotation`.
+static void rotate(libtock_screen_rotation_t rotation, uint32_t width, uint32_t height, uint32_t x, uint32_t y,
+                   uint32_t* destination_x, uint32_t* destination_y) {
+  switch (rotation) {
+    case ROTATION_90:
+      *destination_x = height - 1 - y;
+      *destination_y = x;
+      break;
+    case ROTATION_180:
+      *destination_x = width - 1 - x;
+      *destination_y = height - 1 - y;
+      break;
+    case ROTATION_270:
+      *destination_x = y;
+      *destination_y = width - 1 - x;
+      break;
+    default:
+      *destination_x = x;
+      *destination_y = y;
+      break;
+  }
+}
+
+static void blit_rows(libtock_screen_format_t format, uint8_t* destination, uint32_t destination_stride,
+                      const uint8_t* source, uint32_t source_stride, uint32_t width, uint32_t first, uint32_t last,
+                      uint32_t height, libtock_screen_rotation_t rotation) {
+  uint32_t size = pixel_bytes[format];
+
+  for (uint32_t y = first; y < last; y++) {
+    const uint8_t* in = source + y * source_stride;
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t destination_x, destination_y;
+      rotate(rotation, width, height, x, y, &destination_x, &destination_y);
+      uint8_t* out = destination + destination_y * destination_stride;
+      if (format == MONO) {
+        libtock_pixel_write(MONO, out, destination_x, libtock_pixel_read(MONO, in, x));
+      } else {
+        store(out + destination_x * size, size, load(in + x * size, size));
+      }
+    }
+  }
+}
+
+// RGB_565 turned a quarter, two source rows at a time so that the pixels
+// they put side by side are stored as one word.
+static void turn_565(uint8_t* destination, uint32_t destination_stride, const uint8_t* source, uint32_t source_stride,
+                     uint32_t width, uint32_t height, libtock_screen_rotation_t rotation) {
+  bool clockwise = rotation == ROTATION_90;
+  uint32_t y     = 0;
+
+  // Column of the left pixel of the pair starting at source row `y`.
+#define PAIR_COLUMN(y) (clockwise ? height - 2 - (y) : (y))
+
+  if (height >= 2 && !aligned(destination + PAIR_COLUMN(0) * 2, 4)) {
+    blit_rows(RGB_565, destination, destination_stride, source, source_stride, width, 0, 1, height, rotation);
+    y = 1;
+  }
+
+  if (aligned(source, 2) && source_stride % 2 == 0 && destination_stride % 4 == 0 && y + 1 < height &&
+      aligned(destination + PAIR_COLUMN(y) * 2, 4)) {
+    for ( ; y + 1 < height; y += 2) {
+      const libtock_pixel_half_t* upper = (const libtock_pixel_half_t*) (source + y * source_stride);
+      const libtock_pixel_half_t* lower = (const libtock_pixel_half_t*) (source + (y + 1) * source_stride);
+      uint8_t* column                   = destination + PAIR_COLUMN(y) * 2;
+
+      if (clockwise) {
+        for (uint32_t x = 0; x < width; x++) {
+          *(libtock_pixel_word_t*) (column + x * destination_stride) = pack_halves(lower[x], upper[x]);
+        }
+      } else {
+        for (uint32_t x = 0; x < width; x++) {
+          *(libtock_pixel_word_t*) (column + (width - 1 - x) * destination_stride) = pack_halves(upper[x], lower[x]);
+        }
+      }
+    }
+  }
+
+#undef PAIR_COLUMN
+
+  blit_rows(RGB_565, destination, destination_stride, source, source_stride, width, y, height, height, rotation);
+}
+
+returncode_t libtock_pixel_blit(libtock_screen_format_t format, uint8_t* destination, uint32_t destination_stride,
+                                const uint8_t* source, uint32_t source_stride, uint32_t width, uint32_t height,
+                                libtock_screen_rotation_t rotation) {
+  if (!valid(format) || (uint32_t) rotation > ROTATION_270) return RETURNCODE_EINVAL;
+
+  uint32_t size = pixel_bytes[format];
+
+  if (rotation == ROTATION_NORMAL && format != MONO) {
+    for (uint32_t y = 0; y < height; y++) {
+      memcpy(destination + y * destination_stride, source + y * source_stride, width * size);
+    }
+  } else if (rotation == ROTATION_180 && format != MONO) {
+    for (uint32_t y = 0; y < height; y++) {
+      const uint8_t* in = source + y * source_stride;
+      uint8_t* out      = destination + (height - 1 - y) * destination_stride + (width - 1) * size;
+      for (uint32_t x = 0; x < width; x++, in += size, out -= size) {
+        store(out, size, load(in, size));
+      }
+    }
+  } else if (format == RGB_565) {
+    turn_565(destination, destination_stride, source, source_stride, width, height, rotation);
+  } else {
+    blit_rows(format, destination, destination_stride, source, source_stride, width, 0, height, height, rotation);
+  }
+  return RETURNCODE_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../tock.h"
+#include "screen.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pixel kernels for the screen pixel formats.
+//
+// Colors are exchanged as 32-bit ARGB values, `0xAARRGGBB`, and converted to
+// and from pixel values in a screen format. In buffers, pixels are stored in
+// rows:
+//
+// - `RGB_233` (`rrgggbbb`), `RGB_565`, `RGB_888` and `ARGB_8888` pixels take
+//   one to four bytes, most significant byte first, as the screen expects
+//   them.
+// - `MONO` pixels take one bit, the leftmost pixel of each byte in its most
+//   significant bit. Pixels are on if their luminance is at least half. This
+//   packed row layout is for images such as fonts and icons, not for the
+//   screen: MONO screens take pages of vertical bytes, see `framebuffer.h`,
+//   and `libtock_framebuffer_blit()` draws such images into that layout.
+//
+// Kernels work on rows of pixels starting at the first byte of `row`. Inner
+// loops read and write whole words where the alignment of the buffers allows,
+// falling back to bytes at the edges.
+//
+// Kernels return `RETURNCODE_EINVAL` for an unknown format.
+
+// Words and halfwords that may alias the byte buffers they are loaded from.
+typedef uint32_t __attribute__ ((may_alias)) libtock_pixel_word_t;
+typedef uint16_t __attribute__ ((may_alias)) libtock_pixel_half_t;
+
+// Convert an ARGB color to a pixel value in `format`, and back. Formats
+// without alpha read as opaque.
+uint32_t libtock_pixel_from_argb(libtock_screen_format_t format, uint32_t argb);
+uint32_t libtock_pixel_to_argb(libtock_screen_format_t format, uint32_t pixel);
+
+// Read or write the pixel value at `index` in a row.
+uint32_t libtock_pixel_read(libtock_screen_format_t format, const uint8_t* row, uint32_t index);
+void libtock_pixel_write(libtock_screen_format_t format, uint8_t* row, uint32_t index, uint32_t pixel);
+
+// Set `count` pixels to the pixel value `pixel`.
+returncode_t libtock_pixel_fill(libtock_screen_format_t format, uint8_t* row, uint32_t count, uint32_t pixel);
+
+// Convert `count` pixels from `source` in `source_format` to `destination` in
+// `destination_format`. The buffers must not overlap.
+returncode_t libtock_pixel_convert(libtock_screen_format_t destination_format, uint8_t* destination,
+                                   libtock_screen_format_t source_format, const uint8_t* source, uint32_t count);
+
+// Blend `count` ARGB colors over the pixels of a row. `RGB_565` blends with
+// 5-bit alpha, other formats with 8-bit alpha. For `ARGB_8888` the color
+// channels are blended as if the row were opaque and the alphas combine.
+returncode_t libtock_pixel_blend(libtock_screen_format_t format, uint8_t* row, const uint32_t* argb, uint32_t count);
+
+// Blend one ARGB color over `count` pixels of a row.
+returncode_t libtock_pixel_blend_color(libtock_screen_format_t format, uint8_t* row, uint32_t count, uint32_t argb);
+
+// Copy a `width` by `height` image from `source` to `destination`, turned
+// clockwise by `rotation`. Rows are `source_stride` and `destination_stride`
+// bytes apart. The destination is `height` by `width` pixels for
+// `ROTATION_90` and `ROTATION_270`. The buffers must not overlap.
+returncode_t libtock_pixel_blit(libtock_screen_format_t format, uint8_t* destination, uint32_t destination_stride,
+                                const uint8_t* source, uint32_t source_stride, uint32_t width, uint32_t height,
+                                libtock_screen_rotation_t rotation);
+
+#ifdef __cplusplus
+}
+#endif
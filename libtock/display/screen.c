@@ -1,7 +1,13 @@
 #include <stdlib.h>
 
+#include "pixel.h"
 #include "screen.h"
 
+// Pixel format of the colors passed to `libtock_screen_fill()`, updated
+// whenever the format is read or set.
+static libtock_screen_format_t screen_format = RGB_565;
+static libtock_screen_format_t requested_format;
+
 static void screen_callback_done(int                          status,
                                  __attribute__ ((unused)) int data1,
                                  __attribute__ ((unused)) int data2,
@@ -15,7 +21,19 @@ static void screen_callback_format(int                          status,
                                    __attribute__ ((unused)) int data2,
                                    void*                        opaque) {
   libtock_screen_callback_format cb = (libtock_screen_callback_format) opaque;
-  cb(tock_status_to_returncode(status), (libtock_screen_format_t) data1);
+  returncode_t ret = tock_status_to_returncode(status);
+  if (ret == RETURNCODE_SUCCESS) screen_format = (libtock_screen_format_t) data1;
+  cb(ret, (libtock_screen_format_t) data1);
+}
+
+static void screen_callback_set_format(int                          status,
+                                       __attribute__ ((unused)) int data1,
+                                       __attribute__ ((unused)) int data2,
+                                       void*                        opaque) {
+  libtock_screen_callback_done cb = (libtock_screen_callback_done) opaque;
+  returncode_t ret = tock_status_to_returncode(status);
+  if (ret == RETURNCODE_SUCCESS) screen_format = requested_format;
+  cb(ret);
 }
 
 static void screen_callback_rotation(int                          status,
@@ -149,9 +167,10 @@ returncode_t libtock_screen_get_pixel_format(libtock_screen_callback_format cb)
 returncode_t libtock_screen_set_pixel_format(libtock_screen_format_t format, libtock_screen_callback_done cb) {
   returncode_t ret;
 
-  ret = libtock_screen_set_upcall(screen_callback_done, cb);
+  ret = libtock_screen_set_upcall(screen_callback_set_format, cb);
   if (ret != RETURNCODE_SUCCESS) return ret;
 
+  requested_format = format;
   ret = libtock_screen_command_set_pixel_format((uint32_t) format);
   return ret;
 }
@@ -191,14 +210,17 @@ returncode_t libtock_screen_set_frame(uint16_t x, uint16_t y, uint16_t width, ui
 }
 
 static returncode_t screen_set_color(uint8_t* buffer, int buffer_len, int position, size_t color) {
-  // TODO color mode
-  if (position < buffer_len - 2) {
-    buffer[position * 2]     = (color >> 8) & 0xFF;
-    buffer[position * 2 + 1] = color & 0xFF;
-    return RETURNCODE_SUCCESS;
-  } else {
-    return RETURNCODE_ESIZE;
+  int bits = libtock_screen_get_bits_per_pixel(screen_format);
+
+  if (screen_format == MONO) {
+    // Fill the whole byte so the driver sees the color whichever bit it reads.
+    if (position / 8 >= buffer_len) return RETURNCODE_ESIZE;
+    return libtock_pixel_fill(MONO, buffer + position / 8, 8, color);
   }
+  if ((position + 1) * bits > buffer_len * 8) return RETURNCODE_ESIZE;
+
+  libtock_pixel_write(screen_format, buffer, position, color);
+  return RETURNCODE_SUCCESS;
 }
 
 returncode_t libtock_screen_fill(uint8_t* buffer, int buffer_len, size_t color, libtock_screen_callback_done cb) {
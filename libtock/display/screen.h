@@ -124,8 +124,10 @@ returncode_t libtock_screen_set_frame(uint16_t x, uint16_t y, uint16_t width, ui
 
 // Fill the screen to a given color.
 //
-// The screen data is in buffer. The callback will be called when the screen is
-// finished being filled.
+// The screen data is in buffer. `color` is a pixel value in the screen's pixel
+// format as last read or set with the functions above, `RGB_565` until then.
+// `libtock_pixel_from_argb()` converts colors to pixel values. The callback
+// will be called when the screen is finished being filled.
 returncode_t libtock_screen_fill(uint8_t* buffer, int buffer_len, size_t color, libtock_screen_callback_done cb);
 
 // Write the data in buffer to the screen.
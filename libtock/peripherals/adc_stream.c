@@ -0,0 +1,334 @@
+#include <string.h>
+
+#include "adc_stream.h"
+
+static int stream_find_free(libtock_adc_stream_t* stream) {
+  for (uint32_t i = 0; i < stream->buffer_count; i++) {
+    if (stream->owners[i] == LIBTOCK_ADC_STREAM_FREE) return i;
+  }
+  return -1;
+}
+
+static void stream_lose(libtock_adc_stream_t* stream, uint32_t samples) {
+  stream->pending_lost    += samples;
+  stream->pending_overflow = true;
+  stream->samples_lost    += samples;
+}
+
+// Hand a full buffer to the app.
+static void stream_deliver(libtock_adc_stream_t* stream, int index, uint32_t sample_count, uint32_t timestamp,
+                           bool overflow) {
+  libtock_adc_stream_block_t* block = &stream->blocks[index];
+
+  block->sample_count  = sample_count;
+  block->channel_count = stream->channel_count;
+  block->sequence      = stream->sequence++;
+  block->timestamp     = timestamp;
+  block->lost          = stream->pending_lost;
+  block->overflow      = overflow || stream->pending_overflow;
+
+  stream->owners[index]    = LIBTOCK_ADC_STREAM_APP;
+  stream->pending_lost     = 0;
+  stream->pending_overflow = false;
+  stream->blocks_delivered++;
+
+  stream->cb(block, stream->opaque);
+}
+
+static returncode_t stream_allow_slot(libtock_adc_stream_t* stream, int slot, int index) {
+  uint16_t* samples = stream->blocks[index].samples;
+
+  if (slot == 0) {
+    return libtock_adc_set_buffer(samples, stream->buffer_length);
+  } else {
+    return libtock_adc_set_double_buffer(samples, stream->buffer_length);
+  }
+}
+
+// Take the buffers back from the kernel. Every buffer not held by the app is
+// free again.
+static void stream_release_kernel(libtock_adc_stream_t* stream) {
+  libtock_adc_set_buffer(NULL, 0);
+  libtock_adc_set_double_buffer(NULL, 0);
+
+  for (uint32_t i = 0; i < stream->buffer_count; i++) {
+    if (stream->owners[i] == LIBTOCK_ADC_STREAM_KERNEL) {
+      stream->owners[i] = LIBTOCK_ADC_STREAM_FREE;
+    }
+  }
+  stream->fill_buffer = -1;
+}
+
+// Continuous mode: the buffer in one of the two slots is full.
+static void stream_buffer_full(libtock_adc_stream_t* stream, uint16_t* samples, uint32_t length) {
+  uint32_t now;
+  int slot;
+
+  libtock_alarm_command_read(&now);
+
+  if (samples == stream->blocks[stream->slots[0]].samples) {
+    slot = 0;
+  } else if (samples == stream->blocks[stream->slots[1]].samples) {
+    slot = 1;
+  } else {
+    return;
+  }
+
+  // Buffers fill at a fixed rate, so the buffer was full at most one period
+  // after the previous one. Upcalls only arrive later than that, never
+  // earlier.
+  uint32_t expected = stream->last_full + stream->block_ticks;
+  if (stream->last_slot < 0 || (int32_t) (now - expected) < 0) {
+    stream->last_full = now;
+  } else {
+    stream->last_full = expected;
+  }
+
+  // By the time the other slot is full as well, the kernel writes into this
+  // buffer again.
+  bool overflow = now - stream->last_full >= stream->block_ticks;
+
+  // The upcall for the other slot's buffer never arrived.
+  if (slot == stream->last_slot) {
+    stream_lose(stream, length);
+    stream->sequence++;
+    stream->blocks_dropped++;
+  }
+  stream->last_slot = slot;
+
+  int index = stream->slots[slot];
+  int free  = stream_find_free(stream);
+  if (free < 0 || stream_allow_slot(stream, slot, free) != RETURNCODE_SUCCESS) {
+    // The kernel keeps the buffer and writes over it.
+    stream_lose(stream, length);
+    stream->sequence++;
+    stream->blocks_dropped++;
+    return;
+  }
+
+  stream->owners[free] = LIBTOCK_ADC_STREAM_KERNEL;
+  stream->slots[slot]  = free;
+  stream_deliver(stream, index, length, stream->last_full - stream->block_ticks, overflow);
+}
+
+// Scan mode: start sampling the next channel of the scan.
+static void stream_scan_next(libtock_adc_stream_t* stream) {
+  if (libtock_adc_command_single_sample(stream->channels[stream->scan_channel]) != RETURNCODE_SUCCESS) {
+    // Drop the partial scan.
+    stream->scan_active = false;
+    stream_lose(stream, stream->channel_count);
+  }
+}
+
+static void stream_scan_sample(libtock_adc_stream_t* stream, uint16_t sample) {
+  if (!stream->scan_active) return;
+
+  int index = stream->fill_buffer;
+  stream->blocks[index].samples[stream->fill_count + stream->scan_channel] = sample;
+  stream->scan_channel++;
+  if (stream->scan_channel < stream->channel_count) {
+    stream_scan_next(stream);
+    return;
+  }
+
+  stream->scan_active = false;
+  stream->fill_count += stream->channel_count;
+  if (stream->fill_count == stream->block_samples) {
+    stream->fill_buffer = -1;
+    stream_deliver(stream, index, stream->block_samples, stream->blocks[index].timestamp, false);
+  }
+}
+
+static void stream_scan_alarm(__attribute__ ((unused)) uint32_t now, uint32_t scheduled, void* opaque) {
+  libtock_adc_stream_t* stream = (libtock_adc_stream_t*) opaque;
+
+  if (!stream->running) return;
+
+  // Schedule from the previous deadline so the scan clock does not drift.
+  libtock_alarm_at(scheduled, stream->scan_ticks, stream_scan_alarm, stream, &stream->alarm);
+
+  if (stream->scan_active) {
+    // The previous scan is still running, skip this one.
+    stream_lose(stream, stream->channel_count);
+    return;
+  }
+
+  if (stream->fill_buffer < 0) {
+    int free = stream_find_free(stream);
+    if (free < 0) {
+      stream_lose(stream, stream->channel_count);
+      return;
+    }
+    stream->owners[free] = LIBTOCK_ADC_STREAM_KERNEL;
+    stream->fill_buffer  = free;
+    stream->fill_count   = 0;
+  }
+
+  if (stream->fill_count == 0) {
+    stream->blocks[stream->fill_buffer].timestamp = scheduled;
+  }
+
+  stream->scan_active  = true;
+  stream->scan_channel = 0;
+  stream_scan_next(stream);
+}
+
+static void stream_upcall(int   callback_type,
+                          int   arg1,
+                          int   arg2,
+                          void* opaque) {
+  libtock_adc_stream_t* stream = (libtock_adc_stream_t*) opaque;
+
+  if (!stream->running) return;
+
+  // Upcalls of an earlier run in the other mode may still be queued.
+  if (callback_type == libtock_adc_SingleSample && stream->scan_mode) {
+    stream_scan_sample(stream, (uint16_t) arg2);
+  } else if (callback_type == libtock_adc_ContinuousBuffer && !stream->scan_mode) {
+    stream_buffer_full(stream, (uint16_t*) arg2, (arg1 >> 8) & 0xFFFFFF);
+  }
+}
+
+// Reset the per-run state.
+static void stream_reset(libtock_adc_stream_t* stream, libtock_adc_stream_callback cb, void* opaque) {
+  stream->cb               = cb;
+  stream->opaque           = opaque;
+  stream->sequence         = 0;
+  stream->pending_lost     = 0;
+  stream->pending_overflow = false;
+  stream->last_slot        = -1;
+  stream->scan_active      = false;
+  stream->fill_buffer      = -1;
+  stream->fill_count       = 0;
+}
+
+// Number of alarm ticks per `count` samples at `frequency`.
+static returncode_t stream_ticks(uint32_t count, uint32_t frequency, uint32_t* ticks) {
+  uint32_t alarm_frequency;
+  returncode_t ret;
+
+  ret = libtock_alarm_command_get_frequency(&alarm_frequency);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  *ticks = (uint32_t) (((uint64_t) count * alarm_frequency) / frequency);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_adc_stream_init(libtock_adc_stream_t* stream, uint16_t* memory, uint32_t buffer_length,
+                                     uint32_t buffer_count) {
+  if (buffer_count < 3 || buffer_count > LIBTOCK_ADC_STREAM_MAX_BUFFERS) return RETURNCODE_EINVAL;
+  if (buffer_length == 0) return RETURNCODE_EINVAL;
+
+  memset(stream, 0, sizeof(libtock_adc_stream_t));
+  for (uint32_t i = 0; i < buffer_count; i++) {
+    stream->blocks[i].samples = memory + i * buffer_length;
+    stream->owners[i]         = LIBTOCK_ADC_STREAM_FREE;
+  }
+  stream->buffer_count  = buffer_count;
+  stream->buffer_length = buffer_length;
+  stream->fill_buffer   = -1;
+  stream->last_slot     = -1;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_adc_stream_start(libtock_adc_stream_t* stream, uint8_t channel, uint32_t frequency,
+                                      libtock_adc_stream_callback cb, void* opaque) {
+  returncode_t ret;
+
+  if (stream->running) return RETURNCODE_EBUSY;
+  if (frequency == 0) return RETURNCODE_EINVAL;
+
+  ret = stream_ticks(stream->buffer_length, frequency, &stream->block_ticks);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Blocks from an earlier run may still be held by the app.
+  // A failed start gives back the buffers it took.
+  for (int slot = 0; slot < 2; slot++) {
+    int free = stream_find_free(stream);
+    if (free < 0) {
+      stream_release_kernel(stream);
+      return RETURNCODE_EBUSY;
+    }
+
+    ret = stream_allow_slot(stream, slot, free);
+    if (ret != RETURNCODE_SUCCESS) {
+      stream_release_kernel(stream);
+      return ret;
+    }
+    stream->owners[free] = LIBTOCK_ADC_STREAM_KERNEL;
+    stream->slots[slot]  = free;
+  }
+
+  stream_reset(stream, cb, opaque);
+  stream->scan_mode     = false;
+  stream->channels[0]   = channel;
+  stream->channel_count = 1;
+  stream->block_samples = stream->buffer_length;
+
+  ret = libtock_adc_set_upcall(stream_upcall, stream);
+  if (ret != RETURNCODE_SUCCESS) {
+    stream_release_kernel(stream);
+    return ret;
+  }
+
+  stream->running = true;
+  ret = libtock_adc_command_continuous_buffered_sample(channel, frequency);
+  if (ret != RETURNCODE_SUCCESS) {
+    stream->running = false;
+    stream_release_kernel(stream);
+  }
+  return ret;
+}
+
+returncode_t libtock_adc_stream_start_scan(libtock_adc_stream_t* stream, const uint8_t* channels,
+                                           uint32_t channel_count, uint32_t scan_frequency,
+                                           libtock_adc_stream_callback cb, void* opaque) {
+  returncode_t ret;
+  uint32_t now;
+
+  if (stream->running) return RETURNCODE_EBUSY;
+  if (channel_count == 0 || channel_count > LIBTOCK_ADC_STREAM_MAX_CHANNELS) return RETURNCODE_EINVAL;
+  if (channel_count > stream->buffer_length || scan_frequency == 0) return RETURNCODE_EINVAL;
+
+  ret = stream_ticks(1, scan_frequency, &stream->scan_ticks);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+  if (stream->scan_ticks == 0) return RETURNCODE_EINVAL;
+
+  stream_reset(stream, cb, opaque);
+  stream->scan_mode = true;
+  memcpy(stream->channels, channels, channel_count);
+  stream->channel_count = channel_count;
+  stream->block_samples = (stream->buffer_length / channel_count) * channel_count;
+  stream->block_ticks   = (stream->block_samples / channel_count) * stream->scan_ticks;
+
+  ret = libtock_adc_set_upcall(stream_upcall, stream);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  stream->running = true;
+  libtock_alarm_command_read(&now);
+  libtock_alarm_at(now, stream->scan_ticks, stream_scan_alarm, stream, &stream->alarm);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_adc_stream_release(libtock_adc_stream_t* stream, libtock_adc_stream_block_t* block) {
+  stream->owners[block - stream->blocks] = LIBTOCK_ADC_STREAM_FREE;
+}
+
+returncode_t libtock_adc_stream_stop(libtock_adc_stream_t* stream) {
+  returncode_t ret = RETURNCODE_SUCCESS;
+
+  if (!stream->running) return RETURNCODE_EALREADY;
+  stream->running = false;
+
+  if (stream->scan_mode) {
+    libtock_alarm_cancel(&stream->alarm);
+    if (stream->scan_active) {
+      ret = libtock_adc_stop_sampling();
+    }
+  } else {
+    ret = libtock_adc_stop_sampling();
+  }
+
+  stream_release_kernel(stream);
+  return ret;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "../services/alarm.h"
+#include "../tock.h"
+#include "adc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lossless ADC acquisition into a pool of buffers.
+//
+// This follows the ownership rules of a streaming process slice
+// (`libtock/util/streaming_process_slice.h`): at any time a buffer is either
+// owned by the kernel, which writes samples into it, or by the app, which
+// reads them. A full buffer is handed to the app by swapping a free buffer into
+// its allow slot in the same upcall, so the kernel always has somewhere to
+// write and the app can take as long as it likes with a buffer, as long as it
+// releases it with `libtock_adc_stream_release()` before the pool runs dry.
+//
+// Every buffer is delivered as a block with its sample count, a sequence
+// number, the time of its first sample and an overflow flag. The overflow flag
+// is set on a block when samples right before or within it were lost:
+//
+// - A buffer was full but no free buffer was left to swap in. The kernel then
+//   writes over the full buffer, and its samples are counted in `lost`.
+// - The upcall for a buffer was handled more than one buffer period after the
+//   buffer was full, so the kernel may already have written into it again.
+// - A scan was due while the previous one was still running.
+//
+// Sequence numbers count every buffer the ADC filled, delivered or not, so a
+// gap in them also shows where data is missing.
+//
+// Two modes are supported:
+//
+// - `libtock_adc_stream_start()` samples one channel continuously at the full
+//   rate of the ADC driver, using its double-buffered mode.
+// - `libtock_adc_stream_start_scan()` samples several channels one after the
+//   other on every tick of a scan clock and stores them interleaved, in the
+//   order given: `ch0, ch1, ch2, ch0, ch1, ch2, ...`. The kernel ADC driver
+//   only buffers a single channel, so every sample of a scan is a separate
+//   request and scan rates are limited to a few kHz.
+//
+// The stream registers its own upcall with the ADC driver. Do not mix it with
+// other `libtock_adc_*()` calls while it runs.
+
+#define LIBTOCK_ADC_STREAM_MAX_BUFFERS  8
+#define LIBTOCK_ADC_STREAM_MAX_CHANNELS 8
+
+typedef struct {
+  // Samples, interleaved by channel in scan mode.
+  uint16_t* samples;
+  uint32_t sample_count;
+  uint32_t channel_count;
+  // Number of the ADC buffer this block was filled into, counting from 0.
+  uint32_t sequence;
+  // Alarm time in ticks of the first sample.
+  uint32_t timestamp;
+  // Samples known to be lost right before this block.
+  uint32_t lost;
+  // Samples may be missing before or within this block.
+  bool overflow;
+} libtock_adc_stream_block_t;
+
+// Function signature for block callbacks.
+//
+// - `arg1` (`libtock_adc_stream_block_t*`): The full block. It belongs to the
+//   app until passed to `libtock_adc_stream_release()`.
+// - `arg2` (`void*`): The `opaque` pointer passed when starting the stream.
+typedef void (*libtock_adc_stream_callback)(libtock_adc_stream_block_t*, void*);
+
+typedef enum {
+  LIBTOCK_ADC_STREAM_FREE,
+  LIBTOCK_ADC_STREAM_KERNEL,
+  LIBTOCK_ADC_STREAM_APP,
+} libtock_adc_stream_owner_t;
+
+// State for one stream. Allocated by the caller and initialized with
+// `libtock_adc_stream_init()`.
+typedef struct {
+  libtock_adc_stream_block_t blocks[LIBTOCK_ADC_STREAM_MAX_BUFFERS];
+  libtock_adc_stream_owner_t owners[LIBTOCK_ADC_STREAM_MAX_BUFFERS];
+  uint32_t buffer_count;
+  uint32_t buffer_length;
+
+  libtock_adc_stream_callback cb;
+  void* opaque;
+  bool running;
+  bool scan_mode;
+
+  // Samples per block and duration of a block in alarm ticks.
+  uint32_t block_samples;
+  uint32_t block_ticks;
+  uint32_t sequence;
+  uint32_t pending_lost;
+  bool pending_overflow;
+
+  // Continuous mode: the buffers allowed to the two ADC slots and the
+  // estimated time the last buffer was full.
+  int slots[2];
+  int last_slot;
+  uint32_t last_full;
+
+  // Scan mode.
+  uint8_t channels[LIBTOCK_ADC_STREAM_MAX_CHANNELS];
+  uint32_t channel_count;
+  uint32_t scan_ticks;
+  // A scan is in progress and `scan_channel` is the next channel to store.
+  bool scan_active;
+  uint32_t scan_channel;
+  // Buffer being filled, -1 if none, and the number of samples in it.
+  int fill_buffer;
+  uint32_t fill_count;
+  libtock_alarm_ticks_t alarm;
+
+  // Statistics.
+  uint32_t blocks_delivered;
+  uint32_t blocks_dropped;
+  uint32_t samples_lost;
+} libtock_adc_stream_t;
+
+// Initialize a stream with `buffer_count` buffers of `buffer_length` samples
+// each, taken from `memory`.
+//
+// Returns `RETURNCODE_EINVAL` unless there are 3 to
+// `LIBTOCK_ADC_STREAM_MAX_BUFFERS` buffers: two are always owned by the
+// kernel, the others can be held by the app.
+returncode_t libtock_adc_stream_init(libtock_adc_stream_t* stream, uint16_t* memory, uint32_t buffer_length,
+                                     uint32_t buffer_count);
+
+// Start sampling `channel` continuously at `frequency` samples per second.
+// `cb` is called with every full buffer.
+returncode_t libtock_adc_stream_start(libtock_adc_stream_t* stream, uint8_t channel, uint32_t frequency,
+                                      libtock_adc_stream_callback cb, void* opaque);
+
+// Start scanning `channel_count` channels `scan_frequency` times per second.
+// Each block holds as many complete scans as fit in a buffer.
+//
+// Returns `RETURNCODE_EINVAL` for more than `LIBTOCK_ADC_STREAM_MAX_CHANNELS`
+// channels or more channels than a buffer holds.
+returncode_t libtock_adc_stream_start_scan(libtock_adc_stream_t* stream, const uint8_t* channels,
+                                           uint32_t channel_count, uint32_t scan_frequency,
+                                           libtock_adc_stream_callback cb, void* opaque);
+
+// Return a delivered block to the pool.
+void libtock_adc_stream_release(libtock_adc_stream_t* stream, libtock_adc_stream_block_t* block);
+
+// Stop sampling. Samples not yet delivered are discarded; blocks held by the
+// app stay valid until released.
+returncode_t libtock_adc_stream_stop(libtock_adc_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,678 @@
+#include <string.h>
+
+#include "crc_software.h"
+
+// Every algorithm is computed with the register bit-reversed, so input bytes
+// are consumed LSB first and all three use the same table-driven code.
+// CRC-16-CCITT feeds reversed bytes into an unreflected register, which is
+// the same as a reflected register with the reversed polynomial 0x8408 whose
+// result is bit-reversed at the end.
+//
+// Each algorithm has slicing-by-4 tables: `table[0]` is the usual byte table
+// and `table[k][i]` is the effect of byte `i` followed by `k` zero bytes,
+// `table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff]`.
+
+static const uint32_t crc32_table[4][256] = {
+  {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
+  },
+  {
+    0x00000000, 0x191b3141, 0x32366282, 0x2b2d53c3, 0x646cc504, 0x7d77f445,
+    0x565aa786, 0x4f4196c7, 0xc8d98a08, 0xd1c2bb49, 0xfaefe88a, 0xe3f4d9cb,
+    0xacb54f0c, 0xb5ae7e4d, 0x9e832d8e, 0x87981ccf, 0x4ac21251, 0x53d92310,
+    0x78f470d3, 0x61ef4192, 0x2eaed755, 0x37b5e614, 0x1c98b5d7, 0x05838496,
+    0x821b9859, 0x9b00a918, 0xb02dfadb, 0xa936cb9a, 0xe6775d5d, 0xff6c6c1c,
+    0xd4413fdf, 0xcd5a0e9e, 0x958424a2, 0x8c9f15e3, 0xa7b24620, 0xbea97761,
+    0xf1e8e1a6, 0xe8f3d0e7, 0xc3de8324, 0xdac5b265, 0x5d5daeaa, 0x44469feb,
+    0x6f6bcc28, 0x7670fd69, 0x39316bae, 0x202a5aef, 0x0b07092c, 0x121c386d,
+    0xdf4636f3, 0xc65d07b2, 0xed705471, 0xf46b6530, 0xbb2af3f7, 0xa231c2b6,
+    0x891c9175, 0x9007a034, 0x179fbcfb, 0x0e848dba, 0x25a9de79, 0x3cb2ef38,
+    0x73f379ff, 0x6ae848be, 0x41c51b7d, 0x58de2a3c, 0xf0794f05, 0xe9627e44,
+    0xc24f2d87, 0xdb541cc6, 0x94158a01, 0x8d0ebb40, 0xa623e883, 0xbf38d9c2,
+    0x38a0c50d, 0x21bbf44c, 0x0a96a78f, 0x138d96ce, 0x5ccc0009, 0x45d73148,
+    0x6efa628b, 0x77e153ca, 0xbabb5d54, 0xa3a06c15, 0x888d3fd6, 0x91960e97,
+    0xded79850, 0xc7cca911, 0xece1fad2, 0xf5facb93, 0x7262d75c, 0x6b79e61d,
+    0x4054b5de, 0x594f849f, 0x160e1258, 0x0f152319, 0x243870da, 0x3d23419b,
+    0x65fd6ba7, 0x7ce65ae6, 0x57cb0925, 0x4ed03864, 0x0191aea3, 0x188a9fe2,
+    0x33a7cc21, 0x2abcfd60, 0xad24e1af, 0xb43fd0ee, 0x9f12832d, 0x8609b26c,
+    0xc94824ab, 0xd05315ea, 0xfb7e4629, 0xe2657768, 0x2f3f79f6, 0x362448b7,
+    0x1d091b74, 0x04122a35, 0x4b53bcf2, 0x52488db3, 0x7965de70, 0x607eef31,
+    0xe7e6f3fe, 0xfefdc2bf, 0xd5d0917c, 0xcccba03d, 0x838a36fa, 0x9a9107bb,
+    0xb1bc5478, 0xa8a76539, 0x3b83984b, 0x2298a90a, 0x09b5fac9, 0x10aecb88,
+    0x5fef5d4f, 0x46f46c0e, 0x6dd93fcd, 0x74c20e8c, 0xf35a1243, 0xea412302,
+    0xc16c70c1, 0xd8774180, 0x9736d747, 0x8e2de606, 0xa500b5c5, 0xbc1b8484,
+    0x71418a1a, 0x685abb5b, 0x4377e898, 0x5a6cd9d9, 0x152d4f1e, 0x0c367e5f,
+    0x271b2d9c, 0x3e001cdd, 0xb9980012, 0xa0833153, 0x8bae6290, 0x92b553d1,
+    0xddf4c516, 0xc4eff457, 0xefc2a794, 0xf6d996d5, 0xae07bce9, 0xb71c8da8,
+    0x9c31de6b, 0x852aef2a, 0xca6b79ed, 0xd37048ac, 0xf85d1b6f, 0xe1462a2e,
+    0x66de36e1, 0x7fc507a0, 0x54e85463, 0x4df36522, 0x02b2f3e5, 0x1ba9c2a4,
+    0x30849167, 0x299fa026, 0xe4c5aeb8, 0xfdde9ff9, 0xd6f3cc3a, 0xcfe8fd7b,
+    0x80a96bbc, 0x99b25afd, 0xb29f093e, 0xab84387f, 0x2c1c24b0, 0x350715f1,
+    0x1e2a4632, 0x07317773, 0x4870e1b4, 0x516bd0f5, 0x7a468336, 0x635db277,
+    0xcbfad74e, 0xd2e1e60f, 0xf9ccb5cc, 0xe0d7848d, 0xaf96124a, 0xb68d230b,
+    0x9da070c8, 0x84bb4189, 0x03235d46, 0x1a386c07, 0x31153fc4, 0x280e0e85,
+    0x674f9842, 0x7e54a903, 0x5579fac0, 0x4c62cb81, 0x8138c51f, 0x9823f45e,
+    0xb30ea79d, 0xaa1596dc, 0xe554001b, 0xfc4f315a, 0xd7626299, 0xce7953d8,
+    0x49e14f17, 0x50fa7e56, 0x7bd72d95, 0x62cc1cd4, 0x2d8d8a13, 0x3496bb52,
+    0x1fbbe891, 0x06a0d9d0, 0x5e7ef3ec, 0x4765c2ad, 0x6c48916e, 0x7553a02f,
+    0x3a1236e8, 0x230907a9, 0x0824546a, 0x113f652b, 0x96a779e4, 0x8fbc48a5,
+    0xa4911b66, 0xbd8a2a27, 0xf2cbbce0, 0xebd08da1, 0xc0fdde62, 0xd9e6ef23,
+    0x14bce1bd, 0x0da7d0fc, 0x268a833f, 0x3f91b27e, 0x70d024b9, 0x69cb15f8,
+    0x42e6463b, 0x5bfd777a, 0xdc656bb5, 0xc57e5af4, 0xee530937, 0xf7483876,
+    0xb809aeb1, 0xa1129ff0, 0x8a3fcc33, 0x9324fd72,
+  },
+  {
+    0x00000000, 0x01c26a37, 0x0384d46e, 0x0246be59, 0x0709a8dc, 0x06cbc2eb,
+    0x048d7cb2, 0x054f1685, 0x0e1351b8, 0x0fd13b8f, 0x0d9785d6, 0x0c55efe1,
+    0x091af964, 0x08d89353, 0x0a9e2d0a, 0x0b5c473d, 0x1c26a370, 0x1de4c947,
+    0x1fa2771e, 0x1e601d29, 0x1b2f0bac, 0x1aed619b, 0x18abdfc2, 0x1969b5f5,
+    0x1235f2c8, 0x13f798ff, 0x11b126a6, 0x10734c91, 0x153c5a14, 0x14fe3023,
+    0x16b88e7a, 0x177ae44d, 0x384d46e0, 0x398f2cd7, 0x3bc9928e, 0x3a0bf8b9,
+    0x3f44ee3c, 0x3e86840b, 0x3cc03a52, 0x3d025065, 0x365e1758, 0x379c7d6f,
+    0x35dac336, 0x3418a901, 0x3157bf84, 0x3095d5b3, 0x32d36bea, 0x331101dd,
+    0x246be590, 0x25a98fa7, 0x27ef31fe, 0x262d5bc9, 0x23624d4c, 0x22a0277b,
+    0x20e69922, 0x2124f315, 0x2a78b428, 0x2bbade1f, 0x29fc6046, 0x283e0a71,
+    0x2d711cf4, 0x2cb376c3, 0x2ef5c89a, 0x2f37a2ad, 0x709a8dc0, 0x7158e7f7,
+    0x731e59ae, 0x72dc3399, 0x7793251c, 0x76514f2b, 0x7417f172, 0x75d59b45,
+    0x7e89dc78, 0x7f4bb64f, 0x7d0d0816, 0x7ccf6221, 0x798074a4, 0x78421e93,
+    0x7a04a0ca, 0x7bc6cafd, 0x6cbc2eb0, 0x6d7e4487, 0x6f38fade, 0x6efa90e9,
+    0x6bb5866c, 0x6a77ec5b, 0x68315202, 0x69f33835, 0x62af7f08, 0x636d153f,
+    0x612bab66, 0x60e9c151, 0x65a6d7d4, 0x6464bde3, 0x662203ba, 0x67e0698d,
+    0x48d7cb20, 0x4915a117, 0x4b531f4e, 0x4a917579, 0x4fde63fc, 0x4e1c09cb,
+    0x4c5ab792, 0x4d98dda5, 0x46c49a98, 0x4706f0af, 0x45404ef6, 0x448224c1,
+    0x41cd3244, 0x400f5873, 0x4249e62a, 0x438b8c1d, 0x54f16850, 0x55330267,
+    0x5775bc3e, 0x56b7d609, 0x53f8c08c, 0x523aaabb, 0x507c14e2, 0x51be7ed5,
+    0x5ae239e8, 0x5b2053df, 0x5966ed86, 0x58a487b1, 0x5deb9134, 0x5c29fb03,
+    0x5e6f455a, 0x5fad2f6d, 0xe1351b80, 0xe0f771b7, 0xe2b1cfee, 0xe373a5d9,
+    0xe63cb35c, 0xe7fed96b, 0xe5b86732, 0xe47a0d05, 0xef264a38, 0xeee4200f,
+    0xeca29e56, 0xed60f461, 0xe82fe2e4, 0xe9ed88d3, 0xebab368a, 0xea695cbd,
+    0xfd13b8f0, 0xfcd1d2c7, 0xfe976c9e, 0xff5506a9, 0xfa1a102c, 0xfbd87a1b,
+    0xf99ec442, 0xf85cae75, 0xf300e948, 0xf2c2837f, 0xf0843d26, 0xf1465711,
+    0xf4094194, 0xf5cb2ba3, 0xf78d95fa, 0xf64fffcd, 0xd9785d60, 0xd8ba3757,
+    0xdafc890e, 0xdb3ee339, 0xde71f5bc, 0xdfb39f8b, 0xddf521d2, 0xdc374be5,
+    0xd76b0cd8, 0xd6a966ef, 0xd4efd8b6, 0xd52db281, 0xd062a404, 0xd1a0ce33,
+    0xd3e6706a, 0xd2241a5d, 0xc55efe10, 0xc49c9427, 0xc6da2a7e, 0xc7184049,
+    0xc25756cc, 0xc3953cfb, 0xc1d382a2, 0xc011e895, 0xcb4dafa8, 0xca8fc59f,
+    0xc8c97bc6, 0xc90b11f1, 0xcc440774, 0xcd866d43, 0xcfc0d31a, 0xce02b92d,
+    0x91af9640, 0x906dfc77, 0x922b422e, 0x93e92819, 0x96a63e9c, 0x976454ab,
+    0x9522eaf2, 0x94e080c5, 0x9fbcc7f8, 0x9e7eadcf, 0x9c381396, 0x9dfa79a1,
+    0x98b56f24, 0x99770513, 0x9b31bb4a, 0x9af3d17d, 0x8d893530, 0x8c4b5f07,
+    0x8e0de15e, 0x8fcf8b69, 0x8a809dec, 0x8b42f7db, 0x89044982, 0x88c623b5,
+    0x839a6488, 0x82580ebf, 0x801eb0e6, 0x81dcdad1, 0x8493cc54, 0x8551a663,
+    0x8717183a, 0x86d5720d, 0xa9e2d0a0, 0xa820ba97, 0xaa6604ce, 0xaba46ef9,
+    0xaeeb787c, 0xaf29124b, 0xad6fac12, 0xacadc625, 0xa7f18118, 0xa633eb2f,
+    0xa4755576, 0xa5b73f41, 0xa0f829c4, 0xa13a43f3, 0xa37cfdaa, 0xa2be979d,
+    0xb5c473d0, 0xb40619e7, 0xb640a7be, 0xb782cd89, 0xb2cddb0c, 0xb30fb13b,
+    0xb1490f62, 0xb08b6555, 0xbbd72268, 0xba15485f, 0xb853f606, 0xb9919c31,
+    0xbcde8ab4, 0xbd1ce083, 0xbf5a5eda, 0xbe9834ed,
+  },
+  {
+    0x00000000, 0xb8bc6765, 0xaa09c88b, 0x12b5afee, 0x8f629757, 0x37def032,
+    0x256b5fdc, 0x9dd738b9, 0xc5b428ef, 0x7d084f8a, 0x6fbde064, 0xd7018701,
+    0x4ad6bfb8, 0xf26ad8dd, 0xe0df7733, 0x58631056, 0x5019579f, 0xe8a530fa,
+    0xfa109f14, 0x42acf871, 0xdf7bc0c8, 0x67c7a7ad, 0x75720843, 0xcdce6f26,
+    0x95ad7f70, 0x2d111815, 0x3fa4b7fb, 0x8718d09e, 0x1acfe827, 0xa2738f42,
+    0xb0c620ac, 0x087a47c9, 0xa032af3e, 0x188ec85b, 0x0a3b67b5, 0xb28700d0,
+    0x2f503869, 0x97ec5f0c, 0x8559f0e2, 0x3de59787, 0x658687d1, 0xdd3ae0b4,
+    0xcf8f4f5a, 0x7733283f, 0xeae41086, 0x525877e3, 0x40edd80d, 0xf851bf68,
+    0xf02bf8a1, 0x48979fc4, 0x5a22302a, 0xe29e574f, 0x7f496ff6, 0xc7f50893,
+    0xd540a77d, 0x6dfcc018, 0x359fd04e, 0x8d23b72b, 0x9f9618c5, 0x272a7fa0,
+    0xbafd4719, 0x0241207c, 0x10f48f92, 0xa848e8f7, 0x9b14583d, 0x23a83f58,
+    0x311d90b6, 0x89a1f7d3, 0x1476cf6a, 0xaccaa80f, 0xbe7f07e1, 0x06c36084,
+    0x5ea070d2, 0xe61c17b7, 0xf4a9b859, 0x4c15df3c, 0xd1c2e785, 0x697e80e0,
+    0x7bcb2f0e, 0xc377486b, 0xcb0d0fa2, 0x73b168c7, 0x6104c729, 0xd9b8a04c,
+    0x446f98f5, 0xfcd3ff90, 0xee66507e, 0x56da371b, 0x0eb9274d, 0xb6054028,
+    0xa4b0efc6, 0x1c0c88a3, 0x81dbb01a, 0x3967d77f, 0x2bd27891, 0x936e1ff4,
+    0x3b26f703, 0x839a9066, 0x912f3f88, 0x299358ed, 0xb4446054, 0x0cf80731,
+    0x1e4da8df, 0xa6f1cfba, 0xfe92dfec, 0x462eb889, 0x549b1767, 0xec277002,
+    0x71f048bb, 0xc94c2fde, 0xdbf98030, 0x6345e755, 0x6b3fa09c, 0xd383c7f9,
+    0xc1366817, 0x798a0f72, 0xe45d37cb, 0x5ce150ae, 0x4e54ff40, 0xf6e89825,
+    0xae8b8873, 0x1637ef16, 0x048240f8, 0xbc3e279d, 0x21e91f24, 0x99557841,
+    0x8be0d7af, 0x335cb0ca, 0xed59b63b, 0x55e5d15e, 0x47507eb0, 0xffec19d5,
+    0x623b216c, 0xda874609, 0xc832e9e7, 0x708e8e82, 0x28ed9ed4, 0x9051f9b1,
+    0x82e4565f, 0x3a58313a, 0xa78f0983, 0x1f336ee6, 0x0d86c108, 0xb53aa66d,
+    0xbd40e1a4, 0x05fc86c1, 0x1749292f, 0xaff54e4a, 0x322276f3, 0x8a9e1196,
+    0x982bbe78, 0x2097d91d, 0x78f4c94b, 0xc048ae2e, 0xd2fd01c0, 0x6a4166a5,
+    0xf7965e1c, 0x4f2a3979, 0x5d9f9697, 0xe523f1f2, 0x4d6b1905, 0xf5d77e60,
+    0xe762d18e, 0x5fdeb6eb, 0xc2098e52, 0x7ab5e937, 0x680046d9, 0xd0bc21bc,
+    0x88df31ea, 0x3063568f, 0x22d6f961, 0x9a6a9e04, 0x07bda6bd, 0xbf01c1d8,
+    0xadb46e36, 0x15080953, 0x1d724e9a, 0xa5ce29ff, 0xb77b8611, 0x0fc7e174,
+    0x9210d9cd, 0x2aacbea8, 0x38191146, 0x80a57623, 0xd8c66675, 0x607a0110,
+    0x72cfaefe, 0xca73c99b, 0x57a4f122, 0xef189647, 0xfdad39a9, 0x45115ecc,
+    0x764dee06, 0xcef18963, 0xdc44268d, 0x64f841e8, 0xf92f7951, 0x41931e34,
+    0x5326b1da, 0xeb9ad6bf, 0xb3f9c6e9, 0x0b45a18c, 0x19f00e62, 0xa14c6907,
+    0x3c9b51be, 0x842736db, 0x96929935, 0x2e2efe50, 0x2654b999, 0x9ee8defc,
+    0x8c5d7112, 0x34e11677, 0xa9362ece, 0x118a49ab, 0x033fe645, 0xbb838120,
+    0xe3e09176, 0x5b5cf613, 0x49e959fd, 0xf1553e98, 0x6c820621, 0xd43e6144,
+    0xc68bceaa, 0x7e37a9cf, 0xd67f4138, 0x6ec3265d, 0x7c7689b3, 0xc4caeed6,
+    0x591dd66f, 0xe1a1b10a, 0xf3141ee4, 0x4ba87981, 0x13cb69d7, 0xab770eb2,
+    0xb9c2a15c, 0x017ec639, 0x9ca9fe80, 0x241599e5, 0x36a0360b, 0x8e1c516e,
+    0x866616a7, 0x3eda71c2, 0x2c6fde2c, 0x94d3b949, 0x090481f0, 0xb1b8e695,
+    0xa30d497b, 0x1bb12e1e, 0x43d23e48, 0xfb6e592d, 0xe9dbf6c3, 0x516791a6,
+    0xccb0a91f, 0x740cce7a, 0x66b96194, 0xde0506f1,
+  },
+};
+
+static const uint32_t crc32c_table[4][256] = {
+  {
+    0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+    0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+    0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+    0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+    0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+    0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+    0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+    0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+    0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+    0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+    0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+    0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+    0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+    0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+    0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+    0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+    0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+    0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+    0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+    0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+    0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+    0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+    0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+    0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+    0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+    0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+    0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+    0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+    0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+    0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+    0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+    0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+    0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+    0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+    0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+    0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+    0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+    0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+    0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+    0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+    0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+    0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+    0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351,
+  },
+  {
+    0x00000000, 0x13a29877, 0x274530ee, 0x34e7a899, 0x4e8a61dc, 0x5d28f9ab,
+    0x69cf5132, 0x7a6dc945, 0x9d14c3b8, 0x8eb65bcf, 0xba51f356, 0xa9f36b21,
+    0xd39ea264, 0xc03c3a13, 0xf4db928a, 0xe7790afd, 0x3fc5f181, 0x2c6769f6,
+    0x1880c16f, 0x0b225918, 0x714f905d, 0x62ed082a, 0x560aa0b3, 0x45a838c4,
+    0xa2d13239, 0xb173aa4e, 0x859402d7, 0x96369aa0, 0xec5b53e5, 0xfff9cb92,
+    0xcb1e630b, 0xd8bcfb7c, 0x7f8be302, 0x6c297b75, 0x58ced3ec, 0x4b6c4b9b,
+    0x310182de, 0x22a31aa9, 0x1644b230, 0x05e62a47, 0xe29f20ba, 0xf13db8cd,
+    0xc5da1054, 0xd6788823, 0xac154166, 0xbfb7d911, 0x8b507188, 0x98f2e9ff,
+    0x404e1283, 0x53ec8af4, 0x670b226d, 0x74a9ba1a, 0x0ec4735f, 0x1d66eb28,
+    0x298143b1, 0x3a23dbc6, 0xdd5ad13b, 0xcef8494c, 0xfa1fe1d5, 0xe9bd79a2,
+    0x93d0b0e7, 0x80722890, 0xb4958009, 0xa737187e, 0xff17c604, 0xecb55e73,
+    0xd852f6ea, 0xcbf06e9d, 0xb19da7d8, 0xa23f3faf, 0x96d89736, 0x857a0f41,
+    0x620305bc, 0x71a19dcb, 0x45463552, 0x56e4ad25, 0x2c896460, 0x3f2bfc17,
+    0x0bcc548e, 0x186eccf9, 0xc0d23785, 0xd370aff2, 0xe797076b, 0xf4359f1c,
+    0x8e585659, 0x9dface2e, 0xa91d66b7, 0xbabffec0, 0x5dc6f43d, 0x4e646c4a,
+    0x7a83c4d3, 0x69215ca4, 0x134c95e1, 0x00ee0d96, 0x3409a50f, 0x27ab3d78,
+    0x809c2506, 0x933ebd71, 0xa7d915e8, 0xb47b8d9f, 0xce1644da, 0xddb4dcad,
+    0xe9537434, 0xfaf1ec43, 0x1d88e6be, 0x0e2a7ec9, 0x3acdd650, 0x296f4e27,
+    0x53028762, 0x40a01f15, 0x7447b78c, 0x67e52ffb, 0xbf59d487, 0xacfb4cf0,
+    0x981ce469, 0x8bbe7c1e, 0xf1d3b55b, 0xe2712d2c, 0xd69685b5, 0xc5341dc2,
+    0x224d173f, 0x31ef8f48, 0x050827d1, 0x16aabfa6, 0x6cc776e3, 0x7f65ee94,
+    0x4b82460d, 0x5820de7a, 0xfbc3faf9, 0xe861628e, 0xdc86ca17, 0xcf245260,
+    0xb5499b25, 0xa6eb0352, 0x920cabcb, 0x81ae33bc, 0x66d73941, 0x7575a136,
+    0x419209af, 0x523091d8, 0x285d589d, 0x3bffc0ea, 0x0f186873, 0x1cbaf004,
+    0xc4060b78, 0xd7a4930f, 0xe3433b96, 0xf0e1a3e1, 0x8a8c6aa4, 0x992ef2d3,
+    0xadc95a4a, 0xbe6bc23d, 0x5912c8c0, 0x4ab050b7, 0x7e57f82e, 0x6df56059,
+    0x1798a91c, 0x043a316b, 0x30dd99f2, 0x237f0185, 0x844819fb, 0x97ea818c,
+    0xa30d2915, 0xb0afb162, 0xcac27827, 0xd960e050, 0xed8748c9, 0xfe25d0be,
+    0x195cda43, 0x0afe4234, 0x3e19eaad, 0x2dbb72da, 0x57d6bb9f, 0x447423e8,
+    0x70938b71, 0x63311306, 0xbb8de87a, 0xa82f700d, 0x9cc8d894, 0x8f6a40e3,
+    0xf50789a6, 0xe6a511d1, 0xd242b948, 0xc1e0213f, 0x26992bc2, 0x353bb3b5,
+    0x01dc1b2c, 0x127e835b, 0x68134a1e, 0x7bb1d269, 0x4f567af0, 0x5cf4e287,
+    0x04d43cfd, 0x1776a48a, 0x23910c13, 0x30339464, 0x4a5e5d21, 0x59fcc556,
+    0x6d1b6dcf, 0x7eb9f5b8, 0x99c0ff45, 0x8a626732, 0xbe85cfab, 0xad2757dc,
+    0xd74a9e99, 0xc4e806ee, 0xf00fae77, 0xe3ad3600, 0x3b11cd7c, 0x28b3550b,
+    0x1c54fd92, 0x0ff665e5, 0x759baca0, 0x663934d7, 0x52de9c4e, 0x417c0439,
+    0xa6050ec4, 0xb5a796b3, 0x81403e2a, 0x92e2a65d, 0xe88f6f18, 0xfb2df76f,
+    0xcfca5ff6, 0xdc68c781, 0x7b5fdfff, 0x68fd4788, 0x5c1aef11, 0x4fb87766,
+    0x35d5be23, 0x26772654, 0x12908ecd, 0x013216ba, 0xe64b1c47, 0xf5e98430,
+    0xc10e2ca9, 0xd2acb4de, 0xa8c17d9b, 0xbb63e5ec, 0x8f844d75, 0x9c26d502,
+    0x449a2e7e, 0x5738b609, 0x63df1e90, 0x707d86e7, 0x0a104fa2, 0x19b2d7d5,
+    0x2d557f4c, 0x3ef7e73b, 0xd98eedc6, 0xca2c75b1, 0xfecbdd28, 0xed69455f,
+    0x97048c1a, 0x84a6146d, 0xb041bcf4, 0xa3e32483,
+  },
+  {
+    0x00000000, 0xa541927e, 0x4f6f520d, 0xea2ec073, 0x9edea41a, 0x3b9f3664,
+    0xd1b1f617, 0x74f06469, 0x38513ec5, 0x9d10acbb, 0x773e6cc8, 0xd27ffeb6,
+    0xa68f9adf, 0x03ce08a1, 0xe9e0c8d2, 0x4ca15aac, 0x70a27d8a, 0xd5e3eff4,
+    0x3fcd2f87, 0x9a8cbdf9, 0xee7cd990, 0x4b3d4bee, 0xa1138b9d, 0x045219e3,
+    0x48f3434f, 0xedb2d131, 0x079c1142, 0xa2dd833c, 0xd62de755, 0x736c752b,
+    0x9942b558, 0x3c032726, 0xe144fb14, 0x4405696a, 0xae2ba919, 0x0b6a3b67,
+    0x7f9a5f0e, 0xdadbcd70, 0x30f50d03, 0x95b49f7d, 0xd915c5d1, 0x7c5457af,
+    0x967a97dc, 0x333b05a2, 0x47cb61cb, 0xe28af3b5, 0x08a433c6, 0xade5a1b8,
+    0x91e6869e, 0x34a714e0, 0xde89d493, 0x7bc846ed, 0x0f382284, 0xaa79b0fa,
+    0x40577089, 0xe516e2f7, 0xa9b7b85b, 0x0cf62a25, 0xe6d8ea56, 0x43997828,
+    0x37691c41, 0x92288e3f, 0x78064e4c, 0xdd47dc32, 0xc76580d9, 0x622412a7,
+    0x880ad2d4, 0x2d4b40aa, 0x59bb24c3, 0xfcfab6bd, 0x16d476ce, 0xb395e4b0,
+    0xff34be1c, 0x5a752c62, 0xb05bec11, 0x151a7e6f, 0x61ea1a06, 0xc4ab8878,
+    0x2e85480b, 0x8bc4da75, 0xb7c7fd53, 0x12866f2d, 0xf8a8af5e, 0x5de93d20,
+    0x29195949, 0x8c58cb37, 0x66760b44, 0xc337993a, 0x8f96c396, 0x2ad751e8,
+    0xc0f9919b, 0x65b803e5, 0x1148678c, 0xb409f5f2, 0x5e273581, 0xfb66a7ff,
+    0x26217bcd, 0x8360e9b3, 0x694e29c0, 0xcc0fbbbe, 0xb8ffdfd7, 0x1dbe4da9,
+    0xf7908dda, 0x52d11fa4, 0x1e704508, 0xbb31d776, 0x511f1705, 0xf45e857b,
+    0x80aee112, 0x25ef736c, 0xcfc1b31f, 0x6a802161, 0x56830647, 0xf3c29439,
+    0x19ec544a, 0xbcadc634, 0xc85da25d, 0x6d1c3023, 0x8732f050, 0x2273622e,
+    0x6ed23882, 0xcb93aafc, 0x21bd6a8f, 0x84fcf8f1, 0xf00c9c98, 0x554d0ee6,
+    0xbf63ce95, 0x1a225ceb, 0x8b277743, 0x2e66e53d, 0xc448254e, 0x6109b730,
+    0x15f9d359, 0xb0b84127, 0x5a968154, 0xffd7132a, 0xb3764986, 0x1637dbf8,
+    0xfc191b8b, 0x595889f5, 0x2da8ed9c, 0x88e97fe2, 0x62c7bf91, 0xc7862def,
+    0xfb850ac9, 0x5ec498b7, 0xb4ea58c4, 0x11abcaba, 0x655baed3, 0xc01a3cad,
+    0x2a34fcde, 0x8f756ea0, 0xc3d4340c, 0x6695a672, 0x8cbb6601, 0x29faf47f,
+    0x5d0a9016, 0xf84b0268, 0x1265c21b, 0xb7245065, 0x6a638c57, 0xcf221e29,
+    0x250cde5a, 0x804d4c24, 0xf4bd284d, 0x51fcba33, 0xbbd27a40, 0x1e93e83e,
+    0x5232b292, 0xf77320ec, 0x1d5de09f, 0xb81c72e1, 0xccec1688, 0x69ad84f6,
+    0x83834485, 0x26c2d6fb, 0x1ac1f1dd, 0xbf8063a3, 0x55aea3d0, 0xf0ef31ae,
+    0x841f55c7, 0x215ec7b9, 0xcb7007ca, 0x6e3195b4, 0x2290cf18, 0x87d15d66,
+    0x6dff9d15, 0xc8be0f6b, 0xbc4e6b02, 0x190ff97c, 0xf321390f, 0x5660ab71,
+    0x4c42f79a, 0xe90365e4, 0x032da597, 0xa66c37e9, 0xd29c5380, 0x77ddc1fe,
+    0x9df3018d, 0x38b293f3, 0x7413c95f, 0xd1525b21, 0x3b7c9b52, 0x9e3d092c,
+    0xeacd6d45, 0x4f8cff3b, 0xa5a23f48, 0x00e3ad36, 0x3ce08a10, 0x99a1186e,
+    0x738fd81d, 0xd6ce4a63, 0xa23e2e0a, 0x077fbc74, 0xed517c07, 0x4810ee79,
+    0x04b1b4d5, 0xa1f026ab, 0x4bdee6d8, 0xee9f74a6, 0x9a6f10cf, 0x3f2e82b1,
+    0xd50042c2, 0x7041d0bc, 0xad060c8e, 0x08479ef0, 0xe2695e83, 0x4728ccfd,
+    0x33d8a894, 0x96993aea, 0x7cb7fa99, 0xd9f668e7, 0x9557324b, 0x3016a035,
+    0xda386046, 0x7f79f238, 0x0b899651, 0xaec8042f, 0x44e6c45c, 0xe1a75622,
+    0xdda47104, 0x78e5e37a, 0x92cb2309, 0x378ab177, 0x437ad51e, 0xe63b4760,
+    0x0c158713, 0xa954156d, 0xe5f54fc1, 0x40b4ddbf, 0xaa9a1dcc, 0x0fdb8fb2,
+    0x7b2bebdb, 0xde6a79a5, 0x3444b9d6, 0x91052ba8,
+  },
+  {
+    0x00000000, 0xdd45aab8, 0xbf672381, 0x62228939, 0x7b2231f3, 0xa6679b4b,
+    0xc4451272, 0x1900b8ca, 0xf64463e6, 0x2b01c95e, 0x49234067, 0x9466eadf,
+    0x8d665215, 0x5023f8ad, 0x32017194, 0xef44db2c, 0xe964b13d, 0x34211b85,
+    0x560392bc, 0x8b463804, 0x924680ce, 0x4f032a76, 0x2d21a34f, 0xf06409f7,
+    0x1f20d2db, 0xc2657863, 0xa047f15a, 0x7d025be2, 0x6402e328, 0xb9474990,
+    0xdb65c0a9, 0x06206a11, 0xd725148b, 0x0a60be33, 0x6842370a, 0xb5079db2,
+    0xac072578, 0x71428fc0, 0x136006f9, 0xce25ac41, 0x2161776d, 0xfc24ddd5,
+    0x9e0654ec, 0x4343fe54, 0x5a43469e, 0x8706ec26, 0xe524651f, 0x3861cfa7,
+    0x3e41a5b6, 0xe3040f0e, 0x81268637, 0x5c632c8f, 0x45639445, 0x98263efd,
+    0xfa04b7c4, 0x27411d7c, 0xc805c650, 0x15406ce8, 0x7762e5d1, 0xaa274f69,
+    0xb327f7a3, 0x6e625d1b, 0x0c40d422, 0xd1057e9a, 0xaba65fe7, 0x76e3f55f,
+    0x14c17c66, 0xc984d6de, 0xd0846e14, 0x0dc1c4ac, 0x6fe34d95, 0xb2a6e72d,
+    0x5de23c01, 0x80a796b9, 0xe2851f80, 0x3fc0b538, 0x26c00df2, 0xfb85a74a,
+    0x99a72e73, 0x44e284cb, 0x42c2eeda, 0x9f874462, 0xfda5cd5b, 0x20e067e3,
+    0x39e0df29, 0xe4a57591, 0x8687fca8, 0x5bc25610, 0xb4868d3c, 0x69c32784,
+    0x0be1aebd, 0xd6a40405, 0xcfa4bccf, 0x12e11677, 0x70c39f4e, 0xad8635f6,
+    0x7c834b6c, 0xa1c6e1d4, 0xc3e468ed, 0x1ea1c255, 0x07a17a9f, 0xdae4d027,
+    0xb8c6591e, 0x6583f3a6, 0x8ac7288a, 0x57828232, 0x35a00b0b, 0xe8e5a1b3,
+    0xf1e51979, 0x2ca0b3c1, 0x4e823af8, 0x93c79040, 0x95e7fa51, 0x48a250e9,
+    0x2a80d9d0, 0xf7c57368, 0xeec5cba2, 0x3380611a, 0x51a2e823, 0x8ce7429b,
+    0x63a399b7, 0xbee6330f, 0xdcc4ba36, 0x0181108e, 0x1881a844, 0xc5c402fc,
+    0xa7e68bc5, 0x7aa3217d, 0x52a0c93f, 0x8fe56387, 0xedc7eabe, 0x30824006,
+    0x2982f8cc, 0xf4c75274, 0x96e5db4d, 0x4ba071f5, 0xa4e4aad9, 0x79a10061,
+    0x1b838958, 0xc6c623e0, 0xdfc69b2a, 0x02833192, 0x60a1b8ab, 0xbde41213,
+    0xbbc47802, 0x6681d2ba, 0x04a35b83, 0xd9e6f13b, 0xc0e649f1, 0x1da3e349,
+    0x7f816a70, 0xa2c4c0c8, 0x4d801be4, 0x90c5b15c, 0xf2e73865, 0x2fa292dd,
+    0x36a22a17, 0xebe780af, 0x89c50996, 0x5480a32e, 0x8585ddb4, 0x58c0770c,
+    0x3ae2fe35, 0xe7a7548d, 0xfea7ec47, 0x23e246ff, 0x41c0cfc6, 0x9c85657e,
+    0x73c1be52, 0xae8414ea, 0xcca69dd3, 0x11e3376b, 0x08e38fa1, 0xd5a62519,
+    0xb784ac20, 0x6ac10698, 0x6ce16c89, 0xb1a4c631, 0xd3864f08, 0x0ec3e5b0,
+    0x17c35d7a, 0xca86f7c2, 0xa8a47efb, 0x75e1d443, 0x9aa50f6f, 0x47e0a5d7,
+    0x25c22cee, 0xf8878656, 0xe1873e9c, 0x3cc29424, 0x5ee01d1d, 0x83a5b7a5,
+    0xf90696d8, 0x24433c60, 0x4661b559, 0x9b241fe1, 0x8224a72b, 0x5f610d93,
+    0x3d4384aa, 0xe0062e12, 0x0f42f53e, 0xd2075f86, 0xb025d6bf, 0x6d607c07,
+    0x7460c4cd, 0xa9256e75, 0xcb07e74c, 0x16424df4, 0x106227e5, 0xcd278d5d,
+    0xaf050464, 0x7240aedc, 0x6b401616, 0xb605bcae, 0xd4273597, 0x09629f2f,
+    0xe6264403, 0x3b63eebb, 0x59416782, 0x8404cd3a, 0x9d0475f0, 0x4041df48,
+    0x22635671, 0xff26fcc9, 0x2e238253, 0xf36628eb, 0x9144a1d2, 0x4c010b6a,
+    0x5501b3a0, 0x88441918, 0xea669021, 0x37233a99, 0xd867e1b5, 0x05224b0d,
+    0x6700c234, 0xba45688c, 0xa345d046, 0x7e007afe, 0x1c22f3c7, 0xc167597f,
+    0xc747336e, 0x1a0299d6, 0x782010ef, 0xa565ba57, 0xbc65029d, 0x6120a825,
+    0x0302211c, 0xde478ba4, 0x31035088, 0xec46fa30, 0x8e647309, 0x5321d9b1,
+    0x4a21617b, 0x9764cbc3, 0xf54642fa, 0x2803e842,
+  },
+};
+
+static const uint32_t crc16ccitt_table[4][256] = {
+  {
+    0x00000000, 0x00001189, 0x00002312, 0x0000329b, 0x00004624, 0x000057ad,
+    0x00006536, 0x000074bf, 0x00008c48, 0x00009dc1, 0x0000af5a, 0x0000bed3,
+    0x0000ca6c, 0x0000dbe5, 0x0000e97e, 0x0000f8f7, 0x00001081, 0x00000108,
+    0x00003393, 0x0000221a, 0x000056a5, 0x0000472c, 0x000075b7, 0x0000643e,
+    0x00009cc9, 0x00008d40, 0x0000bfdb, 0x0000ae52, 0x0000daed, 0x0000cb64,
+    0x0000f9ff, 0x0000e876, 0x00002102, 0x0000308b, 0x00000210, 0x00001399,
+    0x00006726, 0x000076af, 0x00004434, 0x000055bd, 0x0000ad4a, 0x0000bcc3,
+    0x00008e58, 0x00009fd1, 0x0000eb6e, 0x0000fae7, 0x0000c87c, 0x0000d9f5,
+    0x00003183, 0x0000200a, 0x00001291, 0x00000318, 0x000077a7, 0x0000662e,
+    0x000054b5, 0x0000453c, 0x0000bdcb, 0x0000ac42, 0x00009ed9, 0x00008f50,
+    0x0000fbef, 0x0000ea66, 0x0000d8fd, 0x0000c974, 0x00004204, 0x0000538d,
+    0x00006116, 0x0000709f, 0x00000420, 0x000015a9, 0x00002732, 0x000036bb,
+    0x0000ce4c, 0x0000dfc5, 0x0000ed5e, 0x0000fcd7, 0x00008868, 0x000099e1,
+    0x0000ab7a, 0x0000baf3, 0x00005285, 0x0000430c, 0x00007197, 0x0000601e,
+    0x000014a1, 0x00000528, 0x000037b3, 0x0000263a, 0x0000decd, 0x0000cf44,
+    0x0000fddf, 0x0000ec56, 0x000098e9, 0x00008960, 0x0000bbfb, 0x0000aa72,
+    0x00006306, 0x0000728f, 0x00004014, 0x0000519d, 0x00002522, 0x000034ab,
+    0x00000630, 0x000017b9, 0x0000ef4e, 0x0000fec7, 0x0000cc5c, 0x0000ddd5,
+    0x0000a96a, 0x0000b8e3, 0x00008a78, 0x00009bf1, 0x00007387, 0x0000620e,
+    0x00005095, 0x0000411c, 0x000035a3, 0x0000242a, 0x000016b1, 0x00000738,
+    0x0000ffcf, 0x0000ee46, 0x0000dcdd, 0x0000cd54, 0x0000b9eb, 0x0000a862,
+    0x00009af9, 0x00008b70, 0x00008408, 0x00009581, 0x0000a71a, 0x0000b693,
+    0x0000c22c, 0x0000d3a5, 0x0000e13e, 0x0000f0b7, 0x00000840, 0x000019c9,
+    0x00002b52, 0x00003adb, 0x00004e64, 0x00005fed, 0x00006d76, 0x00007cff,
+    0x00009489, 0x00008500, 0x0000b79b, 0x0000a612, 0x0000d2ad, 0x0000c324,
+    0x0000f1bf, 0x0000e036, 0x000018c1, 0x00000948, 0x00003bd3, 0x00002a5a,
+    0x00005ee5, 0x00004f6c, 0x00007df7, 0x00006c7e, 0x0000a50a, 0x0000b483,
+    0x00008618, 0x00009791, 0x0000e32e, 0x0000f2a7, 0x0000c03c, 0x0000d1b5,
+    0x00002942, 0x000038cb, 0x00000a50, 0x00001bd9, 0x00006f66, 0x00007eef,
+    0x00004c74, 0x00005dfd, 0x0000b58b, 0x0000a402, 0x00009699, 0x00008710,
+    0x0000f3af, 0x0000e226, 0x0000d0bd, 0x0000c134, 0x000039c3, 0x0000284a,
+    0x00001ad1, 0x00000b58, 0x00007fe7, 0x00006e6e, 0x00005cf5, 0x00004d7c,
+    0x0000c60c, 0x0000d785, 0x0000e51e, 0x0000f497, 0x00008028, 0x000091a1,
+    0x0000a33a, 0x0000b2b3, 0x00004a44, 0x00005bcd, 0x00006956, 0x000078df,
+    0x00000c60, 0x00001de9, 0x00002f72, 0x00003efb, 0x0000d68d, 0x0000c704,
+    0x0000f59f, 0x0000e416, 0x000090a9, 0x00008120, 0x0000b3bb, 0x0000a232,
+    0x00005ac5, 0x00004b4c, 0x000079d7, 0x0000685e, 0x00001ce1, 0x00000d68,
+    0x00003ff3, 0x00002e7a, 0x0000e70e, 0x0000f687, 0x0000c41c, 0x0000d595,
+    0x0000a12a, 0x0000b0a3, 0x00008238, 0x000093b1, 0x00006b46, 0x00007acf,
+    0x00004854, 0x000059dd, 0x00002d62, 0x00003ceb, 0x00000e70, 0x00001ff9,
+    0x0000f78f, 0x0000e606, 0x0000d49d, 0x0000c514, 0x0000b1ab, 0x0000a022,
+    0x000092b9, 0x00008330, 0x00007bc7, 0x00006a4e, 0x000058d5, 0x0000495c,
+    0x00003de3, 0x00002c6a, 0x00001ef1, 0x00000f78,
+  },
+  {
+    0x00000000, 0x000019d8, 0x000033b0, 0x00002a68, 0x00006760, 0x00007eb8,
+    0x000054d0, 0x00004d08, 0x0000cec0, 0x0000d718, 0x0000fd70, 0x0000e4a8,
+    0x0000a9a0, 0x0000b078, 0x00009a10, 0x000083c8, 0x00009591, 0x00008c49,
+    0x0000a621, 0x0000bff9, 0x0000f2f1, 0x0000eb29, 0x0000c141, 0x0000d899,
+    0x00005b51, 0x00004289, 0x000068e1, 0x00007139, 0x00003c31, 0x000025e9,
+    0x00000f81, 0x00001659, 0x00002333, 0x00003aeb, 0x00001083, 0x0000095b,
+    0x00004453, 0x00005d8b, 0x000077e3, 0x00006e3b, 0x0000edf3, 0x0000f42b,
+    0x0000de43, 0x0000c79b, 0x00008a93, 0x0000934b, 0x0000b923, 0x0000a0fb,
+    0x0000b6a2, 0x0000af7a, 0x00008512, 0x00009cca, 0x0000d1c2, 0x0000c81a,
+    0x0000e272, 0x0000fbaa, 0x00007862, 0x000061ba, 0x00004bd2, 0x0000520a,
+    0x00001f02, 0x000006da, 0x00002cb2, 0x0000356a, 0x00004666, 0x00005fbe,
+    0x000075d6, 0x00006c0e, 0x00002106, 0x000038de, 0x000012b6, 0x00000b6e,
+    0x000088a6, 0x0000917e, 0x0000bb16, 0x0000a2ce, 0x0000efc6, 0x0000f61e,
+    0x0000dc76, 0x0000c5ae, 0x0000d3f7, 0x0000ca2f, 0x0000e047, 0x0000f99f,
+    0x0000b497, 0x0000ad4f, 0x00008727, 0x00009eff, 0x00001d37, 0x000004ef,
+    0x00002e87, 0x0000375f, 0x00007a57, 0x0000638f, 0x000049e7, 0x0000503f,
+    0x00006555, 0x00007c8d, 0x000056e5, 0x00004f3d, 0x00000235, 0x00001bed,
+    0x00003185, 0x0000285d, 0x0000ab95, 0x0000b24d, 0x00009825, 0x000081fd,
+    0x0000ccf5, 0x0000d52d, 0x0000ff45, 0x0000e69d, 0x0000f0c4, 0x0000e91c,
+    0x0000c374, 0x0000daac, 0x000097a4, 0x00008e7c, 0x0000a414, 0x0000bdcc,
+    0x00003e04, 0x000027dc, 0x00000db4, 0x0000146c, 0x00005964, 0x000040bc,
+    0x00006ad4, 0x0000730c, 0x00008ccc, 0x00009514, 0x0000bf7c, 0x0000a6a4,
+    0x0000ebac, 0x0000f274, 0x0000d81c, 0x0000c1c4, 0x0000420c, 0x00005bd4,
+    0x000071bc, 0x00006864, 0x0000256c, 0x00003cb4, 0x000016dc, 0x00000f04,
+    0x0000195d, 0x00000085, 0x00002aed, 0x00003335, 0x00007e3d, 0x000067e5,
+    0x00004d8d, 0x00005455, 0x0000d79d, 0x0000ce45, 0x0000e42d, 0x0000fdf5,
+    0x0000b0fd, 0x0000a925, 0x0000834d, 0x00009a95, 0x0000afff, 0x0000b627,
+    0x00009c4f, 0x00008597, 0x0000c89f, 0x0000d147, 0x0000fb2f, 0x0000e2f7,
+    0x0000613f, 0x000078e7, 0x0000528f, 0x00004b57, 0x0000065f, 0x00001f87,
+    0x000035ef, 0x00002c37, 0x00003a6e, 0x000023b6, 0x000009de, 0x00001006,
+    0x00005d0e, 0x000044d6, 0x00006ebe, 0x00007766, 0x0000f4ae, 0x0000ed76,
+    0x0000c71e, 0x0000dec6, 0x000093ce, 0x00008a16, 0x0000a07e, 0x0000b9a6,
+    0x0000caaa, 0x0000d372, 0x0000f91a, 0x0000e0c2, 0x0000adca, 0x0000b412,
+    0x00009e7a, 0x000087a2, 0x0000046a, 0x00001db2, 0x000037da, 0x00002e02,
+    0x0000630a, 0x00007ad2, 0x000050ba, 0x00004962, 0x00005f3b, 0x000046e3,
+    0x00006c8b, 0x00007553, 0x0000385b, 0x00002183, 0x00000beb, 0x00001233,
+    0x000091fb, 0x00008823, 0x0000a24b, 0x0000bb93, 0x0000f69b, 0x0000ef43,
+    0x0000c52b, 0x0000dcf3, 0x0000e999, 0x0000f041, 0x0000da29, 0x0000c3f1,
+    0x00008ef9, 0x00009721, 0x0000bd49, 0x0000a491, 0x00002759, 0x00003e81,
+    0x000014e9, 0x00000d31, 0x00004039, 0x000059e1, 0x00007389, 0x00006a51,
+    0x00007c08, 0x000065d0, 0x00004fb8, 0x00005660, 0x00001b68, 0x000002b0,
+    0x000028d8, 0x00003100, 0x0000b2c8, 0x0000ab10, 0x00008178, 0x000098a0,
+    0x0000d5a8, 0x0000cc70, 0x0000e618, 0x0000ffc0,
+  },
+  {
+    0x00000000, 0x00005adc, 0x0000b5b8, 0x0000ef64, 0x00006361, 0x000039bd,
+    0x0000d6d9, 0x00008c05, 0x0000c6c2, 0x00009c1e, 0x0000737a, 0x000029a6,
+    0x0000a5a3, 0x0000ff7f, 0x0000101b, 0x00004ac7, 0x00008595, 0x0000df49,
+    0x0000302d, 0x00006af1, 0x0000e6f4, 0x0000bc28, 0x0000534c, 0x00000990,
+    0x00004357, 0x0000198b, 0x0000f6ef, 0x0000ac33, 0x00002036, 0x00007aea,
+    0x0000958e, 0x0000cf52, 0x0000033b, 0x000059e7, 0x0000b683, 0x0000ec5f,
+    0x0000605a, 0x00003a86, 0x0000d5e2, 0x00008f3e, 0x0000c5f9, 0x00009f25,
+    0x00007041, 0x00002a9d, 0x0000a698, 0x0000fc44, 0x00001320, 0x000049fc,
+    0x000086ae, 0x0000dc72, 0x00003316, 0x000069ca, 0x0000e5cf, 0x0000bf13,
+    0x00005077, 0x00000aab, 0x0000406c, 0x00001ab0, 0x0000f5d4, 0x0000af08,
+    0x0000230d, 0x000079d1, 0x000096b5, 0x0000cc69, 0x00000676, 0x00005caa,
+    0x0000b3ce, 0x0000e912, 0x00006517, 0x00003fcb, 0x0000d0af, 0x00008a73,
+    0x0000c0b4, 0x00009a68, 0x0000750c, 0x00002fd0, 0x0000a3d5, 0x0000f909,
+    0x0000166d, 0x00004cb1, 0x000083e3, 0x0000d93f, 0x0000365b, 0x00006c87,
+    0x0000e082, 0x0000ba5e, 0x0000553a, 0x00000fe6, 0x00004521, 0x00001ffd,
+    0x0000f099, 0x0000aa45, 0x00002640, 0x00007c9c, 0x000093f8, 0x0000c924,
+    0x0000054d, 0x00005f91, 0x0000b0f5, 0x0000ea29, 0x0000662c, 0x00003cf0,
+    0x0000d394, 0x00008948, 0x0000c38f, 0x00009953, 0x00007637, 0x00002ceb,
+    0x0000a0ee, 0x0000fa32, 0x00001556, 0x00004f8a, 0x000080d8, 0x0000da04,
+    0x00003560, 0x00006fbc, 0x0000e3b9, 0x0000b965, 0x00005601, 0x00000cdd,
+    0x0000461a, 0x00001cc6, 0x0000f3a2, 0x0000a97e, 0x0000257b, 0x00007fa7,
+    0x000090c3, 0x0000ca1f, 0x00000cec, 0x00005630, 0x0000b954, 0x0000e388,
+    0x00006f8d, 0x00003551, 0x0000da35, 0x000080e9, 0x0000ca2e, 0x000090f2,
+    0x00007f96, 0x0000254a, 0x0000a94f, 0x0000f393, 0x00001cf7, 0x0000462b,
+    0x00008979, 0x0000d3a5, 0x00003cc1, 0x0000661d, 0x0000ea18, 0x0000b0c4,
+    0x00005fa0, 0x0000057c, 0x00004fbb, 0x00001567, 0x0000fa03, 0x0000a0df,
+    0x00002cda, 0x00007606, 0x00009962, 0x0000c3be, 0x00000fd7, 0x0000550b,
+    0x0000ba6f, 0x0000e0b3, 0x00006cb6, 0x0000366a, 0x0000d90e, 0x000083d2,
+    0x0000c915, 0x000093c9, 0x00007cad, 0x00002671, 0x0000aa74, 0x0000f0a8,
+    0x00001fcc, 0x00004510, 0x00008a42, 0x0000d09e, 0x00003ffa, 0x00006526,
+    0x0000e923, 0x0000b3ff, 0x00005c9b, 0x00000647, 0x00004c80, 0x0000165c,
+    0x0000f938, 0x0000a3e4, 0x00002fe1, 0x0000753d, 0x00009a59, 0x0000c085,
+    0x00000a9a, 0x00005046, 0x0000bf22, 0x0000e5fe, 0x000069fb, 0x00003327,
+    0x0000dc43, 0x0000869f, 0x0000cc58, 0x00009684, 0x000079e0, 0x0000233c,
+    0x0000af39, 0x0000f5e5, 0x00001a81, 0x0000405d, 0x00008f0f, 0x0000d5d3,
+    0x00003ab7, 0x0000606b, 0x0000ec6e, 0x0000b6b2, 0x000059d6, 0x0000030a,
+    0x000049cd, 0x00001311, 0x0000fc75, 0x0000a6a9, 0x00002aac, 0x00007070,
+    0x00009f14, 0x0000c5c8, 0x000009a1, 0x0000537d, 0x0000bc19, 0x0000e6c5,
+    0x00006ac0, 0x0000301c, 0x0000df78, 0x000085a4, 0x0000cf63, 0x000095bf,
+    0x00007adb, 0x00002007, 0x0000ac02, 0x0000f6de, 0x000019ba, 0x00004366,
+    0x00008c34, 0x0000d6e8, 0x0000398c, 0x00006350, 0x0000ef55, 0x0000b589,
+    0x00005aed, 0x00000031, 0x00004af6, 0x0000102a, 0x0000ff4e, 0x0000a592,
+    0x00002997, 0x0000734b, 0x00009c2f, 0x0000c6f3,
+  },
+  {
+    0x00000000, 0x00001cbb, 0x00003976, 0x000025cd, 0x000072ec, 0x00006e57,
+    0x00004b9a, 0x00005721, 0x0000e5d8, 0x0000f963, 0x0000dcae, 0x0000c015,
+    0x00009734, 0x00008b8f, 0x0000ae42, 0x0000b2f9, 0x0000c3a1, 0x0000df1a,
+    0x0000fad7, 0x0000e66c, 0x0000b14d, 0x0000adf6, 0x0000883b, 0x00009480,
+    0x00002679, 0x00003ac2, 0x00001f0f, 0x000003b4, 0x00005495, 0x0000482e,
+    0x00006de3, 0x00007158, 0x00008f53, 0x000093e8, 0x0000b625, 0x0000aa9e,
+    0x0000fdbf, 0x0000e104, 0x0000c4c9, 0x0000d872, 0x00006a8b, 0x00007630,
+    0x000053fd, 0x00004f46, 0x00001867, 0x000004dc, 0x00002111, 0x00003daa,
+    0x00004cf2, 0x00005049, 0x00007584, 0x0000693f, 0x00003e1e, 0x000022a5,
+    0x00000768, 0x00001bd3, 0x0000a92a, 0x0000b591, 0x0000905c, 0x00008ce7,
+    0x0000dbc6, 0x0000c77d, 0x0000e2b0, 0x0000fe0b, 0x000016b7, 0x00000a0c,
+    0x00002fc1, 0x0000337a, 0x0000645b, 0x000078e0, 0x00005d2d, 0x00004196,
+    0x0000f36f, 0x0000efd4, 0x0000ca19, 0x0000d6a2, 0x00008183, 0x00009d38,
+    0x0000b8f5, 0x0000a44e, 0x0000d516, 0x0000c9ad, 0x0000ec60, 0x0000f0db,
+    0x0000a7fa, 0x0000bb41, 0x00009e8c, 0x00008237, 0x000030ce, 0x00002c75,
+    0x000009b8, 0x00001503, 0x00004222, 0x00005e99, 0x00007b54, 0x000067ef,
+    0x000099e4, 0x0000855f, 0x0000a092, 0x0000bc29, 0x0000eb08, 0x0000f7b3,
+    0x0000d27e, 0x0000cec5, 0x00007c3c, 0x00006087, 0x0000454a, 0x000059f1,
+    0x00000ed0, 0x0000126b, 0x000037a6, 0x00002b1d, 0x00005a45, 0x000046fe,
+    0x00006333, 0x00007f88, 0x000028a9, 0x00003412, 0x000011df, 0x00000d64,
+    0x0000bf9d, 0x0000a326, 0x000086eb, 0x00009a50, 0x0000cd71, 0x0000d1ca,
+    0x0000f407, 0x0000e8bc, 0x00002d6e, 0x000031d5, 0x00001418, 0x000008a3,
+    0x00005f82, 0x00004339, 0x000066f4, 0x00007a4f, 0x0000c8b6, 0x0000d40d,
+    0x0000f1c0, 0x0000ed7b, 0x0000ba5a, 0x0000a6e1, 0x0000832c, 0x00009f97,
+    0x0000eecf, 0x0000f274, 0x0000d7b9, 0x0000cb02, 0x00009c23, 0x00008098,
+    0x0000a555, 0x0000b9ee, 0x00000b17, 0x000017ac, 0x00003261, 0x00002eda,
+    0x000079fb, 0x00006540, 0x0000408d, 0x00005c36, 0x0000a23d, 0x0000be86,
+    0x00009b4b, 0x000087f0, 0x0000d0d1, 0x0000cc6a, 0x0000e9a7, 0x0000f51c,
+    0x000047e5, 0x00005b5e, 0x00007e93, 0x00006228, 0x00003509, 0x000029b2,
+    0x00000c7f, 0x000010c4, 0x0000619c, 0x00007d27, 0x000058ea, 0x00004451,
+    0x00001370, 0x00000fcb, 0x00002a06, 0x000036bd, 0x00008444, 0x000098ff,
+    0x0000bd32, 0x0000a189, 0x0000f6a8, 0x0000ea13, 0x0000cfde, 0x0000d365,
+    0x00003bd9, 0x00002762, 0x000002af, 0x00001e14, 0x00004935, 0x0000558e,
+    0x00007043, 0x00006cf8, 0x0000de01, 0x0000c2ba, 0x0000e777, 0x0000fbcc,
+    0x0000aced, 0x0000b056, 0x0000959b, 0x00008920, 0x0000f878, 0x0000e4c3,
+    0x0000c10e, 0x0000ddb5, 0x00008a94, 0x0000962f, 0x0000b3e2, 0x0000af59,
+    0x00001da0, 0x0000011b, 0x000024d6, 0x0000386d, 0x00006f4c, 0x000073f7,
+    0x0000563a, 0x00004a81, 0x0000b48a, 0x0000a831, 0x00008dfc, 0x00009147,
+    0x0000c666, 0x0000dadd, 0x0000ff10, 0x0000e3ab, 0x00005152, 0x00004de9,
+    0x00006824, 0x0000749f, 0x000023be, 0x00003f05, 0x00001ac8, 0x00000673,
+    0x0000772b, 0x00006b90, 0x00004e5d, 0x000052e6, 0x000005c7, 0x0000197c,
+    0x00003cb1, 0x0000200a, 0x000092f3, 0x00008e48, 0x0000ab85, 0x0000b73e,
+    0x0000e01f, 0x0000fca4, 0x0000d969, 0x0000c5d2,
+  },
+};
+
+typedef struct {
+  const uint32_t (*table)[256];
+  // Bit-reversed polynomial.
+  uint32_t poly;
+  uint32_t width;
+  uint32_t init;
+} crc_params_t;
+
+static const crc_params_t crc_params[] = {
+  [LIBTOCK_CRC_32]      = {crc32_table,      0xEDB88320, 32, 0xFFFFFFFF},
+  [LIBTOCK_CRC_32C]     = {crc32c_table,     0x82F63B78, 32, 0xFFFFFFFF},
+  [LIBTOCK_CRC_16CCITT] = {crc16ccitt_table, 0x8408,     16, 0xFFFF    },
+};
+
+static uint32_t reverse16(uint32_t x) {
+  x = ((x >> 1) & 0x5555) | ((x & 0x5555) << 1);
+  x = ((x >> 2) & 0x3333) | ((x & 0x3333) << 2);
+  x = ((x >> 4) & 0x0F0F) | ((x & 0x0F0F) << 4);
+  x = ((x >> 8) & 0x00FF) | ((x & 0x00FF) << 8);
+  return x;
+}
+
+// Convert between the register and the value reported for the algorithm.
+// Both conversions are their own inverse.
+static uint32_t crc_output(libtock_crc_alg_t algorithm, uint32_t value) {
+  return algorithm == LIBTOCK_CRC_16CCITT ? reverse16(value) : ~value;
+}
+
+// Multiply two polynomials modulo the CRC polynomial, all bit-reversed.
+static uint32_t crc_multiply(const crc_params_t* params, uint32_t a, uint32_t b) {
+  uint32_t m = 1u << (params->width - 1);
+  uint32_t p = 0;
+
+  while (m != 0 && a != 0) {
+    if (a & m) {
+      p ^= b;
+      a ^= m;
+    }
+    m >>= 1;
+    b  = b & 1 ? (b >> 1) ^ params->poly : b >> 1;
+  }
+  return p;
+}
+
+// x^(8 * length) modulo the CRC polynomial, by repeated squaring.
+static uint32_t crc_shift(const crc_params_t* params, uint32_t length) {
+  uint32_t result = 1u << (params->width - 1);
+  uint32_t power  = 1u << (params->width - 9);
+
+  while (length != 0) {
+    if (length & 1) {
+      result = crc_multiply(params, result, power);
+    }
+    power    = crc_multiply(params, power, power);
+    length >>= 1;
+  }
+  return result;
+}
+
+void libtock_crc_begin(libtock_crc_t* crc, libtock_crc_alg_t algorithm) {
+  crc->algorithm = algorithm;
+  crc->reg       = crc_params[algorithm].init;
+}
+
+void libtock_crc_update(libtock_crc_t* crc, const uint8_t* buf, uint32_t length) {
+  const uint32_t (*table)[256] = crc_params[crc->algorithm].table;
+  uint32_t reg = crc->reg;
+
+  // Bytes up to the first word boundary.
+  while (length > 0 && ((uintptr_t) buf & 3) != 0) {
+    reg = (reg >> 8) ^ table[0][(reg ^ *buf++) & 0xFF];
+    length--;
+  }
+
+  // Four bytes at a time. The word load assumes a little-endian CPU, as are
+  // all Tock platforms. `memcpy` compiles to a single aligned load without
+  // breaking strict aliasing.
+  while (length >= 4) {
+    uint32_t word;
+    memcpy(&word, buf, sizeof(word));
+    reg ^= word;
+    reg  = table[3][reg & 0xFF] ^ table[2][(reg >> 8) & 0xFF] ^ table[1][(reg >> 16) & 0xFF] ^ table[0][reg >> 24];
+    buf    += 4;
+    length -= 4;
+  }
+
+  while (length > 0) {
+    reg = (reg >> 8) ^ table[0][(reg ^ *buf++) & 0xFF];
+    length--;
+  }
+
+  crc->reg = reg;
+}
+
+void libtock_crc_append(libtock_crc_t* crc, uint32_t chunk_crc, uint32_t length) {
+  const crc_params_t* params = &crc_params[crc->algorithm];
+
+  // CRCs are linear: the register after the chunk is the chunk's own
+  // register, which started from `init`, plus the difference between the
+  // current register and `init` carried through `length` bytes.
+  uint32_t chunk_reg = crc_output(crc->algorithm, chunk_crc);
+  crc->reg = chunk_reg ^ crc_multiply(params, crc_shift(params, length), crc->reg ^ params->init);
+}
+
+uint32_t libtock_crc_end(libtock_crc_t* crc) {
+  return crc_output(crc->algorithm, crc->reg);
+}
+
+uint32_t libtock_crc_software(libtock_crc_alg_t algorithm, const uint8_t* buf, uint32_t length) {
+  libtock_crc_t crc;
+
+  libtock_crc_begin(&crc, algorithm);
+  libtock_crc_update(&crc, buf, length);
+  return libtock_crc_end(&crc);
+}
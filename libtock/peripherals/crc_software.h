@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../tock.h"
+#include "crc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Incremental CRC computed on the CPU.
+//
+// A CRC over input that arrives in pieces is computed with
+// `libtock_crc_begin()`, any number of `libtock_crc_update()` calls and
+// `libtock_crc_end()`, which returns the same value `libtock_crc_compute()`
+// would for the whole input. The software implementation uses 4 kB
+// slicing-by-4 tables per algorithm, kept in flash.
+//
+// `libtock_crc_append()` continues a CRC with a chunk whose CRC was computed
+// on its own, for example by the CRC driver, so large chunks can be handed to
+// the driver while short ones are computed here. `libtocksync_crc_update()`
+// makes that choice automatically.
+
+typedef struct {
+  libtock_crc_alg_t algorithm;
+  // Bit-reversed CRC register.
+  uint32_t reg;
+} libtock_crc_t;
+
+// Start a new CRC with `algorithm`.
+void libtock_crc_begin(libtock_crc_t* crc, libtock_crc_alg_t algorithm);
+
+// Add `length` bytes from `buf` to the CRC.
+void libtock_crc_update(libtock_crc_t* crc, const uint8_t* buf, uint32_t length);
+
+// Add a chunk of `length` bytes whose CRC on its own, as returned by
+// `libtock_crc_compute()` with the same algorithm, is `chunk_crc`.
+void libtock_crc_append(libtock_crc_t* crc, uint32_t chunk_crc, uint32_t length);
+
+// Return the CRC of all input added since `libtock_crc_begin()`.
+uint32_t libtock_crc_end(libtock_crc_t* crc);
+
+// Compute the CRC of `length` bytes of `buf` in one call.
+uint32_t libtock_crc_software(libtock_crc_alg_t algorithm, const uint8_t* buf, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
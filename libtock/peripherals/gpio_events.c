@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "gpio_events.h"
+
+static void gpio_events_wake(__attribute__ ((unused)) int unused0,
+                             __attribute__ ((unused)) int unused1,
+                             __attribute__ ((unused)) int unused2,
+                             void*                        opaque) {
+  libtock_gpio_events_t* events = (libtock_gpio_events_t*) opaque;
+
+  events->wake_pending = false;
+  events->cb(events->opaque);
+}
+
+static libtock_gpio_events_pin_t* gpio_events_find(libtock_gpio_events_t* events, uint32_t pin) {
+  for (uint32_t i = 0; i < events->pin_count; i++) {
+    if (events->pins[i].pin == pin) return &events->pins[i];
+  }
+  return NULL;
+}
+
+static bool gpio_events_wanted(libtock_gpio_events_pin_t* p, bool level) {
+  switch (p->edges) {
+    case libtock_rising_edge:
+      return level;
+    case libtock_falling_edge:
+      return !level;
+    default:
+      return true;
+  }
+}
+
+static void gpio_events_push(libtock_gpio_events_t* events, libtock_gpio_events_pin_t* p, uint32_t timestamp) {
+  if (events->count == events->ring_size) {
+    p->dropped++;
+    events->dropped++;
+    return;
+  }
+
+  libtock_gpio_event_t* event = &events->ring[(events->head + events->count) % events->ring_size];
+  event->pin       = p->pin;
+  event->level     = p->level;
+  event->timestamp = timestamp;
+  events->count++;
+
+  // The callback runs after the upcall returns, once for a batch of events.
+  if (events->cb != NULL && !events->wake_pending) {
+    if (tock_enqueue(gpio_events_wake, 0, 0, 0, events) >= 0) {
+      events->wake_pending = true;
+    }
+  }
+}
+
+static void gpio_events_settled(uint32_t now, uint32_t scheduled, void* opaque);
+
+// The pin changed to `level`.
+static void gpio_events_accept(libtock_gpio_events_pin_t* p, bool level, uint32_t now) {
+  p->level = level;
+  p->accepted++;
+  if (gpio_events_wanted(p, level)) {
+    gpio_events_push(p->events, p, now);
+  }
+
+  if (p->debounce_ticks > 0) {
+    p->settling = true;
+    libtock_alarm_at(now, p->debounce_ticks, gpio_events_settled, p, &p->alarm);
+  }
+}
+
+static void gpio_events_settled(uint32_t now, __attribute__ ((unused)) uint32_t scheduled, void* opaque) {
+  libtock_gpio_events_pin_t* p = (libtock_gpio_events_pin_t*) opaque;
+  int value;
+
+  p->settling = false;
+  if (libtock_gpio_read(p->pin, &value) != RETURNCODE_SUCCESS) return;
+
+  // The last edges during the debounce time left the pin at the other level.
+  if ((value != 0) != p->level) {
+    gpio_events_accept(p, value != 0, now);
+  }
+}
+
+static void gpio_events_upcall(int                          pin_number,
+                               int                          pin_level,
+                               __attribute__ ((unused)) int unused2,
+                               void*                        opaque) {
+  libtock_gpio_events_t* events = (libtock_gpio_events_t*) opaque;
+  uint32_t now;
+
+  libtock_alarm_command_read(&now);
+
+  libtock_gpio_events_pin_t* p = gpio_events_find(events, (uint32_t) pin_number);
+  if (p == NULL) return;
+
+  p->edges_seen++;
+  if (p->settling) {
+    p->bounces++;
+  } else if ((pin_level == 1) == p->level) {
+    p->missed++;
+  } else {
+    gpio_events_accept(p, pin_level == 1, now);
+  }
+}
+
+returncode_t libtock_gpio_events_init(libtock_gpio_events_t* events, libtock_gpio_event_t* ring, uint32_t ring_size,
+                                      libtock_gpio_events_callback cb, void* opaque) {
+  if (ring_size == 0) return RETURNCODE_EINVAL;
+
+  memset(events, 0, sizeof(libtock_gpio_events_t));
+  events->ring      = ring;
+  events->ring_size = ring_size;
+  events->cb        = cb;
+  events->opaque    = opaque;
+  return libtock_gpio_set_upcall(gpio_events_upcall, events);
+}
+
+returncode_t libtock_gpio_events_add_pin(libtock_gpio_events_t* events, uint32_t pin,
+                                         libtock_gpio_input_mode_t pin_config, libtock_gpio_interrupt_mode_t edges,
+                                         uint32_t debounce_ms) {
+  returncode_t ret;
+  uint32_t frequency;
+  int value;
+
+  if (gpio_events_find(events, pin) != NULL) return RETURNCODE_EALREADY;
+  if (events->pin_count == LIBTOCK_GPIO_EVENTS_MAX_PINS) return RETURNCODE_ENOMEM;
+
+  ret = libtock_alarm_command_get_frequency(&frequency);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_gpio_enable_input(pin, pin_config);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_gpio_read(pin, &value);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  libtock_gpio_events_pin_t* p = &events->pins[events->pin_count];
+  memset(p, 0, sizeof(libtock_gpio_events_pin_t));
+  p->pin            = pin;
+  p->edges          = edges;
+  p->debounce_ticks = (uint32_t) (((uint64_t) debounce_ms * frequency) / 1000);
+  p->level          = value != 0;
+  p->events         = events;
+
+  ret = libtock_gpio_enable_interrupt(pin, libtock_change);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  events->pin_count++;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_gpio_events_remove_pin(libtock_gpio_events_t* events, uint32_t pin) {
+  libtock_gpio_events_pin_t* p = gpio_events_find(events, pin);
+  if (p == NULL) return RETURNCODE_EINVAL;
+
+  returncode_t ret = libtock_gpio_disable_interrupt(pin);
+  if (p->settling) {
+    libtock_alarm_cancel(&p->alarm);
+  }
+
+  // Move the last pin into the gap. Its pending alarm refers to its slot, so
+  // it has to be rescheduled there.
+  libtock_gpio_events_pin_t* last = &events->pins[events->pin_count - 1];
+  if (p != last) {
+    if (last->settling) {
+      libtock_alarm_cancel(&last->alarm);
+    }
+    *p = *last;
+    if (p->settling) {
+      libtock_alarm_at(p->alarm.reference, p->alarm.dt, gpio_events_settled, p, &p->alarm);
+    }
+  }
+  events->pin_count--;
+  return ret;
+}
+
+bool libtock_gpio_events_pop(libtock_gpio_events_t* events, libtock_gpio_event_t* event) {
+  if (events->count == 0) return false;
+
+  *event       = events->ring[events->head];
+  events->head = (events->head + 1) % events->ring_size;
+  events->count--;
+  return true;
+}
+
+uint32_t libtock_gpio_events_pending(libtock_gpio_events_t* events) {
+  return events->count;
+}
+
+const libtock_gpio_events_pin_t* libtock_gpio_events_pin_stats(libtock_gpio_events_t* events, uint32_t pin) {
+  return gpio_events_find(events, pin);
+}
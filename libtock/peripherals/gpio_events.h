@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../services/alarm.h"
+#include "../tock.h"
+#include "gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued, timestamped and debounced GPIO interrupts.
+//
+// The GPIO upcall only timestamps each edge, filters it and appends it to a
+// ring of events, so it stays short no matter how much work the app does per
+// event. The app is woken by a callback that runs after the upcall returns,
+// and takes events out of the ring with `libtock_gpio_events_pop()` at its own
+// pace.
+//
+// Timestamps are alarm ticks read when the upcall runs. Upcalls are only
+// delivered while the app yields, so edges that arrive while the app is busy
+// are stamped when it next yields, in order.
+//
+// Per pin:
+//
+// - Debouncing: after an edge is accepted, further edges on the pin are
+//   ignored for the debounce time. The pin is read again when the debounce time
+//   is over, and if it settled at the other level, an event for that level is
+//   added then.
+// - Edge filtering: interrupts are always enabled on both edges, so the level
+//   of the pin is tracked, but only edges of the selected kind become events.
+// - Counters for edges seen, events accepted, bounces ignored, edges missed
+//   (an interrupt reporting the level the pin already had, meaning a pulse
+//   was too short to observe or an upcall was dropped) and events dropped
+//   because the ring was full.
+//
+// The service registers its own upcall with the GPIO driver. Do not set
+// another GPIO interrupt callback while it is in use.
+
+// Maximum number of pins monitored at once.
+#define LIBTOCK_GPIO_EVENTS_MAX_PINS 8
+
+typedef struct {
+  uint32_t pin;
+  // Level of the pin after the edge.
+  bool level;
+  // Alarm time in ticks.
+  uint32_t timestamp;
+} libtock_gpio_event_t;
+
+// Function signature for the wake-up callback. Called once after one or more
+// events were added to an empty ring.
+//
+// - `arg1` (`void*`): The `opaque` pointer passed to
+//   `libtock_gpio_events_init()`.
+typedef void (*libtock_gpio_events_callback)(void*);
+
+struct libtock_gpio_events;
+
+typedef struct {
+  uint32_t pin;
+  libtock_gpio_interrupt_mode_t edges;
+  uint32_t debounce_ticks;
+
+  // Debounced level and whether edges are being ignored.
+  bool level;
+  bool settling;
+  libtock_alarm_ticks_t alarm;
+  struct libtock_gpio_events* events;
+
+  // Statistics.
+  uint32_t edges_seen;
+  uint32_t accepted;
+  uint32_t bounces;
+  uint32_t missed;
+  uint32_t dropped;
+} libtock_gpio_events_pin_t;
+
+// State for the service. Allocated by the caller and initialized with
+// `libtock_gpio_events_init()`.
+typedef struct libtock_gpio_events {
+  libtock_gpio_event_t* ring;
+  uint32_t ring_size;
+  uint32_t head;
+  uint32_t count;
+
+  libtock_gpio_events_pin_t pins[LIBTOCK_GPIO_EVENTS_MAX_PINS];
+  uint32_t pin_count;
+
+  libtock_gpio_events_callback cb;
+  void* opaque;
+  bool wake_pending;
+
+  // Events dropped because the ring was full, over all pins.
+  uint32_t dropped;
+} libtock_gpio_events_t;
+
+// Initialize the service with a ring of `ring_size` events and register its
+// GPIO upcall. `cb` may be `NULL` if the app polls the ring instead.
+returncode_t libtock_gpio_events_init(libtock_gpio_events_t* events, libtock_gpio_event_t* ring, uint32_t ring_size,
+                                      libtock_gpio_events_callback cb, void* opaque);
+
+// Configure `pin` as an input and start reporting its `edges`, debounced by
+// `debounce_ms` milliseconds (0 for none).
+//
+// Returns `RETURNCODE_ENOMEM` if `LIBTOCK_GPIO_EVENTS_MAX_PINS` pins are
+// already monitored and `RETURNCODE_EALREADY` if `pin` is.
+returncode_t libtock_gpio_events_add_pin(libtock_gpio_events_t* events, uint32_t pin,
+                                         libtock_gpio_input_mode_t pin_config, libtock_gpio_interrupt_mode_t edges,
+                                         uint32_t debounce_ms);
+
+// Stop monitoring `pin`. Its events still in the ring stay there.
+returncode_t libtock_gpio_events_remove_pin(libtock_gpio_events_t* events, uint32_t pin);
+
+// Take the oldest event out of the ring. Returns false if it is empty.
+bool libtock_gpio_events_pop(libtock_gpio_events_t* events, libtock_gpio_event_t* event);
+
+// Number of events in the ring.
+uint32_t libtock_gpio_events_pending(libtock_gpio_events_t* events);
+
+// Counters of `pin`, or `NULL` if it is not monitored.
+const libtock_gpio_events_pin_t* libtock_gpio_events_pin_stats(libtock_gpio_events_t* events, uint32_t pin);
+
+#ifdef __cplusplus
+}
+#endif
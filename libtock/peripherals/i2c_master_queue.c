@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "i2c_master_queue.h"
+
+static void queue_upcall(int command_num, int unused1, int unused2, void* opaque);
+
+static returncode_t queue_start(libtock_i2c_master_queue_t* queue,
+                                libtock_i2c_master_queue_transaction_t* transaction) {
+  uint16_t length = transaction->write_length > transaction->read_length ?
+                    transaction->write_length : transaction->read_length;
+  returncode_t ret;
+
+  ret = i2c_master_set_callback(queue_upcall, queue);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = i2c_master_set_buffer(transaction->buffer, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  switch (transaction->op) {
+    case LIBTOCK_I2C_MASTER_QUEUE_WRITE:
+      ret = i2c_master_write(transaction->address, transaction->write_length);
+      break;
+    case LIBTOCK_I2C_MASTER_QUEUE_READ:
+      ret = i2c_master_read(transaction->address, transaction->read_length);
+      break;
+    case LIBTOCK_I2C_MASTER_QUEUE_WRITE_READ:
+      ret = i2c_master_write_read(transaction->address, transaction->write_length, transaction->read_length);
+      break;
+  }
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  queue->busy = true;
+  return RETURNCODE_SUCCESS;
+}
+
+static libtock_i2c_master_queue_transaction_t queue_pop(libtock_i2c_master_queue_t* queue) {
+  libtock_i2c_master_queue_transaction_t transaction = queue->transactions[queue->head];
+
+  queue->head = (queue->head + 1) % LIBTOCK_I2C_MASTER_QUEUE_LENGTH;
+  queue->count--;
+  return transaction;
+}
+
+// Start the head transaction. Transactions that fail to start are completed
+// with the error.
+static void queue_run(libtock_i2c_master_queue_t* queue) {
+  while (!queue->busy && queue->count > 0) {
+    returncode_t ret = queue_start(queue, &queue->transactions[queue->head]);
+    if (ret != RETURNCODE_SUCCESS) {
+      libtock_i2c_master_queue_transaction_t failed = queue_pop(queue);
+      queue->failed++;
+      failed.cb(ret, failed.opaque);
+    }
+  }
+}
+
+static void queue_upcall(__attribute__ ((unused)) int command_num,
+                         __attribute__ ((unused)) int unused1,
+                         __attribute__ ((unused)) int unused2,
+                         void*                        opaque) {
+  libtock_i2c_master_queue_t* queue = (libtock_i2c_master_queue_t*) opaque;
+  libtock_i2c_master_queue_transaction_t done = queue_pop(queue);
+
+  queue->busy = false;
+  queue->completed++;
+
+  // Get the bus going again before the app looks at the result. A
+  // transaction that fails to start here is retried by `queue_run()` after
+  // the callback, and only completed with the error if that fails too, so
+  // callbacks stay in order.
+  if (queue->count > 0) {
+    queue_start(queue, &queue->transactions[queue->head]);
+  }
+  done.cb(RETURNCODE_SUCCESS, done.opaque);
+  queue_run(queue);
+}
+
+static returncode_t queue_submit(libtock_i2c_master_queue_t* queue, libtock_i2c_master_queue_op_t op,
+                                 uint8_t address, uint8_t* buffer, uint16_t write_length, uint16_t read_length,
+                                 libtock_i2c_master_queue_callback cb, void* opaque) {
+  if (queue->count == LIBTOCK_I2C_MASTER_QUEUE_LENGTH) return RETURNCODE_EBUSY;
+
+  libtock_i2c_master_queue_transaction_t* transaction =
+    &queue->transactions[(queue->head + queue->count) % LIBTOCK_I2C_MASTER_QUEUE_LENGTH];
+  transaction->op           = op;
+  transaction->address      = address;
+  transaction->buffer       = buffer;
+  transaction->write_length = write_length;
+  transaction->read_length  = read_length;
+  transaction->cb           = cb;
+  transaction->opaque       = opaque;
+
+  if (queue->busy || queue->count > 0) {
+    queue->count++;
+    return RETURNCODE_SUCCESS;
+  }
+
+  // The queue is empty and the bus idle, so this is the only transaction.
+  returncode_t ret = queue_start(queue, transaction);
+  if (ret == RETURNCODE_SUCCESS) {
+    queue->count++;
+  }
+  return ret;
+}
+
+void libtock_i2c_master_queue_init(libtock_i2c_master_queue_t* queue) {
+  memset(queue, 0, sizeof(libtock_i2c_master_queue_t));
+}
+
+returncode_t libtock_i2c_master_queue_write(libtock_i2c_master_queue_t* queue, uint8_t address, uint8_t* buffer,
+                                            uint16_t length, libtock_i2c_master_queue_callback cb, void* opaque) {
+  return queue_submit(queue, LIBTOCK_I2C_MASTER_QUEUE_WRITE, address, buffer, length, 0, cb, opaque);
+}
+
+returncode_t libtock_i2c_master_queue_read(libtock_i2c_master_queue_t* queue, uint8_t address, uint8_t* buffer,
+                                           uint16_t length, libtock_i2c_master_queue_callback cb, void* opaque) {
+  return queue_submit(queue, LIBTOCK_I2C_MASTER_QUEUE_READ, address, buffer, 0, length, cb, opaque);
+}
+
+returncode_t libtock_i2c_master_queue_write_read(libtock_i2c_master_queue_t* queue, uint8_t address,
+                                                 uint8_t* buffer, uint16_t write_length, uint16_t read_length,
+                                                 libtock_i2c_master_queue_callback cb, void* opaque) {
+  return queue_submit(queue, LIBTOCK_I2C_MASTER_QUEUE_WRITE_READ, address, buffer, write_length, read_length, cb,
+                      opaque);
+}
+
+int libtock_i2c_master_queue_pending(libtock_i2c_master_queue_t* queue) {
+  return queue->count;
+}
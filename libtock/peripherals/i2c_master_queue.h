@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../tock.h"
+#include "i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued I2C master transactions.
+//
+// Writes, reads and write-reads, each with its own buffer and callback, are
+// accepted into a queue and run in order. The next transaction is started
+// from the completion upcall of the previous one, before the previous one's
+// callback runs, so the bus is not left idle while the app handles results.
+//
+// The kernel I2C master driver does not report bus errors (a missing ACK
+// completes like a successful transfer), so callbacks only see errors from
+// starting a transaction.
+//
+// The queue registers its own upcall and buffer with the I2C master driver.
+// Do not mix it with other `i2c_master_*()` calls while transactions are
+// queued.
+
+// Maximum number of queued transactions.
+#define LIBTOCK_I2C_MASTER_QUEUE_LENGTH 16
+
+// Function signature for transaction callbacks.
+//
+// - `arg1` (`returncode_t`): Status of the transaction.
+// - `arg2` (`void*`): The `opaque` pointer passed with the transaction.
+typedef void (*libtock_i2c_master_queue_callback)(returncode_t, void*);
+
+typedef enum {
+  LIBTOCK_I2C_MASTER_QUEUE_WRITE,
+  LIBTOCK_I2C_MASTER_QUEUE_READ,
+  LIBTOCK_I2C_MASTER_QUEUE_WRITE_READ,
+} libtock_i2c_master_queue_op_t;
+
+typedef struct {
+  libtock_i2c_master_queue_op_t op;
+  uint8_t address;
+  uint8_t* buffer;
+  uint16_t write_length;
+  uint16_t read_length;
+  libtock_i2c_master_queue_callback cb;
+  void* opaque;
+} libtock_i2c_master_queue_transaction_t;
+
+// State for one queue. Allocated by the caller and initialized with
+// `libtock_i2c_master_queue_init()`.
+typedef struct {
+  libtock_i2c_master_queue_transaction_t transactions[LIBTOCK_I2C_MASTER_QUEUE_LENGTH];
+  int head;
+  int count;
+  // The head transaction is on the bus.
+  bool busy;
+
+  // Statistics.
+  uint32_t completed;
+  uint32_t failed;
+} libtock_i2c_master_queue_t;
+
+void libtock_i2c_master_queue_init(libtock_i2c_master_queue_t* queue);
+
+// Queue a write of `length` bytes from `buffer` to `address`.
+//
+// Returns `RETURNCODE_EBUSY` if the queue is full. `buffer` must stay valid
+// until `cb` is called. If the bus is idle, the transaction starts right away
+// and errors starting it are returned here instead of through `cb`.
+returncode_t libtock_i2c_master_queue_write(libtock_i2c_master_queue_t* queue, uint8_t address, uint8_t* buffer,
+                                            uint16_t length, libtock_i2c_master_queue_callback cb, void* opaque);
+
+// Queue a read of `length` bytes from `address` into `buffer`.
+returncode_t libtock_i2c_master_queue_read(libtock_i2c_master_queue_t* queue, uint8_t address, uint8_t* buffer,
+                                           uint16_t length, libtock_i2c_master_queue_callback cb, void* opaque);
+
+// Queue a write of `write_length` bytes from `buffer` followed by a repeated
+// start and a read of `read_length` bytes into the same `buffer`, which must
+// hold the larger of the two.
+returncode_t libtock_i2c_master_queue_write_read(libtock_i2c_master_queue_t* queue, uint8_t address,
+                                                 uint8_t* buffer, uint16_t write_length, uint16_t read_length,
+                                                 libtock_i2c_master_queue_callback cb, void* opaque);
+
+// Number of transactions that have not completed yet.
+int libtock_i2c_master_queue_pending(libtock_i2c_master_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
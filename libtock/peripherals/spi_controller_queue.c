@@ -0,0 +1,197 @@
+#include <string.h>
+
+#include "spi_controller_queue.h"
+
+static void queue_run(libtock_spi_controller_queue_t* queue);
+
+static void queue_upcall(__attribute__ ((unused)) int unused0,
+                         __attribute__ ((unused)) int unused1,
+                         __attribute__ ((unused)) int unused2,
+                         void*                        opaque) {
+  libtock_spi_controller_queue_t* queue = (libtock_spi_controller_queue_t*) opaque;
+
+  queue->busy = false;
+  queue_run(queue);
+}
+
+static returncode_t queue_send(libtock_spi_controller_queue_t* queue, const uint8_t* write, uint8_t* read,
+                               size_t length) {
+  returncode_t ret;
+
+  // Also unallows the read buffer of an earlier transfer.
+  ret = libtock_spi_controller_allow_readwrite_read(read, read != NULL ? length : 0);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_spi_controller_allow_readonly_write((uint8_t*) write, length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_spi_controller_set_upcall(queue_upcall, queue);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_spi_controller_command_read_write_bytes(length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  queue->busy = true;
+  queue->transfers++;
+  queue->bytes += length;
+  return RETURNCODE_SUCCESS;
+}
+
+static void job_begin(libtock_spi_controller_queue_t* queue, libtock_spi_controller_queue_job_t* job) {
+  queue->started = true;
+  queue->segment = 0;
+
+  if (job->hold_cs) {
+    // Not every controller supports this, the transfers work either way.
+    libtock_spi_controller_hold_low();
+  }
+
+  if (job->segments == NULL) {
+    queue->stream_current     = 1;
+    queue->stream_next_length = job->fill(job->stream_buffers[0], job->stream_buffer_length, job->opaque);
+  }
+}
+
+// Start the next transfer of the head job, or set `finished` if there is none.
+static returncode_t job_next(libtock_spi_controller_queue_t* queue, libtock_spi_controller_queue_job_t* job,
+                             bool* finished) {
+  returncode_t ret;
+
+  if (job->segments != NULL) {
+    while (queue->segment < job->segment_count && job->segments[queue->segment].length == 0) {
+      queue->segment++;
+    }
+    if (queue->segment == job->segment_count) {
+      *finished = true;
+      return RETURNCODE_SUCCESS;
+    }
+
+    // Only move on once the transfer has started, so a failed start can be
+    // retried.
+    const libtock_spi_controller_segment_t* segment = &job->segments[queue->segment];
+    ret = queue_send(queue, segment->write, segment->read, segment->length);
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    queue->segment++;
+    return RETURNCODE_SUCCESS;
+  }
+
+  if (queue->stream_next_length == 0) {
+    *finished = true;
+    return RETURNCODE_SUCCESS;
+  }
+
+  int next = 1 - queue->stream_current;
+  ret = queue_send(queue, job->stream_buffers[next], NULL, queue->stream_next_length);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  // Prepare the other buffer while this one is on the wire.
+  queue->stream_current     = next;
+  queue->stream_next_length = job->fill(job->stream_buffers[1 - next], job->stream_buffer_length, job->opaque);
+  return RETURNCODE_SUCCESS;
+}
+
+// Work through the queue until a transfer is started or the queue is empty.
+static void queue_run(libtock_spi_controller_queue_t* queue) {
+  queue->running = true;
+
+  while (!queue->busy && queue->count > 0) {
+    libtock_spi_controller_queue_job_t* job = &queue->jobs[queue->head];
+    bool finished = false;
+
+    if (!queue->started) {
+      job_begin(queue, job);
+    }
+
+    returncode_t ret = job_next(queue, job, &finished);
+    if (ret == RETURNCODE_SUCCESS && !finished) break;
+
+    if (job->hold_cs) {
+      libtock_spi_controller_release_low();
+    }
+
+    libtock_spi_controller_queue_job_t done = *job;
+    queue->head    = (queue->head + 1) % LIBTOCK_SPI_CONTROLLER_QUEUE_LENGTH;
+    queue->count  -= 1;
+    queue->started = false;
+
+    // Get the next job on the wire before calling back. A job that finishes
+    // or fails without starting a transfer is completed by the next pass of
+    // the loop, after this callback, so callbacks stay in order.
+    if (queue->count > 0) {
+      libtock_spi_controller_queue_job_t* next = &queue->jobs[queue->head];
+      bool next_finished;
+
+      job_begin(queue, next);
+      job_next(queue, next, &next_finished);
+    }
+    if (done.cb != NULL) {
+      done.cb(ret, done.opaque);
+    }
+  }
+
+  queue->running = false;
+}
+
+static void queue_kick(__attribute__ ((unused)) int unused0,
+                       __attribute__ ((unused)) int unused1,
+                       __attribute__ ((unused)) int unused2,
+                       void*                        opaque) {
+  queue_run((libtock_spi_controller_queue_t*) opaque);
+}
+
+static returncode_t queue_submit(libtock_spi_controller_queue_t* queue, libtock_spi_controller_queue_job_t* job) {
+  if (queue->count == LIBTOCK_SPI_CONTROLLER_QUEUE_LENGTH) return RETURNCODE_EBUSY;
+
+  // Jobs are only processed from upcalls, so `cb` never runs before this
+  // function returns.
+  if (!queue->busy && !queue->running) {
+    if (tock_enqueue(queue_kick, 0, 0, 0, queue) < 0) return RETURNCODE_EBUSY;
+    queue->running = true;
+  }
+
+  queue->jobs[(queue->head + queue->count) % LIBTOCK_SPI_CONTROLLER_QUEUE_LENGTH] = *job;
+  queue->count++;
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_spi_controller_queue_init(libtock_spi_controller_queue_t* queue) {
+  memset(queue, 0, sizeof(libtock_spi_controller_queue_t));
+}
+
+returncode_t libtock_spi_controller_queue_transfer(libtock_spi_controller_queue_t* queue,
+                                                   const libtock_spi_controller_segment_t* segments,
+                                                   size_t segment_count, bool hold_cs,
+                                                   libtock_spi_controller_queue_callback cb, void* opaque) {
+  libtock_spi_controller_queue_job_t job = {
+    .segments      = segments,
+    .segment_count = segment_count,
+    .hold_cs       = hold_cs,
+    .cb            = cb,
+    .opaque        = opaque,
+  };
+
+  if (segment_count == 0) return RETURNCODE_EINVAL;
+  return queue_submit(queue, &job);
+}
+
+returncode_t libtock_spi_controller_queue_stream(libtock_spi_controller_queue_t* queue,
+                                                 libtock_spi_controller_queue_fill fill, uint8_t* buffers,
+                                                 size_t buffer_length, bool hold_cs,
+                                                 libtock_spi_controller_queue_callback cb, void* opaque) {
+  libtock_spi_controller_queue_job_t job = {
+    .fill                 = fill,
+    .stream_buffers       = {buffers, buffers + buffer_length},
+    .stream_buffer_length = buffer_length,
+    .hold_cs              = hold_cs,
+    .cb                   = cb,
+    .opaque               = opaque,
+  };
+
+  if (buffer_length == 0) return RETURNCODE_EINVAL;
+  return queue_submit(queue, &job);
+}
+
+int libtock_spi_controller_queue_pending(libtock_spi_controller_queue_t* queue) {
+  return queue->count;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../tock.h"
+#include "spi_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued and chained SPI controller transfers.
+//
+// Two kinds of jobs are accepted into a queue and run in order:
+//
+// - A scatter list of segments, each with its own write buffer and optional
+//   read buffer, sent back to back.
+// - A stream, where a fill function produces the data into one of two buffers
+//   while the other one is on the wire. Large payloads such as display frames
+//   are generated piece by piece without the bus waiting for the CPU.
+//
+// Every transfer is started from the completion upcall of the previous one.
+// With `hold_cs`, the chip select is held low from the first transfer of a job
+// to the end of its last, if the kernel's SPI controller supports it.
+//
+// The queue registers its own upcall and buffers with the SPI controller
+// driver. Do not mix it with other `libtock_spi_controller_*()` transfers
+// while jobs are queued.
+
+// Maximum number of queued jobs.
+#define LIBTOCK_SPI_CONTROLLER_QUEUE_LENGTH 8
+
+// One transfer of a scatter list. `write` must hold `length` bytes. `read` is
+// `NULL` for a write-only transfer or receives `length` bytes.
+typedef struct {
+  const uint8_t* write;
+  uint8_t* read;
+  size_t length;
+} libtock_spi_controller_segment_t;
+
+// Function signature for job callbacks.
+//
+// - `arg1` (`returncode_t`): Status of the job.
+// - `arg2` (`void*`): The `opaque` pointer passed with the job.
+typedef void (*libtock_spi_controller_queue_callback)(returncode_t, void*);
+
+// Function signature for stream fill functions. Writes up to `arg2` bytes to
+// `arg1` and returns how many it wrote, 0 at the end of the stream.
+//
+// - `arg1` (`uint8_t*`): Buffer to fill.
+// - `arg2` (`size_t`): Size of the buffer.
+// - `arg3` (`void*`): The `opaque` pointer passed with the job.
+typedef size_t (*libtock_spi_controller_queue_fill)(uint8_t*, size_t, void*);
+
+typedef struct {
+  // Scatter list, or `NULL` for a stream.
+  const libtock_spi_controller_segment_t* segments;
+  size_t segment_count;
+
+  // Stream.
+  libtock_spi_controller_queue_fill fill;
+  uint8_t* stream_buffers[2];
+  size_t stream_buffer_length;
+
+  bool hold_cs;
+  libtock_spi_controller_queue_callback cb;
+  void* opaque;
+} libtock_spi_controller_queue_job_t;
+
+// State for one queue. Allocated by the caller and initialized with
+// `libtock_spi_controller_queue_init()`.
+typedef struct {
+  libtock_spi_controller_queue_job_t jobs[LIBTOCK_SPI_CONTROLLER_QUEUE_LENGTH];
+  int head;
+  int count;
+  // A transfer of the head job is on the wire.
+  bool busy;
+  // Set while jobs are being processed or a run is scheduled.
+  bool running;
+  // The head job has started.
+  bool started;
+
+  // Progress of the head job: the segment on the wire, or for a stream the
+  // buffer on the wire and the number of bytes waiting in the other one.
+  size_t segment;
+  int stream_current;
+  size_t stream_next_length;
+
+  // Statistics.
+  uint32_t transfers;
+  uint32_t bytes;
+} libtock_spi_controller_queue_t;
+
+void libtock_spi_controller_queue_init(libtock_spi_controller_queue_t* queue);
+
+// Queue a scatter list of `segment_count` segments.
+//
+// Returns `RETURNCODE_EBUSY` if the queue is full. `segments` and the buffers
+// they point to must stay valid until `cb` is called, which never happens
+// before this function returns. `cb` may be `NULL` for jobs whose completion
+// does not matter, such as a command followed by other jobs.
+returncode_t libtock_spi_controller_queue_transfer(libtock_spi_controller_queue_t* queue,
+                                                   const libtock_spi_controller_segment_t* segments,
+                                                   size_t segment_count, bool hold_cs,
+                                                   libtock_spi_controller_queue_callback cb, void* opaque);
+
+// Queue a stream. `buffers` must hold `2 * buffer_length` bytes. `fill` is
+// called with each half in turn until it returns 0, then `cb` is called.
+//
+// Data is only written; use a scatter list to read.
+returncode_t libtock_spi_controller_queue_stream(libtock_spi_controller_queue_t* queue,
+                                                 libtock_spi_controller_queue_fill fill, uint8_t* buffers,
+                                                 size_t buffer_length, bool hold_cs,
+                                                 libtock_spi_controller_queue_callback cb, void* opaque);
+
+// Number of jobs that have not completed yet.
+int libtock_spi_controller_queue_pending(libtock_spi_controller_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "entropy_pool.h"
+
+static void pool_refill(libtock_entropy_pool_t* pool, uint32_t wanted);
+
+// AES-128 block encryption for the CTR-DRBG. It is only ever run on the
+// DRBG's own state, so a compact byte-oriented implementation is enough.
+
+static const uint8_t sbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static uint8_t xtime(uint8_t x) {
+  return (x << 1) ^ ((x & 0x80) ? 0x1b : 0);
+}
+
+static void aes128_expand_key(const uint8_t* key, uint8_t* round_keys) {
+  uint8_t rcon = 1;
+
+  memcpy(round_keys, key, 16);
+  for (int i = 16; i < 176; i += 4) {
+    uint8_t t[4];
+    memcpy(t, round_keys + i - 4, 4);
+    if (i % 16 == 0) {
+      uint8_t first = t[0];
+      t[0] = sbox[t[1]] ^ rcon;
+      t[1] = sbox[t[2]];
+      t[2] = sbox[t[3]];
+      t[3] = sbox[first];
+      rcon = xtime(rcon);
+    }
+    for (int j = 0; j < 4; j++) {
+      round_keys[i + j] = round_keys[i + j - 16] ^ t[j];
+    }
+  }
+}
+
+static void aes128_encrypt(const uint8_t* round_keys, const uint8_t* in, uint8_t* out) {
+  uint8_t s[16];
+
+  for (int i = 0; i < 16; i++) {
+    s[i] = in[i] ^ round_keys[i];
+  }
+
+  for (int round = 1; round <= 10; round++) {
+    uint8_t t[16];
+
+    // SubBytes and ShiftRows. The state is stored column by column.
+    for (int i = 0; i < 16; i++) {
+      t[i] = sbox[s[(i + 4 * (i % 4)) % 16]];
+    }
+
+    // MixColumns, except in the last round.
+    if (round < 10) {
+      for (int c = 0; c < 16; c += 4) {
+        uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+        uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+        t[c]     ^= all ^ xtime(a0 ^ a1);
+        t[c + 1] ^= all ^ xtime(a1 ^ a2);
+        t[c + 2] ^= all ^ xtime(a2 ^ a3);
+        t[c + 3] ^= all ^ xtime(a3 ^ a0);
+      }
+    }
+
+    for (int i = 0; i < 16; i++) {
+      s[i] = t[i] ^ round_keys[16 * round + i];
+    }
+  }
+
+  memcpy(out, s, 16);
+}
+
+// CTR-DRBG with AES-128 and no derivation function (NIST SP 800-90A,
+// section 10.2.1). The seed length is 32 bytes.
+
+static void drbg_increment(uint8_t* v) {
+  for (int i = 15; i >= 0; i--) {
+    if (++v[i] != 0) break;
+  }
+}
+
+// CTR_DRBG_Update with `provided_data` of 32 bytes, or all zeros if NULL.
+static void drbg_update(libtock_entropy_pool_t* pool, const uint8_t* round_keys, const uint8_t* provided_data) {
+  uint8_t temp[32];
+
+  drbg_increment(pool->v);
+  aes128_encrypt(round_keys, pool->v, temp);
+  drbg_increment(pool->v);
+  aes128_encrypt(round_keys, pool->v, temp + 16);
+
+  if (provided_data != NULL) {
+    for (int i = 0; i < 32; i++) {
+      temp[i] ^= provided_data[i];
+    }
+  }
+  memcpy(pool->key, temp, 16);
+  memcpy(pool->v, temp + 16, 16);
+  memset(temp, 0, sizeof(temp));
+}
+
+static void drbg_seed(libtock_entropy_pool_t* pool, const uint8_t* entropy) {
+  uint8_t round_keys[176];
+
+  // Instantiation starts from an all-zero key and V, reseeding from the
+  // current state. Both then update the state with the entropy.
+  if (!pool->seeded) {
+    memset(pool->key, 0, sizeof(pool->key));
+    memset(pool->v, 0, sizeof(pool->v));
+    pool->seeded = true;
+  }
+  aes128_expand_key(pool->key, round_keys);
+  drbg_update(pool, round_keys, entropy);
+  pool->reseed_counter = 1;
+  memset(round_keys, 0, sizeof(round_keys));
+}
+
+static void drbg_generate(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length) {
+  uint8_t round_keys[176];
+  uint8_t block[16];
+
+  aes128_expand_key(pool->key, round_keys);
+  while (length > 0) {
+    uint32_t n = length < 16 ? length : 16;
+    drbg_increment(pool->v);
+    aes128_encrypt(round_keys, pool->v, block);
+    memcpy(buffer, block, n);
+    buffer += n;
+    length -= n;
+  }
+  drbg_update(pool, round_keys, NULL);
+  pool->reseed_counter++;
+
+  memset(round_keys, 0, sizeof(round_keys));
+  memset(block, 0, sizeof(block));
+}
+
+static void pool_upcall(__attribute__ ((unused)) int callback_type,
+                        int                          received,
+                        __attribute__ ((unused)) int val2,
+                        void*                        opaque) {
+  libtock_entropy_pool_t* pool = (libtock_entropy_pool_t*) opaque;
+  uint32_t end = pool->refill_offset + received;
+
+  // Bytes may have been taken from the pool while the driver was filling
+  // the space after it. Close the gap.
+  if (pool->available < pool->refill_offset) {
+    memmove(pool->memory + pool->available, pool->memory + pool->refill_offset, received);
+    memset(pool->memory + pool->available + received, 0, end - pool->available - received);
+  }
+  pool->available += received;
+  pool->refilling  = false;
+  pool->refills++;
+
+  pool_refill(pool, 0);
+}
+
+// Start a refill if none is running and the pool is below its low-water
+// mark or holds fewer than `wanted` bytes.
+static void pool_refill(libtock_entropy_pool_t* pool, uint32_t wanted) {
+  returncode_t ret;
+
+  if (pool->refilling || pool->available == pool->size) return;
+  if (pool->available >= pool->low_water && pool->available >= wanted) return;
+
+  pool->refill_offset = pool->available;
+
+  ret = libtock_rng_set_upcall(pool_upcall, pool);
+  if (ret == RETURNCODE_SUCCESS) {
+    ret = libtock_rng_set_allow_readwrite(pool->memory + pool->refill_offset, pool->size - pool->refill_offset);
+  }
+  if (ret == RETURNCODE_SUCCESS) {
+    ret = libtock_rng_command_get_random(pool->size - pool->refill_offset);
+  }
+
+  pool->refill_error = ret;
+  pool->refilling    = ret == RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_entropy_pool_init(libtock_entropy_pool_t* pool, uint8_t* memory, uint32_t size,
+                                       uint32_t low_water) {
+  if (size == 0 || low_water > size) return RETURNCODE_EINVAL;
+
+  memset(pool, 0, sizeof(libtock_entropy_pool_t));
+  pool->memory    = memory;
+  pool->size      = size;
+  pool->low_water = low_water == 0 ? 1 : low_water;
+
+  pool_refill(pool, 0);
+  return pool->refill_error;
+}
+
+returncode_t libtock_entropy_pool_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length) {
+  if (length > pool->available) {
+    if (length > pool->size) return RETURNCODE_ESIZE;
+
+    pool_refill(pool, length);
+    return pool->refilling ? RETURNCODE_EBUSY : pool->refill_error;
+  }
+
+  // Take bytes from the end of the pool and clear them.
+  pool->available -= length;
+  memcpy(buffer, pool->memory + pool->available, length);
+  memset(pool->memory + pool->available, 0, length);
+  pool->bytes_served += length;
+
+  pool_refill(pool, 0);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_entropy_pool_drbg_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length) {
+  returncode_t ret;
+
+  // SP 800-90A limits a single request to 64 kB.
+  if (length > 65536) return RETURNCODE_ESIZE;
+
+  if (!pool->seeded || pool->reseed_counter > LIBTOCK_ENTROPY_POOL_RESEED_INTERVAL) {
+    uint8_t entropy[LIBTOCK_ENTROPY_POOL_SEED_LENGTH];
+
+    ret = libtock_entropy_pool_get(pool, entropy, sizeof(entropy));
+    if (ret != RETURNCODE_SUCCESS) return ret;
+
+    drbg_seed(pool, entropy);
+    memset(entropy, 0, sizeof(entropy));
+  }
+
+  drbg_generate(pool, buffer, length);
+  return RETURNCODE_SUCCESS;
+}
+
+uint32_t libtock_entropy_pool_available(libtock_entropy_pool_t* pool) {
+  return pool->available;
+}
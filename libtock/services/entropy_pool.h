@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../peripherals/syscalls/rng_syscalls.h"
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pool of random bytes refilled in the background from the RNG driver.
+//
+// Requests are served from RAM without any syscalls. Whenever the pool drops
+// below its low-water mark a refill of the empty part is started, and the
+// driver fills it while the app keeps running. Bytes are handed out once and
+// cleared from the pool.
+//
+// For callers that need many random bytes but not fresh entropy for each,
+// `libtock_entropy_pool_drbg_get()` serves output of an AES-128 CTR-DRBG
+// (NIST SP 800-90A, without derivation function) seeded with 32 bytes from
+// the pool and reseeded every `LIBTOCK_ENTROPY_POOL_RESEED_INTERVAL`
+// requests.
+//
+// The pool registers its own upcall with the RNG driver. Do not mix it with
+// `libtock_rng_get_random_bytes()`.
+
+// Number of DRBG requests between reseeds.
+#define LIBTOCK_ENTROPY_POOL_RESEED_INTERVAL 1024
+
+// Bytes of entropy used to seed the DRBG.
+#define LIBTOCK_ENTROPY_POOL_SEED_LENGTH 32
+
+typedef struct {
+  uint8_t* memory;
+  uint32_t size;
+  // Random bytes are in `memory[0 .. available)`.
+  uint32_t available;
+  uint32_t low_water;
+
+  // A refill into `memory[refill_offset .. size)` is in progress.
+  bool refilling;
+  uint32_t refill_offset;
+  returncode_t refill_error;
+
+  // CTR-DRBG state.
+  bool seeded;
+  uint8_t key[16];
+  uint8_t v[16];
+  uint32_t reseed_counter;
+
+  // Statistics.
+  uint32_t refills;
+  uint32_t bytes_served;
+} libtock_entropy_pool_t;
+
+// Initialize a pool in `memory` of `size` bytes and start filling it. A
+// refill starts whenever fewer than `low_water` bytes are left.
+returncode_t libtock_entropy_pool_init(libtock_entropy_pool_t* pool, uint8_t* memory, uint32_t size,
+                                       uint32_t low_water);
+
+// Copy `length` random bytes from the pool into `buffer`.
+//
+// Returns `RETURNCODE_EBUSY` without copying anything if the pool holds fewer
+// than `length` bytes; a refill is running then, so retry after it
+// completes. Returns the error of the last refill if the driver failed, and
+// `RETURNCODE_ESIZE` if `length` is larger than the pool.
+returncode_t libtock_entropy_pool_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length);
+
+// Fill `buffer` with `length` bytes of CTR-DRBG output.
+//
+// Returns `RETURNCODE_EBUSY` if the DRBG needs to be seeded or reseeded and
+// the pool does not have enough bytes for it yet. The pool must be at least
+// `LIBTOCK_ENTROPY_POOL_SEED_LENGTH` bytes large.
+returncode_t libtock_entropy_pool_drbg_get(libtock_entropy_pool_t* pool, uint8_t* buffer, uint32_t length);
+
+// Number of random bytes in the pool.
+uint32_t libtock_entropy_pool_available(libtock_entropy_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,352 @@
+#include <string.h>
+
+#include "../sensors/syscalls/ambient_light_syscalls.h"
+#include "../sensors/syscalls/humidity_syscalls.h"
+#include "../sensors/syscalls/moisture_syscalls.h"
+#include "../sensors/syscalls/ninedof_syscalls.h"
+#include "../sensors/syscalls/pressure_syscalls.h"
+#include "../sensors/syscalls/proximity_syscalls.h"
+#include "../sensors/syscalls/rainfall_syscalls.h"
+#include "../sensors/syscalls/sound_pressure_syscalls.h"
+#include "../sensors/syscalls/temperature_syscalls.h"
+#include "sensor_sampler.h"
+
+#define BIT(sensor) LIBTOCK_SENSOR_SAMPLER_BIT(sensor)
+
+#define NINEDOF_SENSORS (BIT(LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER) | \
+                         BIT(LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER) | \
+                         BIT(LIBTOCK_SENSOR_SAMPLER_GYROSCOPE))
+
+static void sampler_arm_timeout(libtock_sensor_sampler_t* sampler);
+
+static void sampler_complete(libtock_sensor_sampler_t* sampler) {
+  uint32_t now;
+
+  if (!sampler->active || sampler->pending != 0) return;
+
+  if (sampler->timeout_armed) {
+    libtock_alarm_cancel(&sampler->timeout_alarm);
+    sampler->timeout_armed = false;
+  }
+
+  libtock_alarm_command_read(&now);
+  sampler->record.duration = now - sampler->record.timestamp;
+  sampler->active = false;
+  sampler->cb(&sampler->record, sampler->opaque);
+}
+
+static void sampler_finish(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_sensor_t sensor,
+                           returncode_t status) {
+  sampler->record.status[sensor] = status;
+  if (status == RETURNCODE_SUCCESS) {
+    sampler->record.valid |= BIT(sensor);
+  }
+  sampler->pending &= ~BIT(sensor);
+}
+
+static returncode_t sampler_start_read(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_sensor_t sensor) {
+  switch (sensor) {
+    case LIBTOCK_SENSOR_SAMPLER_TEMPERATURE:    return libtock_temperature_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_HUMIDITY:       return libtock_humidity_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT:  return libtock_ambient_light_command_start_intensity_reading();
+    case LIBTOCK_SENSOR_SAMPLER_PRESSURE:       return libtock_pressure_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER:  return libtock_ninedof_command_start_accelerometer_reading();
+    case LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER:   return libtock_ninedof_command_start_magnetometer_reading();
+    case LIBTOCK_SENSOR_SAMPLER_GYROSCOPE:      return libtock_ninedof_command_start_gyroscope_reading();
+    case LIBTOCK_SENSOR_SAMPLER_PROXIMITY:      return libtock_proximity_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE: return libtock_sound_pressure_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_MOISTURE:       return libtock_moisture_command_read();
+    case LIBTOCK_SENSOR_SAMPLER_RAINFALL:       return libtock_rainfall_command_read(sampler->rainfall_hours);
+    default:                                    return RETURNCODE_EINVAL;
+  }
+}
+
+// Start the reads the cycle still needs. A sensor whose previous read has not
+// answered yet is read once it has, and only one 9-DoF read runs at a time.
+static void sampler_issue(libtock_sensor_sampler_t* sampler) {
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    libtock_sensor_sampler_sensor_t sensor = (libtock_sensor_sampler_sensor_t) i;
+    uint32_t bit = BIT(sensor);
+
+    if (!(sampler->pending & bit) || (sampler->issued & bit) || (sampler->in_flight & bit)) continue;
+    if ((bit & NINEDOF_SENSORS) && (sampler->in_flight & NINEDOF_SENSORS)) continue;
+
+    returncode_t ret = sampler_start_read(sampler, sensor);
+    sampler->issued |= bit;
+    if (ret != RETURNCODE_SUCCESS) {
+      sampler_finish(sampler, sensor, ret);
+      continue;
+    }
+
+    sampler->in_flight |= bit;
+    if (bit & NINEDOF_SENSORS) {
+      sampler->ninedof_sensor = sensor;
+    }
+  }
+}
+
+static void sampler_result(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_sensor_t sensor,
+                           returncode_t status, int x, int y, int z) {
+  uint32_t bit = BIT(sensor);
+
+  sampler->in_flight &= ~bit;
+  if (!sampler->active) return;
+
+  // Results of reads from an earlier cycle are dropped.
+  if (sampler->pending & sampler->issued & bit) {
+    sampler->record.value[sensor][0] = x;
+    sampler->record.value[sensor][1] = y;
+    sampler->record.value[sensor][2] = z;
+    sampler_finish(sampler, sensor, status);
+  }
+
+  sampler_issue(sampler);
+  sampler_complete(sampler);
+}
+
+// Upcalls reporting the reading in the first argument.
+#define SAMPLER_UPCALL(name, sensor)                                                            \
+  static void name(int                          value,                                          \
+                   __attribute__ ((unused)) int unused1,                                        \
+                   __attribute__ ((unused)) int unused2,                                        \
+                   void*                        opaque) {                                       \
+    sampler_result((libtock_sensor_sampler_t*) opaque, sensor, RETURNCODE_SUCCESS, value, 0, 0); \
+  }
+
+SAMPLER_UPCALL(temperature_upcall, LIBTOCK_SENSOR_SAMPLER_TEMPERATURE)
+SAMPLER_UPCALL(humidity_upcall, LIBTOCK_SENSOR_SAMPLER_HUMIDITY)
+SAMPLER_UPCALL(ambient_light_upcall, LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT)
+SAMPLER_UPCALL(pressure_upcall, LIBTOCK_SENSOR_SAMPLER_PRESSURE)
+SAMPLER_UPCALL(proximity_upcall, LIBTOCK_SENSOR_SAMPLER_PROXIMITY)
+SAMPLER_UPCALL(sound_pressure_upcall, LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE)
+
+// Upcalls reporting a status and the reading.
+static void moisture_upcall(int                          status,
+                            int                          value,
+                            __attribute__ ((unused)) int unused2,
+                            void*                        opaque) {
+  sampler_result((libtock_sensor_sampler_t*) opaque, LIBTOCK_SENSOR_SAMPLER_MOISTURE, status, value, 0, 0);
+}
+
+static void rainfall_upcall(int                          status,
+                            int                          value,
+                            __attribute__ ((unused)) int unused2,
+                            void*                        opaque) {
+  sampler_result((libtock_sensor_sampler_t*) opaque, LIBTOCK_SENSOR_SAMPLER_RAINFALL, status, value, 0, 0);
+}
+
+static void ninedof_upcall(int x, int y, int z, void* opaque) {
+  libtock_sensor_sampler_t* sampler = (libtock_sensor_sampler_t*) opaque;
+  sampler_result(sampler, sampler->ninedof_sensor, RETURNCODE_SUCCESS, x, y, z);
+}
+
+static void sampler_timeout(uint32_t                          now,
+                            __attribute__ ((unused)) uint32_t scheduled,
+                            void*                             opaque) {
+  libtock_sensor_sampler_t* sampler = (libtock_sensor_sampler_t*) opaque;
+  uint32_t elapsed = now - sampler->record.timestamp;
+
+  sampler->timeout_armed = false;
+  if (!sampler->active) return;
+
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    uint32_t timeout = sampler->config[i].timeout_ticks;
+    if (!(sampler->pending & BIT(i)) || timeout == 0 || elapsed < timeout) continue;
+
+    sampler->record.timed_out |= BIT(i);
+    sampler->timeouts++;
+    sampler_finish(sampler, (libtock_sensor_sampler_sensor_t) i, RETURNCODE_ECANCEL);
+  }
+
+  sampler_arm_timeout(sampler);
+  sampler_complete(sampler);
+}
+
+// Set the timeout alarm for the earliest deadline of the sensors the cycle
+// still waits for. Deadlines count from the start of the cycle.
+static void sampler_arm_timeout(libtock_sensor_sampler_t* sampler) {
+  uint32_t earliest = 0;
+
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    uint32_t timeout = sampler->config[i].timeout_ticks;
+    if (!(sampler->pending & BIT(i)) || timeout == 0) continue;
+    if (earliest == 0 || timeout < earliest) earliest = timeout;
+  }
+  if (earliest == 0) return;
+
+  libtock_alarm_at(sampler->record.timestamp, earliest, sampler_timeout, sampler, &sampler->timeout_alarm);
+  sampler->timeout_armed = true;
+}
+
+static void sampler_cycle(libtock_sensor_sampler_t* sampler, uint32_t now) {
+  libtock_sensor_sampler_record_t* record = &sampler->record;
+  uint32_t wanted = 0;
+
+  for (int i = 0; i < LIBTOCK_SENSOR_SAMPLER_COUNT; i++) {
+    uint32_t divider = sampler->config[i].divider;
+    if (divider != 0 && sampler->cycles % divider == 0) {
+      wanted |= BIT(i);
+    }
+  }
+
+  memset(record, 0, sizeof(libtock_sensor_sampler_record_t));
+  record->sequence  = sampler->cycles++;
+  record->timestamp = now;
+  record->sampled   = wanted;
+
+  sampler->active  = true;
+  sampler->pending = wanted;
+  sampler->issued  = 0;
+
+  sampler_issue(sampler);
+  sampler_arm_timeout(sampler);
+  sampler_complete(sampler);
+}
+
+static void sampler_period(uint32_t now, uint32_t scheduled, void* opaque) {
+  libtock_sensor_sampler_t* sampler = (libtock_sensor_sampler_t*) opaque;
+
+  // Re-arm from the scheduled time so the period does not drift.
+  libtock_alarm_at(scheduled, sampler->period_ticks, sampler_period, sampler, &sampler->period_alarm);
+
+  if (sampler->active) {
+    sampler->overruns++;
+    return;
+  }
+  sampler_cycle(sampler, now);
+}
+
+static void sampler_kick(__attribute__ ((unused)) int unused0,
+                         __attribute__ ((unused)) int unused1,
+                         __attribute__ ((unused)) int unused2,
+                         void*                        opaque) {
+  libtock_sensor_sampler_t* sampler = (libtock_sensor_sampler_t*) opaque;
+  uint32_t now;
+
+  // Stopped before the cycle could start.
+  if (!sampler->scheduled) return;
+  sampler->scheduled = false;
+
+  libtock_alarm_command_read(&now);
+  if (sampler->periodic) {
+    libtock_alarm_at(now, sampler->period_ticks, sampler_period, sampler, &sampler->period_alarm);
+  }
+  sampler_cycle(sampler, now);
+}
+
+static returncode_t sampler_schedule(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_callback cb,
+                                     void* opaque) {
+  if (sampler->scheduled || sampler->active || sampler->periodic) return RETURNCODE_EBUSY;
+
+  // Cycles start from a deferred call, so `cb` never runs before the caller
+  // returns.
+  if (tock_enqueue(sampler_kick, 0, 0, 0, sampler) < 0) return RETURNCODE_EBUSY;
+
+  sampler->scheduled = true;
+  sampler->cb        = cb;
+  sampler->opaque    = opaque;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_sensor_sampler_init(libtock_sensor_sampler_t* sampler) {
+  returncode_t ret;
+
+  memset(sampler, 0, sizeof(libtock_sensor_sampler_t));
+  sampler->rainfall_hours = 1;
+
+  ret = libtock_alarm_command_get_frequency(&sampler->frequency);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_sensor_sampler_configure(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_sensor_t sensor,
+                                              uint32_t divider, uint32_t timeout_ms) {
+  bool exists;
+  returncode_t ret;
+
+  if ((int) sensor < 0 || sensor >= LIBTOCK_SENSOR_SAMPLER_COUNT) return RETURNCODE_EINVAL;
+  if (sampler->active) return RETURNCODE_EBUSY;
+
+  if (divider > 0) {
+    switch (sensor) {
+      case LIBTOCK_SENSOR_SAMPLER_TEMPERATURE:
+        exists = libtock_temperature_exists();
+        ret    = libtock_temperature_set_upcall(temperature_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_HUMIDITY:
+        exists = libtock_humidity_exists();
+        ret    = libtock_humidity_set_upcall(humidity_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT:
+        exists = libtock_ambient_light_exists();
+        ret    = libtock_ambient_light_set_upcall(ambient_light_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_PRESSURE:
+        exists = libtock_pressure_exists();
+        ret    = libtock_pressure_set_upcall(pressure_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_PROXIMITY:
+        exists = libtock_proximity_exists();
+        ret    = libtock_proximity_set_upcall(proximity_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE:
+        exists = libtock_sound_pressure_exists();
+        ret    = libtock_sound_pressure_set_upcall(sound_pressure_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_MOISTURE:
+        exists = libtock_moisture_exists();
+        ret    = libtock_moisture_set_upcall(moisture_upcall, sampler);
+        break;
+      case LIBTOCK_SENSOR_SAMPLER_RAINFALL:
+        exists = libtock_rainfall_exists();
+        ret    = libtock_rainfall_set_upcall(rainfall_upcall, sampler);
+        break;
+      default:
+        exists = libtock_ninedof_exists();
+        ret    = libtock_ninedof_set_upcall(ninedof_upcall, sampler);
+        break;
+    }
+    if (!exists) return RETURNCODE_ENODEVICE;
+    if (ret != RETURNCODE_SUCCESS) return ret;
+  }
+
+  sampler->config[sensor].divider       = divider;
+  sampler->config[sensor].timeout_ticks = (uint32_t) (((uint64_t) timeout_ms * sampler->frequency) / 1000);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_sensor_sampler_sample(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_callback cb,
+                                           void* opaque) {
+  return sampler_schedule(sampler, cb, opaque);
+}
+
+returncode_t libtock_sensor_sampler_start(libtock_sensor_sampler_t* sampler, uint32_t period_ms,
+                                          libtock_sensor_sampler_callback cb, void* opaque) {
+  returncode_t ret;
+
+  if (period_ms == 0) return RETURNCODE_EINVAL;
+
+  ret = sampler_schedule(sampler, cb, opaque);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  sampler->periodic     = true;
+  sampler->period_ticks = (uint32_t) (((uint64_t) period_ms * sampler->frequency) / 1000);
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_sensor_sampler_stop(libtock_sensor_sampler_t* sampler) {
+  if (sampler->periodic && !sampler->scheduled) {
+    libtock_alarm_cancel(&sampler->period_alarm);
+  }
+  if (sampler->timeout_armed) {
+    libtock_alarm_cancel(&sampler->timeout_alarm);
+    sampler->timeout_armed = false;
+  }
+
+  // Reads still in flight stay tracked so their results are dropped.
+  sampler->scheduled = false;
+  sampler->periodic  = false;
+  sampler->active    = false;
+  sampler->pending   = 0;
+}
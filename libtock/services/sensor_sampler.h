@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../tock.h"
+#include "alarm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Concurrent sampling of the environmental and motion sensors.
+//
+// A sampling cycle starts the reads of all selected sensors at once and
+// gathers the results into one record. The callback runs once every sensor
+// of the cycle has answered or timed out, so a cycle takes as long as the
+// slowest sensor rather than the sum of all of them.
+//
+// The accelerometer, magnetometer and gyroscope share the 9-DoF driver, which
+// handles one reading at a time. Their reads are started one after another
+// from the upcall of the previous one.
+//
+// Per sensor:
+//
+// - Rate: a sensor with divider `n` is read in every `n`th cycle.
+// - Timeout: if the result is not in `timeout_ms` after the start of the
+//   cycle, the cycle completes without it. A result that arrives later is
+//   dropped, and the sensor is read again once it has answered.
+//
+// Cycles either run once with `libtock_sensor_sampler_sample()` or
+// periodically with `libtock_sensor_sampler_start()`. Periodic cycles start
+// on a fixed schedule. A cycle that is still running when the next one is due
+// makes that one be skipped and counted as an overrun.
+//
+// The sound pressure sensor must be enabled by the app with
+// `libtock_sound_pressure_command_enable()` before it is sampled.
+//
+// The sampler registers its own upcalls with the sensor drivers. Do not use
+// the other `libtock_*` sensor functions of a configured sensor while the
+// sampler is in use.
+
+typedef enum {
+  LIBTOCK_SENSOR_SAMPLER_TEMPERATURE,
+  LIBTOCK_SENSOR_SAMPLER_HUMIDITY,
+  LIBTOCK_SENSOR_SAMPLER_AMBIENT_LIGHT,
+  LIBTOCK_SENSOR_SAMPLER_PRESSURE,
+  LIBTOCK_SENSOR_SAMPLER_ACCELEROMETER,
+  LIBTOCK_SENSOR_SAMPLER_MAGNETOMETER,
+  LIBTOCK_SENSOR_SAMPLER_GYROSCOPE,
+  LIBTOCK_SENSOR_SAMPLER_PROXIMITY,
+  LIBTOCK_SENSOR_SAMPLER_SOUND_PRESSURE,
+  LIBTOCK_SENSOR_SAMPLER_MOISTURE,
+  LIBTOCK_SENSOR_SAMPLER_RAINFALL,
+  LIBTOCK_SENSOR_SAMPLER_COUNT,
+} libtock_sensor_sampler_sensor_t;
+
+// Bit of `sensor` in the masks of a record.
+#define LIBTOCK_SENSOR_SAMPLER_BIT(sensor) (1u << (sensor))
+
+// Results of one cycle.
+//
+// Readings are in the units of the sensor drivers (see the `libtock_*`
+// callback of each sensor). The 9-DoF sensors use all three values of
+// `value`, the others only `value[sensor][0]`.
+typedef struct {
+  // Number of the cycle, counting from 0.
+  uint32_t sequence;
+  // Alarm time in ticks when the reads were started.
+  uint32_t timestamp;
+  // Ticks from the start until the last result or timeout.
+  uint32_t duration;
+
+  // Sensors read in this cycle.
+  uint32_t sampled;
+  // Sensors that delivered a reading.
+  uint32_t valid;
+  // Sensors that did not answer in time.
+  uint32_t timed_out;
+
+  // Status of each sampled sensor. `RETURNCODE_ECANCEL` after a timeout.
+  returncode_t status[LIBTOCK_SENSOR_SAMPLER_COUNT];
+  int value[LIBTOCK_SENSOR_SAMPLER_COUNT][3];
+} libtock_sensor_sampler_record_t;
+
+// Function signature for the cycle callback.
+//
+// - `arg1` (`const libtock_sensor_sampler_record_t*`): Results of the cycle,
+//   only valid during the callback.
+// - `arg2` (`void*`): The `opaque` pointer passed when sampling started.
+typedef void (*libtock_sensor_sampler_callback)(const libtock_sensor_sampler_record_t*, void*);
+
+typedef struct {
+  // Read in every `divider`th cycle, 0 if not read at all.
+  uint32_t divider;
+  // 0 waits for the result as long as it takes.
+  uint32_t timeout_ticks;
+} libtock_sensor_sampler_config_t;
+
+// State for one sampler. Allocated by the caller and initialized with
+// `libtock_sensor_sampler_init()`.
+typedef struct {
+  libtock_sensor_sampler_config_t config[LIBTOCK_SENSOR_SAMPLER_COUNT];
+  // Period over which rainfall is reported, in hours. 1 after init.
+  int rainfall_hours;
+  uint32_t frequency;
+
+  libtock_sensor_sampler_callback cb;
+  void* opaque;
+
+  // A cycle has been requested but not started yet.
+  bool scheduled;
+  bool periodic;
+  uint32_t period_ticks;
+  libtock_alarm_ticks_t period_alarm;
+
+  // Cycle in progress. `pending` are the sensors the cycle still waits for,
+  // `issued` those read in this cycle, and `in_flight` those whose upcall has
+  // not arrived yet, possibly from an earlier cycle.
+  bool active;
+  uint32_t pending;
+  uint32_t issued;
+  uint32_t in_flight;
+  libtock_sensor_sampler_sensor_t ninedof_sensor;
+  bool timeout_armed;
+  libtock_alarm_ticks_t timeout_alarm;
+  libtock_sensor_sampler_record_t record;
+
+  // Statistics.
+  uint32_t cycles;
+  uint32_t overruns;
+  uint32_t timeouts;
+} libtock_sensor_sampler_t;
+
+// Initialize a sampler with no sensors selected.
+returncode_t libtock_sensor_sampler_init(libtock_sensor_sampler_t* sampler);
+
+// Select `sensor` to be read in every `divider`th cycle, and give up waiting
+// for it `timeout_ms` after the start of a cycle (0 to wait without limit).
+// A `divider` of 0 deselects the sensor.
+//
+// Returns `RETURNCODE_ENODEVICE` if the sensor does not exist and
+// `RETURNCODE_EBUSY` while a cycle is running.
+returncode_t libtock_sensor_sampler_configure(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_sensor_t sensor,
+                                              uint32_t divider, uint32_t timeout_ms);
+
+// Run one cycle and call `cb` with the results.
+//
+// `cb` is never called before this function returns. Returns
+// `RETURNCODE_EBUSY` if a cycle is already requested or running, or periodic
+// sampling is on.
+returncode_t libtock_sensor_sampler_sample(libtock_sensor_sampler_t* sampler, libtock_sensor_sampler_callback cb,
+                                           void* opaque);
+
+// Start a cycle now and then every `period_ms`, calling `cb` at the end of
+// each.
+returncode_t libtock_sensor_sampler_start(libtock_sensor_sampler_t* sampler, uint32_t period_ms,
+                                          libtock_sensor_sampler_callback cb, void* opaque);
+
+// Stop periodic sampling and abandon the cycle in progress without calling
+// the callback.
+void libtock_sensor_sampler_stop(libtock_sensor_sampler_t* sampler);
+
+#ifdef __cplusplus
+}
+#endif
@@ -65,6 +65,96 @@ extern "C" {
   bool _app_state_inited         = false;
 
 
+// Wear-leveled application state.
+//
+// As an alternative to `LIBTOCK_APP_STATE_DECLARE`, the leveled mode stores
+// each save as a new versioned, checksummed record in the next slot of the
+// app's writeable flash regions, rotating through every slot of every region
+// rather than rewriting the same flash page each time. Loading picks the
+// newest record with a valid checksum, so a save interrupted by a reset falls
+// back to the previous state. A save is skipped entirely if the state is
+// unchanged since the newest record.
+//
+//     LIBTOCK_APP_STATE_DECLARE_LEVELED(struct my_state_t, memory_copy, 8);
+//
+// reserves a writeable flash region with room for eight records. Leveled
+// state is accessed with `libtock_app_state_leveled_load()` and
+// `libtock_app_state_leveled_save()`.
+//
+// The kernel rewrites a whole flash page for every save, so each record is
+// placed in its own page: slots start on `LIBTOCK_APP_STATE_SLOT_ALIGN` byte
+// boundaries, which must be a multiple of the flash page size. The default of
+// 4096 covers common page sizes. Define it before including this header to
+// use less flash on chips with smaller pages. Defining it below the page size
+// packs several records into one page, which gives up both the wear leveling
+// and the fallback to the previous state.
+
+#ifndef LIBTOCK_APP_STATE_SLOT_ALIGN
+#define LIBTOCK_APP_STATE_SLOT_ALIGN 4096
+#endif
+
+#define LIBTOCK_APP_STATE_RECORD_MAGIC 0x41505354
+
+// Header stored in front of every leveled record.
+typedef struct {
+  uint32_t magic;
+  // Incremented with every save, the newest record has the highest sequence.
+  uint32_t sequence;
+  // Length of the state following the header.
+  uint32_t length;
+  // CRC-32 over `sequence`, `length` and the state.
+  uint32_t checksum;
+} libtock_app_state_record_header_t;
+
+// Bookkeeping for the leveled mode, declared by
+// `LIBTOCK_APP_STATE_DECLARE_LEVELED`.
+typedef struct {
+  // RAM buffer for staging a record.
+  void* record;
+  // Distance between records in flash.
+  size_t slot_size;
+  // Alignment of the first record in each flash region.
+  size_t slot_align;
+  // Whether the flash regions have been scanned for the newest record.
+  bool scanned;
+  // Slot index of the newest valid record, or -1 if there is none.
+  int newest_slot;
+  uint32_t sequence;
+  // Slot being written by an outstanding save.
+  int pending_slot;
+  // Number of saves skipped because the state was unchanged.
+  uint32_t skipped;
+} libtock_app_state_leveled_t;
+
+#define LIBTOCK_APP_STATE_SLOT_SIZE(_type)                                                        \
+  ((sizeof(libtock_app_state_record_header_t) + sizeof(_type) + LIBTOCK_APP_STATE_SLOT_ALIGN - 1) \
+   / LIBTOCK_APP_STATE_SLOT_ALIGN * LIBTOCK_APP_STATE_SLOT_ALIGN)
+
+// Declare a wear-leveled application state structure with room for `_slots`
+// records. See above.
+#define LIBTOCK_APP_STATE_DECLARE_LEVELED(_type, _identifier, _slots)       \
+  __attribute__((section(".app_state")))                                    \
+  uint8_t _app_state_flash[(_slots) * LIBTOCK_APP_STATE_SLOT_SIZE(_type)      \
+                           + LIBTOCK_APP_STATE_SLOT_ALIGN - 4];             \
+  _type _identifier;                                                        \
+  void* _app_state_flash_pointer = NULL;                                    \
+  void* _app_state_ram_pointer   = &_identifier;                            \
+  size_t _app_state_size         = sizeof(_type);                           \
+  bool _app_state_inited         = false;                                   \
+  uint32_t _app_state_record[(sizeof(libtock_app_state_record_header_t)     \
+                              + sizeof(_type) + 3) / 4];                    \
+  libtock_app_state_leveled_t _app_state_leveled = {                        \
+    .record       = _app_state_record,                                      \
+    .slot_size    = LIBTOCK_APP_STATE_SLOT_SIZE(_type),                     \
+    .slot_align   = LIBTOCK_APP_STATE_SLOT_ALIGN,                           \
+    .scanned      = false,                                                  \
+    .newest_slot  = -1,                                                     \
+    .sequence     = 0,                                                      \
+    .pending_slot = -1,                                                     \
+    .skipped      = 0,                                                      \
+  };
+
+
 // Function signature save done callbacks.
 //
 // - `arg1` (`returncode_t`): Status of save operation.
@@ -75,6 +165,7 @@ extern void* _app_state_flash_pointer;
 extern void* _app_state_ram_pointer;
 extern size_t _app_state_size;
 extern bool _app_state_inited;
+extern libtock_app_state_leveled_t _app_state_leveled;
 
 
 
@@ -85,6 +176,19 @@ returncode_t libtock_app_state_load(void);
 // Save the application state to persistent storage.
 returncode_t libtock_app_state_save(libtock_app_state_callback cb);
 
+// Load the newest valid record of leveled application state into the
+// in-memory storage location. If no record has been saved yet, the in-memory
+// copy is left unchanged.
+returncode_t libtock_app_state_leveled_load(void);
+
+// Save the leveled application state as a new record.
+//
+// If the state matches the newest record the save is skipped and `cb` is
+// called with `RETURNCODE_SUCCESS` on the next `yield()`. Otherwise the record
+// is written to the slot after the newest one and read back before `cb`
+// reports success.
+returncode_t libtock_app_state_leveled_save(libtock_app_state_callback cb);
+
 
 
 #ifdef __cplusplus
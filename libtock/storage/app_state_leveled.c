@@ -0,0 +1,189 @@
+#include <string.h>
+
+#include "app_state.h"
+
+// The leveled mode lives in its own file so that apps using the plain
+// `LIBTOCK_APP_STATE_DECLARE` never link against `_app_state_leveled`.
+
+static uint32_t app_state_crc32(uint32_t crc, const uint8_t* buf, size_t len) {
+  // Bitwise CRC-32 (IEEE 802.3), this only runs once per save and load.
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t app_state_record_checksum(const libtock_app_state_record_header_t* header, const uint8_t* state) {
+  uint32_t crc = app_state_crc32(0, (const uint8_t*) &header->sequence, sizeof(uint32_t) * 2);
+  return app_state_crc32(crc, state, header->length);
+}
+
+// First slot of a writeable flash region, rounded up to the slot alignment so
+// that records start on page boundaries.
+static uint8_t* app_state_region_begin(int region) {
+  uintptr_t begin = (uintptr_t) tock_app_writeable_flash_region_begins_at(region);
+  uintptr_t align = _app_state_leveled.slot_align;
+  return (uint8_t*) ((begin + align - 1) / align * align);
+}
+
+// Number of record slots in a writeable flash region.
+static int app_state_region_slots(int region) {
+  uint8_t* begin = app_state_region_begin(region);
+  uint8_t* end   = tock_app_writeable_flash_region_ends_at(region);
+  if (end <= begin) return 0;
+  return (end - begin) / _app_state_leveled.slot_size;
+}
+
+// Address of a slot, counting across all writeable flash regions. Returns
+// NULL past the last slot.
+static uint8_t* app_state_slot_address(int slot) {
+  int number_regions = tock_app_number_writeable_flash_regions();
+  for (int region = 0; region < number_regions; region++) {
+    int slots = app_state_region_slots(region);
+    if (slot < slots) {
+      return app_state_region_begin(region) + slot * _app_state_leveled.slot_size;
+    }
+    slot -= slots;
+  }
+  return NULL;
+}
+
+static int app_state_total_slots(void) {
+  int total = 0;
+  int number_regions = tock_app_number_writeable_flash_regions();
+  for (int region = 0; region < number_regions; region++) {
+    total += app_state_region_slots(region);
+  }
+  return total;
+}
+
+static bool app_state_record_valid(const uint8_t* slot) {
+  libtock_app_state_record_header_t header;
+  memcpy(&header, slot, sizeof(header));
+
+  if (header.magic != LIBTOCK_APP_STATE_RECORD_MAGIC) return false;
+  if (header.length != _app_state_size) return false;
+  return header.checksum == app_state_record_checksum(&header, slot + sizeof(header));
+}
+
+// Find the newest valid record in all writeable flash regions.
+static void app_state_scan(void) {
+  int total = app_state_total_slots();
+
+  _app_state_leveled.newest_slot = -1;
+  for (int slot = 0; slot < total; slot++) {
+    const uint8_t* address = app_state_slot_address(slot);
+    if (!app_state_record_valid(address)) continue;
+
+    libtock_app_state_record_header_t header;
+    memcpy(&header, address, sizeof(header));
+
+    // Compare sequence numbers so that they may wrap around.
+    if (_app_state_leveled.newest_slot < 0 || (int32_t) (header.sequence - _app_state_leveled.sequence) > 0) {
+      _app_state_leveled.newest_slot = slot;
+      _app_state_leveled.sequence    = header.sequence;
+    }
+  }
+
+  _app_state_leveled.scanned = true;
+}
+
+static returncode_t app_state_leveled_init(void) {
+  if (tock_app_number_writeable_flash_regions() == 0) return RETURNCODE_ENOMEM;
+  if (app_state_total_slots() == 0) return RETURNCODE_ESIZE;
+
+  if (!_app_state_leveled.scanned) {
+    app_state_scan();
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+static void app_state_leveled_upcall(__attribute__ ((unused)) int callback_type,
+                                     __attribute__ ((unused)) int value,
+                                     __attribute__ ((unused)) int unused,
+                                     void*                        opaque) {
+  libtock_app_state_callback cb = (libtock_app_state_callback) opaque;
+  int slot = _app_state_leveled.pending_slot;
+  _app_state_leveled.pending_slot = -1;
+
+  // Only advance to the new record once it reads back correctly.
+  size_t record_len = sizeof(libtock_app_state_record_header_t) + _app_state_size;
+  if (memcmp(app_state_slot_address(slot), _app_state_leveled.record, record_len) != 0) {
+    cb(RETURNCODE_FAIL);
+    return;
+  }
+
+  _app_state_leveled.newest_slot = slot;
+  _app_state_leveled.sequence++;
+  cb(RETURNCODE_SUCCESS);
+}
+
+static void app_state_leveled_skipped(__attribute__ ((unused)) int unused0,
+                                      __attribute__ ((unused)) int unused1,
+                                      __attribute__ ((unused)) int unused2,
+                                      void*                        opaque) {
+  libtock_app_state_callback cb = (libtock_app_state_callback) opaque;
+  cb(RETURNCODE_SUCCESS);
+}
+
+returncode_t libtock_app_state_leveled_load(void) {
+  returncode_t err;
+
+  err = app_state_leveled_init();
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  if (_app_state_leveled.newest_slot >= 0) {
+    const uint8_t* address = app_state_slot_address(_app_state_leveled.newest_slot);
+    memcpy(_app_state_ram_pointer, address + sizeof(libtock_app_state_record_header_t), _app_state_size);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_app_state_leveled_save(libtock_app_state_callback cb) {
+  returncode_t err;
+
+  if (_app_state_leveled.pending_slot >= 0) return RETURNCODE_EBUSY;
+
+  err = app_state_leveled_init();
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Nothing to write if the newest record already holds this state.
+  if (_app_state_leveled.newest_slot >= 0) {
+    const uint8_t* address = app_state_slot_address(_app_state_leveled.newest_slot);
+    if (memcmp(address + sizeof(libtock_app_state_record_header_t), _app_state_ram_pointer, _app_state_size) == 0) {
+      if (tock_enqueue(app_state_leveled_skipped, 0, 0, 0, (void*) cb) < 0) return RETURNCODE_EBUSY;
+      _app_state_leveled.skipped++;
+      return RETURNCODE_SUCCESS;
+    }
+  }
+
+  // Stage the record after the newest one.
+  libtock_app_state_record_header_t header;
+  header.magic    = LIBTOCK_APP_STATE_RECORD_MAGIC;
+  header.sequence = _app_state_leveled.sequence + 1;
+  header.length   = _app_state_size;
+  header.checksum = app_state_record_checksum(&header, _app_state_ram_pointer);
+
+  uint8_t* record = _app_state_leveled.record;
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + sizeof(header), _app_state_ram_pointer, _app_state_size);
+
+  int slot         = (_app_state_leveled.newest_slot + 1) % app_state_total_slots();
+  uint8_t* address = app_state_slot_address(slot);
+
+  err = libtock_app_state_set_readonly_allow(record, sizeof(header) + _app_state_size);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_app_state_set_upcall(app_state_leveled_upcall, (void*) cb);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_app_state_command_save((uint32_t) address);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  _app_state_leveled.pending_slot = slot;
+  return RETURNCODE_SUCCESS;
+}
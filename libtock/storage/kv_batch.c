@@ -0,0 +1,159 @@
+#include "kv_batch.h"
+
+#include <string.h>
+
+static libtock_kv_batch_entry_t* kv_batch_find(libtock_kv_batch_t* batch, const uint8_t* key_buffer,
+                                               uint32_t key_len) {
+  for (int i = 0; i < batch->count; i++) {
+    libtock_kv_batch_entry_t* entry = &batch->entries[i];
+    if (entry->key_len == key_len && memcmp(entry->key, key_buffer, key_len) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static returncode_t kv_batch_queue(libtock_kv_batch_t* batch, libtock_kv_batch_op_t op, const uint8_t* key_buffer,
+                                   uint32_t key_len, const uint8_t* val_buffer, uint32_t val_len) {
+  if (batch->flushing) return RETURNCODE_EBUSY;
+  if (key_len > LIBTOCK_KV_BATCH_MAX_KEY_LEN || val_len > LIBTOCK_KV_BATCH_MAX_VALUE_LEN) return RETURNCODE_ESIZE;
+
+  // The last mutation of a key is the only one that needs to reach flash.
+  libtock_kv_batch_entry_t* entry = kv_batch_find(batch, key_buffer, key_len);
+  if (entry != NULL) {
+    batch->coalesced++;
+  } else {
+    if (batch->count == LIBTOCK_KV_BATCH_ENTRIES) return RETURNCODE_ENOMEM;
+    entry = &batch->entries[batch->count];
+    batch->count++;
+
+    entry->key_len = key_len;
+    memcpy(entry->key, key_buffer, key_len);
+  }
+
+  entry->op        = op;
+  entry->value_len = val_len;
+  if (val_len > 0) {
+    memcpy(entry->value, val_buffer, val_len);
+  }
+  return RETURNCODE_SUCCESS;
+}
+
+static void kv_batch_finish(libtock_kv_batch_t* batch, returncode_t ret) {
+  int written = batch->next;
+
+  // Drop the written mutations, keeping the failed one and any after it.
+  memmove(&batch->entries[0], &batch->entries[written], (batch->count - written) * sizeof(libtock_kv_batch_entry_t));
+  batch->count   -= written;
+  batch->next     = 0;
+  batch->flushing = false;
+
+  batch->cb(ret, written);
+}
+
+static void kv_batch_upcall(int err, int length, int unused2, void* opaque);
+
+static returncode_t kv_batch_issue(libtock_kv_batch_t* batch) {
+  returncode_t err;
+  libtock_kv_batch_entry_t* entry = &batch->entries[batch->next];
+
+  if (batch->cache != NULL) {
+    libtock_kv_cache_invalidate(batch->cache, entry->key, entry->key_len);
+  }
+
+  err = libtock_kv_set_upcall(kv_batch_upcall, batch);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readonly_allow_key_buffer(entry->key, entry->key_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  if (entry->op == LIBTOCK_KV_BATCH_DELETE) {
+    err = libtock_kv_command_delete();
+    return err;
+  }
+
+  err = libtock_kv_set_readonly_allow_input_buffer(entry->value, entry->value_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_command_set();
+  return err;
+}
+
+static void kv_batch_upcall(int                          err,
+                            __attribute__ ((unused)) int length,
+                            __attribute__ ((unused)) int unused2,
+                            void*                        opaque) {
+  libtock_kv_batch_t* batch = (libtock_kv_batch_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(err);
+
+  // A key that was set and then deleted within one batch may never have
+  // existed in the store. Either way it is gone now.
+  if (ret == RETURNCODE_ENOSUPPORT && batch->entries[batch->next].op == LIBTOCK_KV_BATCH_DELETE) {
+    ret = RETURNCODE_SUCCESS;
+  }
+  if (ret != RETURNCODE_SUCCESS) {
+    kv_batch_finish(batch, ret);
+    return;
+  }
+
+  // Start the next operation straight from this upcall.
+  batch->next++;
+  if (batch->next < batch->count) {
+    ret = kv_batch_issue(batch);
+    if (ret != RETURNCODE_SUCCESS) {
+      kv_batch_finish(batch, ret);
+    }
+    return;
+  }
+
+  kv_batch_finish(batch, RETURNCODE_SUCCESS);
+}
+
+static void kv_batch_upcall_empty(__attribute__ ((unused)) int unused0,
+                                  __attribute__ ((unused)) int unused1,
+                                  __attribute__ ((unused)) int unused2,
+                                  void*                        opaque) {
+  kv_batch_finish((libtock_kv_batch_t*) opaque, RETURNCODE_SUCCESS);
+}
+
+void libtock_kv_batch_init(libtock_kv_batch_t* batch, libtock_kv_cache_t* cache) {
+  memset(batch, 0, sizeof(libtock_kv_batch_t));
+  batch->cache = cache;
+}
+
+returncode_t libtock_kv_batch_set(libtock_kv_batch_t* batch, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len) {
+  return kv_batch_queue(batch, LIBTOCK_KV_BATCH_SET, key_buffer, key_len, val_buffer, val_len);
+}
+
+returncode_t libtock_kv_batch_delete(libtock_kv_batch_t* batch, const uint8_t* key_buffer, uint32_t key_len) {
+  return kv_batch_queue(batch, LIBTOCK_KV_BATCH_DELETE, key_buffer, key_len, NULL, 0);
+}
+
+int libtock_kv_batch_pending(const libtock_kv_batch_t* batch) {
+  return batch->count;
+}
+
+returncode_t libtock_kv_batch_flush(libtock_kv_batch_t* batch, libtock_kv_batch_callback_flush cb) {
+  returncode_t err;
+
+  if (batch->flushing) return RETURNCODE_EBUSY;
+
+  batch->flushing = true;
+  batch->next     = 0;
+  batch->cb       = cb;
+
+  if (batch->count == 0) {
+    if (tock_enqueue(kv_batch_upcall_empty, 0, 0, 0, batch) < 0) {
+      batch->flushing = false;
+      return RETURNCODE_EBUSY;
+    }
+    return RETURNCODE_SUCCESS;
+  }
+
+  err = kv_batch_issue(batch);
+  if (err != RETURNCODE_SUCCESS) {
+    batch->flushing = false;
+  }
+  return err;
+}
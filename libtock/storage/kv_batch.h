@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../tock.h"
+#include "kv.h"
+#include "kv_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Write-back batching of KV mutations.
+//
+// Sets and deletes are copied into the batch instead of being sent to the
+// kernel one at a time. A later mutation of a key already in the batch
+// replaces the earlier one, so a value that changes many times between
+// flushes is only written to flash once. `libtock_kv_batch_flush()` then
+// issues the remaining mutations back to back, starting each operation from
+// the completion upcall of the previous one, and calls a single callback when
+// the whole batch is done.
+//
+// Mutations held in the batch are not visible to `libtock_kv_get()` until they
+// are flushed.
+
+#define LIBTOCK_KV_BATCH_ENTRIES       8
+#define LIBTOCK_KV_BATCH_MAX_KEY_LEN   32
+#define LIBTOCK_KV_BATCH_MAX_VALUE_LEN 64
+
+// Function signature for batch flush callbacks.
+//
+// - `arg1` (`returncode_t`): Status of the first failed operation, or
+//   `RETURNCODE_SUCCESS` if every mutation was written.
+// - `arg2` (`int`): Number of mutations written to the kernel.
+typedef void (*libtock_kv_batch_callback_flush)(returncode_t, int);
+
+typedef enum {
+  LIBTOCK_KV_BATCH_SET,
+  LIBTOCK_KV_BATCH_DELETE,
+} libtock_kv_batch_op_t;
+
+typedef struct {
+  libtock_kv_batch_op_t op;
+  uint32_t key_len;
+  uint32_t value_len;
+  uint8_t key[LIBTOCK_KV_BATCH_MAX_KEY_LEN];
+  uint8_t value[LIBTOCK_KV_BATCH_MAX_VALUE_LEN];
+} libtock_kv_batch_entry_t;
+
+// State for one batch. Allocated by the caller and initialized with
+// `libtock_kv_batch_init()`.
+typedef struct {
+  libtock_kv_batch_entry_t entries[LIBTOCK_KV_BATCH_ENTRIES];
+  int count;
+
+  // Number of mutations that replaced a pending mutation of the same key
+  // instead of taking a new entry.
+  uint32_t coalesced;
+
+  // Optional cache to keep coherent with the flushed mutations.
+  libtock_kv_cache_t* cache;
+
+  // State of an in-progress flush.
+  bool flushing;
+  int next;
+  libtock_kv_batch_callback_flush cb;
+} libtock_kv_batch_t;
+
+// Initialize an empty batch.
+//
+// If `cache` is not `NULL`, every key written or deleted by a flush is
+// invalidated in that cache.
+void libtock_kv_batch_init(libtock_kv_batch_t* batch, libtock_kv_cache_t* cache);
+
+// Queue a set of `key_buffer` to `val_buffer`.
+//
+// Both buffers are copied and may be reused as soon as this returns. Returns
+// `RETURNCODE_ESIZE` if the key or value do not fit in a batch entry,
+// `RETURNCODE_ENOMEM` if the batch is full and `RETURNCODE_EBUSY` while the
+// batch is being flushed.
+returncode_t libtock_kv_batch_set(libtock_kv_batch_t* batch, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len);
+
+// Queue a delete of `key_buffer`. Same errors as `libtock_kv_batch_set()`.
+returncode_t libtock_kv_batch_delete(libtock_kv_batch_t* batch, const uint8_t* key_buffer, uint32_t key_len);
+
+// Number of mutations waiting to be flushed.
+int libtock_kv_batch_pending(const libtock_kv_batch_t* batch);
+
+// Write all queued mutations to the kernel, in the order they were first
+// queued.
+//
+// Deleting a key that does not exist is not an error. The flush stops at the
+// first failing operation: the failed mutation and all later ones stay in the
+// batch, so the flush can be retried. `cb` is called once, when the flush
+// completes or fails. An empty batch completes on the next `yield()`.
+returncode_t libtock_kv_batch_flush(libtock_kv_batch_t* batch, libtock_kv_batch_callback_flush cb);
+
+#ifdef __cplusplus
+}
+#endif
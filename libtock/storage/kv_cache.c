@@ -0,0 +1,229 @@
+#include "kv_cache.h"
+
+#include <string.h>
+
+static uint32_t kv_cache_hash(const uint8_t* key_buffer, uint32_t key_len) {
+  // 32-bit FNV-1a.
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < key_len; i++) {
+    hash ^= key_buffer[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static libtock_kv_cache_entry_t* kv_cache_find(libtock_kv_cache_t* cache, uint32_t hash, const uint8_t* key_buffer,
+                                               uint32_t key_len) {
+  if (key_len > LIBTOCK_KV_CACHE_MAX_KEY_LEN) return NULL;
+
+  for (int i = 0; i < LIBTOCK_KV_CACHE_ENTRIES; i++) {
+    libtock_kv_cache_entry_t* entry = &cache->entries[i];
+    if (entry->valid && entry->hash == hash && entry->key_len == key_len &&
+        memcmp(entry->key, key_buffer, key_len) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Store `value` for the key, replacing an existing entry for the same key or
+// else an empty or the least recently used entry.
+static void kv_cache_fill(libtock_kv_cache_t* cache, uint32_t hash, const uint8_t* key_buffer, uint32_t key_len,
+                          const uint8_t* value, uint32_t value_len) {
+  if (key_len > LIBTOCK_KV_CACHE_MAX_KEY_LEN || value_len > LIBTOCK_KV_CACHE_MAX_VALUE_LEN) return;
+
+  libtock_kv_cache_entry_t* entry = kv_cache_find(cache, hash, key_buffer, key_len);
+  if (entry == NULL) {
+    entry = &cache->entries[0];
+    for (int i = 0; i < LIBTOCK_KV_CACHE_ENTRIES; i++) {
+      libtock_kv_cache_entry_t* candidate = &cache->entries[i];
+      if (!candidate->valid) {
+        entry = candidate;
+        break;
+      }
+      // Compare ages rather than raw clock values so wrap-around is harmless.
+      if (cache->clock - candidate->last_used > cache->clock - entry->last_used) {
+        entry = candidate;
+      }
+    }
+  }
+
+  entry->valid     = true;
+  entry->hash      = hash;
+  entry->last_used = ++cache->clock;
+  entry->key_len   = key_len;
+  entry->value_len = value_len;
+  memcpy(entry->key, key_buffer, key_len);
+  memcpy(entry->value, value, value_len);
+}
+
+static void kv_cache_upcall_get(int                          err,
+                                int                          length,
+                                __attribute__ ((unused)) int unused2,
+                                void*                        opaque) {
+  libtock_kv_cache_t* cache = (libtock_kv_cache_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(err);
+
+  // Only complete values are cached, truncated reads report `ESIZE`.
+  if (ret == RETURNCODE_SUCCESS && (uint32_t) length <= cache->op_ret_len) {
+    kv_cache_fill(cache, cache->op_hash, cache->op_key, cache->op_key_len, cache->op_ret_buffer, length);
+  }
+
+  cache->get_cb(ret, length);
+}
+
+static void kv_cache_upcall_hit(int                          ret,
+                                int                          length,
+                                __attribute__ ((unused)) int unused2,
+                                void*                        opaque) {
+  libtock_kv_cache_t* cache = (libtock_kv_cache_t*) opaque;
+  cache->get_cb(ret, length);
+}
+
+static void kv_cache_upcall_insert(int                          err,
+                                   __attribute__ ((unused)) int length,
+                                   __attribute__ ((unused)) int unused2,
+                                   void*                        opaque) {
+  libtock_kv_cache_t* cache = (libtock_kv_cache_t*) opaque;
+  returncode_t ret = tock_status_to_returncode(err);
+
+  // Write-through: the kernel now holds this value, so will future gets.
+  if (ret == RETURNCODE_SUCCESS) {
+    kv_cache_fill(cache, cache->op_hash, cache->op_key, cache->op_key_len, cache->op_value, cache->op_value_len);
+  }
+
+  cache->done_cb(ret);
+}
+
+static void kv_cache_upcall_delete(int                          err,
+                                   __attribute__ ((unused)) int length,
+                                   __attribute__ ((unused)) int unused2,
+                                   void*                        opaque) {
+  libtock_kv_cache_t* cache = (libtock_kv_cache_t*) opaque;
+  cache->done_cb(tock_status_to_returncode(err));
+}
+
+void libtock_kv_cache_init(libtock_kv_cache_t* cache) {
+  memset(cache, 0, sizeof(libtock_kv_cache_t));
+}
+
+void libtock_kv_cache_invalidate(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len) {
+  libtock_kv_cache_entry_t* entry = kv_cache_find(cache, kv_cache_hash(key_buffer, key_len), key_buffer, key_len);
+  if (entry != NULL) {
+    entry->valid = false;
+  }
+}
+
+void libtock_kv_cache_clear(libtock_kv_cache_t* cache) {
+  for (int i = 0; i < LIBTOCK_KV_CACHE_ENTRIES; i++) {
+    cache->entries[i].valid = false;
+  }
+}
+
+returncode_t libtock_kv_cache_get(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  uint8_t* ret_buffer, uint32_t ret_len, libtock_kv_callback_get cb) {
+  returncode_t err;
+  uint32_t hash = kv_cache_hash(key_buffer, key_len);
+
+  libtock_kv_cache_entry_t* entry = kv_cache_find(cache, hash, key_buffer, key_len);
+  if (entry != NULL) {
+    // Mirror the kernel: copy what fits and report `ESIZE` if truncated.
+    uint32_t copy_len = entry->value_len < ret_len ? entry->value_len : ret_len;
+    memcpy(ret_buffer, entry->value, copy_len);
+    returncode_t hit_ret = entry->value_len <= ret_len ? RETURNCODE_SUCCESS : RETURNCODE_ESIZE;
+
+    cache->get_cb = cb;
+    if (tock_enqueue(kv_cache_upcall_hit, hit_ret, entry->value_len, 0, cache) < 0) {
+      return RETURNCODE_EBUSY;
+    }
+
+    entry->last_used = ++cache->clock;
+    cache->hits++;
+    return RETURNCODE_SUCCESS;
+  }
+
+  cache->misses++;
+  cache->op_hash       = hash;
+  cache->op_key        = key_buffer;
+  cache->op_key_len    = key_len;
+  cache->op_ret_buffer = ret_buffer;
+  cache->op_ret_len    = ret_len;
+  cache->get_cb        = cb;
+
+  err = libtock_kv_set_upcall(kv_cache_upcall_get, cache);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readonly_allow_key_buffer(key_buffer, key_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readwrite_allow_output_buffer(ret_buffer, ret_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_command_get();
+  return err;
+}
+
+static returncode_t kv_cache_insert(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                    const uint8_t* val_buffer, uint32_t val_len, returncode_t (*op_fn)(void),
+                                    libtock_kv_callback_done cb) {
+  returncode_t err;
+  uint32_t hash = kv_cache_hash(key_buffer, key_len);
+
+  // Invalidate first, so a failed write can never leave a stale value behind.
+  libtock_kv_cache_entry_t* entry = kv_cache_find(cache, hash, key_buffer, key_len);
+  if (entry != NULL) {
+    entry->valid = false;
+  }
+
+  cache->op_hash      = hash;
+  cache->op_key       = key_buffer;
+  cache->op_key_len   = key_len;
+  cache->op_value     = val_buffer;
+  cache->op_value_len = val_len;
+  cache->done_cb      = cb;
+
+  err = libtock_kv_set_upcall(kv_cache_upcall_insert, cache);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readonly_allow_key_buffer(key_buffer, key_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readonly_allow_input_buffer(val_buffer, val_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  // Do the requested set/add/update operation.
+  err = op_fn();
+  return err;
+}
+
+returncode_t libtock_kv_cache_set(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_command_set, cb);
+}
+
+returncode_t libtock_kv_cache_add(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_command_add, cb);
+}
+
+returncode_t libtock_kv_cache_update(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                     const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb) {
+  return kv_cache_insert(cache, key_buffer, key_len, val_buffer, val_len, libtock_kv_command_update, cb);
+}
+
+returncode_t libtock_kv_cache_delete(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                     libtock_kv_callback_done cb) {
+  returncode_t err;
+
+  libtock_kv_cache_invalidate(cache, key_buffer, key_len);
+  cache->done_cb = cb;
+
+  err = libtock_kv_set_upcall(kv_cache_upcall_delete, cache);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_set_readonly_allow_key_buffer(key_buffer, key_len);
+  if (err != RETURNCODE_SUCCESS) return err;
+
+  err = libtock_kv_command_delete();
+  return err;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../tock.h"
+#include "kv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Client-side read cache for the KV driver.
+//
+// The cache holds the most recently used key/value pairs in a fixed number of
+// entries, evicting the least recently used entry when full. Gets that hit in
+// the cache are answered from RAM without a round-trip to the kernel. Every
+// set/add/update/delete issued through the cache invalidates the matching
+// entry before the operation starts, and on success the new value is written
+// through into the cache.
+//
+// Writes that bypass the cache (e.g. direct calls to `libtock_kv_set()`) are
+// not observed. Callers mixing both APIs must call
+// `libtock_kv_cache_invalidate()` themselves.
+//
+// Values longer than `LIBTOCK_KV_CACHE_MAX_VALUE_LEN` and keys longer than
+// `LIBTOCK_KV_CACHE_MAX_KEY_LEN` are never cached. These sizes are fixed when
+// libtock is built, apps that need more entries can use several caches.
+
+#define LIBTOCK_KV_CACHE_ENTRIES       8
+#define LIBTOCK_KV_CACHE_MAX_KEY_LEN   32
+#define LIBTOCK_KV_CACHE_MAX_VALUE_LEN 64
+
+typedef struct {
+  bool valid;
+  // FNV-1a hash of the key, compared before the full key.
+  uint32_t hash;
+  // Value of the cache clock when this entry was last used.
+  uint32_t last_used;
+  uint32_t key_len;
+  uint32_t value_len;
+  uint8_t key[LIBTOCK_KV_CACHE_MAX_KEY_LEN];
+  uint8_t value[LIBTOCK_KV_CACHE_MAX_VALUE_LEN];
+} libtock_kv_cache_entry_t;
+
+// State for one KV cache. Allocated by the caller and initialized with
+// `libtock_kv_cache_init()`. Only one operation may be outstanding on a cache
+// at a time, as the underlying KV driver only supports one operation.
+typedef struct {
+  libtock_kv_cache_entry_t entries[LIBTOCK_KV_CACHE_ENTRIES];
+  uint32_t clock;
+
+  // Number of gets answered from the cache.
+  uint32_t hits;
+  // Number of gets that had to be sent to the kernel.
+  uint32_t misses;
+
+  // State of the outstanding operation.
+  uint32_t op_hash;
+  const uint8_t* op_key;
+  uint32_t op_key_len;
+  const uint8_t* op_value;
+  uint32_t op_value_len;
+  uint8_t* op_ret_buffer;
+  uint32_t op_ret_len;
+  libtock_kv_callback_get get_cb;
+  libtock_kv_callback_done done_cb;
+} libtock_kv_cache_t;
+
+// Initialize an empty cache and reset its counters.
+void libtock_kv_cache_init(libtock_kv_cache_t* cache);
+
+// Drop the cached value for `key_buffer`, if any.
+void libtock_kv_cache_invalidate(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len);
+
+// Drop all cached values. The hit and miss counters are kept.
+void libtock_kv_cache_clear(libtock_kv_cache_t* cache);
+
+// Get the value for `key_buffer`, from the cache if possible.
+//
+// Has the same semantics as `libtock_kv_get()`. On a hit the value is copied
+// into `ret_buffer` immediately and `cb` is deferred until the next `yield()`,
+// so the callback never runs before this function returns.
+returncode_t libtock_kv_cache_get(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  uint8_t* ret_buffer, uint32_t ret_len, libtock_kv_callback_get cb);
+
+returncode_t libtock_kv_cache_set(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb);
+
+returncode_t libtock_kv_cache_add(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                  const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb);
+
+returncode_t libtock_kv_cache_update(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                     const uint8_t* val_buffer, uint32_t val_len, libtock_kv_callback_done cb);
+
+returncode_t libtock_kv_cache_delete(libtock_kv_cache_t* cache, const uint8_t* key_buffer, uint32_t key_len,
+                                     libtock_kv_callback_done cb);
+
+#ifdef __cplusplus
+}
+#endif
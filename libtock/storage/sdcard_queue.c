@@ -0,0 +1,278 @@
+#include <string.h>
+
+#include "sdcard_queue.h"
+
+#define SECTOR_SIZE LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE
+
+static void queue_run(libtock_sdcard_queue_t* queue);
+
+static uint8_t* slot_data(libtock_sdcard_queue_t* queue, int slot) {
+  return queue->cache_memory + slot * SECTOR_SIZE;
+}
+
+static int slot_find(libtock_sdcard_queue_t* queue, uint32_t sector) {
+  for (uint32_t i = 0; i < queue->cache_sectors; i++) {
+    if (queue->slots[i].valid && queue->slots[i].sector == sector) return i;
+  }
+  return -1;
+}
+
+// An empty slot, or else the least recently used clean slot. Returns -1 if
+// every slot is dirty.
+static int slot_free(libtock_sdcard_queue_t* queue) {
+  int found = -1;
+  for (uint32_t i = 0; i < queue->cache_sectors; i++) {
+    libtock_sdcard_queue_slot_t* slot = &queue->slots[i];
+    if (!slot->valid) return i;
+    if (slot->dirty) continue;
+
+    // Compare ages rather than raw clock values so wrap-around is harmless.
+    if (found < 0 || queue->clock - slot->last_used > queue->clock - queue->slots[found].last_used) {
+      found = i;
+    }
+  }
+  return found;
+}
+
+// The dirty slot to write back next: the least recently used one when
+// `lowest_sector` is false, else the one with the lowest sector.
+static int slot_dirty(libtock_sdcard_queue_t* queue, bool lowest_sector) {
+  int found = -1;
+  for (uint32_t i = 0; i < queue->cache_sectors; i++) {
+    libtock_sdcard_queue_slot_t* slot = &queue->slots[i];
+    if (!slot->valid || !slot->dirty) continue;
+
+    if (found < 0) {
+      found = i;
+    } else if (lowest_sector) {
+      if (slot->sector < queue->slots[found].sector) found = i;
+    } else if (queue->clock - slot->last_used > queue->clock - queue->slots[found].last_used) {
+      found = i;
+    }
+  }
+  return found;
+}
+
+// Remove the head request and call its callback.
+static void queue_complete(libtock_sdcard_queue_t* queue, returncode_t ret) {
+  libtock_sdcard_queue_request_t request = queue->requests[queue->head];
+
+  queue->head = (queue->head + 1) % LIBTOCK_SDCARD_QUEUE_LENGTH;
+  queue->count--;
+  request.cb(ret, request.opaque);
+}
+
+static void queue_upcall(int                          callback_type,
+                         __attribute__ ((unused)) int arg1,
+                         __attribute__ ((unused)) int arg2,
+                         void*                        opaque) {
+  libtock_sdcard_queue_t* queue = (libtock_sdcard_queue_t*) opaque;
+  int slot = queue->in_flight_slot;
+
+  if (callback_type == 0) {
+    queue->card_changed = true;
+  }
+
+  // Card events while no transfer is in flight have no request to fail.
+  if (!queue->busy || queue->count == 0) return;
+
+  switch (callback_type) {
+    case 2:
+      // read_done
+      queue->busy = false;
+      queue->blocks_read++;
+      queue->requests[queue->head].done++;
+      break;
+
+    case 3:
+      // write_done
+      queue->busy = false;
+      queue->blocks_written++;
+      if (slot >= 0) {
+        queue->slots[slot].dirty = false;
+      } else {
+        queue->requests[queue->head].done++;
+      }
+      break;
+
+    case 0:
+    case 4:
+      // The card was removed or reported an error. A sector that was being
+      // written back stays dirty.
+      queue->busy = false;
+      queue_complete(queue, callback_type == 0 ? RETURNCODE_EUNINSTALLED : RETURNCODE_FAIL);
+      break;
+
+    default:
+      return;
+  }
+
+  // Start the next transfer right away.
+  queue_run(queue);
+}
+
+static returncode_t queue_start_read(libtock_sdcard_queue_t* queue, uint32_t sector, uint8_t* buffer) {
+  returncode_t ret;
+
+  ret = libtock_sdcard_set_upcall(queue_upcall, queue);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sdcard_set_readwrite_allow_read_buffer(buffer, SECTOR_SIZE);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sdcard_command_read_block(sector);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  queue->busy = true;
+  return RETURNCODE_SUCCESS;
+}
+
+static returncode_t queue_start_write(libtock_sdcard_queue_t* queue, uint32_t sector, uint8_t* buffer, int slot) {
+  returncode_t ret;
+
+  ret = libtock_sdcard_set_upcall(queue_upcall, queue);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sdcard_set_readonly_allow_write_buffer(buffer, SECTOR_SIZE);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  ret = libtock_sdcard_command_write_block(sector);
+  if (ret != RETURNCODE_SUCCESS) return ret;
+
+  queue->busy           = true;
+  queue->in_flight_slot = slot;
+  return RETURNCODE_SUCCESS;
+}
+
+// Work through the queue until a block transfer is started or the queue is
+// empty. Sectors served from or into the cache need no transfer.
+static void queue_run(libtock_sdcard_queue_t* queue) {
+  queue->running = true;
+
+  while (!queue->busy && queue->count > 0) {
+    libtock_sdcard_queue_request_t* request = &queue->requests[queue->head];
+    returncode_t ret;
+
+    if (request->op == LIBTOCK_SDCARD_QUEUE_FLUSH) {
+      int slot = slot_dirty(queue, true);
+      if (slot < 0) {
+        queue_complete(queue, RETURNCODE_SUCCESS);
+        continue;
+      }
+      ret = queue_start_write(queue, queue->slots[slot].sector, slot_data(queue, slot), slot);
+    } else if (request->done == request->count) {
+      queue_complete(queue, RETURNCODE_SUCCESS);
+      continue;
+    } else {
+      uint32_t sector = request->sector + request->done;
+      uint8_t* data   = request->buffer + request->done * SECTOR_SIZE;
+      int slot        = slot_find(queue, sector);
+
+      if (request->op == LIBTOCK_SDCARD_QUEUE_READ) {
+        if (slot >= 0) {
+          memcpy(data, slot_data(queue, slot), SECTOR_SIZE);
+          queue->slots[slot].last_used = ++queue->clock;
+          queue->cache_hits++;
+          request->done++;
+          continue;
+        }
+        ret = queue_start_read(queue, sector, data);
+      } else if (request->count >= queue->cache_sectors) {
+        // Large writes bypass the cache, which makes a cached copy stale.
+        if (slot >= 0) {
+          queue->slots[slot].valid = false;
+        }
+        ret = queue_start_write(queue, sector, data, -1);
+      } else {
+        if (slot < 0) {
+          slot = slot_free(queue);
+        }
+        if (slot >= 0) {
+          libtock_sdcard_queue_slot_t* entry = &queue->slots[slot];
+          memcpy(slot_data(queue, slot), data, SECTOR_SIZE);
+          entry->valid     = true;
+          entry->dirty     = true;
+          entry->sector    = sector;
+          entry->last_used = ++queue->clock;
+          request->done++;
+          continue;
+        }
+
+        // Every slot is dirty, make room by writing one back.
+        slot = slot_dirty(queue, false);
+        ret  = queue_start_write(queue, queue->slots[slot].sector, slot_data(queue, slot), slot);
+      }
+    }
+
+    if (ret != RETURNCODE_SUCCESS) {
+      queue_complete(queue, ret);
+    }
+  }
+
+  queue->running = false;
+}
+
+static void queue_kick(__attribute__ ((unused)) int unused0,
+                       __attribute__ ((unused)) int unused1,
+                       __attribute__ ((unused)) int unused2,
+                       void*                        opaque) {
+  queue_run((libtock_sdcard_queue_t*) opaque);
+}
+
+static returncode_t queue_submit(libtock_sdcard_queue_t* queue, libtock_sdcard_queue_op_t op, uint32_t sector,
+                                 uint32_t count, uint8_t* buffer, libtock_sdcard_queue_callback cb, void* opaque) {
+  if (queue->count == LIBTOCK_SDCARD_QUEUE_LENGTH) return RETURNCODE_EBUSY;
+
+  // Requests are only processed from upcalls, so `cb` never runs before this
+  // function returns.
+  if (!queue->busy && !queue->running) {
+    if (tock_enqueue(queue_kick, 0, 0, 0, queue) < 0) return RETURNCODE_EBUSY;
+    queue->running = true;
+  }
+
+  libtock_sdcard_queue_request_t* request =
+    &queue->requests[(queue->head + queue->count) % LIBTOCK_SDCARD_QUEUE_LENGTH];
+  request->op     = op;
+  request->sector = sector;
+  request->count  = count;
+  request->done   = 0;
+  request->buffer = buffer;
+  request->cb     = cb;
+  request->opaque = opaque;
+  queue->count++;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_sdcard_queue_init(libtock_sdcard_queue_t* queue, uint8_t* cache_memory,
+                                       libtock_sdcard_queue_slot_t* slots, uint32_t cache_sectors) {
+  if (cache_sectors == 0) return RETURNCODE_EINVAL;
+
+  memset(queue, 0, sizeof(libtock_sdcard_queue_t));
+  memset(slots, 0, cache_sectors * sizeof(libtock_sdcard_queue_slot_t));
+  queue->cache_memory   = cache_memory;
+  queue->slots          = slots;
+  queue->cache_sectors  = cache_sectors;
+  queue->in_flight_slot = -1;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_sdcard_queue_read(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                       uint8_t* buffer, libtock_sdcard_queue_callback cb, void* opaque) {
+  if (count == 0) return RETURNCODE_EINVAL;
+  return queue_submit(queue, LIBTOCK_SDCARD_QUEUE_READ, sector, count, buffer, cb, opaque);
+}
+
+returncode_t libtock_sdcard_queue_write(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                        uint8_t* buffer, libtock_sdcard_queue_callback cb, void* opaque) {
+  if (count == 0) return RETURNCODE_EINVAL;
+  return queue_submit(queue, LIBTOCK_SDCARD_QUEUE_WRITE, sector, count, buffer, cb, opaque);
+}
+
+returncode_t libtock_sdcard_queue_flush(libtock_sdcard_queue_t* queue, libtock_sdcard_queue_callback cb,
+                                        void* opaque) {
+  return queue_submit(queue, LIBTOCK_SDCARD_QUEUE_FLUSH, 0, 0, NULL, cb, opaque);
+}
+
+int libtock_sdcard_queue_pending(libtock_sdcard_queue_t* queue) {
+  return queue->count;
+}
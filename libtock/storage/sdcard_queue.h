@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../tock.h"
+#include "sdcard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued SD card I/O with a write-back sector cache.
+//
+// Reads, writes and flushes of any number of sectors are accepted into a
+// queue and processed in order. The next block transfer is started from the
+// completion upcall of the previous one, so the card never waits for the app
+// to issue the next request.
+//
+// Writes are copied into the write-back cache and complete as soon as the
+// data is there. A later write to a cached sector replaces it in RAM. Dirty
+// sectors reach the card when they are evicted to make room or on
+// `libtock_sdcard_queue_flush()`, which writes them in ascending sector order
+// so that adjacent sectors go out back to back. Reads are answered from the
+// cache when it holds the sector. Writes of at least as many sectors as the
+// cache holds go directly to the card.
+//
+// Data is only guaranteed to be on the card once a flush completes.
+//
+// The queue registers its own upcall with the SD card driver. Do not mix it
+// with direct `libtock_sdcard_*()` calls while requests are queued.
+
+// Maximum number of queued requests.
+#define LIBTOCK_SDCARD_QUEUE_LENGTH 8
+
+#define LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE 512
+
+// Function signature for request callbacks.
+//
+// - `arg1` (`returncode_t`): Status of the request.
+// - `arg2` (`void*`): The `opaque` pointer passed with the request.
+typedef void (*libtock_sdcard_queue_callback)(returncode_t, void*);
+
+typedef enum {
+  LIBTOCK_SDCARD_QUEUE_READ,
+  LIBTOCK_SDCARD_QUEUE_WRITE,
+  LIBTOCK_SDCARD_QUEUE_FLUSH,
+} libtock_sdcard_queue_op_t;
+
+typedef struct {
+  libtock_sdcard_queue_op_t op;
+  uint32_t sector;
+  uint32_t count;
+  // Number of sectors already transferred.
+  uint32_t done;
+  uint8_t* buffer;
+  libtock_sdcard_queue_callback cb;
+  void* opaque;
+} libtock_sdcard_queue_request_t;
+
+typedef struct {
+  bool valid;
+  bool dirty;
+  uint32_t sector;
+  // Value of the queue clock when this sector was last used.
+  uint32_t last_used;
+} libtock_sdcard_queue_slot_t;
+
+// State for one queue. Allocated by the caller and initialized with
+// `libtock_sdcard_queue_init()`.
+typedef struct {
+  libtock_sdcard_queue_request_t requests[LIBTOCK_SDCARD_QUEUE_LENGTH];
+  int head;
+  int count;
+
+  // Write-back cache.
+  uint8_t* cache_memory;
+  libtock_sdcard_queue_slot_t* slots;
+  uint32_t cache_sectors;
+  uint32_t clock;
+
+  // Block transfer in progress, `in_flight_slot` is the cache slot being
+  // written back or -1 for a transfer of the head request.
+  bool busy;
+  int in_flight_slot;
+  // Set while requests are being processed or a run is scheduled.
+  bool running;
+  // Set when the card detect state changes. Cleared by the app.
+  bool card_changed;
+
+  // Statistics.
+  uint32_t cache_hits;
+  uint32_t blocks_read;
+  uint32_t blocks_written;
+} libtock_sdcard_queue_t;
+
+// Initialize an empty queue with a cache of `cache_sectors` sectors.
+//
+// `cache_memory` must hold `cache_sectors * LIBTOCK_SDCARD_QUEUE_SECTOR_SIZE`
+// bytes and `slots` must have `cache_sectors` entries. The SD card must
+// already be initialized.
+returncode_t libtock_sdcard_queue_init(libtock_sdcard_queue_t* queue, uint8_t* cache_memory,
+                                       libtock_sdcard_queue_slot_t* slots, uint32_t cache_sectors);
+
+// Queue a read of `count` sectors starting at `sector` into `buffer`.
+//
+// Returns `RETURNCODE_EBUSY` if the queue is full. `buffer` must stay valid
+// until `cb` is called.
+returncode_t libtock_sdcard_queue_read(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                       uint8_t* buffer, libtock_sdcard_queue_callback cb, void* opaque);
+
+// Queue a write of `count` sectors starting at `sector` from `buffer`.
+//
+// `cb` is called once the data is in the cache or on the card, after which
+// `buffer` may be reused.
+returncode_t libtock_sdcard_queue_write(libtock_sdcard_queue_t* queue, uint32_t sector, uint32_t count,
+                                        uint8_t* buffer, libtock_sdcard_queue_callback cb, void* opaque);
+
+// Queue a flush. `cb` is called once every sector written before the flush
+// is on the card.
+returncode_t libtock_sdcard_queue_flush(libtock_sdcard_queue_t* queue, libtock_sdcard_queue_callback cb,
+                                        void* opaque);
+
+// Number of requests that have not completed yet.
+int libtock_sdcard_queue_pending(libtock_sdcard_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
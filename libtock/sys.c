@@ -22,9 +22,13 @@
 // ------------------------------
 // LIBC SUPPORT STUBS
 // ------------------------------
+//
+// The file stubs are weak so that a file system (e.g.
+// libtock-sync/storage/fat.c) can replace them.
 
 void* __dso_handle = 0;
 
+__attribute__ ((weak))
 int _unlink(const char* pathname) {
   return -1;
 }
@@ -35,19 +39,24 @@ int _isatty(int fd) {
   }
   return 0;
 }
+__attribute__ ((weak))
 int _open(const char* path, int flags, ...) {
   return -1;
 }
+__attribute__ ((weak))
 int _close(int fd) {
   return -1;
 }
+__attribute__ ((weak))
 int _fstat(int fd, struct stat* st) {
   st->st_mode = S_IFCHR;
   return 0;
 }
+__attribute__ ((weak))
 int _lseek(int fd, uint32_t offset, int whence) {
   return 0;
 }
+__attribute__ ((weak))
 int _read(int fd, void* buf, uint32_t count) {
   return 0;   // k_read(fd, (uint8_t*) buf, count);
 }
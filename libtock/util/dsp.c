@@ -0,0 +1,264 @@
+#include <string.h>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+#include "dsp.h"
+
+static int16_t saturate16(int32_t value) {
+  if (value > INT16_MAX) return INT16_MAX;
+  if (value < INT16_MIN) return INT16_MIN;
+  return (int16_t) value;
+}
+
+int16_t* libtock_dsp_adc_to_q15(uint16_t* samples, uint32_t count, uint32_t resolution_bits) {
+  int16_t* out = (int16_t*) samples;
+
+  for (uint32_t i = 0; i < count; i++) {
+    // Left-justify to 16 bits and flip the sign bit.
+    out[i] = (int16_t) ((uint16_t) (samples[i] << (16 - resolution_bits)) ^ 0x8000);
+  }
+  return out;
+}
+
+void libtock_dsp_dc_block_init(libtock_dsp_dc_block_t* dc, int16_t pole) {
+  dc->pole            = pole;
+  dc->previous_input  = 0;
+  dc->previous_output = 0;
+}
+
+uint32_t libtock_dsp_dc_block(libtock_dsp_dc_block_t* dc, int16_t* samples, uint32_t count) {
+  int32_t x_prev = dc->previous_input;
+  int32_t y_prev = dc->previous_output;
+
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t x = samples[i];
+    // Q31 difference plus the Q15 * Q31 feedback term.
+    int64_t y = (int64_t) (x - x_prev) * 65536 + (((int64_t) dc->pole * y_prev) >> 15);
+
+    if (y > INT32_MAX) y = INT32_MAX;
+    if (y < INT32_MIN) y = INT32_MIN;
+
+    x_prev     = x;
+    y_prev     = (int32_t) y;
+    samples[i] = saturate16((int32_t) ((y + 0x8000) >> 16));
+  }
+
+  dc->previous_input  = x_prev;
+  dc->previous_output = y_prev;
+  return count;
+}
+
+returncode_t libtock_dsp_cic_init(libtock_dsp_cic_t* cic, uint32_t order, uint32_t decimation_log2) {
+  if (order == 0 || order > LIBTOCK_DSP_CIC_MAX_ORDER) return RETURNCODE_EINVAL;
+  if (order * decimation_log2 > 16) return RETURNCODE_EINVAL;
+
+  memset(cic, 0, sizeof(libtock_dsp_cic_t));
+  cic->order           = order;
+  cic->decimation_log2 = decimation_log2;
+  return RETURNCODE_SUCCESS;
+}
+
+uint32_t libtock_dsp_cic_decimate(libtock_dsp_cic_t* cic, int16_t* samples, uint32_t count) {
+  uint32_t mask  = (1u << cic->decimation_log2) - 1;
+  uint32_t shift = cic->order * cic->decimation_log2;
+  uint32_t out   = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    // Integrators and combs wrap around; the result is exact as long as the
+    // output fits, which the gain limit in `libtock_dsp_cic_init()` ensures.
+    uint32_t value = (uint32_t) samples[i];
+    for (uint32_t s = 0; s < cic->order; s++) {
+      value += (uint32_t) cic->integrators[s];
+      cic->integrators[s] = (int32_t) value;
+    }
+
+    cic->phase = (cic->phase + 1) & mask;
+    if (cic->phase != 0) continue;
+
+    for (uint32_t s = 0; s < cic->order; s++) {
+      uint32_t delayed = (uint32_t) cic->combs[s];
+      cic->combs[s] = (int32_t) value;
+      value        -= delayed;
+    }
+    samples[out++] = saturate16((int32_t) value >> shift);
+  }
+  return out;
+}
+
+returncode_t libtock_dsp_fir_init(libtock_dsp_fir_t* fir, const int16_t* coefficients, uint32_t taps,
+                                  uint32_t decimation, int16_t* history) {
+  if (taps == 0 || decimation == 0) return RETURNCODE_EINVAL;
+
+  fir->coefficients = coefficients;
+  fir->taps         = taps;
+  fir->decimation   = decimation;
+  fir->history      = history;
+  fir->position     = 0;
+  fir->phase        = 0;
+  memset(history, 0, 2 * taps * sizeof(int16_t));
+  return RETURNCODE_SUCCESS;
+}
+
+// Dot product of `window` (oldest sample first) with `coefficients` in
+// reverse, that is sum(window[j] * coefficients[taps - 1 - j]).
+static int64_t fir_dot(const int16_t* window, const int16_t* coefficients, uint32_t taps) {
+  int64_t acc = 0;
+  uint32_t j  = 0;
+
+#if defined(__ARM_FEATURE_SIMD32)
+  // Two samples and two coefficients per instruction. The exchanging form
+  // multiplies the low sample with the high coefficient, which matches the
+  // reversed order.
+  for (; j + 1 < taps; j += 2) {
+    int16x2_t x, h;
+    memcpy(&x, &window[j], sizeof(x));
+    memcpy(&h, &coefficients[taps - 2 - j], sizeof(h));
+    acc = __smlaldx(x, h, acc);
+  }
+#endif
+  for (; j < taps; j++) {
+    acc += (int32_t) window[j] * coefficients[taps - 1 - j];
+  }
+  return acc;
+}
+
+uint32_t libtock_dsp_fir_decimate(libtock_dsp_fir_t* fir, int16_t* samples, uint32_t count) {
+  uint32_t taps = fir->taps;
+  uint32_t out  = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    fir->history[fir->position]        = samples[i];
+    fir->history[fir->position + taps] = samples[i];
+    fir->position++;
+    if (fir->position == taps) {
+      fir->position = 0;
+    }
+
+    if (++fir->phase < fir->decimation) continue;
+    fir->phase = 0;
+
+    // The newest `taps` samples start at `position`.
+    int64_t acc = fir_dot(&fir->history[fir->position], fir->coefficients, taps);
+    acc = (acc + (1 << 14)) >> 15;
+    if (acc > INT16_MAX) acc = INT16_MAX;
+    if (acc < INT16_MIN) acc = INT16_MIN;
+    samples[out++] = (int16_t) acc;
+  }
+  return out;
+}
+
+void libtock_dsp_rms_init(libtock_dsp_rms_t* rms, uint32_t* squares, uint32_t window_log2) {
+  rms->squares     = squares;
+  rms->window_log2 = window_log2;
+  rms->position    = 0;
+  rms->sum         = 0;
+  memset(squares, 0, sizeof(uint32_t) << window_log2);
+}
+
+static uint32_t isqrt32(uint32_t value) {
+  uint32_t root = 0;
+  uint32_t bit  = 1u << 30;
+
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root   = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+uint32_t libtock_dsp_moving_rms(libtock_dsp_rms_t* rms, int16_t* samples, uint32_t count) {
+  uint32_t mask = (1u << rms->window_log2) - 1;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t square = (uint32_t) ((int32_t) samples[i] * samples[i]);
+
+    rms->sum                    += square;
+    rms->sum                    -= rms->squares[rms->position];
+    rms->squares[rms->position]  = square;
+    rms->position                = (rms->position + 1) & mask;
+
+    // Mean square in Q30 to RMS in Q15.
+    uint32_t root = isqrt32((uint32_t) (rms->sum >> rms->window_log2));
+    samples[i] = root > INT16_MAX ? INT16_MAX : (int16_t) root;
+  }
+  return count;
+}
+
+uint32_t libtock_dsp_scale(const libtock_dsp_scale_t* scale, int16_t* samples, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    int64_t value = ((int64_t) samples[i] * scale->multiplier) >> scale->shift;
+    value += scale->offset;
+
+    if (value > INT16_MAX) value = INT16_MAX;
+    if (value < INT16_MIN) value = INT16_MIN;
+    samples[i] = (int16_t) value;
+  }
+  return count;
+}
+
+void libtock_dsp_stats(const int16_t* samples, uint32_t count, libtock_dsp_stats_t* stats) {
+  int64_t sum          = 0;
+  uint64_t sum_squares = 0;
+  uint32_t min_index   = 0;
+  uint32_t max_index   = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t x = samples[i];
+    if (x < samples[min_index]) min_index = i;
+    if (x > samples[max_index]) max_index = i;
+    sum         += x;
+    sum_squares += (uint32_t) (x * x);
+  }
+
+  stats->min       = samples[min_index];
+  stats->max       = samples[max_index];
+  stats->min_index = min_index;
+  stats->max_index = max_index;
+
+  // The largest magnitude is at one of the extremes.
+  if (-(int32_t) stats->min > stats->max) {
+    stats->peak       = saturate16(-(int32_t) stats->min);
+    stats->peak_index = min_index;
+  } else {
+    stats->peak       = stats->max;
+    stats->peak_index = max_index;
+  }
+
+  stats->mean = (int16_t) (sum / (int64_t) count);
+
+  uint64_t mean_square = sum_squares / count;
+  uint32_t root        = isqrt32((uint32_t) mean_square);
+  stats->rms = root > INT16_MAX ? INT16_MAX : (int16_t) root;
+}
+
+uint32_t libtock_dsp_find_peaks(const int16_t* samples, uint32_t count, int16_t threshold, uint32_t min_distance,
+                                uint32_t* peaks, uint32_t max_peaks) {
+  uint32_t found = 0;
+
+  for (uint32_t i = 1; i + 1 < count; i++) {
+    int16_t x = samples[i];
+    // A plateau counts once, at its first sample.
+    if (x < threshold || x <= samples[i - 1] || x < samples[i + 1]) continue;
+
+    if (found > 0 && i - peaks[found - 1] < min_distance) {
+      if (x > samples[peaks[found - 1]]) {
+        peaks[found - 1] = i;
+      }
+      continue;
+    }
+
+    if (found == max_peaks) break;
+    peaks[found++] = i;
+  }
+  return found;
+}
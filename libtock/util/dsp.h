@@ -0,0 +1,144 @@
+#pragma once
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-point signal processing stages for ADC sample buffers.
+//
+// Samples are Q15 (`int16_t`, -1.0 to just below 1.0); accumulators are Q31
+// or wider, so intermediate results do not lose precision. Every stage works
+// in place on a buffer of samples and has the same shape:
+//
+//     uint32_t stage(state, int16_t* samples, uint32_t count);
+//
+// returning the number of samples left in the buffer, which is smaller than
+// `count` for decimating stages. Stages can be chained by passing the result
+// of one as the count of the next. State carries over between calls, so
+// consecutive buffers of a continuous capture are processed as one signal.
+//
+// Example, run on each buffer from `libtock_adc_continuous_buffered_sample()`:
+//
+//     int16_t* q15 = libtock_dsp_adc_to_q15(buffer, length, 12);
+//     length = libtock_dsp_dc_block(&dc, q15, length);
+//     length = libtock_dsp_cic_decimate(&cic, q15, length);
+//     libtock_dsp_stats(q15, length, &stats);
+//
+// On cores with the DSP extension (Cortex-M4 and up) the FIR stage uses
+// dual 16-bit multiply-accumulate instructions.
+
+// Convert `count` unsigned ADC samples of `resolution_bits` bits in place to
+// Q15, mapping 0 to -1.0 and full scale to just below 1.0. Returns `samples`
+// as `int16_t*`.
+int16_t* libtock_dsp_adc_to_q15(uint16_t* samples, uint32_t count, uint32_t resolution_bits);
+
+// DC removal: a one-pole high-pass filter, y[n] = x[n] - x[n-1] + a * y[n-1].
+typedef struct {
+  // Pole `a` in Q15. Closer to 1.0 gives a lower cut-off frequency.
+  int16_t pole;
+  int16_t previous_input;
+  // Previous output in Q31.
+  int32_t previous_output;
+} libtock_dsp_dc_block_t;
+
+// Initialize a DC blocker with a pole in Q15, for example 32604 (0.995).
+void libtock_dsp_dc_block_init(libtock_dsp_dc_block_t* dc, int16_t pole);
+
+uint32_t libtock_dsp_dc_block(libtock_dsp_dc_block_t* dc, int16_t* samples, uint32_t count);
+
+// Decimating CIC (cascaded integrator-comb) filter, a multiplier-free
+// low-pass filter for large decimation factors.
+#define LIBTOCK_DSP_CIC_MAX_ORDER 4
+
+typedef struct {
+  uint32_t order;
+  uint32_t decimation_log2;
+  uint32_t phase;
+  int32_t integrators[LIBTOCK_DSP_CIC_MAX_ORDER];
+  int32_t combs[LIBTOCK_DSP_CIC_MAX_ORDER];
+} libtock_dsp_cic_t;
+
+// Initialize a CIC filter of `order` stages that decimates by
+// `2^decimation_log2`. The filter gain is removed from the output.
+//
+// Returns `RETURNCODE_EINVAL` unless `order` is 1 to
+// `LIBTOCK_DSP_CIC_MAX_ORDER` and `order * decimation_log2` is at most 16,
+// which keeps the integrators within 32 bits.
+returncode_t libtock_dsp_cic_init(libtock_dsp_cic_t* cic, uint32_t order, uint32_t decimation_log2);
+
+uint32_t libtock_dsp_cic_decimate(libtock_dsp_cic_t* cic, int16_t* samples, uint32_t count);
+
+// Decimating FIR filter with Q15 coefficients. Only every `decimation`th
+// output is computed.
+typedef struct {
+  const int16_t* coefficients;
+  uint32_t taps;
+  uint32_t decimation;
+  // Delay line, stored twice so the newest `taps` samples are always
+  // contiguous.
+  int16_t* history;
+  uint32_t position;
+  uint32_t phase;
+} libtock_dsp_fir_t;
+
+// Initialize a FIR filter. `history` must hold `2 * taps` samples and stays
+// in use by the filter.
+returncode_t libtock_dsp_fir_init(libtock_dsp_fir_t* fir, const int16_t* coefficients, uint32_t taps,
+                                  uint32_t decimation, int16_t* history);
+
+uint32_t libtock_dsp_fir_decimate(libtock_dsp_fir_t* fir, int16_t* samples, uint32_t count);
+
+// Moving RMS over the last `2^window_log2` samples. Each sample is replaced
+// by the RMS of the window ending at it.
+typedef struct {
+  // Squares of the samples in the window, in Q30.
+  uint32_t* squares;
+  uint32_t window_log2;
+  uint32_t position;
+  uint64_t sum;
+} libtock_dsp_rms_t;
+
+// Initialize a moving RMS. `squares` must hold `2^window_log2` entries.
+void libtock_dsp_rms_init(libtock_dsp_rms_t* rms, uint32_t* squares, uint32_t window_log2);
+
+uint32_t libtock_dsp_moving_rms(libtock_dsp_rms_t* rms, int16_t* samples, uint32_t count);
+
+// Linear scaling to physical units, y = (x * multiplier >> shift) + offset,
+// saturated to 16 bits. For example, Q15 samples from an ADC with a 3300 mV
+// reference become millivolts with a multiplier of 3300, a shift of 16 and an
+// offset of 1650.
+typedef struct {
+  int32_t multiplier;
+  uint32_t shift;
+  int32_t offset;
+} libtock_dsp_scale_t;
+
+uint32_t libtock_dsp_scale(const libtock_dsp_scale_t* scale, int16_t* samples, uint32_t count);
+
+// Features of one buffer.
+typedef struct {
+  int16_t min;
+  int16_t max;
+  uint32_t min_index;
+  uint32_t max_index;
+  // Largest absolute value and where it is.
+  int16_t peak;
+  uint32_t peak_index;
+  int16_t mean;
+  int16_t rms;
+} libtock_dsp_stats_t;
+
+// Compute the features of `count` samples. `count` must not be 0.
+void libtock_dsp_stats(const int16_t* samples, uint32_t count, libtock_dsp_stats_t* stats);
+
+// Find local maxima of at least `threshold`, at least `min_distance` samples
+// apart, storing up to `max_peaks` indices in `peaks`. When two peaks are
+// closer, the larger one is kept. Returns the number of peaks stored.
+uint32_t libtock_dsp_find_peaks(const int16_t* samples, uint32_t count, int16_t threshold, uint32_t min_distance,
+                                uint32_t* peaks, uint32_t max_peaks);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,460 @@
+#include <string.h>
+
+#include "fusion.h"
+
+#define ONE_Q24 (1 << 24)
+#define ONE_Q28 (1 << 28)
+
+static int32_t mul24(int32_t a, int32_t b) {
+  return (int32_t) (((int64_t) a * b) >> 24);
+}
+
+static int32_t mul30(int32_t a, int32_t b) {
+  return (int32_t) (((int64_t) a * b) >> 30);
+}
+
+// 1/sqrt(u) in Q30 at the middle of each sixteenth of u in [0.25, 1).
+static const uint32_t rsqrt_table[12] = {
+  2024667000, 1831380208, 1684624773, 1568300315, 1473161629, 1393471397,
+  1325455684, 1266516759, 1214800200, 1168942037, 1127913670, 1090922784,
+};
+
+// atan(2^-i) in units of 2^-32 turns.
+static const uint32_t atan_table[24] = {
+  536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+  2670163,   1335087,   667544,    333772,   166886,   83443,    41722,    20861,
+  10430,     5215,      2608,      1304,     652,      326,      163,      81,
+};
+
+// Scale the `n` components of `v` to unit length in Q30, without a division:
+// 1/sqrt of the sum of squares comes from a table and three Newton steps.
+// Returns false if all components are zero. `out` may be `v`.
+static bool normalize(const int32_t* v, int32_t* out, int n) {
+  uint64_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += (uint64_t) ((int64_t) v[i] * v[i]);
+  }
+  if (sum == 0) return false;
+
+  // sum = u * 2^(64 - k) with u in [0.25, 1) and k even.
+  uint32_t k = __builtin_clzll(sum) & ~1u;
+  uint32_t u = (uint32_t) ((sum << k) >> 32);
+  uint32_t y = rsqrt_table[(u >> 28) - 4];
+
+  for (int i = 0; i < 3; i++) {
+    uint64_t y2 = ((uint64_t) y * y) >> 30;
+    uint32_t t  = (uint32_t) ((u * y2) >> 32);
+    y = (uint32_t) (((uint64_t) y * ((3u << 30) - t)) >> 31);
+  }
+
+  uint32_t shift = 32 - k / 2;
+  for (int i = 0; i < n; i++) {
+    out[i] = (int32_t) (((int64_t) v[i] * y + (1ll << (shift - 1))) >> shift);
+  }
+  return true;
+}
+
+static uint32_t isqrt64(uint64_t v) {
+  uint64_t result = 0;
+  uint64_t bit    = 1ull << 62;
+
+  while (bit > v) bit >>= 2;
+  while (bit != 0) {
+    if (v >= result + bit) {
+      v     -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t) result;
+}
+
+// atan2 in hundredths of a degree by CORDIC vectoring. Inputs are at most 2.0
+// in Q30.
+static int32_t fusion_atan2(int32_t y, int32_t x) {
+  // Angles wrap around at a full turn, so partial sums beyond 180 degrees are
+  // harmless.
+  uint32_t angle = 0;
+
+  // Leave headroom for the CORDIC gain of about 1.65.
+  x >>= 2;
+  y >>= 2;
+
+  // Rotate into the right half-plane.
+  if (x < 0) {
+    int32_t t = x;
+    if (y >= 0) {
+      x     = y;
+      y     = -t;
+      angle = 1u << 30;
+    } else {
+      x     = -y;
+      y     = t;
+      angle = -(1u << 30);
+    }
+  }
+
+  for (int i = 0; i < 24; i++) {
+    int32_t dx = x >> i;
+    int32_t dy = y >> i;
+    if (y > 0) {
+      x     += dy;
+      y     -= dx;
+      angle += atan_table[i];
+    } else {
+      x     -= dy;
+      y     += dx;
+      angle -= atan_table[i];
+    }
+  }
+  return (int32_t) (((int64_t) (int32_t) angle * 18000 + (1ll << 30)) >> 31);
+}
+
+static void fusion_mag(const libtock_fusion_calibration_t* calibration, const int32_t* raw, int32_t* out) {
+  int32_t d[3];
+
+  for (int i = 0; i < 3; i++) {
+    d[i] = raw[i] - calibration->mag_offset[i];
+  }
+  for (int i = 0; i < 3; i++) {
+    const int32_t* row = calibration->mag_matrix[i];
+    out[i] = (int32_t) (((int64_t) row[0] * d[0] + (int64_t) row[1] * d[1] + (int64_t) row[2] * d[2]) >> 16);
+  }
+}
+
+static bool is_zero(const int32_t* v) {
+  return v[0] == 0 && v[1] == 0 && v[2] == 0;
+}
+
+static void fusion_step(libtock_fusion_t* fusion, const libtock_fusion_sample_t* sample) {
+  const libtock_fusion_calibration_t* calibration = &fusion->calibration;
+  int32_t* q = fusion->q;
+  int32_t theta[3];
+  int32_t correction[4] = {0, 0, 0, 0};
+  int32_t a[3], m[3];
+
+  // Rotation during this sample in Q28 radians.
+  for (int i = 0; i < 3; i++) {
+    int64_t counts = sample->gyro[i] - calibration->gyro_bias[i];
+    theta[i] = (int32_t) ((counts * fusion->gyro_multiplier) >> fusion->gyro_shift);
+  }
+
+  bool have_accel = normalize(sample->accel, a, 3);
+  bool have_mag   = false;
+  if (have_accel && !is_zero(sample->mag)) {
+    fusion_mag(calibration, sample->mag, m);
+    have_mag = normalize(m, m, 3);
+  }
+
+  if (have_accel) {
+    // The correction is computed in Q24, which leaves room for the sums of
+    // the gradient.
+    int32_t w = q[0] >> 6, x = q[1] >> 6, y = q[2] >> 6, z = q[3] >> 6;
+    int32_t xx = mul24(x, x), yy = mul24(y, y), zz = mul24(z, z);
+    int32_t xy = mul24(x, y), xz = mul24(x, z), yz = mul24(y, z);
+    int32_t wx = mul24(w, x), wy = mul24(w, y), wz = mul24(w, z);
+    int32_t bx = 0, bz = 0;
+    int32_t b[3];
+
+    for (int i = 0; i < 3; i++) {
+      a[i] >>= 6;
+      m[i] = have_mag ? m[i] >> 6 : 0;
+    }
+
+    // Gravity direction in the sensor frame predicted by the orientation.
+    int32_t v[3] = {
+      2 * (xz - wy),
+      2 * (wx + yz),
+      ONE_Q24 - 2 * (xx + yy),
+    };
+
+    if (have_mag) {
+      // Magnetic field in the earth frame, reduced to its horizontal
+      // strength `bx` along north and its vertical part `bz`.
+      int32_t h[2] = {
+        mul24(m[0], ONE_Q24 - 2 * (yy + zz)) + 2 * mul24(m[1], xy - wz) + 2 * mul24(m[2], xz + wy),
+        2 * mul24(m[0], xy + wz) + mul24(m[1], ONE_Q24 - 2 * (xx + zz)) + 2 * mul24(m[2], yz - wx),
+      };
+      int32_t direction[2];
+      if (normalize(h, direction, 2)) {
+        bx = mul30(h[0], direction[0]) + mul30(h[1], direction[1]);
+      }
+      bz = 2 * mul24(m[0], xz - wy) + 2 * mul24(m[1], yz + wx) + mul24(m[2], ONE_Q24 - 2 * (xx + yy));
+
+      // That field seen in the sensor frame.
+      b[0] = mul24(bx, ONE_Q24 - 2 * (yy + zz)) + 2 * mul24(bz, xz - wy);
+      b[1] = 2 * mul24(bx, xy - wz) + 2 * mul24(bz, wx + yz);
+      b[2] = 2 * mul24(bx, wy + xz) + mul24(bz, ONE_Q24 - 2 * (xx + yy));
+    }
+
+    if (fusion->config.algorithm == LIBTOCK_FUSION_MADGWICK) {
+      // Gradient of the squared error between predicted and measured
+      // directions, the Jacobian transposed times the error.
+      int32_t f1 = v[0] - a[0], f2 = v[1] - a[1], f3 = v[2] - a[2];
+      int32_t s[4] = {
+        2 * (mul24(x, f2) - mul24(y, f1)),
+        2 * (mul24(z, f1) + mul24(w, f2)) - 4 * mul24(x, f3),
+        2 * (mul24(z, f2) - mul24(w, f1)) - 4 * mul24(y, f3),
+        2 * (mul24(x, f1) + mul24(y, f2)),
+      };
+
+      if (have_mag) {
+        int32_t f4 = b[0] - m[0], f5 = b[1] - m[1], f6 = b[2] - m[2];
+        int32_t bxw = mul24(bx, w), bxx = mul24(bx, x), bxy = mul24(bx, y), bxz = mul24(bx, z);
+        int32_t bzw = mul24(bz, w), bzx = mul24(bz, x), bzy = mul24(bz, y), bzz = mul24(bz, z);
+
+        s[0] += -2 * mul24(bzy, f4) + 2 * mul24(bzx - bxz, f5) + 2 * mul24(bxy, f6);
+        s[1] += 2 * mul24(bzz, f4) + 2 * mul24(bxy + bzw, f5) + mul24(2 * bxz - 4 * bzx, f6);
+        s[2] += -mul24(4 * bxy + 2 * bzw, f4) + 2 * mul24(bxx + bzz, f5) + mul24(2 * bxw - 4 * bzy, f6);
+        s[3] += mul24(2 * bzx - 4 * bxz, f4) + 2 * mul24(bzy - bxw, f5) + 2 * mul24(bxx, f6);
+      }
+
+      // Step against the gradient by beta times the sample period.
+      if (normalize(s, s, 4)) {
+        for (int i = 0; i < 4; i++) {
+          correction[i] = -mul30(s[i], fusion->gain_dt);
+        }
+      }
+    } else {
+      // Rotation error between measured and predicted directions, fed back
+      // into the gyroscope rate through a PI controller.
+      int32_t e[3] = {
+        mul24(a[1], v[2]) - mul24(a[2], v[1]),
+        mul24(a[2], v[0]) - mul24(a[0], v[2]),
+        mul24(a[0], v[1]) - mul24(a[1], v[0]),
+      };
+
+      if (have_mag) {
+        e[0] += mul24(m[1], b[2]) - mul24(m[2], b[1]);
+        e[1] += mul24(m[2], b[0]) - mul24(m[0], b[2]);
+        e[2] += mul24(m[0], b[1]) - mul24(m[1], b[0]);
+      }
+
+      for (int i = 0; i < 3; i++) {
+        if (fusion->integral_gain_dt != 0) {
+          fusion->integral[i] += (int32_t) (((int64_t) e[i] * fusion->integral_gain_dt) >> 26);
+          theta[i]            += fusion->integral[i];
+        }
+        theta[i] += (int32_t) (((int64_t) e[i] * fusion->gain_dt) >> 26);
+      }
+    }
+  }
+
+  // q += q * (0, theta) / 2, then back to unit length.
+  int64_t dw = -((int64_t) q[1] * theta[0] + (int64_t) q[2] * theta[1] + (int64_t) q[3] * theta[2]);
+  int64_t dx = (int64_t) q[0] * theta[0] + (int64_t) q[2] * theta[2] - (int64_t) q[3] * theta[1];
+  int64_t dy = (int64_t) q[0] * theta[1] - (int64_t) q[1] * theta[2] + (int64_t) q[3] * theta[0];
+  int64_t dz = (int64_t) q[0] * theta[2] + (int64_t) q[1] * theta[1] - (int64_t) q[2] * theta[0];
+
+  q[0] += (int32_t) (dw >> 29) + correction[0];
+  q[1] += (int32_t) (dx >> 29) + correction[1];
+  q[2] += (int32_t) (dy >> 29) + correction[2];
+  q[3] += (int32_t) (dz >> 29) + correction[3];
+  normalize(q, q, 4);
+}
+
+returncode_t libtock_fusion_init(libtock_fusion_t* fusion, const libtock_fusion_config_t* config,
+                                 const libtock_fusion_calibration_t* calibration) {
+  uint32_t rate = config->sample_rate_hz;
+
+  if (rate == 0 || config->output_rate_hz == 0 || config->output_rate_hz > rate) return RETURNCODE_EINVAL;
+
+  memset(fusion, 0, sizeof(libtock_fusion_t));
+  fusion->config = *config;
+  libtock_fusion_set_calibration(fusion, calibration);
+  fusion->q[0] = 1 << 30;
+
+  // Rotation per sample in Q28 is counts * gyro_scale / (16 * rate). Use the
+  // largest multiplier below 2^31 for the most precision.
+  uint64_t divisor = 16ull * rate;
+  uint64_t scale   = config->gyro_scale;
+  uint32_t shift   = 0;
+  while (shift < 62 && (scale << (shift + 1)) >> (shift + 1) == scale &&
+         (scale << (shift + 1)) / divisor < (1ull << 31)) {
+    shift++;
+  }
+  fusion->gyro_multiplier = (uint32_t) ((scale << shift) / divisor);
+  fusion->gyro_shift      = shift;
+
+  // Gains in Q16 times the sample period, in Q30.
+  fusion->gain_dt          = (int32_t) (((int64_t) config->gain << 14) / rate);
+  fusion->integral_gain_dt = (int32_t) (((int64_t) config->integral_gain << 14) / rate);
+  fusion->output_interval  = rate / config->output_rate_hz;
+  return RETURNCODE_SUCCESS;
+}
+
+void libtock_fusion_set_calibration(libtock_fusion_t* fusion, const libtock_fusion_calibration_t* calibration) {
+  if (calibration != NULL) {
+    fusion->calibration = *calibration;
+    return;
+  }
+
+  memset(&fusion->calibration, 0, sizeof(libtock_fusion_calibration_t));
+  for (int i = 0; i < 3; i++) {
+    fusion->calibration.mag_matrix[i][i] = 1 << 16;
+  }
+}
+
+returncode_t libtock_fusion_reset(libtock_fusion_t* fusion, const libtock_fusion_sample_t* sample) {
+  int32_t up[3], north[3], west[3], m[3];
+
+  if (!normalize(sample->accel, up, 3)) return RETURNCODE_EINVAL;
+
+  // Without a magnetometer, north is wherever the sensor x axis points.
+  m[0] = 1 << 30;
+  m[1] = 0;
+  m[2] = 0;
+  if (!is_zero(sample->mag)) {
+    fusion_mag(&fusion->calibration, sample->mag, m);
+    normalize(m, m, 3);
+  }
+
+  // West is up x north, and north is west x up. The field points partly
+  // down, which the cross product removes.
+  int32_t cross[3] = {
+    mul30(up[1], m[2]) - mul30(up[2], m[1]),
+    mul30(up[2], m[0]) - mul30(up[0], m[2]),
+    mul30(up[0], m[1]) - mul30(up[1], m[0]),
+  };
+  if (!normalize(cross, west, 3)) {
+    // The reference is vertical, use the sensor y axis instead.
+    int32_t y_axis[3] = {0, 1 << 30, 0};
+    cross[0] = -mul30(up[2], y_axis[1]);
+    cross[1] = 0;
+    cross[2] = mul30(up[0], y_axis[1]);
+    if (!normalize(cross, west, 3)) return RETURNCODE_EINVAL;
+  }
+  north[0] = mul30(west[1], up[2]) - mul30(west[2], up[1]);
+  north[1] = mul30(west[2], up[0]) - mul30(west[0], up[2]);
+  north[2] = mul30(west[0], up[1]) - mul30(west[1], up[0]);
+
+  // The rows of the sensor-to-earth rotation are north, west and up. Convert
+  // it to a quaternion from its largest diagonal term, in Q28.
+  int32_t r00 = north[0] >> 2, r01 = north[1] >> 2, r02 = north[2] >> 2;
+  int32_t r10 = west[0] >> 2, r11 = west[1] >> 2, r12 = west[2] >> 2;
+  int32_t r20 = up[0] >> 2, r21 = up[1] >> 2, r22 = up[2] >> 2;
+  int32_t trace = r00 + r11 + r22;
+  int32_t q[4];
+
+  if (trace > 0) {
+    q[0] = ONE_Q28 + trace;
+    q[1] = r21 - r12;
+    q[2] = r02 - r20;
+    q[3] = r10 - r01;
+  } else if (r00 >= r11 && r00 >= r22) {
+    q[0] = r21 - r12;
+    q[1] = ONE_Q28 + r00 - r11 - r22;
+    q[2] = r01 + r10;
+    q[3] = r02 + r20;
+  } else if (r11 >= r22) {
+    q[0] = r02 - r20;
+    q[1] = r01 + r10;
+    q[2] = ONE_Q28 - r00 + r11 - r22;
+    q[3] = r12 + r21;
+  } else {
+    q[0] = r10 - r01;
+    q[1] = r02 + r20;
+    q[2] = r12 + r21;
+    q[3] = ONE_Q28 - r00 - r11 + r22;
+  }
+  if (q[0] < 0) {
+    for (int i = 0; i < 4; i++) q[i] = -q[i];
+  }
+
+  normalize(q, fusion->q, 4);
+  memset(fusion->integral, 0, sizeof(fusion->integral));
+  return RETURNCODE_SUCCESS;
+}
+
+uint32_t libtock_fusion_update(libtock_fusion_t* fusion, const libtock_fusion_sample_t* samples, uint32_t count,
+                               libtock_fusion_orientation_t* outputs, uint32_t max_outputs) {
+  uint32_t written = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    fusion_step(fusion, &samples[i]);
+    fusion->samples++;
+
+    if (++fusion->output_phase < fusion->output_interval) continue;
+    fusion->output_phase = 0;
+    if (written == max_outputs) continue;
+
+    libtock_fusion_orientation_t* out = &outputs[written++];
+    memcpy(out->quaternion, fusion->q, sizeof(out->quaternion));
+    if (fusion->config.euler) {
+      libtock_fusion_euler(fusion->q, &out->roll, &out->pitch, &out->yaw);
+    } else {
+      out->roll  = 0;
+      out->pitch = 0;
+      out->yaw   = 0;
+    }
+    out->sample = fusion->samples;
+  }
+  return written;
+}
+
+void libtock_fusion_orientation(const libtock_fusion_t* fusion, libtock_fusion_orientation_t* orientation) {
+  memcpy(orientation->quaternion, fusion->q, sizeof(orientation->quaternion));
+  libtock_fusion_euler(fusion->q, &orientation->roll, &orientation->pitch, &orientation->yaw);
+  orientation->sample = fusion->samples;
+}
+
+void libtock_fusion_euler(const int32_t quaternion[4], int32_t* roll, int32_t* pitch, int32_t* yaw) {
+  int64_t w = quaternion[0], x = quaternion[1], y = quaternion[2], z = quaternion[3];
+
+  // Entries of the rotation matrix in Q30, each within [-1, 1].
+  int32_t r00 = (int32_t) ((1ll << 30) - ((y * y + z * z) >> 29));
+  int32_t r10 = (int32_t) ((x * y + w * z) >> 29);
+  int32_t r20 = (int32_t) ((x * z - w * y) >> 29);
+  int32_t r21 = (int32_t) ((y * z + w * x) >> 29);
+  int32_t r22 = (int32_t) ((1ll << 30) - ((x * x + y * y) >> 29));
+
+  if (r20 > (1 << 30)) r20 = 1 << 30;
+  if (r20 < -(1 << 30)) r20 = -(1 << 30);
+
+  // cos(pitch) is the length of (r21, r22).
+  int32_t cos_pitch = (int32_t) isqrt64((uint64_t) ((int64_t) r21 * r21 + (int64_t) r22 * r22));
+
+  *roll  = fusion_atan2(r21, r22);
+  *pitch = fusion_atan2(-r20, cos_pitch);
+  *yaw   = fusion_atan2(r10, r00);
+}
+
+void libtock_fusion_calibrate_gyro(libtock_fusion_calibration_t* calibration, const libtock_fusion_sample_t* samples,
+                                   uint32_t count) {
+  if (count == 0) return;
+
+  for (int axis = 0; axis < 3; axis++) {
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      sum += samples[i].gyro[axis];
+    }
+    calibration->gyro_bias[axis] = (int32_t) (sum / (int64_t) count);
+  }
+}
+
+void libtock_fusion_calibrate_mag(libtock_fusion_calibration_t* calibration, const libtock_fusion_sample_t* samples,
+                                  uint32_t count) {
+  int32_t radius[3];
+
+  if (count == 0) return;
+
+  for (int axis = 0; axis < 3; axis++) {
+    int32_t min = samples[0].mag[axis];
+    int32_t max = min;
+    for (uint32_t i = 1; i < count; i++) {
+      int32_t v = samples[i].mag[axis];
+      if (v < min) min = v;
+      if (v > max) max = v;
+    }
+    calibration->mag_offset[axis] = (int32_t) (((int64_t) min + max) / 2);
+    radius[axis] = (int32_t) (((int64_t) max - min) / 2);
+  }
+
+  int64_t mean = ((int64_t) radius[0] + radius[1] + radius[2]) / 3;
+  memset(calibration->mag_matrix, 0, sizeof(calibration->mag_matrix));
+  for (int axis = 0; axis < 3; axis++) {
+    calibration->mag_matrix[axis][axis] = radius[axis] > 0 ? (int32_t) ((mean << 16) / radius[axis]) : 1 << 16;
+  }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-point orientation fusion for 9-DoF sensors.
+//
+// Accelerometer, gyroscope and magnetometer readings, as returned by
+// `libtock_ninedof_read_*()`, are fused into an orientation quaternion with
+// the Madgwick (gradient descent) or Mahony (complementary PI) filter. All
+// arithmetic is integer, with 64-bit products, so the filters run at useful
+// rates on cores without an FPU.
+//
+// Conventions:
+//
+// - All three sensors must report in the same right-handed axes. At rest the
+//   accelerometer reads +1 g on the axis pointing up.
+// - The earth frame has x pointing to magnetic north, y to the west and z up.
+//   The quaternion rotates vectors from the sensor frame to the earth frame.
+// - Quaternions are Q30 (`int32_t`, 1.0 = 2^30), in the order w, x, y, z.
+// - Euler angles are in hundredths of a degree: roll about x, pitch about y
+//   and yaw about z, applied yaw first. Yaw is counter-clockwise from north,
+//   so a compass heading is `-yaw`.
+//
+// Samples are ingested in batches. The filter is updated once per sample and
+// an orientation is written out every `sample_rate_hz / output_rate_hz`
+// samples, so the cost of the Euler conversion is only paid at the output
+// rate.
+//
+// A sample whose magnetometer reading is all zero updates the filter from the
+// accelerometer and gyroscope only (no yaw correction); one whose
+// accelerometer reading is all zero from the gyroscope only.
+
+// Gyroscope scales for `gyro_scale`, radians per second per count in Q32.
+#define LIBTOCK_FUSION_GYRO_SCALE_DPS  74961321u
+#define LIBTOCK_FUSION_GYRO_SCALE_MDPS 74961u
+
+// A filter gain in Q16, from a constant such as 0.1.
+#define LIBTOCK_FUSION_GAIN(x) ((int32_t) ((x) * 65536))
+
+// Suggested gains: Madgwick beta, and Mahony proportional and integral gains.
+#define LIBTOCK_FUSION_MADGWICK_GAIN_DEFAULT LIBTOCK_FUSION_GAIN(0.1)
+#define LIBTOCK_FUSION_MAHONY_GAIN_DEFAULT   LIBTOCK_FUSION_GAIN(0.5)
+#define LIBTOCK_FUSION_MAHONY_INTEGRAL_GAIN_DEFAULT 0
+
+typedef enum {
+  LIBTOCK_FUSION_MADGWICK,
+  LIBTOCK_FUSION_MAHONY,
+} libtock_fusion_algorithm_t;
+
+// One reading of each sensor, in sensor counts.
+typedef struct {
+  int32_t accel[3];
+  int32_t gyro[3];
+  int32_t mag[3];
+} libtock_fusion_sample_t;
+
+typedef struct {
+  libtock_fusion_algorithm_t algorithm;
+  // Rate at which samples were taken, and at which orientations are wanted.
+  uint32_t sample_rate_hz;
+  uint32_t output_rate_hz;
+  // Radians per second per gyroscope count, in Q32.
+  uint32_t gyro_scale;
+  // Madgwick beta or Mahony proportional gain, in Q16.
+  int32_t gain;
+  // Mahony integral gain in Q16, unused by Madgwick.
+  int32_t integral_gain;
+  // Whether outputs include Euler angles.
+  bool euler;
+} libtock_fusion_config_t;
+
+typedef struct {
+  // Subtracted from gyroscope readings.
+  int32_t gyro_bias[3];
+  // Hard-iron offset, subtracted from magnetometer readings.
+  int32_t mag_offset[3];
+  // Soft-iron correction applied after the offset, in Q16. The identity
+  // matrix (65536 on the diagonal) leaves readings unchanged.
+  int32_t mag_matrix[3][3];
+} libtock_fusion_calibration_t;
+
+typedef struct {
+  // Orientation quaternion in Q30.
+  int32_t quaternion[4];
+  // Hundredths of a degree, 0 unless `euler` is set in the configuration.
+  int32_t roll;
+  int32_t pitch;
+  int32_t yaw;
+  // Number of samples ingested up to and including this one.
+  uint32_t sample;
+} libtock_fusion_orientation_t;
+
+// State for one filter. Allocated by the caller and initialized with
+// `libtock_fusion_init()`.
+typedef struct {
+  libtock_fusion_config_t config;
+  libtock_fusion_calibration_t calibration;
+
+  // Orientation in Q30.
+  int32_t q[4];
+  // Mahony integral term, radians per sample in Q28.
+  int32_t integral[3];
+
+  // Derived from the configuration: rotation per sample in Q28 is
+  // `counts * gyro_multiplier >> gyro_shift`, gains times the sample period
+  // are in Q30.
+  uint32_t gyro_multiplier;
+  uint32_t gyro_shift;
+  int32_t gain_dt;
+  int32_t integral_gain_dt;
+  uint32_t output_interval;
+  uint32_t output_phase;
+
+  uint32_t samples;
+} libtock_fusion_t;
+
+// Initialize a filter at the identity orientation. `calibration` may be NULL
+// for uncalibrated sensors.
+//
+// Returns `RETURNCODE_EINVAL` if a rate is 0 or the output rate exceeds the
+// sample rate.
+returncode_t libtock_fusion_init(libtock_fusion_t* fusion, const libtock_fusion_config_t* config,
+                                 const libtock_fusion_calibration_t* calibration);
+
+// Replace the calibration used for following samples.
+void libtock_fusion_set_calibration(libtock_fusion_t* fusion, const libtock_fusion_calibration_t* calibration);
+
+// Set the orientation directly from the accelerometer and magnetometer of one
+// sample, skipping the time the filter would need to converge. Without a
+// magnetometer reading the yaw is set to 0.
+//
+// Returns `RETURNCODE_EINVAL` if the accelerometer reading is all zero.
+returncode_t libtock_fusion_reset(libtock_fusion_t* fusion, const libtock_fusion_sample_t* sample);
+
+// Update the filter with `count` samples, and write an orientation to
+// `outputs` every output interval, up to `max_outputs`. Returns the number of
+// orientations written.
+uint32_t libtock_fusion_update(libtock_fusion_t* fusion, const libtock_fusion_sample_t* samples, uint32_t count,
+                               libtock_fusion_orientation_t* outputs, uint32_t max_outputs);
+
+// Current orientation with Euler angles, regardless of the output interval.
+void libtock_fusion_orientation(const libtock_fusion_t* fusion, libtock_fusion_orientation_t* orientation);
+
+// Convert a Q30 quaternion to Euler angles in hundredths of a degree.
+void libtock_fusion_euler(const int32_t quaternion[4], int32_t* roll, int32_t* pitch, int32_t* yaw);
+
+// Set the gyroscope bias to the mean of `count` samples taken at rest.
+void libtock_fusion_calibrate_gyro(libtock_fusion_calibration_t* calibration, const libtock_fusion_sample_t* samples,
+                                   uint32_t count);
+
+// Set the hard-iron offset and a diagonal soft-iron correction from `count`
+// samples taken while the device is turned through all orientations. Each
+// axis is centered on the midpoint of its range and scaled to the mean range
+// of the three axes.
+void libtock_fusion_calibrate_mag(libtock_fusion_calibration_t* calibration, const libtock_fusion_sample_t* samples,
+                                  uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,267 @@
+#include <string.h>
+
+#include "../peripherals/crc_software.h"
+#include "timeseries.h"
+
+#define HEADER_LENGTH  LIBTOCK_TIMESERIES_HEADER_LENGTH
+#define TRAILER_LENGTH LIBTOCK_TIMESERIES_TRAILER_LENGTH
+
+// Control byte of a sample: bit 7 flags a timestamp field, bits 0 to 5 a
+// field per channel. 01rrrrrr stands for r + 1 samples without any fields.
+#define CONTROL_TIMESTAMP 0x80
+#define CONTROL_RUN       0x40
+#define CONTROL_RUN_MASK  0xC0
+#define MAX_RUN           64
+
+// Largest encoding of one sample: a control byte, a 33-bit timestamp field
+// and a 37-bit field per channel.
+#define MAX_SAMPLE_LENGTH (1 + 5 + 6 * LIBTOCK_TIMESERIES_MAX_CHANNELS)
+
+static uint64_t zigzag(int64_t v) {
+  return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+  return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static uint32_t put_varint(uint8_t* out, uint64_t v) {
+  uint32_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t) v | 0x80;
+    v      >>= 7;
+  }
+  out[n++] = (uint8_t) v;
+  return n;
+}
+
+static bool get_varint(libtock_timeseries_decoder_t* decoder, uint64_t* v) {
+  uint64_t result = 0;
+
+  for (uint32_t shift = 0; shift < 64; shift += 7) {
+    if (decoder->position == decoder->length) return false;
+    uint8_t byte = decoder->payload[decoder->position++];
+    result |= (uint64_t) (byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void put_u16(uint8_t* out, uint32_t v) {
+  out[0] = v & 0xFF;
+  out[1] = (v >> 8) & 0xFF;
+}
+
+static uint32_t get_u16(const uint8_t* in) {
+  return in[0] | (in[1] << 8);
+}
+
+// Field of channel `i` for a change from `previous` to `value`, 0 if it did
+// not change.
+static uint64_t channel_field(uint8_t xor_mask, int i, int32_t previous, int32_t value) {
+  if (xor_mask & (1 << i)) {
+    uint32_t x = (uint32_t) previous ^ (uint32_t) value;
+    if (x == 0) return 0;
+    uint32_t trailing = __builtin_ctz(x);
+    return ((uint64_t) (x >> trailing) << 5) | trailing;
+  }
+  return zigzag((int64_t) value - previous);
+}
+
+static int32_t channel_apply(uint8_t xor_mask, int i, int32_t previous, uint64_t field) {
+  if (xor_mask & (1 << i)) {
+    return (int32_t) ((uint32_t) previous ^ ((uint32_t) (field >> 5) << (field & 0x1F)));
+  }
+  return (int32_t) ((int64_t) previous + unzigzag(field));
+}
+
+returncode_t libtock_timeseries_encoder_init(libtock_timeseries_encoder_t* encoder, uint32_t channels,
+                                             uint8_t xor_mask) {
+  if (channels == 0 || channels > LIBTOCK_TIMESERIES_MAX_CHANNELS) return RETURNCODE_EINVAL;
+
+  memset(encoder, 0, sizeof(libtock_timeseries_encoder_t));
+  encoder->channels = channels;
+  encoder->xor_mask = xor_mask & ((1 << channels) - 1);
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_timeseries_encoder_start(libtock_timeseries_encoder_t* encoder, uint8_t* buffer, uint32_t size) {
+  if (size < LIBTOCK_TIMESERIES_MIN_BLOCK || size > LIBTOCK_TIMESERIES_MAX_BLOCK) return RETURNCODE_EINVAL;
+
+  encoder->buffer = buffer;
+  encoder->size   = size;
+  encoder->length = HEADER_LENGTH;
+  encoder->count  = 0;
+  encoder->run    = 0;
+  return RETURNCODE_SUCCESS;
+}
+
+returncode_t libtock_timeseries_encoder_add(libtock_timeseries_encoder_t* encoder, uint32_t timestamp,
+                                            const int32_t* values) {
+  uint8_t sample[MAX_SAMPLE_LENGTH];
+  uint32_t length = 0;
+  int32_t delta   = 0;
+  bool empty      = false;
+
+  if (encoder->buffer == NULL) return RETURNCODE_EINVAL;
+  if (encoder->count == 0xFFFF) return RETURNCODE_ESIZE;
+
+  if (encoder->count == 0) {
+    // The first sample of a block is stored in full.
+    length = put_varint(sample, timestamp);
+    for (int i = 0; i < encoder->channels; i++) {
+      uint64_t field = encoder->xor_mask & (1 << i) ? (uint32_t) values[i] : zigzag(values[i]);
+      length += put_varint(sample + length, field);
+    }
+  } else {
+    uint8_t control = 0;
+    int64_t delta_of_delta;
+
+    delta          = (int32_t) (timestamp - encoder->timestamp);
+    delta_of_delta = (int64_t) delta - encoder->delta;
+    length         = 1;
+    if (delta_of_delta != 0) {
+      control |= CONTROL_TIMESTAMP;
+      length  += put_varint(sample + length, zigzag(delta_of_delta));
+    }
+    for (int i = 0; i < encoder->channels; i++) {
+      uint64_t field = channel_field(encoder->xor_mask, i, encoder->values[i], values[i]);
+      if (field != 0) {
+        control |= 1 << i;
+        length  += put_varint(sample + length, field);
+      }
+    }
+    sample[0] = control;
+    empty     = control == 0;
+  }
+
+  // A sample without fields extends the run, which needs a byte when it
+  // starts.
+  uint32_t needed = empty ? (encoder->run == 0 ? 1 : 0) : length;
+  if (encoder->length + needed + TRAILER_LENGTH > encoder->size) return RETURNCODE_ESIZE;
+
+  if (empty) {
+    if (encoder->run == 0) {
+      encoder->run_position = encoder->length++;
+    }
+    if (++encoder->run == MAX_RUN) {
+      encoder->buffer[encoder->run_position] = CONTROL_RUN | (MAX_RUN - 1);
+      encoder->run = 0;
+    }
+  } else {
+    if (encoder->run > 0) {
+      encoder->buffer[encoder->run_position] = CONTROL_RUN | (encoder->run - 1);
+      encoder->run = 0;
+    }
+    memcpy(encoder->buffer + encoder->length, sample, length);
+    encoder->length += length;
+  }
+
+  encoder->timestamp = timestamp;
+  encoder->delta     = delta;
+  memcpy(encoder->values, values, encoder->channels * sizeof(int32_t));
+  encoder->count++;
+  return RETURNCODE_SUCCESS;
+}
+
+uint32_t libtock_timeseries_encoder_finish(libtock_timeseries_encoder_t* encoder) {
+  uint8_t* buffer = encoder->buffer;
+
+  if (buffer == NULL || encoder->count == 0) return 0;
+
+  if (encoder->run > 0) {
+    buffer[encoder->run_position] = CONTROL_RUN | (encoder->run - 1);
+    encoder->run = 0;
+  }
+
+  buffer[0] = LIBTOCK_TIMESERIES_MAGIC;
+  buffer[1] = LIBTOCK_TIMESERIES_VERSION;
+  buffer[2] = encoder->channels;
+  buffer[3] = encoder->xor_mask;
+  put_u16(buffer + 4, encoder->count);
+  put_u16(buffer + 6, encoder->length - HEADER_LENGTH);
+  put_u16(buffer + encoder->length, libtock_crc_software(LIBTOCK_CRC_16CCITT, buffer, encoder->length));
+
+  uint32_t length = encoder->length + TRAILER_LENGTH;
+  encoder->buffer = NULL;
+  return length;
+}
+
+uint32_t libtock_timeseries_block_length(const uint8_t* data, uint32_t available) {
+  if (available < HEADER_LENGTH) return 0;
+  if (data[0] != LIBTOCK_TIMESERIES_MAGIC || data[1] != LIBTOCK_TIMESERIES_VERSION) return 0;
+  if (data[2] == 0 || data[2] > LIBTOCK_TIMESERIES_MAX_CHANNELS) return 0;
+
+  uint32_t length = HEADER_LENGTH + get_u16(data + 6) + TRAILER_LENGTH;
+  return length <= available ? length : 0;
+}
+
+returncode_t libtock_timeseries_decoder_init(libtock_timeseries_decoder_t* decoder, const uint8_t* block,
+                                             uint32_t length) {
+  uint32_t block_length = libtock_timeseries_block_length(block, length);
+
+  if (block_length == 0) return RETURNCODE_EINVAL;
+
+  uint32_t payload_length = block_length - HEADER_LENGTH - TRAILER_LENGTH;
+  uint32_t crc = libtock_crc_software(LIBTOCK_CRC_16CCITT, block, HEADER_LENGTH + payload_length);
+  if (crc != get_u16(block + HEADER_LENGTH + payload_length)) return RETURNCODE_FAIL;
+
+  memset(decoder, 0, sizeof(libtock_timeseries_decoder_t));
+  decoder->channels = block[2];
+  decoder->xor_mask = block[3];
+  decoder->count    = get_u16(block + 4);
+  decoder->payload  = block + HEADER_LENGTH;
+  decoder->length   = payload_length;
+  return RETURNCODE_SUCCESS;
+}
+
+bool libtock_timeseries_decoder_next(libtock_timeseries_decoder_t* decoder, uint32_t* timestamp, int32_t* values) {
+  uint64_t field;
+
+  if (decoder->corrupt || decoder->decoded == decoder->count) return false;
+
+  if (decoder->decoded == 0) {
+    if (!get_varint(decoder, &field)) goto corrupt;
+    decoder->timestamp = (uint32_t) field;
+    for (int i = 0; i < decoder->channels; i++) {
+      if (!get_varint(decoder, &field)) goto corrupt;
+      decoder->values[i] = decoder->xor_mask & (1 << i) ? (int32_t) (uint32_t) field : (int32_t) unzigzag(field);
+    }
+  } else if (decoder->run > 0) {
+    decoder->run--;
+    decoder->timestamp += decoder->delta;
+  } else {
+    if (decoder->position == decoder->length) goto corrupt;
+    uint8_t control = decoder->payload[decoder->position++];
+
+    if ((control & CONTROL_RUN_MASK) == CONTROL_RUN) {
+      // This sample is the first of the run.
+      decoder->run        = control & (MAX_RUN - 1);
+      decoder->timestamp += decoder->delta;
+    } else {
+      if (control & CONTROL_TIMESTAMP) {
+        if (!get_varint(decoder, &field)) goto corrupt;
+        decoder->delta = (int32_t) ((int64_t) decoder->delta + unzigzag(field));
+      }
+      decoder->timestamp += decoder->delta;
+
+      for (int i = 0; i < decoder->channels; i++) {
+        if (!(control & (1 << i))) continue;
+        if (!get_varint(decoder, &field)) goto corrupt;
+        decoder->values[i] = channel_apply(decoder->xor_mask, i, decoder->values[i], field);
+      }
+    }
+  }
+
+  *timestamp = decoder->timestamp;
+  memcpy(values, decoder->values, decoder->channels * sizeof(int32_t));
+  decoder->decoded++;
+  return true;
+
+corrupt:
+  decoder->corrupt = true;
+  return false;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "../tock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming compression for time series of sensor readings.
+//
+// Samples of a timestamp and up to `LIBTOCK_TIMESERIES_MAX_CHANNELS` 32-bit
+// values are encoded into blocks that each decode on their own, so a block
+// can be sent over the radio or written to flash as soon as it is full, and
+// a lost block does not affect the others.
+//
+// Within a block:
+//
+// - Timestamps are stored as the zig-zag varint of their delta-of-delta,
+//   which is 0 for regular sampling.
+// - Integer channels store the zig-zag varint of the change from the previous
+//   value. Channels selected in `xor_mask` store the XOR with the previous
+//   value instead, with its trailing zero bits removed, which suits the bit
+//   patterns of `float` readings.
+// - Each sample starts with a control byte flagging the fields that are not
+//   zero, and only those follow. Runs of samples where every field is zero
+//   take one byte per 64 samples.
+//
+// Slowly changing readings at a fixed rate take one to three bytes per sample
+// instead of four per field.
+//
+// Block layout, all multi-byte fields little-endian:
+//
+//     offset 0   magic 0x54 ('T')
+//            1   format version, 1
+//            2   number of channels
+//            3   XOR channel mask
+//            4   number of samples (16 bits)
+//            6   payload length (16 bits)
+//            8   payload
+//            8+n CRC-16-CCITT of everything before it (16 bits)
+//
+// `tools/timeseries_decode` decodes blocks on a host computer.
+
+#define LIBTOCK_TIMESERIES_MAX_CHANNELS 6
+
+#define LIBTOCK_TIMESERIES_MAGIC   0x54
+#define LIBTOCK_TIMESERIES_VERSION 1
+
+// Bytes of a block that are not payload.
+#define LIBTOCK_TIMESERIES_HEADER_LENGTH  8
+#define LIBTOCK_TIMESERIES_TRAILER_LENGTH 2
+
+// Smallest and largest block buffers.
+#define LIBTOCK_TIMESERIES_MIN_BLOCK 64
+#define LIBTOCK_TIMESERIES_MAX_BLOCK \
+        (LIBTOCK_TIMESERIES_HEADER_LENGTH + 0xFFFF + LIBTOCK_TIMESERIES_TRAILER_LENGTH)
+
+typedef struct {
+  uint8_t channels;
+  uint8_t xor_mask;
+
+  // Block being filled.
+  uint8_t* buffer;
+  uint32_t size;
+  uint32_t length;
+  uint32_t count;
+
+  // Previous sample and timestamp delta.
+  uint32_t timestamp;
+  int32_t delta;
+  int32_t values[LIBTOCK_TIMESERIES_MAX_CHANNELS];
+  // Samples identical in every field that have not been written yet, and
+  // where their run byte goes.
+  uint32_t run;
+  uint32_t run_position;
+} libtock_timeseries_encoder_t;
+
+typedef struct {
+  uint8_t channels;
+  uint8_t xor_mask;
+
+  const uint8_t* payload;
+  uint32_t length;
+  uint32_t position;
+  uint32_t count;
+  uint32_t decoded;
+  // Set when the payload ended or held a bad value before `count` samples.
+  bool corrupt;
+
+  uint32_t timestamp;
+  int32_t delta;
+  int32_t values[LIBTOCK_TIMESERIES_MAX_CHANNELS];
+  uint32_t run;
+} libtock_timeseries_decoder_t;
+
+// Initialize an encoder for samples of `channels` values. Bit `i` of
+// `xor_mask` selects XOR encoding for channel `i`.
+//
+// Returns `RETURNCODE_EINVAL` unless `channels` is 1 to
+// `LIBTOCK_TIMESERIES_MAX_CHANNELS`.
+returncode_t libtock_timeseries_encoder_init(libtock_timeseries_encoder_t* encoder, uint32_t channels,
+                                             uint8_t xor_mask);
+
+// Start a new block in `buffer` of `size` bytes, between
+// `LIBTOCK_TIMESERIES_MIN_BLOCK` and `LIBTOCK_TIMESERIES_MAX_BLOCK`.
+returncode_t libtock_timeseries_encoder_start(libtock_timeseries_encoder_t* encoder, uint8_t* buffer, uint32_t size);
+
+// Add a sample with one value per channel to the block.
+//
+// Returns `RETURNCODE_ESIZE` if the sample does not fit, in which case the
+// block is unchanged and should be finished and the sample added to a new
+// one.
+returncode_t libtock_timeseries_encoder_add(libtock_timeseries_encoder_t* encoder, uint32_t timestamp,
+                                            const int32_t* values);
+
+// Complete the block and return its length in bytes, 0 if it holds no
+// samples. The block is at the start of the buffer passed to
+// `libtock_timeseries_encoder_start()`.
+uint32_t libtock_timeseries_encoder_finish(libtock_timeseries_encoder_t* encoder);
+
+// Length of the block starting at `data`, or 0 if `data` does not start with
+// a block header that fits in `available` bytes. Used to walk a stream of
+// blocks.
+uint32_t libtock_timeseries_block_length(const uint8_t* data, uint32_t available);
+
+// Start decoding the block of `length` bytes at `block`.
+//
+// Returns `RETURNCODE_EINVAL` if it is not a block of a known version and
+// `RETURNCODE_FAIL` if the CRC does not match.
+returncode_t libtock_timeseries_decoder_init(libtock_timeseries_decoder_t* decoder, const uint8_t* block,
+                                             uint32_t length);
+
+// Decode the next sample into `timestamp` and `values`, which must hold one
+// value per channel. Returns false after the last sample, or once the
+// payload turns out to be malformed, which sets `corrupt`.
+bool libtock_timeseries_decoder_next(libtock_timeseries_decoder_t* decoder, uint32_t* timestamp, int32_t* values);
+
+#ifdef __cplusplus
+}
+#endif
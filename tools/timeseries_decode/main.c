@@ -0,0 +1,92 @@
+// Decode a file of time-series blocks written by `libtock/util/timeseries.h`
+// and print the samples as CSV.
+//
+// Blocks may be separated by other data, such as radio framing or erased
+// flash, which is skipped. Blocks that fail their CRC are reported on stderr
+// and skipped as well.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libtock/util/timeseries.h>
+
+static uint8_t* read_file(const char* path, uint32_t* length) {
+  FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+  uint8_t* data = NULL;
+  size_t size = 0, capacity = 0, n;
+
+  if (file == NULL) return NULL;
+  do {
+    if (size == capacity) {
+      capacity = capacity ? capacity * 2 : 65536;
+      data     = realloc(data, capacity);
+      if (data == NULL) return NULL;
+    }
+    n     = fread(data + size, 1, capacity - size, file);
+    size += n;
+  } while (n > 0);
+
+  if (file != stdin) fclose(file);
+  *length = size;
+  return data;
+}
+
+int main(int argc, char** argv) {
+  libtock_timeseries_decoder_t decoder;
+  uint32_t length, position = 0, blocks = 0, skipped = 0;
+  uint32_t timestamp;
+  int32_t values[LIBTOCK_TIMESERIES_MAX_CHANNELS];
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <file|->\n", argv[0]);
+    return 1;
+  }
+
+  uint8_t* data = read_file(argv[1], &length);
+  if (data == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  while (position < length) {
+    uint32_t block_length = libtock_timeseries_block_length(data + position, length - position);
+    if (block_length == 0 ||
+        libtock_timeseries_decoder_init(&decoder, data + position, block_length) != RETURNCODE_SUCCESS) {
+      if (block_length != 0) fprintf(stderr, "block at offset %u fails its CRC, skipping\n", position);
+      position++;
+      skipped++;
+      continue;
+    }
+
+    if (blocks == 0) {
+      printf("block,timestamp");
+      for (int i = 0; i < decoder.channels; i++) printf(",channel %d", i);
+      printf("\n");
+    }
+
+    while (libtock_timeseries_decoder_next(&decoder, &timestamp, values)) {
+      printf("%u,%u", blocks, timestamp);
+      for (int i = 0; i < decoder.channels; i++) {
+        if (decoder.xor_mask & (1 << i)) {
+          float value;
+          memcpy(&value, &values[i], sizeof(value));
+          printf(",%g", value);
+        } else {
+          printf(",%d", values[i]);
+        }
+      }
+      printf("\n");
+    }
+    if (decoder.corrupt || decoder.position != decoder.length) {
+      fprintf(stderr, "block %u at offset %u is malformed after %u samples\n", blocks, position, decoder.decoded);
+    }
+
+    position += block_length;
+    blocks++;
+  }
+
+  fprintf(stderr, "%u blocks decoded, %u bytes skipped\n", blocks, skipped);
+  free(data);
+  return 0;
+}